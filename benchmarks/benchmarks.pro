@@ -0,0 +1,14 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+# 开发机上运行：qmake benchmarks/benchmarks.pro && make && ./sysfs_backend_bench
+TARGET = sysfs_backend_bench
+TEMPLATE = app
+
+include(../control_modules.pri)
+
+SOURCES += \
+    sysfs_backend_bench.cpp
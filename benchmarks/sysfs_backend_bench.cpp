@@ -0,0 +1,356 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+#include "device/curtain_controller.h"
+#include "hardware/gpio_controller.h"
+#include "hardware/pwm_channel_pool.h"
+#include "hardware/pwm_controller.h"
+#include "hardware/sysfs_io.h"
+#include "config/gpio_config.h"
+
+/**
+ * sysfs后端基准测试
+ *
+ * 在各SysfsIo实现上运行三组操作，逐次计时，输出吞吐与p50/p99延迟：
+ * - curtain：各执行器依次 打开-暂停-关闭-暂停（每次一个GPIO事务，暂停时保存位置文件）
+ * - pump：水泵与施药泵交替开关
+ * - pwm：三通道同步设置与主通道单独设置交替，占空比每次变化
+ * tmpfs与memory后端默认运行；kernel后端会真实驱动保温帘电机、水泵与补光灯，须以--kernel显式开启。
+ *
+ * 另在临时目录的普通文件树上经GPIOController::setPin比较单个引脚的翻转：关闭属性文件缓存时
+ * 每次打开-写入-关闭（缓存前的路径），开启时对缓存的fd pwrite一个字节。
+ */
+
+namespace {
+
+const int PERMILLE_FULL = 1000;   // 占空比满量程（‰）
+const int TOGGLE_PIN = 40;        // 翻转对比用的引脚（文件树中任意空闲引脚）
+
+// memory后端的写入失败只在计时阶段注入，初始化与清理不受影响
+struct Injection {
+    MemorySysfsIo *memory = nullptr;
+    double failureRate = 0.0;
+
+    void arm() const
+    {
+        if (memory) {
+            memory->setFailureRate(MemorySysfsIo::WriteOperation, failureRate);
+        }
+    }
+    void disarm() const
+    {
+        if (memory) {
+            memory->setFailureRate(MemorySysfsIo::WriteOperation, 0.0);
+        }
+    }
+};
+
+struct Result {
+    int operations = 0;
+    int failures = 0;
+    qint64 totalNs = 0;
+    QVector<qint64> latencies;    // 已排序
+};
+
+// 临时目录优先放在tmpfs上，与实际部署时的SYSFS_MIRROR_ROOT一致
+QString tmpfsTemplate(const QString &name)
+{
+    const QString shm = "/dev/shm";
+    return (QDir(shm).exists() ? shm : QDir::tempPath()) + "/" + name + "-XXXXXX";
+}
+
+qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+template <typename Operation>
+Result measure(int iterations, const Injection &injection, Operation operation)
+{
+    Result result;
+    result.latencies.reserve(iterations);
+    injection.arm();
+    const qint64 begin = monotonicNs();
+    for (int i = 0; i < iterations; ++i) {
+        const qint64 start = monotonicNs();
+        const bool ok = operation(i);
+        result.latencies.append(monotonicNs() - start);
+        if (!ok) {
+            result.failures++;
+        }
+    }
+    result.totalNs = monotonicNs() - begin;
+    injection.disarm();
+    result.operations = iterations;
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+double percentileUs(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0.0;
+    }
+    const int index = qBound(0, int(std::ceil(p * sorted.size())) - 1, sorted.size() - 1);
+    return sorted.at(index) / 1000.0;
+}
+
+void printHeader(QTextStream &out)
+{
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg(QString("后端"), -8).arg(QString("操作"), -8).arg(QString("次数"), 8).arg(QString("失败"), 6)
+           .arg(QString("吞吐(ops/s)"), 12).arg(QString("p50(us)"), 10).arg(QString("p99(us)"), 10)
+           .arg(QString("最大(us)"), 10);
+}
+
+void printResult(QTextStream &out, const QString &backend, const QString &mix, const Result &result)
+{
+    const double seconds = result.totalNs / 1e9;
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg(backend, -8).arg(mix, -8)
+           .arg(result.operations, 8).arg(result.failures, 6)
+           .arg(seconds > 0.0 ? result.operations / seconds : 0.0, 12, 'f', 0)
+           .arg(percentileUs(result.latencies, 0.50), 10, 'f', 1)
+           .arg(percentileUs(result.latencies, 0.99), 10, 'f', 1)
+           .arg(result.latencies.isEmpty() ? 0.0 : result.latencies.last() / 1000.0, 10, 'f', 1);
+    out.flush();
+}
+
+void printSkipped(QTextStream &out, const QString &backend, const QString &mix, const QString &reason)
+{
+    out << QString("%1 %2 跳过：%3\n").arg(backend, -8).arg(mix, -8).arg(reason);
+    out.flush();
+}
+
+// 保温帘与水泵共用一个GPIO控制器（sysfs后端）
+void runGpioMixes(QTextStream &out, const QString &backend, SysfsIo *io, int iterations,
+                  const Injection &injection)
+{
+    GPIOController gpio;
+    if (!gpio.setSysfsIo(io) || !gpio.setBackend(GPIOController::SysfsBackend) || !gpio.initialize()) {
+        printSkipped(out, backend, "curtain", "GPIO控制器初始化失败");
+        printSkipped(out, backend, "pump", "GPIO控制器初始化失败");
+        return;
+    }
+
+    {
+        // 每个后端从相同的位置状态开始（未校准，全关）
+        const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir(dataDir).removeRecursively();
+
+        CurtainController curtain;
+        curtain.setGPIOController(&gpio);
+        if (curtain.initialize()) {
+            const int count = curtain.curtainCount();
+            printResult(out, backend, "curtain", measure(iterations, injection, [&curtain, count](int i) {
+                const CurtainController::CurtainType type = (i / 4) % count;
+                switch (i % 4) {
+                    case 0:
+                        return curtain.openCurtain(type);
+                    case 2:
+                        return curtain.closeCurtain(type);
+                    default:
+                        return curtain.pauseCurtain(type);
+                }
+            }));
+        } else {
+            printSkipped(out, backend, "curtain", "保温帘控制器初始化失败");
+        }
+        curtain.shutdown();
+    }
+
+    printResult(out, backend, "pump", measure(iterations, injection, [&gpio](int i) {
+        switch (i % 4) {
+            case 0:
+                return gpio.startPump();
+            case 1:
+                return gpio.stopPump();
+            case 2:
+                return gpio.startFertilizerPump();
+            default:
+                return gpio.stopFertilizerPump();
+        }
+    }));
+}
+
+void runPwmMix(QTextStream &out, const QString &backend, SysfsIo *io, int iterations,
+               const Injection &injection)
+{
+    PwmChannelPool pool;
+    if (!pool.setSysfsIo(io) || !pool.initialize()) {
+        printSkipped(out, backend, "pwm", "主PWM通道初始化失败");
+        return;
+    }
+
+    // 只设置已初始化的通道，未接的灯串不计入失败
+    const QStringList keys = pool.dutyPermilles().keys();
+    printResult(out, backend, "pwm", measure(iterations, injection, [&pool, &keys](int i) {
+        const int permille = (i * 37) % (PERMILLE_FULL + 1);
+        if (i % 2) {
+            return pool.primary()->setDutyPermille(permille);
+        }
+        QMap<QString, int> duties;
+        for (int k = 0; k < keys.size(); ++k) {
+            duties.insert(keys.at(k), (permille + k * 250) % (PERMILLE_FULL + 1));
+        }
+        return pool.setDutyPermilles(duties);
+    }));
+    pool.cleanup();
+}
+
+void runBackend(QTextStream &out, const QString &backend, SysfsIo *io, int iterations,
+                const Injection &injection = Injection())
+{
+    runGpioMixes(out, backend, io, iterations, injection);
+    runPwmMix(out, backend, io, iterations, injection);
+}
+
+// 普通文件组成的gpio树：引脚目录预先建好（exportPin()视为已导出），属性文件可直接读写
+bool createPlainGpioTree(const QString &root, const QList<int> &pins)
+{
+    const QString base = root + GPIO_BASE_PATH;
+    QMap<QString, QByteArray> files;
+    files.insert(base + "/export", QByteArray());
+    files.insert(base + "/unexport", QByteArray());
+    for (int pin : pins) {
+        const QString pinDir = QString("%1/gpio%2").arg(base).arg(pin);
+        if (!QDir().mkpath(pinDir)) {
+            return false;
+        }
+        files.insert(pinDir + "/value", "0");
+        files.insert(pinDir + "/direction", "in");
+        files.insert(pinDir + "/edge", "none");
+        files.insert(pinDir + "/active_low", "0");
+    }
+
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        QFile file(it.key());
+        if (!file.open(QIODevice::WriteOnly) || file.write(it.value()) != it.value().size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 经GPIOController::setPin翻转单个引脚，cacheFds为false时每次写入重新打开value文件
+bool toggleThroughController(SysfsIo *io, bool cacheFds, int iterations, Result *result)
+{
+    GPIOController gpio;
+    if (!gpio.setSysfsIo(io) || !gpio.setAttributeFdCache(cacheFds) || !gpio.initialize()
+            || !gpio.exportPin(TOGGLE_PIN) || !gpio.setDirection(TOGGLE_PIN, "out")) {
+        return false;
+    }
+    *result = measure(iterations, Injection(), [&gpio](int i) {
+        return gpio.setPin(TOGGLE_PIN, i % 2);
+    });
+    return true;
+}
+
+// 单引脚翻转：逐次打开属性文件（缓存前的路径）与缓存fd pwrite对比，两者都经GPIOController，
+// 后端为临时目录中普通文件上的真实open/pwrite/close
+void runToggleComparison(QTextStream &out, int iterations)
+{
+    QTemporaryDir dir(tmpfsTemplate("gpio-toggle-bench"));
+    const QList<int> pins = QList<int>() << POWER_SUPPLY_PIN << PUMP_CONTROL_PIN << FERTILIZER_PUMP_PIN << TOGGLE_PIN;
+    if (!dir.isValid() || !createPlainGpioTree(dir.path(), pins)) {
+        printSkipped(out, "rootfs", "toggle", "无法在临时目录中创建gpio文件树");
+        return;
+    }
+
+    KernelSysfsIo io(dir.path());
+    Result reopened;
+    Result cached;
+    if (!toggleThroughController(&io, false, iterations, &reopened)
+            || !toggleThroughController(&io, true, iterations, &cached)) {
+        printSkipped(out, io.name(), "toggle", "引脚导出失败");
+        return;
+    }
+
+    printResult(out, io.name(), "reopen", reopened);
+    printResult(out, io.name(), "cached", cached);
+    if (cached.totalNs > 0 && percentileUs(cached.latencies, 0.99) > 0.0) {
+        out << QString("缓存fd相对逐次打开：翻转速率%1倍，p99延迟%2倍\n")
+               .arg(double(reopened.totalNs) / cached.totalNs, 0, 'f', 1)
+               .arg(percentileUs(reopened.latencies, 0.99) / percentileUs(cached.latencies, 0.99), 0, 'f', 1);
+        out.flush();
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("sysfs_backend_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("比较各sysfs后端上保温帘、水泵与PWM操作的吞吐与尾延迟");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "每组操作次数（默认2000）", "n", "2000");
+    QCommandLineOption latencyOption("latency-ns", "memory后端每次读写附加的延迟（纳秒）", "ns", "0");
+    QCommandLineOption failureOption("failure-rate", "memory后端写入失败概率（0-1）", "p", "0");
+    QCommandLineOption kernelOption("kernel", "同时测试真实sysfs（会驱动实际的电机、水泵与补光灯）");
+    QCommandLineOption verboseOption("verbose", "输出控制器调试日志");
+    parser.addOption(iterationsOption);
+    parser.addOption(latencyOption);
+    parser.addOption(failureOption);
+    parser.addOption(kernelOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const qint64 latencyNs = qMax<qint64>(0, parser.value(latencyOption).toLongLong());
+    const double failureRate = qBound(0.0, parser.value(failureOption).toDouble(), 1.0);
+
+    // 逐次操作的调试日志会主导计时结果
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("default.debug=false");
+    }
+
+    // 保温帘位置等文件写入测试专用目录，不影响实际数据
+    QStandardPaths::setTestModeEnabled(true);
+
+    QTextStream out(stdout);
+    out << QString("每组%1次操作，memory后端附加延迟%2ns、写入失败概率%3\n\n")
+           .arg(iterations).arg(latencyNs).arg(failureRate);
+    printHeader(out);
+
+    if (parser.isSet(kernelOption)) {
+        KernelSysfsIo kernel;
+        runBackend(out, kernel.name(), &kernel, iterations);
+    }
+
+    QTemporaryDir mirrorDir(tmpfsTemplate("sysfs-bench"));
+    if (mirrorDir.isValid()) {
+        MirroredSysfsIo mirrored(mirrorDir.path());
+        runBackend(out, mirrored.name(), &mirrored, iterations);
+    } else {
+        printSkipped(out, "tmpfs", "*", "无法创建临时目录");
+    }
+
+    MemorySysfsIo memory;
+    memory.setLatency(MemorySysfsIo::ReadOperation, latencyNs);
+    memory.setLatency(MemorySysfsIo::WriteOperation, latencyNs);
+    Injection injection;
+    injection.memory = &memory;
+    injection.failureRate = failureRate;
+    runBackend(out, memory.name(), &memory, iterations, injection);
+
+    out << "\n";
+    runToggleComparison(out, iterations);
+    return 0;
+}
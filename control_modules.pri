@@ -0,0 +1,51 @@
+# 硬件控制与执行器模块：主程序、tests/与benchmarks/共用，新增或删除这些模块的源文件只改这里
+INCLUDEPATH += $$PWD/include
+
+SOURCES += \
+    $$PWD/src/hardware/pwm_controller.cpp \
+    $$PWD/src/hardware/pwm_channel_pool.cpp \
+    $$PWD/src/hardware/gpio_controller.cpp \
+    $$PWD/src/hardware/gpio_chardev.cpp \
+    $$PWD/src/hardware/gpio_line_io.cpp \
+    $$PWD/src/hardware/gpio_mmio.cpp \
+    $$PWD/src/hardware/gpio_event_monitor.cpp \
+    $$PWD/src/hardware/sysfs_io.cpp \
+    $$PWD/src/hardware/flow_meter.cpp \
+    $$PWD/src/hardware/pump_scheduler.cpp \
+    $$PWD/src/hardware/power_budget_scheduler.cpp \
+    $$PWD/src/hardware/motion_profile.cpp \
+    $$PWD/src/hardware/stepper_pulse_generator.cpp \
+    $$PWD/src/hardware/serial_stepper_bus.cpp \
+    $$PWD/src/hardware/serial_stepper_emulator.cpp \
+    $$PWD/src/device/curtain_actuator.cpp \
+    $$PWD/src/device/curtain_controller.cpp \
+    $$PWD/src/device/curtain_position.cpp \
+    $$PWD/src/device/curtain_travel_calibrator.cpp \
+    $$PWD/src/device/curtain_command_queue.cpp \
+    $$PWD/src/device/curtain_state_machine.cpp \
+    $$PWD/src/system/state_journal.cpp
+
+HEADERS += \
+    $$PWD/include/hardware/pwm_controller.h \
+    $$PWD/include/hardware/pwm_channel_pool.h \
+    $$PWD/include/hardware/gpio_controller.h \
+    $$PWD/include/hardware/gpio_chardev.h \
+    $$PWD/include/hardware/gpio_line_io.h \
+    $$PWD/include/hardware/gpio_mmio.h \
+    $$PWD/include/hardware/gpio_event_monitor.h \
+    $$PWD/include/hardware/sysfs_io.h \
+    $$PWD/include/hardware/flow_meter.h \
+    $$PWD/include/hardware/pump_scheduler.h \
+    $$PWD/include/hardware/power_budget_scheduler.h \
+    $$PWD/include/hardware/motion_profile.h \
+    $$PWD/include/hardware/stepper_pulse_generator.h \
+    $$PWD/include/hardware/serial_stepper_bus.h \
+    $$PWD/include/hardware/serial_stepper_emulator.h \
+    $$PWD/include/device/curtain_actuator.h \
+    $$PWD/include/device/curtain_controller.h \
+    $$PWD/include/device/curtain_position.h \
+    $$PWD/include/device/curtain_travel_calibrator.h \
+    $$PWD/include/device/curtain_command_queue.h \
+    $$PWD/include/device/curtain_state_machine.h \
+    $$PWD/include/system/state_journal.h \
+    $$PWD/include/config/gpio_config.h
@@ -4,8 +4,10 @@
 #include <QObject>
 #include <QTimer>
 
+#include "device/curtain_controller.h"
+#include "device/curtain_command_queue.h"
+
 // 前向声明
-class CurtainController;
 class GY30LightSensor;
 
 /**
@@ -54,6 +56,7 @@ public:
     // 配置参数
     void setLightThresholds(float openThreshold, float closeThreshold);
     void setOperationDuration(int seconds);
+    void setPositionTargets(double openPercent, double closePercent); // 开帘/关帘时的目标开度
 
 signals:
     void stateChanged(DecisionState state);           // 状态改变信号
@@ -65,6 +68,8 @@ signals:
 private slots:
     void onLightValueChanged(float lux);              // 光照值变化处理
     void onOperationTimeout();                        // 操作超时处理
+    void onCommandFinished(quint64 id, CurtainController::CurtainType type,
+                           CurtainCommandQueue::Result result); // 保温帘命令结束
 
 private:
     // 核心决策逻辑
@@ -89,6 +94,9 @@ private:
     float m_openThreshold;                            // 开帘光照阈值（默认500）
     float m_closeThreshold;                           // 关帘光照阈值（默认300）
     int m_operationDuration;                          // 操作持续时间（默认18秒）
+    double m_openPosition;                            // 开帘目标开度（默认100%）
+    double m_closePosition;                           // 关帘目标开度（默认0%）
+    quint64 m_commandId;                              // 当前保温帘命令编号
 
     // 防抖动
     float m_lastLightValue;                           // 上次光照值
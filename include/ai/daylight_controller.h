@@ -0,0 +1,126 @@
+#ifndef DAYLIGHT_CONTROLLER_H
+#define DAYLIGHT_CONTROLLER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+
+// 前向声明
+class PWMController;
+class GY30LightSensor;
+class DaylightLoopThread;
+
+/**
+ * @brief 补光闭环控制器（日光补偿）
+ *
+ * 按GY30测得的光照调节主通道补光灯占空比，使棚内光照保持在目标值：日光充足时灯自动调暗直至关闭。
+ * 控制线程以DAYLIGHT_LOOP_PERIOD_MS的固定周期（CLOCK_MONOTONIC timerfd）运行，不受界面线程阻塞影响；
+ * 每周期取最新光照样本执行PI(D)运算，输出以千分比在一个周期内线性渐变到新值。
+ * - 抗积分饱和：输出饱和且误差继续推向饱和方向时暂停积分，积分项限制在输出范围内
+ * - 微分项作用于测量值（仅在新样本到达时更新），修改目标值不产生冲击
+ * - 样本过期或为模拟数据时保持当前输出
+ * - 开启时以当前占空比初始化积分项，无扰切换
+ */
+class DaylightController : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 控制参数
+    struct Tuning {
+        double kp;             // ‰/lux
+        double ki;             // ‰/(lux·s)
+        double kd;             // ‰·s/lux
+        double deadbandLux;
+        int minPermille;
+        int maxPermille;
+
+        Tuning();              // DAYLIGHT_*默认值
+    };
+
+    // 回路统计
+    struct Statistics {
+        quint64 ticks;              // 控制周期数
+        quint64 overruns;           // 错过的周期（一次唤醒时定时器已多次到期）
+        quint64 staleTicks;         // 样本过期或为模拟数据而保持输出的周期
+        quint64 saturatedTicks;     // 输出饱和、积分暂停的周期
+        quint64 writeFailures;      // 占空比写入失败次数
+        qint64 maxJitterNs;         // 实际周期与设定周期之差的最大值
+        qint64 totalJitterNs;       // 累计值（平均值 = totalJitterNs / ticks）
+        qint64 maxComputeNs;        // 单周期运算与写入耗时最大值
+        double lastLux;             // 最近参与调节的光照
+        double lastErrorLux;        // 最近的误差（目标 - 测量）
+        double absErrorLuxSeconds;  // |误差|对时间的积分（平均误差 = absErrorLuxSeconds / regulatedSeconds）
+        double regulatedSeconds;    // 实际闭环调节的时长
+        double energyUsedWh;        // 闭环期间主通道补光灯耗电（按占空比线性估算）
+        double energySavedWh;       // 相对DAYLIGHT_BASELINE_PERMILLE固定占空比节省的电量
+        int outputPermille;         // 当前输出
+
+        Statistics() : ticks(0), overruns(0), staleTicks(0), saturatedTicks(0), writeFailures(0),
+                       maxJitterNs(0), totalJitterNs(0), maxComputeNs(0), lastLux(0.0), lastErrorLux(0.0),
+                       absErrorLuxSeconds(0.0), regulatedSeconds(0.0), energyUsedWh(0.0), energySavedWh(0.0),
+                       outputPermille(0) {}
+    };
+
+    explicit DaylightController(QObject *parent = nullptr);
+    ~DaylightController();
+
+    // 初始化和设置
+    void setPWMController(PWMController *controller); // 启动前调用，不接管所有权
+    void setLightSensor(GY30LightSensor *sensor);
+    bool start();                        // 启动控制线程
+    void stop();
+
+    // 状态控制（任意线程）
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    void setTargetLux(double lux);
+    double targetLux() const;
+    void setTuning(const Tuning &tuning);
+    Tuning tuning() const;
+    void submitLux(float lux, bool simulated); // 光照样本（由传感器信号直接调用）
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+signals:
+    void enabledChanged(bool enabled);
+    void loopUpdated(double lux, double errorLux, int outputPermille); // 每次实际调节后发出（控制线程）
+    void errorOccurred(const QString &error);
+
+private:
+    friend class DaylightLoopThread;
+
+    void runLoop();                      // 控制线程
+    void tick(qint64 nowNs, quint64 expirations);
+
+    PWMController *m_pwmController;      // 主通道（不拥有）
+    DaylightLoopThread *m_thread;
+    int m_timerFd;                       // CLOCK_MONOTONIC timerfd，周期触发
+    int m_wakeFd;                        // eventfd，退出时唤醒
+    QAtomicInt m_stopping;
+
+    // 以下成员由m_mutex保护
+    bool m_enabled;
+    quint64 m_enabledSeq;                // setEnabled每次切换加一，周期内据此判断快照后是否被关闭或重开
+    double m_targetLux;
+    Tuning m_tuning;
+    float m_sampleLux;
+    bool m_sampleSimulated;
+    qint64 m_sampleNs;                   // 样本到达时刻（0为尚无样本）
+    quint64 m_sampleSeq;
+    bool m_resetState;                   // 开启后下一周期重新初始化积分项
+    Statistics m_stats;
+    mutable QMutex m_mutex;
+
+    // 控制线程私有状态
+    double m_integral;                   // 积分项（‰）
+    double m_lastLux;                    // 上次样本，用于测量值微分
+    double m_derivative;                 // 测量值变化率（lux/s），新样本到达时更新
+    qint64 m_lastSampleNs;
+    quint64 m_lastSeq;
+    qint64 m_lastTickNs;
+    int m_output;                        // 当前输出（‰）
+};
+
+#endif // DAYLIGHT_CONTROLLER_H
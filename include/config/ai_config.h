@@ -10,8 +10,27 @@
 // 操作时间配置
 #define AI_OPERATION_DURATION     18        // 操作持续时间（秒）
 #define AI_DEBOUNCE_INTERVAL      2         // 防抖动间隔（秒）
+#define AI_OPERATION_MARGIN_MS    2000      // 行程已标定时，操作时间为预计行程时间加此余量（毫秒）
+
+// 目标开度配置（百分比，可设为部分遮光）
+#define AI_OPEN_POSITION_PERCENT   100.0    // 强光时上帘开度
+#define AI_CLOSE_POSITION_PERCENT  0.0      // 弱光时上帘开度
 
 // 默认状态配置
 #define AI_DEFAULT_STATE          false     // 重启默认状态（关闭）
 
+// 补光闭环配置（按GY30光照调节主通道补光灯，日光充足时自动调暗）
+#define DAYLIGHT_DEFAULT_ENABLED     false     // 重启默认状态（关闭，由云端指令开启）
+#define DAYLIGHT_TARGET_LUX          800.0     // 默认目标光照（lux）
+#define DAYLIGHT_LOOP_PERIOD_MS      500       // 控制周期（独立线程固定频率）
+#define DAYLIGHT_SAMPLE_TIMEOUT_MS   6000      // 光照样本超过该时间未更新时保持输出（GY30每2秒采样）
+#define DAYLIGHT_KP                  0.2       // 比例增益（‰/lux）
+#define DAYLIGHT_KI                  0.05      // 积分增益（‰/(lux·s)）
+#define DAYLIGHT_KD                  0.0       // 微分增益（‰·s/lux），作用于测量值，避免改目标时突跳
+#define DAYLIGHT_DEADBAND_LUX        10.0      // 误差死区，目标附近不再微调
+#define DAYLIGHT_MIN_PERMILLE        0         // 输出下限（‰）
+#define DAYLIGHT_MAX_PERMILLE        1000      // 输出上限（‰）
+#define DAYLIGHT_LAMP_POWER_W        200.0     // 主通道灯串满功率（瓦），按占空比线性估算耗电
+#define DAYLIGHT_BASELINE_PERMILLE   1000      // 节能基准：不启用闭环时补光灯的固定占空比（‰）
+
 #endif // AI_CONFIG_H
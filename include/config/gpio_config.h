@@ -16,6 +16,40 @@
 #define SIDE_CURTAIN_ENABLE_PIN 105  // gpio3_b1 - 侧面帘使能控制
 #define SIDE_CURTAIN_ENABLE2_PIN 101 // gpio3_a5 - 侧面帘使能控制2（步进电机驱动板2）
 
+// 步进驱动STEP脉冲引脚（-1表示驱动板自带脉冲发生器，只由方向与使能控制；
+// 使用STEP/DIR驱动时填写引脚号，方向沿用DIR1引脚）
+#define TOP_CURTAIN_STEP_PIN    -1  // 上侧帘步进脉冲
+#define SIDE_CURTAIN_STEP_PIN   -1  // 侧面帘步进脉冲
+
+// 帘幕限位开关输入引脚（-1表示未安装，安装后填写引脚号，如 #define TOP_CURTAIN_OPEN_LIMIT_PIN 98）
+#define TOP_CURTAIN_OPEN_LIMIT_PIN    -1  // 上侧帘全开限位
+#define TOP_CURTAIN_CLOSE_LIMIT_PIN   -1  // 上侧帘全关限位
+#define SIDE_CURTAIN_OPEN_LIMIT_PIN   -1  // 侧面帘全开限位
+#define SIDE_CURTAIN_CLOSE_LIMIT_PIN  -1  // 侧面帘全关限位
+
+// RS-485智能步进驱动器站地址（-1表示不经串口总线；1-247时运动与停机命令经CURTAIN_SERIAL_DEVICE下发，
+// 不再输出STEP脉冲，方向引脚可不接）
+#define TOP_CURTAIN_SERIAL_ADDRESS    -1
+#define SIDE_CURTAIN_SERIAL_ADDRESS   -1
+
+// 帘幕/风口执行器配置表（CurtainController按下标驱动，下标0、1固定为顶部与侧部保温帘）
+// 每项：标识, 名称, 分组（逗号分隔）, DIR1, DIR2, 使能, 使能2, STEP, 全开限位, 全关限位, 串口站地址，-1表示未接
+// 应用数据目录下存在CURTAIN_ACTUATOR_FILE时以文件为准；新增STEP引脚需同时加入GPIO_FAST_PINS
+#define CURTAIN_ACTUATORS { \
+    { "top",  "顶部保温帘", "roof", \
+      TOP_CURTAIN_DIR1_PIN, TOP_CURTAIN_DIR2_PIN, TOP_CURTAIN_ENABLE_PIN, TOP_CURTAIN_ENABLE2_PIN, \
+      TOP_CURTAIN_STEP_PIN, TOP_CURTAIN_OPEN_LIMIT_PIN, TOP_CURTAIN_CLOSE_LIMIT_PIN, TOP_CURTAIN_SERIAL_ADDRESS }, \
+    { "side", "侧部保温帘", "side", \
+      SIDE_CURTAIN_DIR1_PIN, SIDE_CURTAIN_DIR2_PIN, SIDE_CURTAIN_ENABLE_PIN, SIDE_CURTAIN_ENABLE2_PIN, \
+      SIDE_CURTAIN_STEP_PIN, SIDE_CURTAIN_OPEN_LIMIT_PIN, SIDE_CURTAIN_CLOSE_LIMIT_PIN, SIDE_CURTAIN_SERIAL_ADDRESS } \
+}
+#define CURTAIN_ACTUATOR_FILE  "curtain_actuators.json" // 执行器配置文件（应用数据目录下）
+#define CURTAIN_MAX_COUNT      16                       // 执行器数量上限
+
+// 流量计脉冲输入引脚（-1表示未安装）
+#define PUMP_FLOW_METER_PIN          -1  // 水泵出水管霍尔流量计
+#define FERTILIZER_FLOW_METER_PIN    -1  // 施药泵管路霍尔流量计
+
 // 3.3C引脚不够用，GPIO3_B6配置为常高电平
 #define POWER_SUPPLY_PIN        110  // gpio3_b6 - 3.3V电源输出
 
@@ -33,9 +67,143 @@
 #define CURTAIN_ENABLE   GPIO_LOW   // 低电平使能运行
 #define CURTAIN_DISABLE  GPIO_HIGH  // 高电平暂停
 
+// 限位开关定义
+#define CURTAIN_LIMIT_ACTIVE       GPIO_LOW  // 限位开关常开接地，触发时为低电平
+#define CURTAIN_LIMIT_DEBOUNCE_US  5000      // 限位开关去抖时间（微秒）
+#define CURTAIN_TRAVEL_TIMEOUT_MS  120000    // 安装限位开关时的最大行程时间（毫秒）
+
+// 保温帘位置估计
+#define CURTAIN_FULL_TRAVEL_MS              18000  // 全行程运行时间（未配置步进全行程步数时按时间推算位置）
+#define CURTAIN_END_OVERRUN_PERCENT         10     // 无限位开关时全开/全关多运行的行程比例，确保到达终点
+#define CURTAIN_POSITION_TOLERANCE_PERCENT  1.0    // 与目标开度相差不超过该值时不再运动
+#define CURTAIN_POSITION_FILE               "curtain_position.json" // 位置持久化文件（应用数据目录下）
+#define CURTAIN_REVERSAL_DWELL_MS           500    // 运动中换向时停机等待时间（毫秒），其间的命令合并为最后一个
+
+// 行程在线标定（安装限位开关的帘幕，每次限位到限位的完整运动学习一次全行程时间与步数）
+#define CURTAIN_CALIBRATION_FILE            "curtain_calibration.json" // 标定模型持久化文件（应用数据目录下）
+#define CURTAIN_CALIBRATION_ALPHA           0.3    // 指数加权系数（新样本权重），前几个样本按样本数平均以加快收敛
+#define CURTAIN_CALIBRATION_MIN_SAMPLES     3      // 达到该样本数后启用离群样本剔除
+#define CURTAIN_CALIBRATION_MAX_DEVIATION   0.3    // 与模型偏差超过该比例的样本视为卡滞或打滑，不参与学习
+#define CURTAIN_CALIBRATION_RELEARN_OUTLIERS 3    // 连续该数量的同向离群样本视为持久变化（更换电机、减速比或帘布），以其均值重建模型
+
+// 执行器状态日志（保温帘位置、泵运行截止时刻、补光灯占空比；进程重启后恢复）
+#define STATE_JOURNAL_FILE                  "actuator_state.journal" // 追加写日志文件（应用数据目录下）
+#define STATE_JOURNAL_SYNC_MS               200    // 首条未落盘记录后等待该时间批量fdatasync
+#define STATE_JOURNAL_COMPACT_RECORDS       4096   // 自上次压缩起追加的记录数达到该值时压缩为快照
+
 // GPIO操作路径
 #define GPIO_BASE_PATH "/sys/class/gpio"
 #define GPIO_EXPORT_PATH "/sys/class/gpio/export"
 #define GPIO_UNEXPORT_PATH "/sys/class/gpio/unexport"
 
+// PWM操作路径
+#define PWM_CLASS_PATH "/sys/class/pwm"
+
+// 补光灯PWM通道表（PwmChannelPool按(芯片, 通道)管理；第一项为主通道，对应亮度滑块与云端pwm属性）
+// 每项：标识, 名称, PWM芯片号(pwmchipN), 通道号(pwmM), 周期(ns), 反相极性(0/1)
+// 主通道以外的通道初始化失败（如该棚未接对应灯串）只告警，不影响其余通道
+#define PWM_CHANNELS { \
+    { "white", "白光", 0, 0, 1000000, 0 }, \
+    { "red",   "红光", 1, 0, 1000000, 0 }, \
+    { "blue",  "蓝光", 2, 0, 1000000, 0 } \
+}
+
+// 光谱配方：标识, 名称, 各通道占空比（"通道标识:百分比"，逗号分隔；未列出或不可用的通道保持不变）
+#define PWM_RECIPES { \
+    { "seedling",   "育苗",     "white:40,red:30,blue:60" }, \
+    { "vegetative", "营养生长", "white:60,red:50,blue:70" }, \
+    { "flowering",  "开花结果", "white:50,red:90,blue:30" }, \
+    { "off",        "关闭",     "white:0,red:0,blue:0" } \
+}
+#define PWM_RECIPE_FADE_MS      3000   // 云端切换配方未指定pwmFadeMs时的渐变时间（毫秒）
+
+// 补光灯渐变
+#define PWM_FADE_RATE_HZ        100    // 渐变期间占空比更新频率
+#define PWM_FADE_DEFAULT_MS     800    // 云端指令未指定pwmFadeMs时的渐变时间（毫秒）
+#define PWM_SLIDER_FADE_MS      150    // 亮度滑块的渐变时间（毫秒），拖动中不断改向新位置
+
+// sysfs访问后端选择（GPIOController/PWMController可通过setSysfsIo替换）
+#define SYSFS_IO_KERNEL   0  // 真实sysfs
+#define SYSFS_IO_MIRROR   1  // tmpfs镜像树（无硬件的开发机）
+#define SYSFS_IO_MEMORY   2  // 纯内存（可注入延迟与失败）
+#define SYSFS_IO_BACKEND  SYSFS_IO_KERNEL
+#define SYSFS_MIRROR_ROOT "/dev/shm/greenhouse-sysfs"  // 镜像树根目录
+
+// GPIO字符设备(v2 uAPI)配置
+#define GPIO_CHIP_DEV_PREFIX   "/dev/gpiochip"  // 字符设备路径前缀
+#define GPIO_LINES_PER_CHIP    32               // RK3588每个GPIO控制器32条线路
+#define GPIO_CHARDEV_CONSUMER  "greenhouse"     // 线路请求的使用者标签
+
+// GPIO后端选择（运行时可通过GPIOController::setBackend切换）
+#define GPIO_BACKEND_SYSFS     0  // sysfs接口
+#define GPIO_BACKEND_CHARDEV   1  // 字符设备接口
+#define GPIO_DEFAULT_BACKEND   GPIO_BACKEND_SYSFS
+
+// 流量计定义
+#define FLOW_METER_PULSES_PER_LITRE     450.0  // 每升脉冲数（YF-S201: F = 7.5 * Q(L/min)）
+#define FLOW_METER_PUBLISH_INTERVAL_MS  1000   // 流量与累计体积发布间隔（毫秒）
+#define FLOW_METER_DEBOUNCE_US          0      // 霍尔输出无抖动，不去抖
+#define GPIO_PULSE_EVENT_BUFFER_SIZE    256    // 计数线路的内核事件缓冲大小（事件数）
+
+// 泵定时调度线程的SCHED_FIFO优先级（1-99，无权限时退回普通调度）
+#define PUMP_SCHEDULER_RT_PRIORITY      50
+
+// 步进脉冲发生器
+#define STEPPER_RT_PRIORITY             80     // 脉冲线程SCHED_FIFO优先级，高于泵调度
+#define STEPPER_MAX_STEPS_PER_SECOND    20000  // 允许的最高步频
+#define STEPPER_DIR_SETUP_US            20     // 方向建立到首个脉冲的间隔（微秒）
+#define STEPPER_DEADLINE_MISS_US        50     // 边沿晚于计划超过该值记为错过截止期（微秒）
+#define CURTAIN_STEPPER_STEPS_PER_SECOND 800   // 保温帘电机步频
+#define CURTAIN_TRAVEL_STEPS            0      // 全行程步数，0为持续运行直到限位、暂停或行程超时
+
+// 加减速曲线（步进脉冲发生器按步查表，热循环中不做运算）
+#define MOTION_PROFILE_TRAPEZOID        0      // 匀加速（梯形速度曲线）
+#define MOTION_PROFILE_SCURVE           1      // 起止加速度为零（S形速度曲线）
+#define MOTION_RAMP_STEPS               200    // 加速段步数（减速段对称）
+#define MOTION_RAMP_START_SPS           100    // 起步与停止步频
+#define MOTION_RAMP_COMMON_SPEEDS       { 400, 800, 1600 } // 编译期生成加速表的步频，其它步频首次使用时生成
+#define CURTAIN_MOTION_PROFILE          MOTION_PROFILE_SCURVE
+
+// RS-485步进驱动器串口总线（帧格式见serial_stepper_bus.h）
+#define CURTAIN_SERIAL_DEVICE           "/dev/ttyS4"
+#define CURTAIN_SERIAL_BAUD             115200
+#define CURTAIN_SERIAL_RS485_RTS        1      // 由串口驱动按RTS切换收发方向（TIOCSRS485，不支持时忽略）
+#define CURTAIN_SERIAL_TIMEOUT_MS       50     // 单次请求应答超时
+#define CURTAIN_SERIAL_RETRIES          2      // 超时重发次数（同一序号，驱动器按序号去重）
+#define CURTAIN_SERIAL_MAX_OUTSTANDING  4      // 总线上同时等待应答的请求数
+#define CURTAIN_SERIAL_EMULATE          0      // 1为连接伪终端上的仿真驱动器（无硬件联调）
+
+// 24V电源供电预算（保温帘电机与水泵、施药泵共用），电流单位mA
+#define POWER_BUDGET_MA                 6000   // 允许的估计总电流
+#define POWER_BUDGET_RETRY_MS           200    // 余量不足且无确定释放时刻时，泵定时任务的重试间隔
+#define CURTAIN_MOTOR_INRUSH_MA         3000   // 保温帘电机起动浪涌（执行器配置文件可逐个覆盖）
+#define CURTAIN_MOTOR_STEADY_MA         1200   // 保温帘电机稳态电流
+#define CURTAIN_MOTOR_INRUSH_MS         500    // 保温帘电机浪涌持续时间
+#define PUMP_INRUSH_MA                  4500   // 水泵起动浪涌
+#define PUMP_STEADY_MA                  1500
+#define PUMP_INRUSH_MS                  800
+#define FERTILIZER_PUMP_INRUSH_MA       1500   // 施药泵起动浪涌
+#define FERTILIZER_PUMP_STEADY_MA       600
+#define FERTILIZER_PUMP_INRUSH_MS       300
+
+// 输入线路启用内部上拉（仅字符设备后端，sysfs后端依赖外部上拉）
+#define GPIO_INPUT_BIAS_PULL_UP 1
+
+// RK3588 GPIO控制器寄存器（mmap直接访问，仅用于GPIO_FAST_PINS中的引脚）
+#define GPIO_MMIO_SOURCE        "/dev/mem"  // 映射源，可指向普通文件（各bank按页依次排列）用于测试
+#define GPIO_MMIO_BANK_COUNT    5
+#define GPIO_MMIO_BANK_BASES    { 0xFD8A0000, 0xFEC20000, 0xFEC30000, 0xFEC40000, 0xFEC50000 } // GPIO0-GPIO4物理基址
+#define GPIO_MMIO_SWPORT_DR_L   0x00  // 数据寄存器（线路0-15），高16位为写使能掩码
+#define GPIO_MMIO_SWPORT_DR_H   0x04  // 数据寄存器（线路16-31）
+#define GPIO_MMIO_SWPORT_DDR_L  0x08  // 方向寄存器（线路0-15），1为输出
+#define GPIO_MMIO_SWPORT_DDR_H  0x0C  // 方向寄存器（线路16-31）
+#define GPIO_MMIO_EXT_PORT      0x70  // 外部端口电平（只读）
+
+// 寄存器直接访问的引脚（步进脉冲等高频输出），仍通过sysfs/字符设备导出并设置复用，
+// 电平写入改为单次寄存器存储。-1为占位，不对应任何引脚
+#define GPIO_FAST_PINS          { TOP_CURTAIN_STEP_PIN, SIDE_CURTAIN_STEP_PIN }
+
+// 输出影子寄存器后台校验间隔（毫秒）
+#define GPIO_SHADOW_VERIFY_INTERVAL_MS 5000
+
 #endif // GPIO_CONFIG_H
@@ -9,7 +9,10 @@
 class QTimer;
 class UIManager;
 class PWMController;
+class PwmChannelPool;
 class GPIOController;
+class PumpScheduler;
+class PowerBudgetScheduler;
 class CurtainController;
 class YOLOv8Integration;
 class WeatherService;
@@ -18,6 +21,9 @@ class WindowManager;
 class AHT20Sensor;
 class GY30LightSensor;
 class AIDecisionManager;
+class DaylightController;
+class BringUpCoordinator;
+class StateJournal;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -61,8 +67,11 @@ private:
 
     // 功能模块管理器
     UIManager *m_uiManager;           // UI界面管理
-    PWMController *m_pwmController;   // PWM补光灯控制
+    PwmChannelPool *m_pwmPool;        // 补光灯PWM通道池（红、蓝、白光灯串）
+    PWMController *m_pwmController;   // 主通道（亮度滑块），属于m_pwmPool
     GPIOController *m_gpioController; // GPIO控制器
+    PumpScheduler *m_pumpScheduler;   // 泵定时运行调度
+    PowerBudgetScheduler *m_powerScheduler; // 执行器供电预算（错开电机与水泵起动）
     CurtainController *m_curtainController; // 保温帘控制
     YOLOv8Integration *m_yoloIntegration;   // YOLOv8集成
     WeatherService *m_weatherService;       // 天气服务
@@ -71,6 +80,9 @@ private:
     AHT20Sensor *m_aht20Sensor;            // AHT20温湿度传感器
     GY30LightSensor *m_gy30Sensor;         // GY30光照传感器（I2C7）
     AIDecisionManager *m_aiDecisionManager; // AI智能决策管理器
+    DaylightController *m_daylightController; // 补光闭环（按光照自动调节主通道）
+    BringUpCoordinator *m_bringUp;          // 硬件启动协调（并行初始化）
+    StateJournal *m_stateJournal;           // 执行器状态日志（重启后恢复）
 };
 
 #endif // MAINWINDOW_H
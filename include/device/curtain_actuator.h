@@ -0,0 +1,64 @@
+#ifndef CURTAIN_ACTUATOR_H
+#define CURTAIN_ACTUATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief 帘幕/风口执行器引脚组（编译期配置表CURTAIN_ACTUATORS的一项）
+ */
+struct CurtainPinSet {
+    const char *key;        // 标识（位置持久化与配置文件使用）
+    const char *name;       // 显示名称
+    const char *groups;     // 所属分组，逗号分隔，如 "roof" 或 "west,side"
+    int dir1Pin;
+    int dir2Pin;
+    int enablePin;
+    int enable2Pin;         // 第二块驱动板使能，-1为无
+    int stepPin;            // STEP脉冲，-1为驱动板自带脉冲发生器
+    int openLimitPin;       // 全开限位，-1为未安装
+    int closeLimitPin;      // 全关限位，-1为未安装
+    int serialAddress;      // RS-485驱动器站地址，-1为不经串口总线
+};
+
+/**
+ * @brief 帘幕/风口执行器配置
+ *
+ * 默认取自gpio_config.h中的CURTAIN_ACTUATORS；应用数据目录下存在CURTAIN_ACTUATOR_FILE时
+ * 以文件为准（格式见load()），便于不同规模的温室不改代码即可增减帘幕与风口。
+ * 下标即CurtainController::CurtainType。
+ */
+struct CurtainActuator {
+    QString key;
+    QString name;
+    QStringList groups;
+    int dir1Pin;
+    int dir2Pin;
+    int enablePin;
+    int enable2Pin;
+    int stepPin;
+    int openLimitPin;
+    int closeLimitPin;
+    int serialAddress;
+    int inrushMa;           // 电机起动浪涌电流（供电预算，默认CURTAIN_MOTOR_INRUSH_MA）
+    int steadyMa;           // 电机稳态电流
+    int inrushMs;           // 浪涌持续时间
+
+    CurtainActuator();
+    explicit CurtainActuator(const CurtainPinSet &pins);
+
+    int limitPin(bool open) const { return open ? openLimitPin : closeLimitPin; }
+    bool inGroup(const QString &group) const;   // "all"匹配所有执行器
+    bool isSerial() const { return serialAddress >= 0; }
+
+    static QVector<CurtainActuator> defaults();
+    // 读取配置文件：{"curtains": [{"key": "top", "name": "...", "groups": ["roof"],
+    //   "dir1": 116, "dir2": 139, "enable": 99, "enable2": 96, "step": -1, "openLimit": -1, "closeLimit": -1,
+    //   "serialAddress": -1, "inrushMa": 3000, "steadyMa": 1200, "inrushMs": 500}]}（站地址与电流字段可省略；
+    //   经串口总线驱动时方向引脚可省略）
+    // 文件不存在或无效时返回默认配置，error中给出原因
+    static QVector<CurtainActuator> load(const QString &path, QString *error = nullptr);
+};
+
+#endif // CURTAIN_ACTUATOR_H
@@ -0,0 +1,113 @@
+#ifndef CURTAIN_COMMAND_QUEUE_H
+#define CURTAIN_COMMAND_QUEUE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+
+#include "device/curtain_controller.h"
+
+class QTimer;
+
+/**
+ * @brief 保温帘命令队列（每个帘幕一条通道，仅在GUI线程使用）
+ *
+ * 界面、AI决策与云端的开/关/开度/暂停命令统一经此提交：
+ * - 每条通道最多一个执行中命令和一个待执行命令，新命令覆盖待执行命令（后者以Superseded结束）；
+ * - 与执行中命令目标相同的命令并入执行中命令，随其一起结束；
+ * - 暂停立即停止当前运动并丢弃待执行命令；
+ * - 同方向的新目标直接抢占（原命令以Preempted结束）；反向时先停机，
+ *   等待CURTAIN_REVERSAL_DWELL_MS后再启动，其间到达的命令继续合并，避免频繁换向。
+ * 分组命令（submitGroup）按成员逐条入队，可同时启动的成员合并为一次控制器调用，
+ * 方向与使能在同一GPIO事务中切换。
+ * 每个命令以commandFinished(id, ...)报告结果，信号总在submit()返回后发出。
+ */
+class CurtainCommandQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Action {
+        Open,       // 全开
+        Close,      // 全关
+        MoveTo,     // 运动到指定开度
+        Pause       // 暂停
+    };
+
+    enum Result {
+        Completed,  // 已执行完成（或已在目标位置）
+        Superseded, // 执行前被更新的命令覆盖
+        Preempted,  // 执行中被新命令抢占
+        Cancelled,  // 被cancel()取消
+        Failed      // 执行失败或运动出错
+    };
+
+    // 通道统计
+    struct Statistics {
+        quint64 submitted;   // 提交的命令数
+        quint64 executed;    // 实际下发到控制器的命令数
+        quint64 coalesced;   // 并入执行中命令的数目
+        quint64 superseded;
+        quint64 preempted;
+        quint64 failed;
+        quint64 reversals;   // 运动中换向次数
+
+        Statistics() : submitted(0), executed(0), coalesced(0), superseded(0),
+                       preempted(0), failed(0), reversals(0) {}
+    };
+
+    explicit CurtainCommandQueue(CurtainController *controller, QObject *parent = nullptr);
+
+    quint64 submit(CurtainController::CurtainType type, Action action, double percent = 0.0,
+                   const QString &source = QString());   // 返回命令编号，编号无效时返回0
+    QList<quint64> submitGroup(const QString &group, Action action, double percent = 0.0,
+                               const QString &source = QString()); // 分组内每个执行器一个命令编号
+    bool cancel(quint64 id);                              // 取消待执行或执行中的命令
+    bool isIdle(CurtainController::CurtainType type) const;
+    void setReversalDwellMs(int dwellMs);                 // 换向停机等待，默认CURTAIN_REVERSAL_DWELL_MS
+    Statistics statistics(CurtainController::CurtainType type) const;
+
+signals:
+    void commandFinished(quint64 id, CurtainController::CurtainType type, CurtainCommandQueue::Result result);
+
+private slots:
+    void onCurtainStateChanged(CurtainController::CurtainType type, CurtainController::CurtainState state);
+
+private:
+    struct Command {
+        quint64 id;
+        Action action;
+        double target;           // 目标开度（暂停时无意义）
+        QString source;
+        QList<quint64> merged;   // 并入本命令的其它命令编号
+    };
+
+    struct Lane {
+        bool hasActive;
+        bool hasPending;
+        Command active;
+        Command pending;
+        int direction;           // 执行中命令的运动方向：1打开，-1关闭，0未运动
+        QTimer *dwellTimer;      // 换向停机等待
+        Statistics stats;
+    };
+
+    Lane &laneOf(CurtainController::CurtainType type);
+    Command makeCommand(CurtainController::CurtainType type, Action action, double percent, const QString &source);
+    void pauseLanes(const QList<CurtainController::CurtainType> &types, const QList<Command> &commands);
+    bool enqueue(CurtainController::CurtainType type, const Command &command); // 需要下发时返回true
+    void dispatch(const QList<CurtainController::CurtainType> &types);
+    void start(const QList<CurtainController::CurtainType> &types);
+    void finishActive(CurtainController::CurtainType type, Result result);
+    void finish(CurtainController::CurtainType type, const Command &command, Result result);
+    int directionOf(CurtainController::CurtainType type, const Command &command) const;
+
+    CurtainController *m_controller;
+    QVector<Lane> m_lanes;       // 下标即执行器编号
+    quint64 m_nextId;
+    int m_reversalDwellMs;
+    bool m_dispatching;          // 下发命令期间忽略控制器的同步状态信号
+};
+
+#endif // CURTAIN_COMMAND_QUEUE_H
@@ -3,25 +3,43 @@
 
 #include <QObject>
 #include <QString>
+#include <QList>
+#include <QVector>
+#include <QAtomicInt>
+
+#include "device/curtain_actuator.h"
+#include "device/curtain_position.h"
+#include "device/curtain_state_machine.h"
+#include "device/curtain_travel_calibrator.h"
 
 // 前向声明
 class GPIOController;
+class StepperPulseGenerator;
+class CurtainCommandQueue;
+class PowerBudgetScheduler;
+class StateJournal;
+class SerialStepperBus;
+class SerialStepperEmulator;
+class QTimer;
 
 /**
  * @brief 保温帘控制器
  *
- * 负责管理顶部和侧部保温帘的控制
- * 支持步进电机控制和状态监控
+ * 负责管理保温帘与风口执行器的控制，执行器按配置表（CurtainActuator）描述，
+ * 数量不限于顶部和侧部两幅；所有执行器走同一套控制路径。
+ * 支持步进电机控制、状态监控，以及按分组一次GPIO事务同时启停多个执行器。
+ * 配置了串口站地址的执行器由RS-485智能驱动器运行，运动与停机命令经SerialStepperBus异步下发
  */
 class CurtainController : public QObject
 {
     Q_OBJECT
 
 public:
-    // 保温帘类型枚举
-    enum CurtainType {
-        TopCurtain,    // 顶部保温帘
-        SideCurtain    // 侧部保温帘
+    // 保温帘编号，即执行器配置表下标
+    typedef int CurtainType;
+    enum {
+        TopCurtain = 0,    // 顶部保温帘
+        SideCurtain = 1    // 侧部保温帘
     };
 
     // 保温帘状态枚举
@@ -44,51 +62,146 @@ public:
     bool pauseCurtain(CurtainType type);  // 暂停保温帘运动
     bool resumeCurtain(CurtainType type); // 恢复保温帘运动
     void stopCurtain(CurtainType type);   // 停止保温帘运动
+    bool setCurtainPosition(CurtainType type, double percent); // 运动到指定开度（0全关，100全开）
 
-    // GPIO控制接口
-    bool openTopCurtain();                // 上侧帘打开
-    bool closeTopCurtain();               // 上侧帘关闭
-    bool pauseTopCurtain();               // 上侧帘暂停
-    bool openSideCurtain();               // 侧面帘打开
-    bool closeSideCurtain();              // 侧面帘关闭
-    bool pauseSideCurtain();              // 侧面帘暂停
+    // 多执行器接口：方向与使能在一次GPIO事务中切换，failed返回未能启动的执行器
+    bool moveCurtains(const QList<CurtainType> &types, double percent, QList<CurtainType> *failed = nullptr);
+    bool pauseCurtains(const QList<CurtainType> &types);
+    bool setGroupPosition(const QString &group, double percent); // 分组运动到指定开度，如 ("west", 0)
+    bool pauseGroup(const QString &group);
 
     // 初始化和设置
     bool initialize();                    // 初始化GPIO控制器
+    void shutdown();                      // 停止脉冲线程与串口总线，须在GPIO控制器销毁前调用（可重复调用）
     void setGPIOController(GPIOController *controller); // 设置GPIO控制器
+    void setPowerScheduler(PowerBudgetScheduler *scheduler); // 电机通电前申请供电余量（以使能引脚登记负载）
+    void setStateJournal(StateJournal *journal); // 位置改为写入状态日志并从中恢复（初始化前调用）
+
+    // 执行器配置
+    int curtainCount() const { return m_channels.size(); }
+    bool isValidCurtain(CurtainType type) const { return type >= 0 && type < m_channels.size(); }
+    QString curtainName(CurtainType type) const;
+    QList<CurtainType> curtainsInGroup(const QString &group) const; // "all"为全部执行器
 
     // 状态查询
     CurtainState getCurtainState(CurtainType type) const;
+    double getCurtainPosition(CurtainType type) const;        // 当前估计开度（百分比）
+    bool isPositionCalibrated(CurtainType type) const;        // 自到达终点以来位置是否可信
+    bool isCurtainMoving(CurtainType type) const;             // 运动中（含等待供电余量与换向停机等待）
+    int expectedTravelMs(CurtainType type, double percent) const; // 按标定模型预计运动到目标开度的时间，该方向未标定返回0
+    int calibrationSamples(CurtainType type, bool open) const;    // 行程标定样本数
+
+    // 命令队列：界面、AI与云端的命令经此合并与抢占，避免并发调用相互竞争
+    CurtainCommandQueue *commandQueue() const { return m_commandQueue; }
+    SerialStepperBus *serialBus() const { return m_serialBus; } // 未配置串口驱动器时为nullptr
     QString getStatusString() const;      // 获取状态字符串
     void updateStatus();                  // 更新状态
 
 signals:
     void curtainStateChanged(CurtainType type, CurtainState state); // 状态改变信号
+    void positionChanged(CurtainType type, double percent);         // 运动结束后开度更新
+    void travelCalibrated(CurtainType type, bool open, int fullTravelMs, double errorPercent); // 行程模型更新（errorPercent为原模型的终点误差）
     void statusUpdated(const QString &status); // 状态更新信号
     void errorOccurred(const QString &error);  // 错误信号
 
-private slots:
-    void onOperationTimeout();           // 操作超时处理
-
 private:
-    // GPIO控制方法
-    bool setTopCurtainGPIO(bool dir1, bool dir2, bool enable);   // 设置上侧帘GPIO
-    bool setSideCurtainGPIO(bool dir1, bool dir2, bool enable);  // 设置侧面帘GPIO
-    bool setTopCurtainGPIOWithDual(bool dir1, bool dir2, bool enable); // 设置上侧帘GPIO（双使能引脚）
-    bool setSideCurtainGPIOWithDual(bool dir1, bool dir2, bool enable); // 设置侧面帘GPIO（双使能引脚）
-    bool initializeGPIOPins();                                   // 初始化GPIO引脚
+    // 单个执行器的配置与运行状态，按下标连续存放；
+    // 构造后不再增删，事件监视线程与脉冲线程只经const访问（避免QVector分离）
+    struct Channel {
+        CurtainActuator actuator;
+        mutable QAtomicInt motion;       // 运动方向：1打开，-1关闭，0停止（限位线程据此判断是否停机）
+        CurtainStateMachine machine;
+        CurtainPosition position;        // 位置估计
+        CurtainTravelCalibrator calibrator; // 行程在线标定
+        double target;                   // 目标开度
+        QTimer *travelTimer;             // 行程超时（仅安装限位开关时使用）
+        QTimer *positionTimer;           // 按时间推算的到位定时
+        QTimer *reversalTimer;           // 运动中反向时的停机等待，到期后运动到reversalTarget
+        double reversalTarget;           // 停机等待结束后的目标开度（等待期间的命令只更新目标）
+        quint64 powerTicket;             // 等待供电余量的申请编号
+        quint32 serialMove;              // 最近一次串口运动命令的请求编号
+        quint32 serialStop;              // 等待应答后关闭使能的减速停机请求编号
+
+        Channel(const CurtainActuator &config, qint64 fullTravelNs, quint64 fullTravelSteps);
+    };
+
+    // 一次运动的结束方式
+    struct Travel {
+        CurtainType type;
+        bool open;
+        quint64 steps;                   // 步进运动步数，0为持续运行
+        bool limitEnded;                 // 由限位结束
+        bool stepEnded;                  // 由脉冲发生器按步数结束
+        double distance;                 // 行程（百分比）
+    };
 
-    // 状态变量
-    CurtainState m_topCurtainState;
-    CurtainState m_sideCurtainState;
+    bool initializeGPIOPins();                                   // 初始化GPIO引脚
+    QList<CurtainType> deferReversals(const QList<CurtainType> &types, double percent); // 反向的执行器先停机等待，返回其余执行器
+    bool prepareTravel(CurtainType type, double percent, Travel *travel); // 更新状态与位置模型，需驱动时返回true
+    bool acquirePower(const Travel &travel);                     // 申请供电余量，不足时排队并返回false
+    bool energizeTravel(const Travel &travel);                   // 供电余量准入后单独启动（GUI线程）
+    void beginTravel(const Travel &travel);                      // 通电前记录运动方向与位置起点
+    void launchTravel(const Travel &travel, bool driven);        // 方向与使能已提交后启动脉冲与定时
+    void releasePower(const CurtainActuator &actuator) const;    // 电机已断电（任意线程）
+    bool haltCurtains(const QList<CurtainType> &types, bool decelerate); // 停机（不改变状态）
+    bool moveTo(CurtainType type, double percent);               // 按位置模型运动到目标开度
+    void finishPositioning(CurtainType type);                    // 到达目标开度后停机（GUI线程）
+    void onTravelTimeout(CurtainType type);                      // 限位行程超时
+    void onPositionTimeout(CurtainType type);                    // 按时间推算到达目标开度
+    void initializeLimitSwitches();                              // 初始化限位开关边沿检测
+
+    // 限位开关
+    void onLimitEdge(int pin, bool rising, qint64 timestampNs);  // 限位边沿（事件监视线程中直接调用）
+    void finishTravel(CurtainType type, bool open, qint64 limitNs = 0); // 到达终点后更新状态（GUI线程），limitNs为限位边沿时刻
+    void onStepperStopped(int pin);                              // 步进运动结束（脉冲线程中直接调用），暂停时关闭使能
+    void onStepperMoveFinished(int pin, quint64 steps, bool halted); // 步进运动结束后修正位置（GUI线程）
+
+    // 串口驱动器
+    bool openSerialBus();                                        // 打开串口总线（仿真时先启动仿真驱动器）
+    void onSerialReply(quint32 requestId, int address, int command); // 命令应答（GUI线程）
+    void onSerialFailed(quint32 requestId, int address, int command, const QString &error); // 命令失败（GUI线程）
+    CurtainType serialCurtain(int address) const;                // 站地址对应的执行器，未配置返回-1
+
+    // 位置模型
+    bool settlePosition(CurtainType type);                       // 结算运动后的开度，有运动时返回true（不持久化）
+    void loadPositions();
+    void applyCalibration(CurtainType type);                     // 标定模型写入位置估计
+    void loadCalibration();
+    void saveCalibration() const;
+    void savePositions() const;
+    static qint64 fullTravelNs(const CurtainActuator &actuator); // 全行程时间
+
+    // 状态机
+    bool transition(CurtainType type, CurtainStateMachine::Event event); // 执行状态转移，状态改变时发出一次信号
+    static CurtainState toState(CurtainStateMachine::Phase phase);
+
+    // 执行器
+    QVector<Channel> m_channels;
     bool m_initialized;
+    QString m_positionFile;
+    QString m_calibrationFile;
 
     // GPIO控制器
     GPIOController *m_gpioController;
 
-    // 硬件控制接口（待实现）
-    bool controlStepperMotor(CurtainType type, bool open); // 步进电机控制
-    bool readSensorStatus(CurtainType type);               // 读取传感器状态
+    CurtainCommandQueue *m_commandQueue;
+
+    // 供电预算（可选）
+    PowerBudgetScheduler *m_powerScheduler;
+
+    // 执行器状态日志（可选，不拥有）
+    StateJournal *m_stateJournal;
+
+    // 步进脉冲发生器（配置了STEP引脚时创建）
+    StepperPulseGenerator *m_stepper;
+
+    // RS-485驱动器串口总线（配置了串口站地址时创建）
+    SerialStepperBus *m_serialBus;
+    SerialStepperEmulator *m_serialEmulator; // CURTAIN_SERIAL_EMULATE时的仿真驱动器
+
+    // 硬件控制接口
+    bool controlStepperMotor(CurtainType type, bool open, quint64 steps); // 步进电机控制（方向已由DIR1设置，steps为0时持续运行）
+    bool readSensorStatus(CurtainType type, bool open);    // 读取限位开关状态（触发返回true）
 
     // 工具函数
     QString curtainTypeToString(CurtainType type) const;
@@ -0,0 +1,52 @@
+#ifndef CURTAIN_POSITION_H
+#define CURTAIN_POSITION_H
+
+#include <QJsonObject>
+#include <QtGlobal>
+
+/**
+ * @brief 保温帘位置估计（开度百分比，0为全关，100为全开）
+ *
+ * 运动中按已运行时间推算位置；步进驱动已知全行程步数时，运动结束后按实际输出步数修正。
+ * 到达限位时重新归零。断电发生在运动中时恢复为运动起点，并标记为未校准，
+ * 下一次全开或全关到达终点后恢复校准。打开与关闭方向的全行程时间与步数分别设置（行程标定结果）。
+ */
+class CurtainPosition
+{
+public:
+    CurtainPosition(qint64 fullTravelNs, quint64 fullTravelSteps);
+
+    void setTravelModel(bool open, qint64 fullTravelNs, quint64 fullTravelSteps); // 运动中设置时从下一次运动起生效
+    qint64 fullTravelNs(bool open) const { return m_fullTravelNs[open ? 1 : 0]; }
+    quint64 fullTravelSteps(bool open) const { return m_fullTravelSteps[open ? 1 : 0]; }
+
+    double percent(qint64 nowNs) const;          // 当前估计开度（运动中外推）
+    bool isMoving() const { return m_direction != 0; }
+    int direction() const { return m_direction; } // 1打开，-1关闭，0停止
+    bool isCalibrated() const { return m_calibrated; }
+
+    void begin(bool open, qint64 nowNs, bool stepExact); // 开始运动；stepExact为true时结束后可按步数修正
+    void end(qint64 nowNs);                      // 按运行时间结算
+    void applySteps(quint64 steps);              // 按最近一次运动实际输出的步数修正
+    void reachLimit(bool open);                  // 到达全开/全关位置，重新归零
+
+    qint64 travelTimeNs(double fromPercent, double toPercent) const;  // 方向由起止开度决定
+    quint64 travelSteps(double fromPercent, double toPercent) const; // 全行程步数未知时返回0
+
+    QJsonObject toJson() const;
+    void fromJson(const QJsonObject &json);
+
+private:
+    qint64 m_fullTravelNs[2];        // 下标：0关闭，1打开
+    quint64 m_fullTravelSteps[2];
+    qint64 m_runTravelNs;             // 本次运动使用的全行程时间
+    double m_percent;         // 最近一次结算的开度
+    double m_startPercent;    // 运动起点
+    qint64 m_startNs;
+    int m_direction;
+    int m_lastDirection;      // 最近一次运动的方向（步数修正用）
+    bool m_stepExact;         // 最近一次运动可按步数修正
+    bool m_calibrated;
+};
+
+#endif // CURTAIN_POSITION_H
@@ -0,0 +1,65 @@
+#ifndef CURTAIN_STATE_MACHINE_H
+#define CURTAIN_STATE_MACHINE_H
+
+/**
+ * @brief 保温帘状态机（编译期转移表）
+ *
+ * 转移表按 阶段 x 事件 查表，非法转移直接拒绝且不改变状态。
+ * 暂停分为“打开中暂停”和“关闭中暂停”两个阶段，恢复方向由表本身决定；
+ * 对外两者都报告为CurtainController::Paused。
+ */
+class CurtainStateMachine
+{
+public:
+    enum Phase {
+        Stopped,
+        Opening,
+        Closing,
+        PausedOpening,   // 打开途中暂停
+        PausedClosing,   // 关闭途中暂停
+        Open,
+        Closed,
+        Error,
+        PhaseCount
+    };
+
+    enum Event {
+        StartOpen,       // 开始向打开方向运动（含改变目标）
+        StartClose,      // 开始向关闭方向运动
+        Pause,           // 暂停，可恢复
+        Resume,          // 按暂停前的方向恢复
+        Stop,            // 停止，不可恢复
+        ReachOpen,       // 到达全开
+        ReachClosed,     // 到达全关
+        ReachTarget,     // 到达中间开度
+        Fault,           // 运动故障（超时等）
+        EventCount
+    };
+
+    explicit CurtainStateMachine(Phase initial = Stopped) : m_phase(initial) {}
+
+    Phase phase() const { return m_phase; }
+    bool isPaused() const { return m_phase == PausedOpening || m_phase == PausedClosing; }
+    bool isMoving() const { return m_phase == Opening || m_phase == Closing; }
+
+    static bool accepts(Phase phase, Event event);   // 转移是否合法
+    static Phase next(Phase phase, Event event);     // 非法时返回PhaseCount
+
+    // 执行事件；非法时返回false且阶段不变
+    bool handle(Event event)
+    {
+        const Phase target = next(m_phase, event);
+        if (target == PhaseCount) {
+            return false;
+        }
+        m_phase = target;
+        return true;
+    }
+
+    static const char *eventName(Event event);
+
+private:
+    Phase m_phase;
+};
+
+#endif // CURTAIN_STATE_MACHINE_H
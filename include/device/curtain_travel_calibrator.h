@@ -0,0 +1,69 @@
+#ifndef CURTAIN_TRAVEL_CALIBRATOR_H
+#define CURTAIN_TRAVEL_CALIBRATOR_H
+
+#include <QJsonObject>
+#include <QtGlobal>
+
+/**
+ * @brief 保温帘行程在线标定
+ *
+ * 全行程时间随温度与帘布磨损变化，固定时长会过冲或不到位。从一个终点（位置已校准）出发、
+ * 中途未暂停或换向、由对侧限位开关结束的运动，其时长（限位边沿的内核时间戳减去起动时刻）
+ * 即为该方向的全行程时间；步进驱动同时得到全行程步数。
+ * 打开与关闭方向各自维护指数加权模型，前几个样本按样本数平均以加快收敛；
+ * 样本数达到CURTAIN_CALIBRATION_MIN_SAMPLES后，偏差过大的样本（卡滞、打滑）不参与学习；
+ * 连续CURTAIN_CALIBRATION_RELEARN_OUTLIERS个偏向同一侧的离群样本说明行程已持久改变，以这些样本的均值重建模型。
+ */
+class CurtainTravelCalibrator
+{
+public:
+    CurtainTravelCalibrator(qint64 defaultTravelNs, quint64 defaultTravelSteps);
+
+    // 运动过程
+    void start(bool open, qint64 nowNs);     // 从终点出发的运动开始
+    void abort();                            // 运动中断（暂停、停止、换向、故障）
+    bool isRunning() const { return m_running; }
+    // 到达对侧限位：样本有效时更新模型并返回true，errorPercent为原模型在本次运动中的终点误差
+    bool finish(bool open, qint64 limitNs, double *errorPercent = nullptr);
+    bool applySteps(quint64 steps);          // 刚完成标定的运动实际输出的步数，更新步数模型时返回true
+
+    // 模型
+    qint64 travelNs(bool open) const;
+    quint64 travelSteps(bool open) const;    // 未知时返回0
+    int samples(bool open) const;
+
+    QJsonObject toJson() const;
+    void fromJson(const QJsonObject &json);
+
+private:
+    // 连续离群样本（同一侧）
+    struct OutlierRun {
+        int count;            // 正数偏长，负数偏短
+        double sum;           // 样本之和
+
+        OutlierRun() : count(0), sum(0.0) {}
+    };
+
+    struct Model {
+        double travelNs;
+        double travelSteps;
+        int samples;
+        int stepSamples;
+        OutlierRun travelOutliers;
+        OutlierRun stepOutliers;
+    };
+
+    static double blend(double model, double sample, int samples);  // 指数加权更新
+    static bool isOutlier(double model, double sample, int samples);
+    // 记录离群样本，连续同向达到阈值时以其均值重建模型并返回true
+    static bool relearn(OutlierRun &run, double &model, int &samples, double sample);
+
+    Model m_models[2];        // 下标：0关闭，1打开
+    bool m_running;
+    bool m_runOpen;
+    qint64 m_runStartNs;
+    bool m_stepsPending;      // 等待刚完成的运动报告步数
+    bool m_stepsOpen;
+};
+
+#endif // CURTAIN_TRAVEL_CALIBRATOR_H
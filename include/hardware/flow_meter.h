@@ -0,0 +1,57 @@
+#ifndef FLOW_METER_H
+#define FLOW_METER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+
+#include "config/gpio_config.h"
+
+class QTimer;
+struct GpioPulseCounter;
+
+/**
+ * @brief 霍尔流量计
+ *
+ * 脉冲由GPIOController的计数模式在事件监视线程中累加，本类只按固定间隔
+ * 采样计数器并发布瞬时流量与累计体积，GUI线程不会被逐个脉冲唤醒。
+ */
+class FlowMeter : public QObject
+{
+    Q_OBJECT
+
+public:
+    FlowMeter(int pin, const QSharedPointer<GpioPulseCounter> &counter,
+              double pulsesPerLitre = FLOW_METER_PULSES_PER_LITRE, QObject *parent = nullptr);
+
+    void start(int publishIntervalMs = FLOW_METER_PUBLISH_INTERVAL_MS); // 开始周期发布
+    void stop();
+    void setPublishInterval(int intervalMs);
+
+    int pin() const { return m_pin; }
+    double pulsesPerLitre() const { return m_pulsesPerLitre; }
+    quint64 pulsesForLitres(double litres) const; // 体积换算为脉冲数（向上取整）
+
+    quint64 pulseCount() const;                   // 当前累计脉冲数
+    double totalLitres() const;                   // 自上次清零以来的累计体积（升）
+    double litresPerMinute() const { return m_litresPerMinute; } // 最近一次发布的瞬时流量
+    void resetTotal();                            // 累计体积清零
+
+signals:
+    void flowUpdated(double litresPerMinute, double totalLitres);
+
+private slots:
+    void publish();
+
+private:
+    int m_pin;
+    QSharedPointer<GpioPulseCounter> m_counter;
+    double m_pulsesPerLitre;
+    QTimer *m_timer;
+    QElapsedTimer m_sampleTimer;   // 两次采样间隔
+    quint64 m_lastPulses;          // 上次采样的计数
+    quint64 m_basePulses;          // 累计体积清零时的计数
+    double m_litresPerMinute;
+};
+
+#endif // FLOW_METER_H
@@ -0,0 +1,87 @@
+#ifndef GPIO_CHARDEV_H
+#define GPIO_CHARDEV_H
+
+#include <QMap>
+#include <QVector>
+#include <QString>
+
+class GpioLineIo;
+struct gpio_v2_line_config;
+
+/**
+ * @brief GPIO字符设备(v2 uAPI)线路管理
+ *
+ * 每个gpiochip只维护一个线路请求，包含本进程占用的全部线路，
+ * 因此同一芯片上任意多个引脚的电平可以用一次
+ * GPIO_V2_LINE_SET_VALUES_IOCTL原子地同时更新。
+ * 已占用线路的方向修改在原请求内完成；新增或释放线路需要关闭旧请求后重新申请，
+ * 期间该芯片上的线路短暂不归本进程所有（见rebuildRequest()）。
+ * 引脚号沿用sysfs全局编号，按 chip = pin / 32、offset = pin % 32 换算。
+ */
+class GpioCharDev
+{
+public:
+    explicit GpioCharDev(GpioLineIo *io = nullptr); // io为空时使用内核实现，接管所有权
+    ~GpioCharDev();
+
+    void setLineIo(GpioLineIo *io);                 // 替换ioctl实现（先释放所有线路），接管所有权
+    bool isAvailable();                             // 字符设备是否可用
+
+    // 线路管理
+    bool claimLine(int pin, bool output, bool level); // 申请线路（输出时附带初始电平）
+    QVector<int> claimLines(const QMap<int, bool> &outputs, const QVector<int> &inputs); // 批量申请，每个芯片一次ioctl，返回失败引脚
+    bool releaseLine(int pin);                      // 释放线路
+    void releaseAll();                              // 释放所有线路
+
+    // 边沿检测输入：每条线路独立请求，返回的请求fd可直接加入epoll读取事件
+    int requestEdgeLine(int pin, bool rising, bool falling, bool pullUp, int debounceUs,
+                        bool *kernelDebounce = nullptr, int eventBufferSize = 0); // 失败返回-1，eventBufferSize为0时使用内核默认值
+    void releaseEdgeLine(int pin);
+    bool isEdgeLine(int pin) const;
+
+    // 电平读写
+    bool setLevels(const QMap<int, bool> &levels, QVector<int> *failedPins = nullptr); // 批量设置电平，每个芯片一次ioctl
+    bool getLevel(int pin, bool &level);            // 读取线路电平
+    bool getLevels(const QList<int> &pins, QMap<int, bool> &levels); // 批量读取，每个芯片一次ioctl
+
+    // 状态查询
+    bool isClaimed(int pin) const;
+    bool isOutput(int pin) const;
+    QString lastError() const { return m_lastError; }
+
+    static int chipOf(int pin);                     // 引脚所在芯片
+    static int offsetOf(int pin);                   // 引脚在芯片内的偏移
+
+private:
+    // 单个芯片上已占用的线路
+    struct ChipLines {
+        int chipFd;              // 芯片fd
+        int requestFd;           // 线路请求fd
+        QVector<int> offsets;    // 请求中的线路偏移（请求内索引顺序）
+        quint64 outputLines;     // 输出线路位图（按线路偏移）
+        quint64 levels;          // 输出电平位图（按线路偏移）
+
+        ChipLines() : chipFd(-1), requestFd(-1), outputLines(0), levels(0) {}
+    };
+
+    // 独立申请的边沿检测线路
+    struct EdgeLine {
+        int chipFd;
+        int requestFd;
+
+        EdgeLine() : chipFd(-1), requestFd(-1) {}
+    };
+
+    static void buildConfig(const ChipLines &lines, struct gpio_v2_line_config *config); // 按线路方向与电平缓存生成配置
+    bool reconfigureRequest(int chip);              // 线路集合不变时在原请求内修改方向（GPIO_V2_LINE_SET_CONFIG_IOCTL）
+    bool rebuildRequest(int chip);                  // 按当前线路集合重新申请（保持输出电平，期间线路短暂释放）
+    void closeChip(ChipLines &lines);               // 关闭芯片及请求fd
+    void setError(const QString &error);
+
+    GpioLineIo *m_io;
+    QMap<int, ChipLines> m_chips;                   // chip -> 已占用线路
+    QMap<int, EdgeLine> m_edgeLines;                // pin -> 边沿检测线路
+    QString m_lastError;
+};
+
+#endif // GPIO_CHARDEV_H
@@ -4,15 +4,98 @@
 #include <QObject>
 #include <QString>
 #include <QMap>
+#include <QVector>
+#include <QPair>
+#include <QSharedPointer>
+#include <QRecursiveMutex>
+
+#include "config/gpio_config.h"
+
+class GpioCharDev;
+class GpioLineIo;
+class SysfsIo;
+class GpioMmio;
+class GpioEventMonitor;
+class FlowMeter;
+class PowerBudgetScheduler;
+struct GpioPulseCounter;
+class ShadowVerifyThread;
 
 class GPIOController : public QObject
 {
     Q_OBJECT
 
 public:
+    // GPIO访问后端
+    enum Backend {
+        SysfsBackend,    // /sys/class/gpio 接口
+        CharDevBackend   // /dev/gpiochipN 字符设备接口（v2 uAPI）
+    };
+
+    // 输入边沿检测
+    enum Edge {
+        NoEdge,          // 不检测
+        RisingEdge,      // 上升沿
+        FallingEdge,     // 下降沿
+        BothEdges        // 双边沿
+    };
+
+    // 批量操作结果
+    struct TransactionResult {
+        bool success;                 // 全部操作成功
+        QMap<int, QString> failures;  // 失败引脚 -> 失败原因
+        int pinCount;                 // 涉及的引脚数
+        int unchangedCount;           // 已处于目标状态而跳过写入的引脚数
+        qint64 elapsedUs;             // 提交耗时（微秒）
+
+        TransactionResult() : success(true), pinCount(0), unchangedCount(0), elapsedUs(0) {}
+    };
+
+    /**
+     * @brief GPIO批量操作
+     *
+     * 收集导出、方向、电平操作，commit()时按gpiochip分组以最少的系统调用提交：
+     * sysfs后端一次目录扫描代替逐引脚探测、方向与初始电平合并为"high"/"low"写入；
+     * 字符设备后端每个芯片一次线路申请、一次电平设置。
+     */
+    class Transaction
+    {
+    public:
+        Transaction &exportPin(int pin);                              // 导出引脚
+        Transaction &setDirection(int pin, const QString &direction); // 设置方向
+        Transaction &setPin(int pin, bool value);                     // 设置电平
+        TransactionResult commit();                                   // 提交（提交后清空）
+        bool isEmpty() const;
+
+    private:
+        friend class GPIOController;
+        explicit Transaction(GPIOController *controller);
+
+        GPIOController *m_controller;
+        QVector<int> m_exports;         // 待导出引脚
+        QMap<int, QString> m_directions; // 待设置方向
+        QMap<int, bool> m_levels;       // 待设置电平
+    };
+
     explicit GPIOController(QObject *parent = nullptr);
     ~GPIOController();
 
+    Transaction beginTransaction();         // 开始批量操作
+
+    // 后端选择
+    bool setBackend(Backend backend);       // 运行时切换后端，已导出引脚按原方向和电平迁移
+    Backend backend() const { return m_backend; }
+    void setCharDevLineIo(GpioLineIo *io);  // 替换字符设备ioctl实现（如进程内模拟），接管所有权
+    bool setSysfsIo(SysfsIo *io);           // 替换sysfs访问实现（初始化前调用），不接管所有权，nullptr恢复默认
+    SysfsIo *sysfsIo() const { return m_sysfs; }
+    bool setAttributeFdCache(bool enabled); // 关闭后每次读写重新打开属性文件（缓存前的行为，基准测试对比用；初始化前调用）
+
+    // 寄存器直接访问（仅快速引脚，导出与方向仍经当前后端）
+    bool setMmioSource(const QString &source); // 替换映射源（初始化前调用），普通文件为测试模式
+    bool setFastPins(const QList<int> &pins);  // 替换快速引脚（初始化前调用），默认GPIO_FAST_PINS
+    bool isFastPin(int pin) const { return m_fastPins.contains(pin); }
+    GpioMmio *fastIo() const;                  // 已映射时返回，实时线程可直接写快速引脚，否则nullptr
+
     // 初始化和清理
     bool initialize();
     void cleanup();
@@ -22,22 +105,48 @@ public:
     bool unexportPin(int pin);
     bool setDirection(int pin, const QString &direction);
     bool setPin(int pin, bool value);
-    bool getPin(int pin);
+    bool getPin(int pin);            // 输出引脚返回影子寄存器，不访问硬件
+    bool readHardwarePin(int pin);   // 强制从硬件读取电平
+    bool setPins(const QMap<int, bool> &levels); // 批量设置电平（字符设备后端每个芯片一次ioctl）
+
+    // 输入边沿事件（epoll监视，事件通过inputEdge信号发出）
+    bool configureInput(int pin, Edge edge, int debounceUs = 0); // 设为输入并启用边沿检测，优先使用内核去抖
+
+    // 脉冲计数（流量计等高频输入，不逐个发出inputEdge）
+    bool configurePulseCounter(int pin, Edge edge = RisingEdge, int debounceUs = 0);
+    QSharedPointer<GpioPulseCounter> pulseCounter(int pin) const; // 计数器，读取无需加锁
+    quint64 pulseCount(int pin) const;
 
     // 专用初始化方法
     bool initializePowerSupplyPin(); // 初始化GPIO3_B6为常高电平
     bool initializePumpControlPin(); // 初始化GPIO3_A7水泵控制引脚
     bool initializeFertilizerPumpPin(); // 初始化GPIO3_A1施药泵控制引脚
 
+    // 供电预算（可选）：开泵前申请余量，不足时排队，准入后再开启
+    void setPowerScheduler(PowerBudgetScheduler *scheduler) { m_powerScheduler = scheduler; }
+
     // 水泵控制方法
-    bool startPump();  // 开启水泵（GPIO3_A7置1）
+    bool startPump();  // 开启水泵（GPIO3_A7置1），供电余量不足时排队并返回true
     bool stopPump();   // 关闭水泵（GPIO3_A7置0）
     bool getPumpStatus(); // 获取水泵状态
+    bool isPumpStartPending() const; // 开泵仍在等待供电余量（GPIO3_A7尚未置1）
 
     // 施药泵控制方法
-    bool startFertilizerPump();  // 开启施药泵（GPIO3_A1置1）
+    bool startFertilizerPump();  // 开启施药泵（GPIO3_A1置1），供电余量不足时排队并返回true
     bool stopFertilizerPump();   // 关闭施药泵（GPIO3_A1置0）
     bool getFertilizerPumpStatus(); // 获取施药泵状态
+    bool isFertilizerPumpStartPending() const; // 开泵仍在等待供电余量（GPIO3_A1尚未置1）
+
+    // 按输送体积运行（需安装流量计，达到体积后在事件监视线程中直接关泵）
+    bool startPumpForVolume(double litres);
+    bool startFertilizerPumpForVolume(double litres);
+    FlowMeter *pumpFlowMeter() const { return m_pumpFlowMeter; }             // 未安装返回nullptr
+    FlowMeter *fertilizerFlowMeter() const { return m_fertilizerFlowMeter; } // 未安装返回nullptr
+
+    // 影子寄存器校验
+    void setShadowVerification(bool enabled, int intervalMs = GPIO_SHADOW_VERIFY_INTERVAL_MS); // 后台周期回读校验
+    bool isShadowVerificationEnabled() const { return m_verifyThread != nullptr; }
+    bool verifyShadow();             // 批量回读所有输出引脚并与影子寄存器比较
 
     // 状态查询
     bool isInitialized() const { return m_initialized; }
@@ -45,6 +154,9 @@ public:
 
 signals:
     void errorOccurred(const QString &error);
+    void shadowMismatch(int pin, bool expected, bool actual); // 硬件电平与影子寄存器不一致
+    void inputEdge(int pin, bool rising, qint64 timestampNs);  // 输入边沿事件（在事件监视线程中发出，时间戳为CLOCK_MONOTONIC）
+    void pumpVolumeReached(int pumpPin, double litres);        // 定量运行完成（在事件监视线程中发出）
 
 private:
     // 内部辅助方法
@@ -52,8 +164,65 @@ private:
     QString readFromFile(const QString &filePath);
     QString getPinPath(int pin, const QString &attribute);
 
+    // 引脚属性文件描述符缓存（导出时打开，注销/清理时关闭）
+    struct PinFiles {
+        int valueFd;      // value属性文件描述符
+        int directionFd;  // direction属性文件描述符
+        bool valueReadOnly; // value以只读方式打开（仅输入引脚）
+
+        PinFiles() : valueFd(-1), directionFd(-1), valueReadOnly(false) {}
+    };
+
+    bool openPinFiles(int pin);                 // 打开并缓存引脚属性文件
+    void closePinFiles(int pin);                // 关闭引脚属性文件
+    int pinFd(int pin, bool direction);         // 获取缓存的描述符（必要时重新打开）
+    bool writeAttribute(int pin, int fd, const char *data, int length); // pwrite写入属性，失败时丢弃该描述符
+
+    bool releaseSysfsExport(int pin);           // 释放sysfs导出，供字符设备申请线路
+    TransactionResult commitTransaction(const Transaction &transaction); // 提交批量操作
+    bool readHardwareLevels(const QList<int> &pins, QMap<int, bool> &levels); // 批量回读硬件电平
+    bool sysfsStateMatches(int pin, const QString &direction); // 已导出引脚的方向与电平是否已是目标状态
+    void updateShadow(int pin, const QString &direction); // 按方向设置更新影子寄存器
+    void syncFastPin(int pin);                  // 快速引脚的方向与电平同步到寄存器映射
+    bool setupInput(int pin, Edge edge, int debounceUs, const QSharedPointer<GpioPulseCounter> &counter); // 配置输入（counter非空为计数模式）
+    bool applyInputEdge(int pin, Edge edge, int debounceUs,
+                        const QSharedPointer<GpioPulseCounter> &counter); // 在当前后端上申请边沿检测并加入监视
+
+    // 定量运行
+    struct VolumeRun {
+        int pumpPin;              // 受控泵引脚
+        quint64 startPulses;      // 开始时的计数
+        double pulsesPerLitre;    // 流量计系数
+    };
+
+    FlowMeter *createFlowMeter(int pin);        // 配置流量计引脚并创建流量计，未安装返回nullptr
+    bool switchOnPump(int pumpPin, const QString &name, bool *queued = nullptr); // 经供电预算开泵，排队等待时返回true并置queued
+    bool switchOffPump(int pumpPin);            // 关泵并释放供电余量（取消排队中的开泵）
+    bool startVolumeRun(int pumpPin, FlowMeter *meter, double litres);
+    void cancelVolumeRun(int pumpPin);
+    void onPulseTargetReached(int pin, quint64 pulses); // 计数达到目标（事件监视线程中直接调用）
+
     bool m_initialized;
+    Backend m_backend;                  // 当前后端
+    GpioCharDev *m_charDev;             // 字符设备线路管理
+    SysfsIo *m_sysfs;                   // sysfs访问实现（不拥有）
+    GpioMmio *m_mmio;                   // 快速引脚寄存器映射
+    QMap<int, bool> m_fastPins;         // 快速引脚（默认GPIO_FAST_PINS中的有效引脚）
     QMap<int, bool> m_exportedPins; // 记录已导出的引脚
+    QMap<int, QString> m_pinDirections; // 记录引脚方向设置
+    QMap<int, PinFiles> m_pinFiles; // 已打开的引脚属性文件
+    bool m_fdCacheEnabled;              // 是否缓存属性文件描述符
+    QMap<int, bool> m_outputShadow;     // 输出引脚影子寄存器（本进程是唯一写入者）
+    ShadowVerifyThread *m_verifyThread; // 影子寄存器后台校验线程
+    GpioEventMonitor *m_eventMonitor;   // 输入边沿事件监视
+    QMap<int, QPair<Edge, int> > m_inputEdges; // 边沿检测配置（pin -> 边沿, 去抖微秒），切换后端时重新申请
+    QMap<int, QSharedPointer<GpioPulseCounter> > m_pulseCounters; // 计数模式引脚的计数器
+    QMap<int, VolumeRun> m_volumeRuns;  // 流量计引脚 -> 进行中的定量运行
+    QMap<int, bool> m_pendingPumps;     // 等待供电余量的泵引脚（准入、关泵或开启失败时移除）
+    FlowMeter *m_pumpFlowMeter;         // 水泵流量计
+    FlowMeter *m_fertilizerFlowMeter;   // 施药泵流量计
+    PowerBudgetScheduler *m_powerScheduler; // 供电预算（不拥有）
+    mutable QRecursiveMutex m_mutex;    // 保护硬件访问与状态（校验线程等并发访问）
 };
 
 #endif // GPIO_CONTROLLER_H
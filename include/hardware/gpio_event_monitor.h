@@ -0,0 +1,93 @@
+#ifndef GPIO_EVENT_MONITOR_H
+#define GPIO_EVENT_MONITOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QSharedPointer>
+
+class GpioEventThread;
+
+/**
+ * @brief 脉冲计数器
+ *
+ * 计数模式的事件源不逐个发出信号，监视线程每读取一批内核事件只做一次原子加法，
+ * 读取方（如流量计的周期发布）无需加锁。
+ */
+struct GpioPulseCounter {
+    QAtomicInteger<quint64> pulses;      // 累计脉冲数
+    QAtomicInteger<quint64> target;      // 目标脉冲数，达到时发出pulseTargetReached（0为不设目标）
+    QAtomicInteger<qint64> lastPulseNs;  // 最近一次脉冲的时间戳（CLOCK_MONOTONIC）
+
+    GpioPulseCounter() : pulses(0), target(0), lastPulseNs(0) {}
+};
+
+/**
+ * @brief GPIO输入边沿事件监视器
+ *
+ * 在独立线程中用一个epoll循环等待所有输入引脚的边沿事件：
+ * - 字符设备线路请求fd：读取内核gpio_v2_line_event（自带CLOCK_MONOTONIC时间戳）
+ * - sysfs value文件：等待EPOLLPRI后回读电平，时间戳取自CLOCK_MONOTONIC
+ * edgeDetected信号在监视线程中发出，消费者可直连以获得最低延迟，
+ * 或使用默认连接方式投递到自身线程。
+ * 带计数器的事件源只累加计数，用于kHz级的流量计脉冲。
+ */
+class GpioEventMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 事件源类型
+    enum SourceType {
+        CharDevSource,   // 字符设备线路请求fd
+        SysfsSource      // sysfs value文件fd
+    };
+
+    explicit GpioEventMonitor(QObject *parent = nullptr);
+    ~GpioEventMonitor();
+
+    bool start();                          // 启动监视线程
+    void stop();                           // 停止监视线程
+    bool isRunning() const;
+
+    // 事件源管理（可在任意线程调用）
+    bool addSource(int pin, int fd, SourceType type, int softDebounceUs = 0,
+                   const QSharedPointer<GpioPulseCounter> &counter = QSharedPointer<GpioPulseCounter>()); // softDebounceUs用于内核不支持去抖时的软件过滤，counter非空时为计数模式
+    void removeSource(int pin);
+    bool hasSource(int pin) const;
+
+signals:
+    void edgeDetected(int pin, bool rising, qint64 timestampNs); // 边沿事件（监视线程中发出）
+    void pulseTargetReached(int pin, quint64 pulses);             // 计数达到目标（监视线程中发出）
+
+private:
+    friend class GpioEventThread;
+
+    // 单个事件源
+    struct Source {
+        int fd;
+        SourceType type;
+        int softDebounceUs;    // 软件去抖时间（微秒），0为不过滤
+        qint64 lastEventNs;    // 上次接受的事件时间
+        bool lastLevel;        // 上次电平（sysfs去重）
+        QSharedPointer<GpioPulseCounter> counter; // 计数模式
+
+        Source() : fd(-1), type(CharDevSource), softDebounceUs(0), lastEventNs(0), lastLevel(false) {}
+    };
+
+    void runLoop();                        // epoll事件循环（监视线程）
+    void handleSource(int pin);            // 处理单个就绪事件源
+    bool acceptEvent(int pin, qint64 timestampNs, bool rising); // 软件去抖
+    static bool debounce(Source &source, qint64 timestampNs, bool rising); // 去抖判断并记录本次事件
+
+    int m_epollFd;                         // epoll实例
+    int m_wakeFd;                          // eventfd，用于唤醒并退出循环
+    QAtomicInt m_stopping;
+    GpioEventThread *m_thread;
+    QMap<int, Source> m_sources;           // pin -> 事件源
+    mutable QMutex m_mutex;                // 保护m_sources
+};
+
+#endif // GPIO_EVENT_MONITOR_H
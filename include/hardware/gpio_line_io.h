@@ -0,0 +1,100 @@
+#ifndef GPIO_LINE_IO_H
+#define GPIO_LINE_IO_H
+
+#include <QMap>
+#include <QVector>
+
+#include <linux/gpio.h>
+
+/**
+ * @brief GPIO字符设备ioctl接口抽象
+ *
+ * 封装 /dev/gpiochipN 的 open/ioctl/close 调用面（GPIO v2 uAPI），
+ * 返回值语义与系统调用一致：成功返回0（或fd），失败返回-1并设置errno。
+ * 实际硬件使用KernelGpioLineIo，板外调试使用SimulatedGpioLineIo。
+ */
+class GpioLineIo
+{
+public:
+    virtual ~GpioLineIo() {}
+
+    virtual int openChip(int chip) = 0;                                       // 打开gpiochipN，返回芯片fd
+    virtual int requestLines(int chipFd, struct gpio_v2_line_request *request) = 0; // GPIO_V2_GET_LINE_IOCTL
+    virtual int setValues(int requestFd, struct gpio_v2_line_values *values) = 0;   // GPIO_V2_LINE_SET_VALUES_IOCTL
+    virtual int getValues(int requestFd, struct gpio_v2_line_values *values) = 0;   // GPIO_V2_LINE_GET_VALUES_IOCTL
+    virtual int setConfig(int requestFd, struct gpio_v2_line_config *config) = 0;   // GPIO_V2_LINE_SET_CONFIG_IOCTL（原请求内改方向）
+    virtual void closeFd(int fd) = 0;                                         // 关闭芯片fd或线路请求fd
+};
+
+/**
+ * @brief 内核GPIO字符设备实现
+ */
+class KernelGpioLineIo : public GpioLineIo
+{
+public:
+    int openChip(int chip) override;
+    int requestLines(int chipFd, struct gpio_v2_line_request *request) override;
+    int setValues(int requestFd, struct gpio_v2_line_values *values) override;
+    int getValues(int requestFd, struct gpio_v2_line_values *values) override;
+    int setConfig(int requestFd, struct gpio_v2_line_config *config) override;
+    void closeFd(int fd) override;
+};
+
+/**
+ * @brief 进程内模拟的GPIO字符设备
+ *
+ * 在内存中实现与内核相同的线路请求语义（线路占用检测、按请求内索引的
+ * bits/mask、输出默认值），并统计ioctl次数，便于在没有开发板时验证
+ * 多线路原子写入的行为。
+ * 带边沿标志的请求返回真实的管道读端fd，injectEdge()写入gpio_v2_line_event，
+ * 因此可以直接加入epoll验证事件路径。
+ */
+class SimulatedGpioLineIo : public GpioLineIo
+{
+public:
+    explicit SimulatedGpioLineIo(int chipCount = 5, int linesPerChip = 32);
+
+    int openChip(int chip) override;
+    int requestLines(int chipFd, struct gpio_v2_line_request *request) override;
+    int setValues(int requestFd, struct gpio_v2_line_values *values) override;
+    int getValues(int requestFd, struct gpio_v2_line_values *values) override;
+    int setConfig(int requestFd, struct gpio_v2_line_config *config) override;
+    void closeFd(int fd) override;
+
+    // 调试查询
+    bool lineLevel(int chip, int offset) const;    // 线路当前电平
+    bool isLineRequested(int chip, int offset) const; // 线路是否被占用
+    int ioctlCount() const { return m_ioctlCount; } // 累计ioctl次数
+    int ioctlCount(unsigned long request) const { return m_ioctlCounts.value(request, 0); } // 某种ioctl的次数，如GPIO_V2_LINE_SET_VALUES_IOCTL
+    void resetIoctlCount() { m_ioctlCount = 0; m_ioctlCounts.clear(); }
+
+    // 模拟外部输入：改变线路电平，若线路配置了对应边沿则产生事件
+    bool injectEdge(int chip, int offset, bool rising);
+
+private:
+    struct Handle {
+        int chip;                 // 所属芯片
+        bool isRequest;           // true为线路请求fd，false为芯片fd
+        QVector<int> offsets;     // 请求中的线路偏移（按请求内索引排列）
+        quint64 outputMask;       // 请求内为输出的线路（按请求内索引）
+        quint64 edgeFlags;        // 请求的边沿检测标志
+        int eventWriteFd;         // 事件管道写端（仅边沿请求）
+        quint32 seqno;            // 请求内事件序号
+    };
+
+    void countIoctl(unsigned long request);
+    static quint64 outputMaskOf(const struct gpio_v2_line_config &config, int numLines); // 按请求内索引的输出线路
+    void applyOutputValues(int chip, const struct gpio_v2_line_config &config, const QVector<int> &offsets,
+                           quint64 outputMask); // 写入输出默认值
+
+    int m_chipCount;
+    int m_linesPerChip;
+    int m_nextFd;
+    int m_ioctlCount;
+    QMap<unsigned long, int> m_ioctlCounts; // ioctl请求码 -> 次数
+    QMap<int, Handle> m_handles;          // fd -> 句柄
+    QMap<int, quint64> m_levels;          // chip -> 线路电平位图
+    QMap<int, quint64> m_requestedLines;  // chip -> 已占用线路位图
+};
+
+#endif // GPIO_LINE_IO_H
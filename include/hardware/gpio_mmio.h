@@ -0,0 +1,78 @@
+#ifndef GPIO_MMIO_H
+#define GPIO_MMIO_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include "config/gpio_config.h"
+
+/**
+ * @brief GPIO控制器寄存器直接访问（mmap）
+ *
+ * 将各GPIO bank的寄存器页映射到进程地址空间，电平与方向的修改都是一次32位存储：
+ * RK3588的SWPORT_DR/DDR寄存器高16位是低16位的写使能掩码，只有掩码置位的线路被修改，
+ * 无需读-改-写，与内核及其他线程对同一bank其它线路的访问互不干扰。
+ *
+ * 映射源为字符设备（/dev/mem）时按物理基址映射；为普通文件时进入测试模式，
+ * 各bank依次占用一页，可在写入后直接检查文件内容中的位模式。
+ * 引脚复用与导出仍由sysfs/字符设备后端完成，本类只负责数据与方向寄存器。
+ */
+class GpioMmio
+{
+public:
+    explicit GpioMmio(const QString &source = GPIO_MMIO_SOURCE);
+    ~GpioMmio();
+
+    bool open();                                // 映射全部bank
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+    bool isFileBacked() const { return m_fileBacked; } // 测试模式
+    QString source() const { return m_source; }
+    QString lastError() const { return m_lastError; }
+
+    // 单次存储（调用前须已open()，可在任意线程无锁调用）
+    inline void write(int pin, bool level);
+    inline void setDirection(int pin, bool output);
+    void writeBank(int chip, quint32 mask, quint32 levels); // 同一bank多条线路同时更新，最多两次存储
+    bool read(int pin) const;                   // 读取EXT_PORT（测试模式下文件中该寄存器不随DR变化）
+
+    quint32 registerValue(int chip, int offset) const; // 读取原始寄存器值（测试校验用）
+
+    static bool isValidPin(int pin);
+
+private:
+    inline volatile quint32 *reg(int chip, int offset) const;
+    inline void store(int chip, int lowOffset, int line, bool set); // 写带掩码的L/H寄存器
+
+    QString m_source;
+    int m_fd;
+    bool m_fileBacked;
+    long m_pageSize;
+    void *m_maps[GPIO_MMIO_BANK_COUNT];         // 各bank映射的页起始地址
+    volatile quint32 *m_banks[GPIO_MMIO_BANK_COUNT]; // 各bank寄存器基址
+    QString m_lastError;
+};
+
+inline volatile quint32 *GpioMmio::reg(int chip, int offset) const
+{
+    return m_banks[chip] + offset / 4;
+}
+
+inline void GpioMmio::store(int chip, int lowOffset, int line, bool set)
+{
+    // 线路0-15在L寄存器，16-31在H寄存器（偏移+4）
+    const int shift = line & 15;
+    *reg(chip, lowOffset + ((line >> 4) << 2)) = (1u << (shift + 16)) | (quint32(set) << shift);
+}
+
+inline void GpioMmio::write(int pin, bool level)
+{
+    store(pin / GPIO_LINES_PER_CHIP, GPIO_MMIO_SWPORT_DR_L, pin % GPIO_LINES_PER_CHIP, level);
+}
+
+inline void GpioMmio::setDirection(int pin, bool output)
+{
+    store(pin / GPIO_LINES_PER_CHIP, GPIO_MMIO_SWPORT_DDR_L, pin % GPIO_LINES_PER_CHIP, output);
+}
+
+#endif // GPIO_MMIO_H
@@ -24,6 +24,7 @@ public:
 
 signals:
     void luxValueChanged(float lux); // 光照值变化信号
+    void luxSampled(float lux, bool simulated); // 每次读取后发出（含未变化的值），simulated为硬件不可用时的模拟数据
 
 private slots:
     void readSensorData(); // 读取传感器数据
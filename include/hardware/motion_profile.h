@@ -0,0 +1,50 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <QtGlobal>
+
+#include "config/gpio_config.h"
+
+/**
+ * @brief 步进运动加减速规划
+ *
+ * 规划结果只包含一张加速表（每步的半周期，纳秒）与巡航半周期：
+ * 加速段按步序查表，减速段按剩余步数倒序查同一张表，行程不足两段加速时截短为三角形曲线。
+ * MOTION_RAMP_COMMON_SPEEDS中的步频在编译期（constexpr）生成加速表，
+ * 其它步频在首次规划时生成并缓存，表在进程生命周期内保持有效。
+ */
+class MotionProfile
+{
+public:
+    enum Shape {
+        Trapezoid = MOTION_PROFILE_TRAPEZOID, // 匀加速
+        SCurve = MOTION_PROFILE_SCURVE        // 起止加速度为零
+    };
+
+    MotionProfile();
+
+    // 规划一次运动；steps为0时持续运行，只有加速段，减速在停止时开始
+    static MotionProfile plan(quint64 steps, int stepsPerSecond, Shape shape = Shape(CURTAIN_MOTION_PROFILE));
+
+    quint64 steps() const { return m_steps; }
+    int stepsPerSecond() const { return m_stepsPerSecond; }
+    Shape shape() const { return m_shape; }
+    const quint32 *ramp() const { return m_ramp; }              // 加速表，nullptr表示不加减速
+    int rampLength() const { return m_rampLength; }             // 本次使用的加速段步数
+    qint64 cruiseHalfPeriodNs() const { return m_cruiseHalfPeriodNs; }
+    bool isPrecomputed() const { return m_precomputed; }        // 加速表是否编译期生成
+
+    // 指定步频与曲线的完整加速表（MOTION_RAMP_STEPS项），步频不高于起步步频时返回nullptr
+    static const quint32 *rampTable(int stepsPerSecond, Shape shape, bool *precomputed = nullptr);
+
+private:
+    quint64 m_steps;
+    int m_stepsPerSecond;
+    Shape m_shape;
+    const quint32 *m_ramp;
+    int m_rampLength;
+    qint64 m_cruiseHalfPeriodNs;
+    bool m_precomputed;
+};
+
+#endif // MOTION_PROFILE_H
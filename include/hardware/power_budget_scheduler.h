@@ -0,0 +1,111 @@
+#ifndef POWER_BUDGET_SCHEDULER_H
+#define POWER_BUDGET_SCHEDULER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+
+#include <functional>
+
+#include "config/gpio_config.h"
+
+class QTimer;
+
+/**
+ * @brief 执行器供电预算调度器
+ *
+ * 保温帘电机与水泵、施药泵共用24V电源，同时起动时浪涌叠加会拉低电压。
+ * 每个负载登记起动浪涌电流、浪涌持续时间与稳态电流，通电前向调度器申请：
+ * - 估计电流（已通电负载 + 新负载浪涌）不超过预算时立即准入；
+ * - 超出预算但等其它负载浪涌结束后即可容纳时，错开到该时刻再通电；
+ * - 稳态电流已无余量时排队，等待其它负载断电（先到先得）。
+ * 没有其它负载通电时总是准入，单个负载的浪涌超出预算也不会永久阻塞。
+ *
+ * 账目由互斥锁保护，tryAcquire()/release()可在任意线程调用；submit()排队的通电动作
+ * 在调度器所在线程（GUI线程）中执行。负载编号使用控制该负载通电的GPIO引脚号。
+ */
+class PowerBudgetScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 等待时间统计
+    struct Statistics {
+        quint64 requests;     // 准入的申请数
+        quint64 immediate;    // 无需等待
+        quint64 delayed;      // 错开浪涌或排队后准入
+        quint64 cancelled;    // 排队中被取消
+        qint64 totalWaitUs;   // 累计等待时间
+        qint64 maxWaitUs;     // 最长等待时间
+
+        Statistics() : requests(0), immediate(0), delayed(0), cancelled(0), totalWaitUs(0), maxWaitUs(0) {}
+        qint64 meanWaitUs() const { return requests ? totalWaitUs / qint64(requests) : 0; }
+    };
+
+    explicit PowerBudgetScheduler(int budgetMa = POWER_BUDGET_MA, QObject *parent = nullptr);
+
+    void registerLoad(int loadId, const QString &name, int inrushMa, int steadyMa, int inrushMs);
+    void setBudget(int budgetMa);
+    int budget() const;
+
+    // 同步申请（任意线程）：准入时记为通电并返回true；否则retryAtNs给出可再次申请的时刻。
+    // requestedNs为首次申请时刻（计入等待时间），0为当前时刻。不参与submit()的排队顺序
+    bool tryAcquire(int loadId, qint64 requestedNs = 0, qint64 *retryAtNs = nullptr);
+
+    // 异步申请（调度器所在线程）：准入后执行start，start返回false视为通电失败并立即释放。
+    // 能立即准入时start在本调用内执行。返回申请编号
+    quint64 submit(int loadId, const std::function<bool()> &start);
+    bool cancel(quint64 ticket);       // 取消排队中的申请
+    void cancelAll(int loadId);        // 取消某个负载排队中的全部申请
+    void release(int loadId);          // 负载已断电（任意线程，未通电时忽略）
+
+    // 运行指标
+    int currentDrawMa() const;         // 当前估计电流
+    int peakDrawMa() const;            // 准入时刻的估计电流峰值
+    int queueDepth() const { return m_queue.size(); }
+    Statistics statistics() const;                 // 全部负载
+    Statistics statistics(int loadId) const;       // 单个负载
+
+    static qint64 monotonicNs();
+
+signals:
+    void admitted(int loadId, qint64 waitUs);      // 负载准入（在申请所在线程发出）
+
+private:
+    struct Load {
+        QString name;
+        int inrushMa;
+        int steadyMa;
+        qint64 inrushNs;
+    };
+
+    struct Request {
+        quint64 ticket;
+        int loadId;
+        std::function<bool()> start;
+        qint64 requestedNs;
+        bool deferred;                 // 曾因余量不足未能准入（计入等待时间）
+    };
+
+    QString loadName(int loadId) const;
+    int drawAtLocked(qint64 atNs) const;           // 已通电负载在atNs时刻的估计电流
+    bool fitsLocked(const Load &load, qint64 nowNs, qint64 *retryAtNs) const;
+    void recordLocked(int loadId, qint64 waitUs);
+    void processQueue();                           // 按顺序准入排队的申请（调度器所在线程）
+
+    QMap<int, Load> m_loads;
+    QMap<int, qint64> m_active;        // 已通电负载 -> 通电时刻
+    int m_budgetMa;
+    int m_peakDrawMa;
+    QMap<int, Statistics> m_stats;
+    Statistics m_total;
+    mutable QMutex m_mutex;            // 保护以上账目
+
+    QList<Request> m_queue;            // 排队中的异步申请（仅调度器所在线程访问）
+    quint64 m_nextTicket;
+    QTimer *m_retryTimer;              // 队首等待浪涌结束的定时
+};
+
+#endif // POWER_BUDGET_SCHEDULER_H
@@ -0,0 +1,88 @@
+#ifndef PUMP_SCHEDULER_H
+#define PUMP_SCHEDULER_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "config/gpio_config.h"
+
+class GPIOController;
+class PowerBudgetScheduler;
+class StateJournal;
+class PumpSchedulerThread;
+
+/**
+ * @brief 泵定时运行调度器
+ *
+ * 接收"在T时刻开启泵X运行N毫秒"的任务，由独立线程基于CLOCK_MONOTONIC的
+ * timerfd（绝对时间）执行开关动作，不受GUI线程重绘等阻塞影响。
+ * 每个任务结束后报告请求时长与实际通电时长（两次电平写入完成时刻之差）。
+ * 设置了供电预算时，开泵前在调度线程中同步申请余量，不足时推迟到调度器给出的时刻重试。
+ * 设置了状态日志时记录每个泵的运行截止时刻，进程重启后start()按剩余时长继续运行。
+ */
+class PumpScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PumpScheduler(GPIOController *controller, QObject *parent = nullptr);
+    ~PumpScheduler();
+
+    bool start();                      // 启动调度线程
+    void stop();                       // 停止调度线程（运行中的泵立即关闭）
+    bool isRunning() const;
+    void setPowerScheduler(PowerBudgetScheduler *scheduler) { m_powerScheduler = scheduler; } // 启动前设置
+    void setStateJournal(StateJournal *journal) { m_stateJournal = journal; }                 // 启动前设置
+
+    // 任务管理（可在任意线程调用），返回任务ID，失败返回-1
+    int schedule(int pumpPin, int durationMs, qint64 startAtNs = 0); // startAtNs为CLOCK_MONOTONIC绝对时间，0为立即
+    int scheduleIn(int pumpPin, int durationMs, int delayMs);        // 延迟delayMs后运行
+    bool cancel(int jobId);            // 取消任务，运行中的泵立即关闭
+    void cancelAll(int pumpPin);       // 取消某个泵的全部任务
+
+    static qint64 monotonicNs();       // 当前CLOCK_MONOTONIC时间（纳秒）
+
+signals:
+    void jobStarted(int jobId, int pumpPin, qint64 startLatencyUs);  // 泵已开启（调度线程中发出）
+    void jobFinished(int jobId, int pumpPin, qint64 requestedUs,
+                     qint64 actualUs, bool cancelled);                // 任务结束（调度线程中发出）
+    void errorOccurred(const QString &error);
+
+private:
+    friend class PumpSchedulerThread;
+
+    // 单个定时任务
+    struct Job {
+        int pumpPin;
+        qint64 startNs;          // 计划开启时间
+        qint64 durationNs;       // 请求通电时长
+        qint64 actualStartNs;    // 实际开启完成时间（0为尚未开启）
+        qint64 admitNs;          // 供电余量不足时推迟到的重试时间（0为未推迟）
+        bool cancelled;
+
+        Job() : pumpPin(-1), startNs(0), durationNs(0), actualStartNs(0), admitNs(0), cancelled(false) {}
+        qint64 dueNs() const { return qMax(startNs, admitNs); }
+    };
+
+    void runLoop();                    // timerfd事件循环（调度线程）
+    void processDueJobs();             // 执行到期的开关动作
+    void armTimer();                   // 按最早到期时间设置timerfd
+    void wake();                       // 唤醒调度线程重新计算到期时间
+    bool switchPump(int pumpPin, bool on, qint64 &doneNs); // 写入泵引脚电平，返回完成时刻
+    void resumeFromJournal();          // 继续重启前未到截止时刻的运行
+
+    GPIOController *m_gpioController;
+    PowerBudgetScheduler *m_powerScheduler; // 供电预算（不拥有）
+    StateJournal *m_stateJournal;      // 状态日志（不拥有）
+    int m_timerFd;                     // CLOCK_MONOTONIC timerfd
+    int m_wakeFd;                      // eventfd
+    QAtomicInt m_stopping;
+    PumpSchedulerThread *m_thread;
+    int m_nextJobId;
+    QMap<int, Job> m_jobs;             // 任务ID -> 任务
+    mutable QMutex m_mutex;            // 保护m_jobs
+};
+
+#endif // PUMP_SCHEDULER_H
@@ -0,0 +1,110 @@
+#ifndef PWM_CHANNEL_POOL_H
+#define PWM_CHANNEL_POOL_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+
+#include "hardware/pwm_controller.h"
+
+class SysfsIo;
+class StateJournal;
+
+/**
+ * @brief 补光灯PWM通道（编译期配置表PWM_CHANNELS的一项）
+ */
+struct PwmChannelSpec {
+    const char *key;        // 标识（配方、云端指令与上报使用）
+    const char *name;       // 显示名称
+    int chip;               // pwmchipN
+    int channel;            // pwmM
+    int periodNs;           // PWM周期
+    int inversed;           // 1为反相极性（低电平点亮的驱动板）
+};
+
+/**
+ * @brief 光谱配方（编译期配置表PWM_RECIPES的一项）
+ */
+struct PwmRecipeSpec {
+    const char *key;
+    const char *name;
+    const char *duties;     // "通道标识:百分比"，逗号分隔，百分比可带一位小数
+};
+
+/**
+ * @brief 补光灯PWM通道池
+ *
+ * 每棚的红、蓝、白光灯串各接一个PWM通道。通道池按PWM_CHANNELS创建各通道的PWMController，
+ * 以(芯片, 通道)或标识查找；第一项为主通道（亮度滑块）。
+ * setDutyPermilles()按配置表顺序持有所有目标通道的占空比锁，在同一轮中连续写入，期间不会插入
+ * 渐变或单通道写入；sysfs没有跨通道的原子更新，各通道之间仍相隔一次pwrite。
+ * fadeDutyPermilles()让各通道以同一起始时刻渐变，过渡值只取决于时刻，各通道同时到达目标。
+ * 光谱配方（PWM_RECIPES）一次设置多个通道，不可用的通道跳过。
+ */
+class PwmChannelPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PwmChannelPool(QObject *parent = nullptr);
+    ~PwmChannelPool();
+
+    // 初始化与清理
+    bool initialize();                    // 初始化全部通道，主通道成功即返回true
+    void cleanup();
+    bool setSysfsIo(SysfsIo *io);         // 初始化前调用，不接管所有权
+    void setStateJournal(StateJournal *journal); // 初始化前调用，不接管所有权
+
+    // 通道查询
+    int channelCount() const { return m_channels.size(); }
+    QStringList channelKeys() const;      // 配置表顺序
+    QString channelName(const QString &key) const;
+    PWMController *channel(const QString &key) const;   // 未配置时返回nullptr
+    PWMController *channel(int chip, int channel) const;
+    PWMController *primary() const;       // 主通道
+    bool isAvailable(const QString &key) const;  // 已配置且初始化成功
+    QMap<QString, int> dutyPermilles() const;    // 各可用通道当前占空比（‰，渐变中为过渡值）
+
+    // 多通道同步更新（标识 -> 占空比‰）
+    bool setDutyPermilles(const QMap<QString, int> &duties);
+    bool fadeDutyPermilles(const QMap<QString, int> &duties, int durationMs,
+                           PWMController::FadeCurve curve = PWMController::Cie1931Curve); // durationMs<=0时立即设置
+
+    // 光谱配方
+    QStringList recipeKeys() const;
+    QString recipeName(const QString &key) const;
+    bool applyRecipe(const QString &key, int fadeMs = 0);
+
+    PWMController::Statistics statistics() const; // 各通道属性写入统计之和
+
+signals:
+    void recipeApplied(const QString &key);
+    void errorOccurred(const QString &error);
+
+private:
+    struct Channel {
+        QString key;
+        QString name;
+        PWMController *controller;
+    };
+
+    struct Recipe {
+        QString key;
+        QString name;
+        QMap<QString, int> duties;    // 标识 -> 占空比‰
+    };
+
+    static quint32 address(int chip, int channel) { return (quint32(chip) << 16) | quint16(channel); }
+
+    int indexOf(const QString &key) const { return m_keyIndex.value(key, -1); }
+    bool checkTargets(const QMap<QString, int> &duties, QList<int> *indexes); // 按配置表顺序列出目标通道
+
+    QVector<Channel> m_channels;          // 配置表顺序，同时是多通道加锁顺序
+    QMap<QString, int> m_keyIndex;        // 标识 -> 下标
+    QMap<quint32, int> m_addressIndex;    // (芯片, 通道) -> 下标
+    QVector<Recipe> m_recipes;
+};
+
+#endif // PWM_CHANNEL_POOL_H
@@ -3,55 +3,176 @@
 
 #include <QObject>
 #include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QAtomicInt>
+
+class SysfsIo;
+class StateJournal;
+class PwmFadeThread;
 
 /**
- * @brief PWM补光灯控制器
+ * @brief PWM补光灯控制器（单个PWM通道）
  *
  * 负责管理PWM硬件控制，实现补光灯强度调节
- * 基于Linux sysfs PWM接口，支持1000Hz频率控制
+ * 基于Linux sysfs PWM接口，每个对象对应pwmchipN/pwmM一个通道，周期与极性按通道配置（默认pwmchip0/pwm0、1000Hz）；
+ * 多路灯串由PwmChannelPool统一管理
+ * 设置了状态日志时记录每次设置的占空比，重启后恢复该值而不是导出时的默认值
+ * 通道属性文件打开一次后缓存fd（pwrite语义写入），与上次写入值相同的写入直接跳过，
+ * 拖动亮度滑块时只有换算后纳秒值变化的位置才产生sysfs写入。
+ * fadeTo()在独立线程中以PWM_FADE_RATE_HZ的固定频率把占空比过渡到目标值，过渡在感知亮度空间中
+ * 线性进行（伽马2.2或CIE 1931明度曲线，查找表在编译期生成）；渐变中收到新目标时从当前输出改向，
+ * 亮度不跳变。setDutyCycle()立即生效并取消进行中的渐变。
+ * 占空比内部以纳秒保存（64位运算），对外另提供千分比接口；百分比接口只是千分比的包装，
+ * 低亮度时每级0.1%，不再出现1%一级的可见跳变。
  */
 class PWMController : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit PWMController(QObject *parent = nullptr);
+    // 渐变曲线：目标亮度按曲线换算为占空比
+    enum FadeCurve {
+        LinearCurve,       // 占空比线性变化
+        Gamma22Curve,      // 伽马2.2
+        Cie1931Curve       // CIE 1931明度（L*）
+    };
+
+    // 属性写入统计
+    struct Statistics {
+        quint64 requested;     // 请求写入次数
+        quint64 performed;     // 实际写入sysfs次数
+        quint64 suppressed;    // 与上次写入值相同而跳过的次数
+        quint64 failed;        // 写入失败次数
+        quint64 opens;         // 打开属性文件次数
+
+        Statistics() : requested(0), performed(0), suppressed(0), failed(0), opens(0) {}
+    };
+
+    explicit PWMController(QObject *parent = nullptr); // pwmchip0/pwm0，1000Hz，正常极性
+    PWMController(int chip, int channel, int periodNs, bool inversed, QObject *parent = nullptr);
     ~PWMController();
 
     // 主要功能接口
     bool initialize();                    // 初始化PWM设备
     bool setDutyCycle(int percentage);    // 设置占空比(0-100%)
+    bool setDutyPermille(int permille);   // 设置占空比(0-1000‰)
+    bool setDutyNs(qint64 dutyNs);        // 按纳秒设置占空比(0-周期)
+    bool fadeTo(int percentage, int durationMs, FadeCurve curve = Cie1931Curve); // 渐变到目标占空比，durationMs<=0时立即设置
+    bool fadeToPermille(int permille, int durationMs, FadeCurve curve = Cie1931Curve);
     bool enable(bool enabled);            // 启用/禁用PWM
     void cleanup();                       // 清理PWM资源
+    bool setSysfsIo(SysfsIo *io);         // 替换sysfs访问实现（初始化前调用），不接管所有权，nullptr恢复默认
+    void setStateJournal(StateJournal *journal) { m_stateJournal = journal; } // 初始化前调用，不接管所有权
 
     // 状态查询
     bool isInitialized() const { return m_initialized; }
-    int getCurrentDutyCycle() const { return m_currentDutyCycle; }
+    int chip() const { return m_chip; }
+    int channel() const { return m_channel; }
+    int periodNs() const { return m_periodNs; }
+    bool isInversed() const { return m_inversed; }
+    int getCurrentDutyCycle() const;      // 当前输出的占空比（渐变中为过渡值，四舍五入到1%）
+    int getCurrentDutyPermille() const;   // 当前输出的占空比（‰）
+    qint64 currentDutyNs() const;         // 当前输出的占空比（纳秒）
+    bool isFading() const;
     int readActualDutyCycle();            // 从硬件读取实际占空比
+    int readActualDutyPermille();
+    Statistics statistics() const;
+    void resetStatistics();
 
 signals:
     void dutyCycleChanged(int percentage); // 占空比改变信号
+    void dutyPermilleChanged(int permille); // 占空比改变信号（‰）
     void statusChanged(bool enabled);      // 状态改变信号
     void errorOccurred(const QString &error); // 错误信号
 
 private:
+    friend class PwmFadeThread;
+    friend class PwmChannelPool;          // 多通道同步写入
+
     // PWM配置常量
-    static const QString PWM_CHIP_PATH;
-    static const QString PWM_EXPORT_PATH;
-    static const QString PWM_PATH;
-    static const int PWM_PERIOD_NS;       // 1000Hz = 1000000ns
+    static const int PWM_DEFAULT_PERIOD_NS; // 1000Hz = 1000000ns
+    static const int PWM_PERMILLE_FULL;     // 千分比满量程
+    static const int PWM_EXPORT_TIMEOUT_MS; // 导出后等待通道目录出现的最长时间
+    static const int PWM_EXPORT_POLL_MS;    // 等待期间的轮询间隔
+
+    // 通道属性文件
+    enum Attribute {
+        DutyCycleAttribute,
+        EnableAttribute,
+        PeriodAttribute,
+        PolarityAttribute,
+        AttributeCount
+    };
+
+    // 进行中的渐变（感知亮度空间中线性过渡）
+    struct Fade {
+        bool active;
+        FadeCurve curve;
+        double startLevel;       // 起点亮度（0-1）
+        double targetLevel;      // 目标亮度（0-1）
+        qint64 targetNs;         // 目标占空比（纳秒），终点精确写入
+        qint64 startNs;          // 起始时刻（CLOCK_MONOTONIC）
+        qint64 durationNs;
+
+        Fade() : active(false), curve(LinearCurve), startLevel(0.0), targetLevel(0.0),
+                 targetNs(0), startNs(0), durationNs(0) {}
+    };
+
+    // 通道配置
+    int m_chip;
+    int m_channel;
+    int m_periodNs;
+    bool m_inversed;
+    QString m_chipPath;                   // /sys/class/pwm/pwmchipN
+    QString m_channelPath;                // /sys/class/pwm/pwmchipN/pwmM
+    QString m_label;                      // 日志中的通道名，如 pwmchip0/pwm0
 
     // 状态变量
     bool m_initialized;
-    int m_currentDutyCycle;
+    SysfsIo *m_sysfs;                     // sysfs访问实现（不拥有）
+    StateJournal *m_stateJournal;         // 状态日志（不拥有）
+    int m_currentPermille;                // 当前输出的占空比（‰），由m_dutyNs换算
+    qint64 m_dutyNs;                      // 当前输出的占空比（纳秒）
+    Fade m_fade;
+    mutable QMutex m_dutyMutex;           // 保护占空比与渐变状态，写入占空比期间持有（先于m_ioMutex加锁）
+
+    int m_attributeFds[AttributeCount];           // 已打开的属性文件（-1为未打开）
+    QByteArray m_attributeValues[AttributeCount]; // 最近写入或读到的属性值（空为未知）
+    Statistics m_stats;
+    mutable QMutex m_ioMutex;             // 保护属性文件、缓存值与统计
+
+    // 渐变线程
+    PwmFadeThread *m_fadeThread;
+    int m_fadeTimerFd;                    // CLOCK_MONOTONIC timerfd，渐变期间周期触发
+    int m_fadeWakeFd;                     // eventfd，退出时唤醒
+    QAtomicInt m_fadeStopping;
+    QMutex m_fadeThreadMutex;             // 渐变线程按需启动，界面与补光闭环线程都可能首次调用（先于m_dutyMutex加锁）
 
     // 内部功能函数
     bool exportPWM();                     // 导出PWM设备
     bool setPeriod(int periodNs);         // 设置PWM周期
     bool setPolarity(const QString &polarity); // 设置PWM极性
-    bool writeToFile(const QString &filePath, const QString &value); // 写入文件
-    QString readFromFile(const QString &filePath); // 从文件读取
-    int readActualDutyCycleInternal();    // 内部读取占空比(不检查初始化状态)
+    bool writeToFile(const QString &filePath, const QString &value); // 写入导出/注销等一次性文件
+    qint64 readActualDutyNsInternal();    // 内部读取占空比纳秒值(不检查初始化状态)，失败返回-1
+    int attributeFd(Attribute attribute); // 打开并缓存属性文件
+    void closeAttributes();               // 关闭全部属性文件并清除缓存值（注销前调用）
+    bool writeAttribute(Attribute attribute, const QByteArray &value, bool *performed = nullptr); // 值未变化时跳过
+    QByteArray readAttribute(Attribute attribute, bool *ok = nullptr);
+    bool writeDutyLocked(qint64 dutyNs, bool *performed = nullptr); // 写入占空比（持有m_dutyMutex）
+    qint64 dutyNsForPermille(int permille) const; // 千分比 -> 纳秒（四舍五入）
+    int permilleFor(qint64 dutyNs) const;         // 纳秒 -> 千分比（四舍五入）
+    qint64 journaledDutyNs(qint64 value, qint64 aux, quint32 flags) const; // 日志记录 -> 纳秒
+    int journalKey() const { return (m_chip << 8) | m_channel; } // pwmchip0/pwm0为0
+    void dutyWritten(qint64 dutyNs, bool performed); // 写入成功后记录日志并发出信号（不持有锁）
+
+    // 渐变
+    bool fadeToAt(int permille, int durationMs, FadeCurve curve, qint64 startNs); // 指定起始时刻，多通道共用
+    bool startFadeThread();
+    void stopFadeThread();
+    void armFadeTimer(bool enabled);      // 启动/停止周期定时
+    void runFadeLoop();                   // 渐变线程
+    void stepFade();                      // 按当前时刻写入过渡值
 };
 
 #endif // PWM_CONTROLLER_H
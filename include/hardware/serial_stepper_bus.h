@@ -0,0 +1,156 @@
+#ifndef SERIAL_STEPPER_BUS_H
+#define SERIAL_STEPPER_BUS_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "config/gpio_config.h"
+
+class SerialStepperBusThread;
+
+/**
+ * @brief RS-485智能步进驱动器串口总线
+ *
+ * 非阻塞termios串口，收发在独立线程中用poll完成，调用方线程只把请求放入队列。
+ * 帧格式（多字节字段小端）：
+ *   请求  A5 | 站地址 | 序号 | 命令 | 长度 | 数据... | CRC16
+ *   应答  5A | 站地址 | 序号 | 状态 | 长度 | 数据... | CRC16
+ * CRC16为Modbus多项式（0xA001，初值0xFFFF），覆盖帧头之后至数据末尾。
+ * 总线上最多CURTAIN_SERIAL_MAX_OUTSTANDING个请求同时等待应答，按序号匹配；
+ * 超时后以原序号重发（驱动器按序号去重），同一站点已发出更新的命令时不再重发，
+ * 避免迟到的运动命令覆盖停机命令。
+ * 串口断开（POLLHUP/POLLERR）后收发循环退出，未完成的请求按失败报告，此后send()返回0，
+ * 直到重新open()。
+ */
+class SerialStepperBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 命令
+    enum Command {
+        Ping = 0x01,       // 无数据
+        Move = 0x10,       // 方向(1) | 步频(2) | 步数(4)，步数0为持续运行
+        Stop = 0x11,       // 减速(1)
+        Status = 0x20      // 应答：运动中(1) | 位置(4，有符号步数)
+    };
+
+    // 应答状态
+    enum ReplyStatus {
+        StatusOk = 0x00,
+        StatusBusy = 0x01,
+        StatusBadCommand = 0x02,
+        StatusBadCrc = 0x03
+    };
+
+    // 解析出的一帧
+    struct Frame {
+        quint8 address;
+        quint8 sequence;
+        quint8 code;       // 请求为命令，应答为状态
+        QByteArray payload;
+    };
+
+    // 总线统计
+    struct Statistics {
+        quint64 requests;          // 已提交请求
+        quint64 replies;           // 成功应答
+        quint64 retries;           // 超时重发
+        quint64 timeouts;          // 重发后仍超时
+        quint64 rejected;          // 驱动器返回非成功状态
+        quint64 crcErrors;         // 校验错误帧
+        quint64 unexpected;        // 无匹配请求的应答（重发后迟到的应答）
+        qint64 maxRoundTripUs;     // 最长往返时间
+        qint64 totalRoundTripUs;
+
+        Statistics() : requests(0), replies(0), retries(0), timeouts(0), rejected(0), crcErrors(0),
+                       unexpected(0), maxRoundTripUs(0), totalRoundTripUs(0) {}
+        qint64 meanRoundTripUs() const { return replies ? totalRoundTripUs / qint64(replies) : 0; }
+    };
+
+    static const quint8 RequestStart = 0xA5;
+    static const quint8 ReplyStart = 0x5A;
+    static const int MaxPayload = 32;
+
+    explicit SerialStepperBus(QObject *parent = nullptr);
+    ~SerialStepperBus();
+
+    bool open(const QString &device, int baud = CURTAIN_SERIAL_BAUD); // 打开串口并启动收发线程（断开后可重新打开）
+    void close();                      // 停止线程，未完成的请求按失败报告
+    bool isOpen() const;               // 收发循环运行中（串口断开后返回false）
+    QString device() const { return m_device; }
+
+    // 提交请求（可在任意线程调用），返回请求编号，总线未打开返回0
+    quint32 send(int address, Command command, const QByteArray &payload = QByteArray(),
+                 int timeoutMs = CURTAIN_SERIAL_TIMEOUT_MS);
+    quint32 move(int address, bool forward, quint32 steps, int stepsPerSecond);
+    quint32 stop(int address, bool decelerate);
+    quint32 queryStatus(int address);
+
+    Statistics statistics() const;
+
+    // 帧编解码（仿真驱动器共用）
+    static quint16 crc16(const char *data, int length);
+    static QByteArray encodeFrame(quint8 start, quint8 address, quint8 sequence, quint8 code,
+                                  const QByteArray &payload);
+    // 从缓冲区取出一帧并移除；跳过帧头前的杂散字节与校验错误的帧。数据不足返回false
+    static bool takeFrame(QByteArray &buffer, quint8 start, Frame *frame, quint64 *crcErrors = nullptr);
+
+signals:
+    void replyReceived(quint32 requestId, int address, int command, const QByteArray &payload); // 收发线程中发出
+    void requestFailed(quint32 requestId, int address, int command, const QString &error);      // 收发线程中发出
+    void errorOccurred(const QString &error);
+
+private:
+    friend class SerialStepperBusThread;
+
+    // 单个请求
+    struct Request {
+        quint32 id;
+        quint8 address;
+        quint8 command;
+        quint8 sequence;
+        QByteArray payload;
+        QByteArray frame;
+        int timeoutMs;
+        int attempts;              // 已发送次数
+        qint64 sentNs;             // 首次发送时刻
+        qint64 deadlineNs;         // 本次发送的应答截止时刻
+    };
+
+    void runLoop();                            // 收发循环（收发线程）
+    void takeQueued(qint64 nowNs);             // 按空闲序号把排队请求转为待应答并写入发送缓冲
+    void readAvailable(qint64 nowNs);          // 读取并分发应答
+    void writePending();                       // 发送缓冲写入串口
+    void handleTimeouts(qint64 nowNs);         // 重发或报告超时
+    int pollTimeoutMs(qint64 nowNs) const;     // 距最早截止时刻的毫秒数，无待应答请求返回-1
+    void failAll(const QString &error);        // 报告所有未完成请求失败，此后不再接受新请求
+    void wake();
+
+    QString m_device;
+    int m_fd;                          // 串口（非阻塞）
+    int m_wakeFd;                      // eventfd，新请求或退出时唤醒
+    QAtomicInt m_stopping;
+    SerialStepperBusThread *m_thread;
+
+    QList<Request> m_queued;           // 尚未发出的请求（受m_mutex保护）
+    bool m_loopExited;                 // 收发循环已退出（关闭或串口断开）
+    quint32 m_nextId;
+    Statistics m_stats;
+    mutable QMutex m_mutex;            // 保护以上成员
+
+    // 以下仅收发线程访问
+    QMap<quint8, Request> m_outstanding;   // 序号 -> 等待应答的请求
+    QMap<quint8, quint32> m_latestSent;    // 站地址 -> 最近发出的请求编号
+    QMap<quint8, quint8> m_lastSequence;   // 站地址 -> 最近使用的序号（新请求避开，防止被误当作重发）
+    quint8 m_nextSequence;
+    QByteArray m_rxBuffer;
+    QByteArray m_txBuffer;
+};
+
+#endif // SERIAL_STEPPER_BUS_H
@@ -0,0 +1,97 @@
+#ifndef SERIAL_STEPPER_EMULATOR_H
+#define SERIAL_STEPPER_EMULATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+
+class SerialStepperEmulatorThread;
+
+/**
+ * @brief 伪终端上的RS-485步进驱动器仿真
+ *
+ * 创建一对伪终端，在独立线程中按SerialStepperBus的帧格式应答master端，
+ * SerialStepperBus打开devicePath()（slave端）即可在无硬件时端到端联调。
+ * 每个站地址独立仿真：运动命令按步频推算位置，按序号去重（重发只补发应答），
+ * 可设置应答延迟、周期性丢弃请求或破坏应答校验，用于验证流水线、超时与重发。
+ */
+class SerialStepperEmulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SerialStepperEmulator(QObject *parent = nullptr);
+    ~SerialStepperEmulator();
+
+    bool start();                      // 创建伪终端并启动应答线程
+    void stop();
+    QString devicePath() const { return m_devicePath; }
+
+    // 故障注入（可在任意线程调用）
+    void setReplyDelayMs(int delayMs);
+    void setDropEvery(int count);      // 每count个请求不应答一个，0为不丢弃
+    void setCorruptEvery(int count);   // 每count个应答破坏一个校验，0为不破坏
+
+    // 仿真驱动器状态
+    qint32 position(int address) const;
+    bool isMoving(int address) const;
+    int executedCommands(int address) const; // 实际执行的命令数（不含去重的重发）
+
+signals:
+    void commandExecuted(int address, int command); // 应答线程中发出
+
+private:
+    friend class SerialStepperEmulatorThread;
+
+    // 单个仿真驱动器
+    struct Drive {
+        bool moving;
+        bool forward;
+        int stepsPerSecond;
+        quint32 remaining;         // 剩余步数，0为持续运行
+        double position;
+        qint64 updatedNs;          // 上次推算位置的时刻
+        int lastSequence;          // 最近执行的序号（-1为无）
+        QByteArray lastReply;
+        int executed;
+
+        Drive() : moving(false), forward(true), stepsPerSecond(0), remaining(0), position(0.0),
+                  updatedNs(0), lastSequence(-1), executed(0) {}
+    };
+
+    // 延迟发送的应答
+    struct PendingReply {
+        qint64 dueNs;
+        QByteArray frame;
+    };
+
+    void runLoop();                                 // 应答循环（应答线程）
+    void handleRequests();                          // 解析请求并生成应答
+    QByteArray execute(Drive &drive, quint8 command, const QByteArray &payload, quint8 *status); // 执行命令，返回应答数据
+    static void advance(Drive &drive, qint64 nowNs);  // 按步频推算位置
+
+    int m_masterFd;
+    int m_wakeFd;
+    QString m_devicePath;
+    QAtomicInt m_stopping;
+    SerialStepperEmulatorThread *m_thread;
+
+    QMap<int, Drive> m_drives;         // 站地址 -> 仿真驱动器
+    int m_replyDelayMs;
+    int m_dropEvery;
+    int m_corruptEvery;
+    quint64 m_requestCount;
+    quint64 m_replyCount;
+    mutable QMutex m_mutex;            // 保护以上成员
+
+    // 以下仅应答线程访问
+    QByteArray m_rxBuffer;
+    QByteArray m_txBuffer;
+    QList<PendingReply> m_pendingReplies;
+};
+
+#endif // SERIAL_STEPPER_EMULATOR_H
@@ -0,0 +1,118 @@
+#ifndef STEPPER_PULSE_GENERATOR_H
+#define STEPPER_PULSE_GENERATOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+#include "config/gpio_config.h"
+#include "hardware/motion_profile.h"
+
+class GPIOController;
+class GpioMmio;
+class StepperPulseThread;
+
+/**
+ * @brief 步进电机STEP/DIR脉冲发生器
+ *
+ * 独立的SCHED_FIFO线程（mlockall锁定内存）按CLOCK_MONOTONIC绝对时间输出50%占空比的STEP方波，
+ * 可同时驱动多个通道。按MotionProfile运动时每步的半周期取自预先规划的加速表，热循环只做查表。
+ * 快速引脚（GPIO_FAST_PINS）经寄存器映射单次存储翻转，
+ * 其它引脚退回GPIOController当前后端。每个边沿记录相对计划时刻的延迟，
+ * 运动结束时给出错过截止期次数与抖动统计。
+ */
+class StepperPulseGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 单次运动的时序统计（边沿实际时刻相对计划时刻）
+    struct Statistics {
+        quint64 steps;           // 已输出步数
+        quint64 edges;           // 边沿数
+        quint64 missedDeadlines; // 延迟超过STEPPER_DEADLINE_MISS_US的边沿数
+        qint64 maxLatenessNs;    // 最大延迟
+        qint64 meanLatenessNs;   // 平均延迟
+        qint64 jitterNs;         // 延迟标准差
+        bool fastPath;           // 是否经寄存器映射输出
+
+        Statistics() : steps(0), edges(0), missedDeadlines(0), maxLatenessNs(0),
+                       meanLatenessNs(0), jitterNs(0), fastPath(false) {}
+    };
+
+    explicit StepperPulseGenerator(GPIOController *controller, QObject *parent = nullptr);
+    ~StepperPulseGenerator();
+
+    bool start();                      // 启动脉冲线程
+    void stop();                       // 停止线程，所有STEP引脚置低
+    bool isRunning() const;
+
+    // 运动控制（可在任意线程调用）
+    // dirPin为-1时由调用方预先设置方向；steps为0时持续运行直到halt()
+    bool move(int stepPin, int dirPin, bool forward, quint64 steps, int stepsPerSecond); // 恒速
+    bool move(int stepPin, int dirPin, bool forward, const MotionProfile &profile);      // 按加减速规划
+    void halt(int stepPin, bool decelerate = false); // 在当前脉冲结束后停止并取消等待换向的命令；decelerate时先按加速表减速
+    bool isMoving(int stepPin) const;
+    Statistics lastStatistics(int stepPin) const; // 最近一次结束的运动的统计
+
+signals:
+    void moveFinished(int stepPin, quint64 steps, bool halted); // 运动结束（脉冲线程中发出）
+    void errorOccurred(const QString &error);
+
+private:
+    friend class StepperPulseThread;
+
+    // 线程间传递的命令
+    struct Command {
+        int stepPin;
+        int dirPin;
+        bool forward;
+        quint64 steps;
+        qint64 halfPeriodNs;     // 巡航半周期
+        const quint32 *ramp;     // 加速表，nullptr为恒速
+        int rampLength;
+        bool halt;
+        bool decelerate;
+    };
+
+    // 脉冲线程内的通道状态（仅脉冲线程访问）
+    struct Channel {
+        int stepPin;
+        quint64 targetSteps;     // 0为持续运行
+        qint64 halfPeriodNs;     // 当前步的半周期
+        qint64 cruiseHalfPeriodNs;
+        const quint32 *ramp;
+        int rampLength;
+        int rampIndex;           // 当前速度在加速表中的位置（已用加速步数）
+        qint64 nextEdgeNs;       // 下一个边沿的计划时刻
+        bool level;              // STEP当前电平
+        bool halting;
+        GpioMmio *fastIo;        // 非空时经寄存器映射输出
+        Statistics stats;
+        double latencySum;       // 用于计算均值与标准差
+        double latencySquareSum;
+    };
+
+    bool enqueueMove(const Command &command, int stepsPerSecond);
+    void runLoop();                    // 脉冲线程主循环
+    void takeCommands(QVector<Channel> &channels); // 合并待处理命令
+    void writeStep(const Channel &channel);
+    void finishChannel(Channel &channel);
+    void recordLateness(Channel &channel, qint64 latenessNs);
+
+    GPIOController *m_gpioController;
+    StepperPulseThread *m_thread;
+    QAtomicInt m_stopping;
+    QAtomicInt m_commandsPending;      // 脉冲线程在边沿之间检查，避免每个边沿加锁
+    QList<Command> m_commands;         // 待处理命令
+    QMap<int, bool> m_moving;          // 运动中的STEP引脚
+    QMap<int, Statistics> m_lastStatistics;
+    mutable QMutex m_mutex;            // 保护以上容器
+    QWaitCondition m_commandReady;     // 空闲时等待命令
+};
+
+#endif // STEPPER_PULSE_GENERATOR_H
@@ -0,0 +1,214 @@
+#ifndef SYSFS_IO_H
+#define SYSFS_IO_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <random>
+
+#include <errno.h>
+
+/**
+ * @brief sysfs属性文件访问接口抽象
+ *
+ * GPIOController（sysfs后端）与PWMController通过本接口访问 /sys/class 下的属性文件，
+ * 路径始终使用内核中的逻辑路径（如 /sys/class/gpio/export），由实现决定映射到何处。
+ * 返回值语义与系统调用一致：成功返回fd或字节数，失败返回-1并设置errno。
+ * - KernelSysfsIo：真实sysfs
+ * - MirroredSysfsIo：tmpfs目录中的镜像树，模拟导出等内核行为，可用shell直接查看状态
+ * - MemorySysfsIo：纯内存实现，可注入每次操作的延迟与失败
+ */
+class SysfsIo
+{
+public:
+    virtual ~SysfsIo() {}
+
+    virtual int open(const QString &path, int flags) = 0;          // flags为O_RDONLY/O_WRONLY/O_RDWR
+    virtual int write(int fd, const char *data, int length) = 0;   // 从偏移0写入（pwrite语义）
+    virtual int read(int fd, char *buffer, int length) = 0;        // 从偏移0读取（pread语义）
+    virtual void close(int fd) = 0;
+    virtual bool exists(const QString &path) = 0;                  // 文件或目录是否存在
+    virtual QStringList entries(const QString &dirPath) = 0;       // 目录下的条目名
+    virtual bool pollable() const { return false; }                // fd能否加入epoll等待POLLPRI
+    virtual QString name() const = 0;                              // 后端名称（日志用）
+
+    // 便利函数：打开-读写-关闭
+    bool writeFile(const QString &path, const QByteArray &data);
+    QByteArray readFile(const QString &path, bool *ok = nullptr);
+
+    // 进程默认实例，由SYSFS_IO_BACKEND选择，不需要释放
+    static SysfsIo *defaultIo();
+};
+
+/**
+ * @brief 真实sysfs实现
+ *
+ * root非空时逻辑路径加此前缀，可指向临时目录中的普通文件树（基准测试以真实open/pwrite计时）。
+ */
+class KernelSysfsIo : public SysfsIo
+{
+public:
+    explicit KernelSysfsIo(const QString &root = QString()) : m_root(root) {}
+
+    int open(const QString &path, int flags) override;
+    int write(int fd, const char *data, int length) override;
+    int read(int fd, char *buffer, int length) override;
+    void close(int fd) override;
+    bool exists(const QString &path) override;
+    QStringList entries(const QString &dirPath) override;
+    bool pollable() const override { return m_root.isEmpty(); } // 普通文件不支持POLLPRI
+    QString name() const override { return m_root.isEmpty() ? "kernel" : "rootfs"; }
+
+private:
+    QString m_root;
+};
+
+/**
+ * @brief 模拟内核行为的sysfs树（公共部分）
+ *
+ * 在路径层面模拟 gpio/pwm 的导出、注销与属性校验：
+ * - 写 gpio/export 创建 gpioN/{value,direction,edge,active_low}，重复导出返回EBUSY
+ * - direction接受 in/out/high/low，输入引脚写value返回EPERM
+ * - 写 pwmchipN/export 创建 pwmM/{period,duty_cycle,enable,polarity}，duty_cycle不得超过period
+ * 存储由子类提供。
+ */
+class EmulatedSysfsIo : public SysfsIo
+{
+public:
+    // 可注入的操作类型
+    enum Operation {
+        OpenOperation,
+        ReadOperation,
+        WriteOperation,
+        ListOperation,
+        OperationCount
+    };
+
+    int open(const QString &path, int flags) override;
+    int write(int fd, const char *data, int length) override;
+    int read(int fd, char *buffer, int length) override;
+    void close(int fd) override;
+    bool exists(const QString &path) override;
+    QStringList entries(const QString &dirPath) override;
+
+protected:
+    EmulatedSysfsIo();
+    void populate(int pwmChips, int channelsPerChip); // 创建gpio与pwmchip骨架，子类构造完成后调用
+
+    // 存储原语（调用时已持有m_mutex）
+    virtual bool storeIsDir(const QString &path) const = 0;
+    virtual bool storeIsFile(const QString &path) const = 0;
+    virtual bool storeRead(const QString &path, QByteArray &data) const = 0;
+    virtual bool storeWrite(const QString &path, const QByteArray &data) = 0;
+    virtual void storeMkdir(const QString &path) = 0;
+    virtual void storeRemove(const QString &path) = 0; // 递归删除
+    virtual QStringList storeList(const QString &dirPath) const = 0;
+
+    // 注入点：返回false时操作失败（errno已设置），在加锁前调用
+    virtual bool beforeOperation(Operation operation) { Q_UNUSED(operation) return true; }
+
+private:
+    struct Handle {
+        QString path;
+        int flags;
+    };
+
+    int applyWrite(const QString &path, const QByteArray &value); // 执行写入及其内核副作用，返回0或errno
+    QByteArray attribute(const QString &path) const;              // 读取属性（去除换行）
+
+    QMap<int, Handle> m_handles;
+    int m_nextHandle;
+
+protected:
+    mutable QMutex m_mutex;
+};
+
+/**
+ * @brief tmpfs镜像sysfs树
+ *
+ * 逻辑路径映射到 root + 路径（如 /dev/shm/greenhouse-sysfs/sys/class/gpio），
+ * 每次读写都经过真实的文件系统调用。
+ */
+class MirroredSysfsIo : public EmulatedSysfsIo
+{
+public:
+    explicit MirroredSysfsIo(const QString &root, int pwmChips = 4, int channelsPerChip = 1);
+
+    QString root() const { return m_root; }
+    QString name() const override { return "tmpfs"; }
+
+protected:
+    bool storeIsDir(const QString &path) const override;
+    bool storeIsFile(const QString &path) const override;
+    bool storeRead(const QString &path, QByteArray &data) const override;
+    bool storeWrite(const QString &path, const QByteArray &data) override;
+    void storeMkdir(const QString &path) override;
+    void storeRemove(const QString &path) override;
+    QStringList storeList(const QString &dirPath) const override;
+
+private:
+    QString m_root;
+};
+
+/**
+ * @brief 纯内存sysfs树
+ *
+ * 支持按操作类型注入固定延迟和失败（概率或接下来N次），并统计操作次数，
+ * 用于在开发机上比较各后端的吞吐与尾延迟、验证错误处理路径。
+ */
+class MemorySysfsIo : public EmulatedSysfsIo
+{
+public:
+    explicit MemorySysfsIo(int pwmChips = 4, int channelsPerChip = 1);
+
+    QString name() const override { return "memory"; }
+
+    // 注入配置（可在任意线程调用）
+    void setLatency(Operation operation, qint64 latencyNs);          // 每次操作的附加延迟
+    void setFailureRate(Operation operation, double probability, int error = EIO); // 随机失败概率（0-1）
+    void failNext(Operation operation, int count, int error = EIO);  // 接下来count次操作失败
+    void clearInjection();                                           // 清除所有注入
+
+    // 统计
+    quint64 operationCount(Operation operation) const;
+    quint64 failureCount(Operation operation) const;
+    void resetCounters();
+
+protected:
+    bool storeIsDir(const QString &path) const override;
+    bool storeIsFile(const QString &path) const override;
+    bool storeRead(const QString &path, QByteArray &data) const override;
+    bool storeWrite(const QString &path, const QByteArray &data) override;
+    void storeMkdir(const QString &path) override;
+    void storeRemove(const QString &path) override;
+    QStringList storeList(const QString &dirPath) const override;
+
+    bool beforeOperation(Operation operation) override;
+
+private:
+    // 单类操作的注入设置与统计
+    struct Injection {
+        qint64 latencyNs;
+        double failureRate;
+        int failureError;
+        int failNextCount;
+        int failNextError;
+        quint64 operations;
+        quint64 failures;
+
+        Injection() : latencyNs(0), failureRate(0.0), failureError(0),
+                      failNextCount(0), failNextError(0), operations(0), failures(0) {}
+    };
+
+    QMap<QString, QByteArray> m_files;   // 路径 -> 内容
+    QSet<QString> m_dirs;                // 目录路径
+    Injection m_injection[OperationCount];
+    std::mt19937 m_random;
+    mutable QMutex m_injectionMutex;     // 保护注入设置与统计
+};
+
+#endif // SYSFS_IO_H
@@ -5,6 +5,7 @@
 #include <QString>
 #include <QJsonObject>
 #include <QTimer>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 class QTcpSocket;
@@ -31,18 +32,27 @@ public:
     };
 
     // 设备数据结构
+    // 补光灯单个PWM通道的占空比
+    struct PwmChannelData {
+        QString key;            // 通道标识（PWM_CHANNELS）
+        int dutyPermille;       // 占空比(‰)
+
+        PwmChannelData() : dutyPermille(0) {}
+        PwmChannelData(const QString &channelKey, int permille) : key(channelKey), dutyPermille(permille) {}
+    };
+
     struct DeviceData {
         double temperature;     // 温度(°C)
         double humidity;        // 湿度(%)
         double lightIntensity;  // 光照强度(lux)
-        int pwmDutyCycle;      // PWM占空比(%)
+        QVector<PwmChannelData> pwmChannels; // 各补光通道占空比，第一项为主通道
         bool curtainTopOpen;   // 顶部保温帘状态
         bool curtainSideOpen;  // 侧部保温帘状态
         QString timestamp;     // 时间戳
         bool isValid;          // 数据有效性
 
         DeviceData() : temperature(0), humidity(0), lightIntensity(0),
-                      pwmDutyCycle(0), curtainTopOpen(false), curtainSideOpen(false),
+                      curtainTopOpen(false), curtainSideOpen(false),
                       isValid(false) {}
     };
 
@@ -0,0 +1,94 @@
+#ifndef BRING_UP_COORDINATOR_H
+#define BRING_UP_COORDINATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+#include <functional>
+
+class QThreadPool;
+
+/**
+ * @brief 硬件启动协调器
+ *
+ * 按依赖关系并行执行各设备的初始化：无依赖关系的任务在工作线程池中同时运行，
+ * 任务完成后在协调器所在线程（GUI线程）中调度后续任务，因此主窗口在硬件初始化期间
+ * 即可绘制与响应。依赖失败的任务被跳过。全部结束后输出各任务的等待与执行耗时。
+ *
+ * 需要创建QObject子对象、启动定时器或操作界面的任务使用MainThread在GUI线程中执行，
+ * 这类任务总是经事件循环派发，不会在start()内同步运行。
+ */
+class BringUpCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 任务执行线程
+    enum Affinity {
+        WorkerThread,    // 工作线程池
+        MainThread       // 协调器所在线程
+    };
+
+    // 任务状态
+    enum State {
+        Pending,         // 等待依赖
+        Running,         // 执行中
+        Succeeded,       // 成功
+        Failed,          // 失败
+        Skipped          // 依赖失败而跳过
+    };
+
+    explicit BringUpCoordinator(QObject *parent = nullptr);
+    ~BringUpCoordinator();
+
+    // 登记任务（start()前调用），依赖必须是已登记的任务名
+    bool addTask(const QString &name, const std::function<bool()> &function,
+                 const QStringList &dependencies = QStringList(), Affinity affinity = WorkerThread);
+
+    bool start();                    // 开始执行，依赖关系有环或引用未知任务时返回false
+    bool isFinished() const { return m_started && m_remaining == 0; }
+    void abort();                    // 不再派发新任务，并等待执行中的工作线程任务返回（退出前调用）
+
+    State taskState(const QString &name) const;
+    QString report() const;          // 各任务耗时明细
+
+signals:
+    void taskFinished(const QString &name, bool success, qint64 elapsedMs); // 单个任务结束（跳过时elapsedMs为0）
+    void finished(bool allSucceeded, qint64 elapsedMs);                     // 全部结束
+
+private:
+    struct Task {
+        QString name;
+        std::function<bool()> function;
+        QVector<int> dependencies;   // 依赖任务下标
+        Affinity affinity;
+        State state;
+        qint64 readyNs;              // 依赖满足的时刻（相对start()）
+        qint64 startNs;              // 开始执行的时刻
+        qint64 finishNs;             // 结束的时刻
+
+        Task() : affinity(WorkerThread), state(Pending), readyNs(0), startNs(0), finishNs(0) {}
+    };
+
+    int indexOf(const QString &name) const;
+    bool hasCycle() const;
+    void dispatchReady();            // 派发依赖已满足的任务
+    void runTask(int index, const std::function<bool()> &function); // 执行任务函数（任意线程）
+    void onTaskDone(int index, bool success, qint64 startNs, qint64 finishNs); // 协调器线程中调用
+
+    friend class BringUpRunnable;
+
+    QVector<Task> m_tasks;
+    QThreadPool *m_pool;             // 专用线程池，不占用全局线程池
+    QElapsedTimer m_clock;
+    bool m_started;
+    QAtomicInt m_aborted;            // 工作线程中读取
+    int m_remaining;                 // 尚未结束的任务数
+    bool m_allSucceeded;
+};
+
+#endif // BRING_UP_COORDINATOR_H
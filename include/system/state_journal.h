@@ -0,0 +1,133 @@
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "config/gpio_config.h"
+
+class StateJournalThread;
+
+/**
+ * @brief 执行器状态日志
+ *
+ * 控制器在状态变化时追加一条定长记录（类别、键、数值、墙上时间、CRC32），write()进入页缓存后即返回，
+ * 进程崩溃不会丢失；后台线程在首条未落盘记录之后STATE_JOURNAL_SYNC_MS批量fdatasync，防止断电丢失。
+ * 打开时mmap整个文件顺序回放，每个（类别，键）保留最后一条记录，末尾写了一半的记录被截掉。
+ * 追加的记录数达到STATE_JOURNAL_COMPACT_RECORDS时，后台线程把当前状态写成快照文件并原子替换，
+ * 压缩期间追加的记录随后补写到新文件中。
+ * record()可在任意线程调用，与最后一条记录相同的状态不重复追加。
+ */
+class StateJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 记录类别
+    enum Kind {
+        CurtainPosition = 1,   // 键：执行器标识的keyFor()；数值：开度×1000；辅助值：运动起点×1000；标志见CurtainFlags
+        PumpDeadline = 2,      // 键：泵引脚；数值：运行截止的墙上时间（毫秒），0为未运行；辅助值：请求时长（毫秒）
+        PwmDuty = 3            // 键：(芯片<<8)|通道；数值：占空比（纳秒，带PwmNanoseconds时）或百分比（旧记录）；辅助值：周期（纳秒）
+    };
+
+    // 保温帘记录标志
+    enum CurtainFlags {
+        CurtainMoving = 0x1,
+        CurtainCalibrated = 0x2
+    };
+
+    // PWM记录标志
+    enum PwmFlags {
+        PwmNanoseconds = 0x1   // 数值为纳秒，按辅助值中的周期换算；无此标志时为百分比
+    };
+
+    // 回放得到的最新状态
+    struct Entry {
+        qint64 value;
+        qint64 aux;
+        quint32 flags;
+        qint64 wallMs;         // 记录时刻（墙上时间，毫秒）
+
+        Entry() : value(0), aux(0), flags(0), wallMs(0) {}
+    };
+
+    // 日志统计
+    struct Statistics {
+        quint64 replayed;      // 打开时回放的有效记录
+        quint64 discarded;     // 打开时截掉的无效字节
+        quint64 appended;      // 本次运行追加的记录
+        quint64 skipped;       // 与最新状态相同未追加的记录
+        quint64 syncs;         // fdatasync次数
+        quint64 compactions;   // 压缩次数
+
+        Statistics() : replayed(0), discarded(0), appended(0), skipped(0), syncs(0), compactions(0) {}
+    };
+
+    explicit StateJournal(QObject *parent = nullptr);
+    ~StateJournal();
+
+    bool open(const QString &path);    // 回放并启动落盘线程
+    void close();                      // 落盘并停止线程
+    bool isOpen() const { return m_thread != nullptr; }
+
+    bool record(Kind kind, int key, qint64 value, qint64 aux = 0, quint32 flags = 0); // 任意线程
+    bool lookup(Kind kind, int key, Entry *entry) const;
+    QList<int> keys(Kind kind) const;  // 某类别已记录的键
+
+    Statistics statistics() const;
+
+    static quint16 keyFor(const QString &name); // 字符串标识映射为16位键
+    static qint64 wallMs();            // 当前墙上时间（毫秒）
+
+signals:
+    void errorOccurred(const QString &error);
+
+private:
+    friend class StateJournalThread;
+
+    // 磁盘记录（本机字节序）
+    struct Record {
+        quint32 magic;
+        quint32 sequence;
+        quint16 kind;
+        quint16 key;
+        quint32 flags;
+        qint64 wallMs;
+        qint64 value;
+        qint64 aux;
+        quint32 reserved;
+        quint32 crc;           // 覆盖之前的全部字段
+    };
+
+    static quint32 crc32(const void *data, int length);
+    static quint32 slot(int kind, int key) { return (quint32(kind) << 16) | quint16(key); }
+
+    bool replay();                     // mmap回放并截掉尾部无效数据
+    bool appendLocked(const Record &record); // 写入当前文件（持有m_mutex）
+    bool writeRecords(int fd, const QList<Record> &records);
+    void runLoop();                    // 批量落盘与压缩（落盘线程）
+    void syncNow();
+    bool compact();                    // 快照写入临时文件后替换日志
+    void wake();
+
+    QString m_path;
+    int m_fd;                          // 日志文件（O_APPEND）
+    int m_wakeFd;                      // eventfd，首条未落盘记录或退出时唤醒
+    QAtomicInt m_stopping;
+    StateJournalThread *m_thread;
+
+    QMap<quint32, Record> m_latest;    // （类别，键）-> 最新记录
+    quint32 m_sequence;
+    qint64 m_dirtySinceNs;             // 首条未落盘记录的时刻（0为已全部落盘）
+    int m_sinceCompaction;             // 自上次压缩起追加的记录数
+    bool m_compacting;
+    QList<Record> m_carry;             // 压缩期间追加、需补写到新文件的记录
+    Statistics m_stats;
+    mutable QMutex m_mutex;            // 保护以上成员与m_fd的写入
+};
+
+#endif // STATE_JOURNAL_H
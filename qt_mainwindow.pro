@@ -1,6 +1,11 @@
 QT       += core gui widgets network
 
-CONFIG += c++11
+CONFIG += c++14
+
+# QRecursiveMutex需要Qt 5.14及以上
+lessThan(QT_MAJOR_VERSION, 5)|equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 14) {
+    error("需要Qt 5.14或更高版本")
+}
 
 # 项目信息
 TARGET = wonderfulnewworld
@@ -10,39 +15,39 @@ VERSION = 1.0.0
 # 包含路径
 INCLUDEPATH += include
 
+# 硬件控制与执行器模块（与tests/、benchmarks/共用）
+include(control_modules.pri)
+
 # 源文件 - 按功能模块组织
 SOURCES += \
     main.cpp \
     src/core/mainwindow.cpp \
     src/ui/ui_manager.cpp \
-    src/hardware/pwm_controller.cpp \
-    src/hardware/gpio_controller.cpp \
     src/hardware/gy30_sensor.cpp \
     src/hardware/gy30_light_sensor.cpp \
-    src/device/curtain_controller.cpp \
     src/ai/ai_decision_manager.cpp \
+    src/ai/daylight_controller.cpp \
     src/integration/yolov8_integration.cpp \
     src/network/weather_service.cpp \
     src/network/mqtt_service.cpp \
-    src/system/window_manager.cpp
+    src/system/window_manager.cpp \
+    src/system/bring_up_coordinator.cpp
 
 # 头文件 - 按功能模块组织
 HEADERS += \
     include/core/mainwindow.h \
     include/ui/ui_manager.h \
-    include/hardware/pwm_controller.h \
-    include/hardware/gpio_controller.h \
     include/hardware/gy30_sensor.h \
     include/hardware/gy30_light_sensor.h \
-    include/device/curtain_controller.h \
     include/ai/ai_decision_manager.h \
+    include/ai/daylight_controller.h \
     include/integration/yolov8_integration.h \
     include/network/weather_service.h \
     include/network/mqtt_service.h \
     include/config/aliyun_config.h \
-    include/config/gpio_config.h \
     include/config/ai_config.h \
     include/system/window_manager.h \
+    include/system/bring_up_coordinator.h
 
 
 # UI文件
@@ -1,7 +1,9 @@
 #include "ai/ai_decision_manager.h"
 #include "device/curtain_controller.h"
+#include "device/curtain_command_queue.h"
 #include "hardware/gy30_light_sensor.h"
 #include "config/ai_config.h"
+#include "config/gpio_config.h"
 
 #include <QDebug>
 #include <QTimer>
@@ -17,6 +19,9 @@ AIDecisionManager::AIDecisionManager(QObject *parent)
     , m_openThreshold(AI_LIGHT_OPEN_THRESHOLD)      // 光照>500开帘
     , m_closeThreshold(AI_LIGHT_CLOSE_THRESHOLD)     // 光照<300关帘
     , m_operationDuration(AI_OPERATION_DURATION * 1000)   // 18秒操作时间
+    , m_openPosition(AI_OPEN_POSITION_PERCENT)
+    , m_closePosition(AI_CLOSE_POSITION_PERCENT)
+    , m_commandId(0)
     , m_lastLightValue(0.0f)
     , m_debounceTimer(new QTimer(this))
 {
@@ -55,6 +60,8 @@ bool AIDecisionManager::initialize()
     // 连接光照传感器信号
     connect(m_lightSensor, &GY30LightSensor::luxValueChanged,
             this, &AIDecisionManager::onLightValueChanged);
+    connect(m_curtainController->commandQueue(), &CurtainCommandQueue::commandFinished,
+            this, &AIDecisionManager::onCommandFinished);
 
     m_initialized = true;
     qDebug() << "AI智能决策管理器初始化完成";
@@ -118,6 +125,13 @@ void AIDecisionManager::setOperationDuration(int seconds)
     qDebug() << QString("操作持续时间已更新: %1秒").arg(seconds);
 }
 
+void AIDecisionManager::setPositionTargets(double openPercent, double closePercent)
+{
+    m_openPosition = qBound(0.0, openPercent, 100.0);
+    m_closePosition = qBound(0.0, closePercent, 100.0);
+    qDebug() << QString("AI目标开度已更新: 开帘%1%, 关帘%2%").arg(m_openPosition).arg(m_closePosition);
+}
+
 void AIDecisionManager::onLightValueChanged(float lux)
 {
     if (m_state != Enabled) {
@@ -168,6 +182,14 @@ void AIDecisionManager::executeOperation(OperationType operation)
         return;
     }
 
+    // 已在目标开度时不再运动，也不锁定手动控制
+    const double target = (operation == OpenCurtain) ? m_openPosition : m_closePosition;
+    const double current = m_curtainController->getCurtainPosition(CurtainController::TopCurtain);
+    if (qAbs(current - target) < CURTAIN_POSITION_TOLERANCE_PERCENT
+            && m_curtainController->isPositionCalibrated(CurtainController::TopCurtain)) {
+        return;
+    }
+
     // 切换到操作状态
     m_state = Operating;
     m_currentOperation = operation;
@@ -177,25 +199,31 @@ void AIDecisionManager::executeOperation(OperationType operation)
     // 锁定手动控制
     lockManualControl();
 
-    // 执行具体操作
-    bool success = false;
-    if (operation == OpenCurtain) {
-        success = m_curtainController->openTopCurtain();
-        qDebug() << "AI决策执行：开启上帘";
-    } else if (operation == CloseCurtain) {
-        success = m_curtainController->closeTopCurtain();
-        qDebug() << "AI决策执行：关闭上帘";
+    // 执行具体操作：经命令队列运动到目标开度，由保温帘控制器按位置模型停机，失败在onCommandFinished中处理
+    m_commandId = m_curtainController->commandQueue()->submit(CurtainController::TopCurtain,
+            CurtainCommandQueue::MoveTo, target, "AI决策");
+    qDebug() << QString("AI决策执行：%1上帘至%2%").arg(operation == OpenCurtain ? "开启" : "关闭").arg(target);
+
+    // 操作时长：行程已标定时按预计运动时间加余量，否则使用固定时长
+    const int travelMs = m_curtainController->expectedTravelMs(CurtainController::TopCurtain, target);
+    const int durationMs = (travelMs > 0) ? travelMs + AI_OPERATION_MARGIN_MS : m_operationDuration;
+    m_operationTimer->start(durationMs);
+    qDebug() << QString("AI决策操作开始，%1秒后自动结束%2").arg(durationMs / 1000.0, 0, 'f', 1)
+                .arg(travelMs > 0 ? "（按标定行程）" : "");
+}
+
+void AIDecisionManager::onCommandFinished(quint64 id, CurtainController::CurtainType type, CurtainCommandQueue::Result result)
+{
+    Q_UNUSED(type)
+    if (id != m_commandId || m_state != Operating) {
+        return;
     }
 
-    if (!success) {
+    if (result == CurtainCommandQueue::Failed) {
         emit errorOccurred("AI决策操作执行失败");
+        m_operationTimer->stop();
         onOperationTimeout(); // 立即结束操作
-        return;
     }
-
-    // 启动18秒定时器
-    m_operationTimer->start(m_operationDuration);
-    qDebug() << QString("AI决策操作开始，%1秒后自动结束").arg(m_operationDuration / 1000);
 }
 
 void AIDecisionManager::onOperationTimeout()
@@ -204,12 +232,6 @@ void AIDecisionManager::onOperationTimeout()
         return;
     }
 
-    // 停止操作
-    if (m_currentOperation == OpenCurtain || m_currentOperation == CloseCurtain) {
-        m_curtainController->pauseTopCurtain(); // 暂停操作
-        qDebug() << "AI决策操作时间到，暂停遮光帘";
-    }
-
     // 解锁手动控制
     unlockManualControl();
 
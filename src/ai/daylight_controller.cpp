@@ -0,0 +1,387 @@
+#include "ai/daylight_controller.h"
+#include "hardware/pwm_controller.h"
+#include "hardware/gy30_light_sensor.h"
+#include "config/ai_config.h"
+
+#include <QThread>
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 补光闭环控制线程
+ */
+class DaylightLoopThread : public QThread
+{
+public:
+    explicit DaylightLoopThread(DaylightController *controller) : m_controller(controller) {}
+
+protected:
+    void run() override { m_controller->runLoop(); }
+
+private:
+    DaylightController *m_controller;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+DaylightController::Tuning::Tuning()
+    : kp(DAYLIGHT_KP)
+    , ki(DAYLIGHT_KI)
+    , kd(DAYLIGHT_KD)
+    , deadbandLux(DAYLIGHT_DEADBAND_LUX)
+    , minPermille(DAYLIGHT_MIN_PERMILLE)
+    , maxPermille(DAYLIGHT_MAX_PERMILLE)
+{
+}
+
+DaylightController::DaylightController(QObject *parent)
+    : QObject(parent)
+    , m_pwmController(nullptr)
+    , m_thread(nullptr)
+    , m_timerFd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_enabled(false)
+    , m_enabledSeq(0)
+    , m_targetLux(DAYLIGHT_TARGET_LUX)
+    , m_sampleLux(0.0f)
+    , m_sampleSimulated(false)
+    , m_sampleNs(0)
+    , m_sampleSeq(0)
+    , m_resetState(false)
+    , m_integral(0.0)
+    , m_lastLux(0.0)
+    , m_derivative(0.0)
+    , m_lastSampleNs(0)
+    , m_lastSeq(0)
+    , m_lastTickNs(0)
+    , m_output(0)
+{
+}
+
+DaylightController::~DaylightController()
+{
+    stop();
+}
+
+void DaylightController::setPWMController(PWMController *controller)
+{
+    m_pwmController = controller;
+}
+
+void DaylightController::setLightSensor(GY30LightSensor *sensor)
+{
+    if (!sensor) {
+        return;
+    }
+    // 直接连接：样本在传感器线程写入，控制线程按周期读取最新值
+    connect(sensor, &GY30LightSensor::luxSampled, this, [this](float lux, bool simulated) {
+        submitLux(lux, simulated);
+    }, Qt::DirectConnection);
+}
+
+bool DaylightController::start()
+{
+    if (m_thread) {
+        return true;
+    }
+    if (!m_pwmController) {
+        emit errorOccurred("补光闭环未设置PWM控制器");
+        return false;
+    }
+
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_timerFd < 0 || m_wakeFd < 0) {
+        emit errorOccurred(QString("补光闭环定时器创建失败: %1").arg(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    // 周期定时，首次到期即为一个周期之后
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = DAYLIGHT_LOOP_PERIOD_MS / 1000;
+    spec.it_interval.tv_nsec = (DAYLIGHT_LOOP_PERIOD_MS % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(m_timerFd, 0, &spec, nullptr) < 0) {
+        emit errorOccurred(QString("补光闭环定时器设置失败: %1").arg(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    m_lastTickNs = 0;
+    m_stopping.storeRelease(0);
+    m_thread = new DaylightLoopThread(this);
+    m_thread->start(QThread::HighPriority);
+    qDebug() << QString("补光闭环线程已启动，周期%1ms，目标%2lux，%3")
+                .arg(DAYLIGHT_LOOP_PERIOD_MS).arg(targetLux()).arg(isEnabled() ? "已开启" : "未开启");
+    return true;
+}
+
+void DaylightController::stop()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        quint64 one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qWarning() << "补光闭环线程唤醒失败:" << strerror(errno);
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+
+        const Statistics stats = statistics();
+        qDebug() << QString("补光闭环统计: 周期%1次，错过%2次，样本过期%3次，饱和%4次，平均误差%5lux，"
+                            "耗电%6Wh，节省%7Wh，最大抖动%8us")
+                    .arg(stats.ticks).arg(stats.overruns).arg(stats.staleTicks).arg(stats.saturatedTicks)
+                    .arg(stats.regulatedSeconds > 0.0 ? stats.absErrorLuxSeconds / stats.regulatedSeconds : 0.0, 0, 'f', 1)
+                    .arg(stats.energyUsedWh, 0, 'f', 2).arg(stats.energySavedWh, 0, 'f', 2)
+                    .arg(stats.maxJitterNs / 1000);
+    }
+
+    if (m_timerFd >= 0) {
+        close(m_timerFd);
+        m_timerFd = -1;
+    }
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+}
+
+void DaylightController::setEnabled(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_enabled == enabled) {
+            return;
+        }
+        m_enabled = enabled;
+        m_enabledSeq++;
+        m_resetState = enabled; // 下一周期以当前占空比初始化积分项
+    }
+    qDebug() << QString("补光闭环%1").arg(enabled ? "开启" : "关闭");
+    emit enabledChanged(enabled);
+}
+
+bool DaylightController::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+void DaylightController::setTargetLux(double lux)
+{
+    QMutexLocker locker(&m_mutex);
+    m_targetLux = qMax(0.0, lux);
+}
+
+double DaylightController::targetLux() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_targetLux;
+}
+
+void DaylightController::setTuning(const Tuning &tuning)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tuning = tuning;
+    m_tuning.minPermille = qBound(0, tuning.minPermille, 1000);
+    m_tuning.maxPermille = qBound(m_tuning.minPermille, tuning.maxPermille, 1000);
+}
+
+DaylightController::Tuning DaylightController::tuning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tuning;
+}
+
+void DaylightController::submitLux(float lux, bool simulated)
+{
+    QMutexLocker locker(&m_mutex);
+    m_sampleLux = lux;
+    m_sampleSimulated = simulated;
+    m_sampleNs = monotonicNs();
+    m_sampleSeq++;
+}
+
+DaylightController::Statistics DaylightController::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void DaylightController::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stats = Statistics();
+}
+
+void DaylightController::runLoop()
+{
+    struct pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_stopping.loadAcquire()) {
+        const int count = poll(fds, 2, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "补光闭环等待失败:" << strerror(errno);
+            break;
+        }
+
+        quint64 value;
+        if ((fds[1].revents & POLLIN) && read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "补光闭环唤醒读取失败:" << strerror(errno);
+        }
+        // 到期次数大于1说明错过了周期，按实际间隔计算，不补跑
+        if ((fds[0].revents & POLLIN) && read(m_timerFd, &value, sizeof(value)) > 0 && value > 0) {
+            tick(monotonicNs(), value);
+        }
+    }
+}
+
+void DaylightController::tick(qint64 nowNs, quint64 expirations)
+{
+    const qint64 periodNs = qint64(DAYLIGHT_LOOP_PERIOD_MS) * 1000000LL;
+    const qint64 intervalNs = m_lastTickNs ? nowNs - m_lastTickNs : periodNs;
+    const double dt = double(intervalNs) / 1e9;
+    m_lastTickNs = nowNs;
+
+    // 在锁内取快照，运算与写入在锁外进行
+    bool enabled;
+    quint64 enabledSeq;
+    bool reset;
+    bool fresh;
+    double target;
+    Tuning tuning;
+    float lux;
+    qint64 sampleNs;
+    quint64 sampleSeq;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.ticks++;
+        m_stats.overruns += expirations - 1;
+        const qint64 jitterNs = qAbs(intervalNs - periodNs);
+        m_stats.maxJitterNs = qMax(m_stats.maxJitterNs, jitterNs);
+        m_stats.totalJitterNs += jitterNs;
+
+        enabled = m_enabled;
+        enabledSeq = m_enabledSeq;
+        reset = m_resetState;
+        m_resetState = false;
+        target = m_targetLux;
+        tuning = m_tuning;
+        lux = m_sampleLux;
+        sampleNs = m_sampleNs;
+        sampleSeq = m_sampleSeq;
+        fresh = sampleNs > 0 && !m_sampleSimulated
+                && nowNs - sampleNs <= qint64(DAYLIGHT_SAMPLE_TIMEOUT_MS) * 1000000LL;
+
+        // 能耗按上一周期保持的输出计算（灯串功率与占空比近似成正比）
+        if (enabled && !reset) {
+            const double hours = dt / 3600.0;
+            m_stats.energyUsedWh += DAYLIGHT_LAMP_POWER_W * m_output / 1000.0 * hours;
+            m_stats.energySavedWh += DAYLIGHT_LAMP_POWER_W * (DAYLIGHT_BASELINE_PERMILLE - m_output) / 1000.0 * hours;
+        }
+        if (enabled && !fresh) {
+            m_stats.staleTicks++;
+        }
+    }
+
+    if (!enabled) {
+        return;
+    }
+
+    // 无扰切换：积分项从当前占空比开始，微分从下一个样本开始计算
+    if (reset) {
+        m_output = qBound(tuning.minPermille, m_pwmController->getCurrentDutyPermille(), tuning.maxPermille);
+        m_integral = m_output;
+        m_derivative = 0.0;
+        m_lastSampleNs = 0;
+        m_lastSeq = 0;
+    }
+
+    if (!fresh) {
+        return; // 保持输出
+    }
+
+    // 测量值微分只在新样本到达时更新，两次样本之间沿用
+    if (sampleSeq != m_lastSeq) {
+        m_derivative = (m_lastSampleNs > 0 && sampleNs > m_lastSampleNs)
+                       ? (lux - m_lastLux) / (double(sampleNs - m_lastSampleNs) / 1e9) : 0.0;
+        m_lastLux = lux;
+        m_lastSampleNs = sampleNs;
+        m_lastSeq = sampleSeq;
+    }
+
+    const double rawError = target - lux;
+    const double error = (qAbs(rawError) <= tuning.deadbandLux) ? 0.0 : rawError;
+    const double minOutput = tuning.minPermille;
+    const double maxOutput = tuning.maxPermille;
+
+    // 抗积分饱和：输出已饱和且误差仍推向饱和方向时不积分
+    const double proportional = tuning.kp * error;
+    const double derivative = -tuning.kd * m_derivative;
+    const double candidate = m_integral + tuning.ki * error * dt;
+    const double unclamped = proportional + candidate + derivative;
+    const bool saturated = (unclamped > maxOutput && error > 0.0) || (unclamped < minOutput && error < 0.0);
+    if (!saturated) {
+        m_integral = candidate;
+    }
+    m_integral = qBound(minOutput, m_integral, maxOutput);
+    const int output = qBound(tuning.minPermille, qRound(proportional + m_integral + derivative), tuning.maxPermille);
+
+    // 在一个周期内线性过渡到新输出，两次调节之间亮度连续。
+    // 写入前在锁内复查：快照后闭环被关闭（或关闭后又重开）时放弃本周期，
+    // 写入期间持锁，setEnabled(false)返回后的手动占空比不会被本周期的输出覆盖
+    bool writeFailed = false;
+    if (output != m_output) {
+        QMutexLocker locker(&m_mutex);
+        if (m_enabledSeq != enabledSeq) {
+            return;
+        }
+        if (m_pwmController->fadeToPermille(output, DAYLIGHT_LOOP_PERIOD_MS, PWMController::LinearCurve)) {
+            m_output = output;
+        } else {
+            writeFailed = true;
+        }
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.lastLux = lux;
+        m_stats.lastErrorLux = rawError;
+        m_stats.absErrorLuxSeconds += qAbs(rawError) * dt;
+        m_stats.regulatedSeconds += dt;
+        m_stats.outputPermille = m_output;
+        if (saturated) {
+            m_stats.saturatedTicks++;
+        }
+        if (writeFailed) {
+            m_stats.writeFailures++;
+        }
+        m_stats.maxComputeNs = qMax(m_stats.maxComputeNs, monotonicNs() - nowNs);
+    }
+
+    emit loopUpdated(lux, rawError, m_output);
+}
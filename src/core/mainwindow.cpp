@@ -1,6 +1,7 @@
 #include "core/mainwindow.h"
 #include "ui_mainwindow.h"
 #include "config/aliyun_config.h"
+#include "config/ai_config.h"
 #include <QLoggingCategory>
 #include <QStandardPaths>
 #include <QDir>
@@ -14,15 +15,22 @@
 // 功能模块
 #include "ui/ui_manager.h"
 #include "hardware/pwm_controller.h"
+#include "hardware/pwm_channel_pool.h"
 #include "hardware/gpio_controller.h"
+#include "hardware/pump_scheduler.h"
+#include "hardware/power_budget_scheduler.h"
 #include "hardware/gy30_sensor.h" // AHT20传感器
 #include "hardware/gy30_light_sensor.h" // GY30光照传感器
 #include "device/curtain_controller.h"
+#include "device/curtain_command_queue.h"
 #include "ai/ai_decision_manager.h"
+#include "ai/daylight_controller.h"
 #include "integration/yolov8_integration.h"
 #include "network/weather_service.h"
 #include "network/mqtt_service.h"
 #include "system/window_manager.h"
+#include "system/bring_up_coordinator.h"
+#include "system/state_journal.h"
 
 // Qt核心
 #include <QDateTime>
@@ -70,7 +78,10 @@ MainWindow::MainWindow(QWidget *parent)
     , ui(new Ui::MainWindow)
     , m_timer(new QTimer(this))
     , m_uiManager(nullptr)
+    , m_pwmPool(nullptr)
     , m_pwmController(nullptr)
+    , m_pumpScheduler(nullptr)
+    , m_powerScheduler(nullptr)
     , m_curtainController(nullptr)
     , m_yoloIntegration(nullptr)
     , m_weatherService(nullptr)
@@ -79,6 +90,9 @@ MainWindow::MainWindow(QWidget *parent)
     , m_aht20Sensor(nullptr)
     , m_gy30Sensor(nullptr)
     , m_aiDecisionManager(nullptr)
+    , m_daylightController(nullptr)
+    , m_bringUp(nullptr)
+    , m_stateJournal(nullptr)
 {
     ui->setupUi(this);
 
@@ -91,6 +105,9 @@ MainWindow::MainWindow(QWidget *parent)
     // 设置信号连接
     setupConnections();
 
+    // 信号连接就绪后开始硬件初始化，窗口无需等待其完成即可绘制
+    m_bringUp->start();
+
     // 启动定时器 - 设置为精确的1秒间隔
     m_timer->setTimerType(Qt::PreciseTimer); // 使用精确定时器
     m_timer->start(1000); // 1秒更新一次时间
@@ -103,9 +120,34 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 等待仍在执行的硬件初始化任务返回，再清理其使用的控制器
+    if (m_bringUp) {
+        m_bringUp->abort();
+    }
+
+    // 补光闭环先于PWM通道停止
+    if (m_daylightController) {
+        m_daylightController->stop();
+    }
+
     // 清理资源
-    if (m_pwmController) {
-        m_pwmController->cleanup();
+    if (m_pwmPool) {
+        m_pwmPool->cleanup();
+    }
+
+    // 保温帘的脉冲线程与串口总线先于GPIO控制器停止（GPIO控制器先创建，会先于保温帘控制器析构）
+    if (m_curtainController) {
+        m_curtainController->shutdown();
+    }
+
+    // 调度线程先于GPIO控制器停止（运行中的泵在此关闭）
+    if (m_pumpScheduler) {
+        m_pumpScheduler->stop();
+    }
+
+    // 以上停机产生的记录落盘后再关闭日志
+    if (m_stateJournal) {
+        m_stateJournal->close();
     }
 
     // 清理日志系统
@@ -129,30 +171,48 @@ void MainWindow::initializeModules()
     m_windowManager->setWindowFlags();
     m_windowManager->setWindowStyle();
 
-    // 2. 初始化PWM控制器
-    m_pwmController = new PWMController(this);
-    if (!m_pwmController->initialize()) {
-        qWarning() << "PWM控制器初始化失败";
+    // 硬件初始化由启动协调器按依赖关系并行执行（见下方任务登记），此处只创建对象
+    m_bringUp = new BringUpCoordinator(this);
+
+    // 执行器状态日志：在控制器初始化前回放，重启后立即恢复位置、泵运行与占空比
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    m_stateJournal = new StateJournal(this);
+    if (!m_stateJournal->open(dataDir + "/" + STATE_JOURNAL_FILE)) {
+        qWarning() << "状态日志不可用，执行器状态不会在重启后恢复";
     }
 
+    // 2. 创建补光灯PWM通道池，主通道供亮度滑块使用
+    m_pwmPool = new PwmChannelPool(this);
+    m_pwmPool->setStateJournal(m_stateJournal);
+    m_pwmController = m_pwmPool->primary();
+
     // 3. 初始化MQTT阿里云服务
     m_mqttService = new MqttService(this);
     m_mqttService->setAutoReconnect(true);
     m_mqttService->setReportInterval(10); // 10秒上报一次数据
     m_mqttService->setHeartbeatInterval(300); // 5分钟心跳间隔
 
-    // 4. 初始化GPIO控制器
+    // 4. 创建GPIO控制器
     m_gpioController = new GPIOController(this);
-    if (!m_gpioController->initialize()) {
-        qWarning() << "GPIO控制器初始化失败";
-    }
 
-    // 5. 初始化保温帘控制器
+    // 泵定时运行调度（独立线程，不受界面重绘影响）
+    m_pumpScheduler = new PumpScheduler(m_gpioController, this);
+    m_pumpScheduler->setStateJournal(m_stateJournal);
+
+    // 5. 创建保温帘控制器
     m_curtainController = new CurtainController(this);
     m_curtainController->setGPIOController(m_gpioController);
-    if (!m_curtainController->initialize()) {
-        qWarning() << "保温帘控制器初始化失败";
-    }
+    m_curtainController->setStateJournal(m_stateJournal);
+
+    // 供电预算：保温帘电机与水泵、施药泵共用24V电源，起动浪涌错开
+    m_powerScheduler = new PowerBudgetScheduler(POWER_BUDGET_MA, this);
+    m_powerScheduler->registerLoad(PUMP_CONTROL_PIN, "水泵", PUMP_INRUSH_MA, PUMP_STEADY_MA, PUMP_INRUSH_MS);
+    m_powerScheduler->registerLoad(FERTILIZER_PUMP_PIN, "施药泵", FERTILIZER_PUMP_INRUSH_MA,
+                                   FERTILIZER_PUMP_STEADY_MA, FERTILIZER_PUMP_INRUSH_MS);
+    m_gpioController->setPowerScheduler(m_powerScheduler);
+    m_pumpScheduler->setPowerScheduler(m_powerScheduler);
+    m_curtainController->setPowerScheduler(m_powerScheduler); // 登记各执行器电机
 
     // 6. 初始化UI管理器并设置控制器
     m_uiManager = new UIManager(this);
@@ -175,9 +235,6 @@ void MainWindow::initializeModules()
     m_weatherService->setAutoUpdate(true, 30); // 30分钟自动更新
     m_weatherService->fetchWeatherData(); // 立即获取天气数据
 
-    // 9. 同步PWM滑块初始值
-    syncPWMSliderValue();
-
     // 延时启动MQTT连接，确保其他模块初始化完成
     QTimer::singleShot(2000, this, [this]() {
         if (m_mqttService) {
@@ -190,34 +247,75 @@ void MainWindow::initializeModules()
         }
     });
 
-    // 10. 初始化AHT20温湿度传感器
+    // 10. 创建AHT20温湿度传感器
     m_aht20Sensor = new AHT20Sensor(this);
-    if (m_aht20Sensor->initialize()) {
-        qDebug() << "AHT20温湿度传感器初始化成功";
-    } else {
-        qWarning() << "AHT20温湿度传感器初始化失败";
-    }
 
-    // 11. 初始化GY30光照传感器（I2C7）
+    // 11. 创建GY30光照传感器（I2C7）
     m_gy30Sensor = new GY30LightSensor(this);
-    if (m_gy30Sensor->initialize()) {
-        qDebug() << "GY30光照传感器初始化成功";
-    } else {
-        qWarning() << "GY30光照传感器初始化失败";
-    }
 
-    // 12. 初始化AI智能决策管理器
+    // 12. 创建AI智能决策管理器
     m_aiDecisionManager = new AIDecisionManager(this);
     m_aiDecisionManager->setCurtainController(m_curtainController);
     m_aiDecisionManager->setLightSensor(m_gy30Sensor);
-    if (m_aiDecisionManager->initialize()) {
-        qDebug() << "AI智能决策管理器初始化成功";
-    } else {
-        qWarning() << "AI智能决策管理器初始化失败";
-    }
 
     // 将AI管理器设置到UI管理器
     m_uiManager->setAIDecisionManager(m_aiDecisionManager);
+
+    // 补光闭环：按GY30光照调节主通道补光灯
+    m_daylightController = new DaylightController(this);
+    m_daylightController->setPWMController(m_pwmController);
+    m_daylightController->setLightSensor(m_gy30Sensor);
+    m_daylightController->setEnabled(DAYLIGHT_DEFAULT_ENABLED);
+
+    // 13. 登记硬件初始化任务
+    // 工作线程：PWM、GPIO、I2C传感器互不依赖，同时执行；保温帘依赖GPIO
+    m_bringUp->addTask("pwm", [this]() {
+        return m_pwmPool->initialize();
+    });
+    m_bringUp->addTask("gpio", [this]() {
+        return m_gpioController->initialize();
+    });
+    m_bringUp->addTask("curtains", [this]() {
+        return m_curtainController->initialize();
+    }, QStringList() << "gpio");
+    m_bringUp->addTask("aht20", [this]() {
+        return m_aht20Sensor->initialize();
+    });
+    m_bringUp->addTask("gy30", [this]() {
+        return m_gy30Sensor->initialize();
+    });
+
+    // 主线程：启动线程、定时器与界面同步
+    m_bringUp->addTask("pump-scheduler", [this]() {
+        return m_pumpScheduler->start();
+    }, QStringList() << "gpio", BringUpCoordinator::MainThread);
+    m_bringUp->addTask("pwm-slider", [this]() {
+        syncPWMSliderValue(); // 同步PWM滑块初始值
+        return true;
+    }, QStringList() << "pwm", BringUpCoordinator::MainThread);
+    m_bringUp->addTask("aht20-reading", [this]() {
+        m_aht20Sensor->startReading(3000); // 3秒间隔读取，立即执行一次
+        return true;
+    }, QStringList() << "aht20", BringUpCoordinator::MainThread);
+    m_bringUp->addTask("gy30-reading", [this]() {
+        m_gy30Sensor->startReading(2000); // 2秒间隔读取，立即执行一次
+        qDebug() << "GY30传感器开始读取数据";
+        return true;
+    }, QStringList() << "gy30", BringUpCoordinator::MainThread);
+    m_bringUp->addTask("daylight", [this]() {
+        return m_daylightController->start();
+    }, QStringList() << "pwm" << "gy30-reading", BringUpCoordinator::MainThread);
+    m_bringUp->addTask("ai-decision", [this]() {
+        return m_aiDecisionManager->initialize();
+    }, QStringList() << "curtains" << "gy30", BringUpCoordinator::MainThread);
+
+    connect(m_bringUp, &BringUpCoordinator::finished, this, [](bool allSucceeded, qint64 elapsedMs) {
+        if (allSucceeded) {
+            qDebug() << QString("硬件初始化全部完成，耗时%1ms").arg(elapsedMs);
+        } else {
+            qWarning() << QString("硬件初始化完成，部分设备失败，耗时%1ms").arg(elapsedMs);
+        }
+    });
 }
 
 void MainWindow::setupConnections()
@@ -285,14 +383,38 @@ void MainWindow::setupConnections()
 
     }
 
-    // PWM控制器连接
-    if (m_pwmController) {
-        connect(m_pwmController, &PWMController::errorOccurred,
+    // PWM通道池连接（各通道错误带通道标识转发）
+    if (m_pwmPool) {
+        connect(m_pwmPool, &PwmChannelPool::errorOccurred,
                 [](const QString &error) {
                     Q_UNUSED(error)
                 });
     }
 
+    // 补光闭环：手动拖动亮度滑块时暂停闭环；闭环调节时滑块跟随输出
+    if (m_daylightController) {
+        QSlider *lightSlider = ui->stackedWidget->findChild<QSlider*>("lightSlider");
+        if (lightSlider) {
+            connect(lightSlider, &QSlider::sliderPressed, [this]() {
+                if (m_daylightController->isEnabled()) {
+                    qDebug() << "手动调节补光，补光闭环已关闭";
+                    m_daylightController->setEnabled(false);
+                }
+            });
+        }
+        connect(m_daylightController, &DaylightController::loopUpdated, this,
+                [this](double, double, int) {
+                    syncPWMSliderValue();
+                });
+    }
+
+    // 状态日志写入失败只影响重启恢复，记录告警
+    if (m_stateJournal) {
+        connect(m_stateJournal, &StateJournal::errorOccurred, [](const QString &error) {
+            qWarning() << "状态日志错误:" << error;
+        });
+    }
+
     // 保温帘控制器连接
     if (m_curtainController) {
         connect(m_curtainController, &CurtainController::statusUpdated,
@@ -515,9 +637,6 @@ void MainWindow::setupConnections()
                         }
                     }
                 });
-
-        // 信号连接完成后启动传感器读取
-        m_aht20Sensor->startReading(3000); // 3秒间隔读取，立即执行一次
     }
 
     // GY30光照传感器连接
@@ -536,10 +655,6 @@ void MainWindow::setupConnections()
                         }
                     }
                 });
-
-        // 信号连接完成后启动传感器读取
-        m_gy30Sensor->startReading(2000); // 2秒间隔读取，立即执行一次
-        qDebug() << "GY30传感器开始读取数据";
     }
 
     // AI智能决策管理器连接
@@ -596,30 +711,96 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 void MainWindow::handleCloudCommand(const QJsonObject &cmd)
 {
     // 解析控制指令并执行相应操作
+    // 手动补光指令与拖动亮度滑块一样先关闭补光闭环，否则下一周期即被闭环输出覆盖；
+    // 同一指令中的daylightEnabled在其后处理，可随即以新占空比重新开启
+    auto takeManualLightControl = [this]() {
+        if (m_daylightController && m_daylightController->isEnabled()) {
+            qDebug() << "云端手动调节补光，补光闭环已关闭";
+            m_daylightController->setEnabled(false);
+        }
+    };
+
+    // 补光灯：{"pwmDutyCycle": 占空比, "pwmFadeMs": 渐变时间}，占空比可带一位小数，pwmFadeMs为0时立即切换
     if (cmd.contains("pwmDutyCycle") && m_pwmController) {
-        int dutyCycle = cmd["pwmDutyCycle"].toInt();
+        const double dutyCycle = cmd["pwmDutyCycle"].toDouble();
         if (dutyCycle >= 0 && dutyCycle <= 100) {
-            m_pwmController->setDutyCycle(dutyCycle);
+            takeManualLightControl();
+            const int fadeMs = cmd.contains("pwmFadeMs") ? cmd["pwmFadeMs"].toInt() : PWM_FADE_DEFAULT_MS;
+            m_pwmController->fadeToPermille(qRound(dutyCycle * 10.0), fadeMs);
+        }
+    }
+
+    // 多通道：{"pwmChannels": {"red": 80, "blue": 40}, "pwmFadeMs": 渐变时间}，各通道同时到达目标
+    if (cmd.contains("pwmChannels") && m_pwmPool) {
+        const QJsonObject channels = cmd["pwmChannels"].toObject();
+        QMap<QString, int> duties;
+        for (auto it = channels.constBegin(); it != channels.constEnd(); ++it) {
+            duties.insert(it.key(), qRound(it.value().toDouble() * 10.0));
         }
+        const int fadeMs = cmd.contains("pwmFadeMs") ? cmd["pwmFadeMs"].toInt() : PWM_FADE_DEFAULT_MS;
+        takeManualLightControl();
+        m_pwmPool->fadeDutyPermilles(duties, fadeMs);
     }
 
+    // 光谱配方：{"pwmRecipe": "flowering", "pwmFadeMs": 渐变时间}
+    if (cmd.contains("pwmRecipe") && m_pwmPool) {
+        const int fadeMs = cmd.contains("pwmFadeMs") ? cmd["pwmFadeMs"].toInt() : PWM_RECIPE_FADE_MS;
+        takeManualLightControl();
+        m_pwmPool->applyRecipe(cmd["pwmRecipe"].toString(), fadeMs);
+    }
+
+    // 补光闭环：{"daylightEnabled": true, "daylightTargetLux": 800}
+    if (cmd.contains("daylightTargetLux") && m_daylightController) {
+        m_daylightController->setTargetLux(cmd["daylightTargetLux"].toDouble());
+    }
+    if (cmd.contains("daylightEnabled") && m_daylightController) {
+        m_daylightController->setEnabled(cmd["daylightEnabled"].toBool());
+    }
+
+    // 定时运行：{"pumpRunMs": 时长, "pumpDelayMs": 延迟}，施药泵同理
+    if (cmd.contains("pumpRunMs") && m_pumpScheduler) {
+        m_pumpScheduler->scheduleIn(PUMP_CONTROL_PIN, cmd["pumpRunMs"].toInt(), cmd["pumpDelayMs"].toInt());
+    }
+
+    if (cmd.contains("fertilizerPumpRunMs") && m_pumpScheduler) {
+        m_pumpScheduler->scheduleIn(FERTILIZER_PUMP_PIN, cmd["fertilizerPumpRunMs"].toInt(),
+                                    cmd["fertilizerPumpDelayMs"].toInt());
+    }
+
+    // 保温帘命令经命令队列提交，与界面和AI命令合并
     if (cmd.contains("curtainTopOpen") && m_curtainController) {
         bool open = cmd["curtainTopOpen"].toBool();
-        if (open) {
-            m_curtainController->openCurtain(CurtainController::TopCurtain);
-        } else {
-            m_curtainController->closeCurtain(CurtainController::TopCurtain);
-        }
+        m_curtainController->commandQueue()->submit(CurtainController::TopCurtain,
+                open ? CurtainCommandQueue::Open : CurtainCommandQueue::Close, 0.0, "云端");
     }
 
     if (cmd.contains("curtainSideOpen") && m_curtainController) {
         bool open = cmd["curtainSideOpen"].toBool();
-        if (open) {
-            m_curtainController->openCurtain(CurtainController::SideCurtain);
-        } else {
-            m_curtainController->closeCurtain(CurtainController::SideCurtain);
-        }
+        m_curtainController->commandQueue()->submit(CurtainController::SideCurtain,
+                open ? CurtainCommandQueue::Open : CurtainCommandQueue::Close, 0.0, "云端");
+    }
+
+    // 部分开度：{"curtainTopPosition": 40} 表示上帘开到40%
+    if (cmd.contains("curtainTopPosition") && m_curtainController) {
+        m_curtainController->commandQueue()->submit(CurtainController::TopCurtain, CurtainCommandQueue::MoveTo,
+                cmd["curtainTopPosition"].toDouble(), "云端");
+    }
 
+    if (cmd.contains("curtainSidePosition") && m_curtainController) {
+        m_curtainController->commandQueue()->submit(CurtainController::SideCurtain, CurtainCommandQueue::MoveTo,
+                cmd["curtainSidePosition"].toDouble(), "云端");
+    }
+
+    // 分组命令：{"curtainGroup": "west", "curtainGroupPosition": 0} 表示西侧全部关闭，
+    // {"curtainGroup": "all", "curtainGroupPause": true} 表示全部暂停；组内执行器一次GPIO事务切换
+    if (cmd.contains("curtainGroup") && m_curtainController) {
+        const QString group = cmd["curtainGroup"].toString();
+        if (cmd["curtainGroupPause"].toBool()) {
+            m_curtainController->commandQueue()->submitGroup(group, CurtainCommandQueue::Pause, 0.0, "云端");
+        } else if (cmd.contains("curtainGroupPosition")) {
+            m_curtainController->commandQueue()->submitGroup(group, CurtainCommandQueue::MoveTo,
+                    cmd["curtainGroupPosition"].toDouble(), "云端");
+        }
     }
 
     // 可以添加更多控制指令处理
@@ -639,7 +820,6 @@ void MainWindow::collectDeviceData()
     data.temperature = 25.0;    // 默认温度25°C
     data.humidity = 50.0;       // 默认湿度50%
     data.lightIntensity = 500;  // 默认光照500lux
-    data.pwmDutyCycle = 50;     // 默认PWM 50%
 
     // 从AHT20传感器获取温湿度数据
     if (m_aht20Sensor) {
@@ -656,10 +836,18 @@ void MainWindow::collectDeviceData()
         data.lightIntensity = 500.0; // 传感器不可用时使用固定值
     }
 
-    // 从PWM控制器获取占空比
-    if (m_pwmController) {
-        int pwm = m_pwmController->getCurrentDutyCycle();
-        if (pwm >= 0 && pwm <= 100) data.pwmDutyCycle = pwm;
+    // 从PWM通道池获取各通道占空比（主通道总是上报，其余通道可用时上报）
+    if (m_pwmPool) {
+        const QStringList keys = m_pwmPool->channelKeys();
+        for (int i = 0; i < keys.size(); ++i) {
+            if (i > 0 && !m_pwmPool->isAvailable(keys[i])) {
+                continue;
+            }
+            int permille = m_pwmPool->channel(keys[i])->getCurrentDutyPermille();
+            if (permille >= 0 && permille <= 1000) {
+                data.pwmChannels.append(MqttService::PwmChannelData(keys[i], permille));
+            }
+        }
     }
 
     // 从保温帘控制器获取状态
@@ -684,21 +872,21 @@ void MainWindow::syncPWMSliderValue()
         return;
     }
 
-    // 获取PWM当前占空比
-    int currentDutyCycle = m_pwmController->getCurrentDutyCycle();
+    // 获取PWM当前占空比（‰，滑块刻度为0.1%）
+    int currentPermille = m_pwmController->getCurrentDutyPermille();
 
     // 查找PWM滑块控件
     QSlider *lightSlider = ui->stackedWidget->findChild<QSlider*>("lightSlider");
     if (lightSlider) {
         // 暂时断开信号连接，避免触发硬件设置
         lightSlider->blockSignals(true);
-        lightSlider->setValue(currentDutyCycle);
+        lightSlider->setValue(currentPermille);
         lightSlider->blockSignals(false);
 
         // 同步状态显示
         QLabel *lightStatusValue = ui->stackedWidget->findChild<QLabel*>("lightStatusValue");
         if (lightStatusValue) {
-            lightStatusValue->setText(QString("%1%").arg(currentDutyCycle));
+            lightStatusValue->setText(QString("%1%").arg(currentPermille / 10.0, 0, 'f', 1));
         }
     }
 }
@@ -0,0 +1,141 @@
+#include "device/curtain_actuator.h"
+#include "config/gpio_config.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+
+static const CurtainPinSet DEFAULT_ACTUATORS[] = CURTAIN_ACTUATORS;
+
+CurtainActuator::CurtainActuator()
+    : dir1Pin(-1)
+    , dir2Pin(-1)
+    , enablePin(-1)
+    , enable2Pin(-1)
+    , stepPin(-1)
+    , openLimitPin(-1)
+    , closeLimitPin(-1)
+    , serialAddress(-1)
+    , inrushMa(CURTAIN_MOTOR_INRUSH_MA)
+    , steadyMa(CURTAIN_MOTOR_STEADY_MA)
+    , inrushMs(CURTAIN_MOTOR_INRUSH_MS)
+{
+}
+
+CurtainActuator::CurtainActuator(const CurtainPinSet &pins)
+    : key(QString::fromUtf8(pins.key))
+    , name(QString::fromUtf8(pins.name))
+    , groups(QString::fromUtf8(pins.groups).split(",", Qt::SkipEmptyParts))
+    , dir1Pin(pins.dir1Pin)
+    , dir2Pin(pins.dir2Pin)
+    , enablePin(pins.enablePin)
+    , enable2Pin(pins.enable2Pin)
+    , stepPin(pins.stepPin)
+    , openLimitPin(pins.openLimitPin)
+    , closeLimitPin(pins.closeLimitPin)
+    , serialAddress(pins.serialAddress)
+    , inrushMa(CURTAIN_MOTOR_INRUSH_MA)
+    , steadyMa(CURTAIN_MOTOR_STEADY_MA)
+    , inrushMs(CURTAIN_MOTOR_INRUSH_MS)
+{
+}
+
+bool CurtainActuator::inGroup(const QString &group) const
+{
+    return group == "all" || groups.contains(group);
+}
+
+QVector<CurtainActuator> CurtainActuator::defaults()
+{
+    QVector<CurtainActuator> actuators;
+    for (const CurtainPinSet &pins : DEFAULT_ACTUATORS) {
+        actuators.append(CurtainActuator(pins));
+    }
+    return actuators;
+}
+
+QVector<CurtainActuator> CurtainActuator::load(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QString("配置文件不存在，使用默认配置");
+        }
+        return defaults();
+    }
+
+    const QJsonArray list = QJsonDocument::fromJson(file.readAll()).object()["curtains"].toArray();
+    if (list.isEmpty() || list.size() > CURTAIN_MAX_COUNT) {
+        if (error) {
+            *error = QString("配置文件须包含1-%1个执行器，使用默认配置").arg(CURTAIN_MAX_COUNT);
+        }
+        return defaults();
+    }
+
+    QVector<CurtainActuator> actuators;
+    QSet<QString> keys;
+    QSet<int> outputs;
+    QSet<int> addresses;
+    for (const QJsonValue &value : list) {
+        const QJsonObject json = value.toObject();
+        CurtainActuator actuator;
+        actuator.key = json["key"].toString();
+        actuator.name = json["name"].toString(actuator.key);
+        for (const QJsonValue &group : json["groups"].toArray()) {
+            actuator.groups.append(group.toString());
+        }
+        actuator.dir1Pin = json["dir1"].toInt(-1);
+        actuator.dir2Pin = json["dir2"].toInt(-1);
+        actuator.enablePin = json["enable"].toInt(-1);
+        actuator.enable2Pin = json["enable2"].toInt(-1);
+        actuator.stepPin = json["step"].toInt(-1);
+        actuator.openLimitPin = json["openLimit"].toInt(-1);
+        actuator.closeLimitPin = json["closeLimit"].toInt(-1);
+        actuator.serialAddress = json["serialAddress"].toInt(-1);
+        actuator.inrushMa = json["inrushMa"].toInt(CURTAIN_MOTOR_INRUSH_MA);
+        actuator.steadyMa = json["steadyMa"].toInt(CURTAIN_MOTOR_STEADY_MA);
+        actuator.inrushMs = json["inrushMs"].toInt(CURTAIN_MOTOR_INRUSH_MS);
+
+        // 标识唯一、方向与使能必填、输出引脚不得与其它执行器共用
+        QString reason;
+        if (actuator.key.isEmpty() || keys.contains(actuator.key)) {
+            reason = "标识为空或重复";
+        } else if (actuator.enablePin < 0 || (actuator.dir1Pin < 0 && !actuator.isSerial())) {
+            reason = "缺少方向或使能引脚";
+        } else if (actuator.isSerial() && (actuator.serialAddress < 1 || actuator.serialAddress > 247
+                                           || addresses.contains(actuator.serialAddress))) {
+            reason = QString("串口站地址%1无效或重复").arg(actuator.serialAddress);
+        }
+        const int pins[] = { actuator.dir1Pin, actuator.dir2Pin, actuator.enablePin,
+                             actuator.enable2Pin, actuator.stepPin };
+        for (int pin : pins) {
+            if (reason.isEmpty() && pin >= 0 && outputs.contains(pin)) {
+                reason = QString("引脚%1已被占用").arg(pin);
+            }
+        }
+        if (!reason.isEmpty()) {
+            if (error) {
+                *error = QString("执行器%1配置无效（%2），使用默认配置").arg(actuators.size()).arg(reason);
+            }
+            return defaults();
+        }
+
+        keys.insert(actuator.key);
+        if (actuator.isSerial()) {
+            addresses.insert(actuator.serialAddress);
+        }
+        for (int pin : pins) {
+            if (pin >= 0) {
+                outputs.insert(pin);
+            }
+        }
+        actuators.append(actuator);
+    }
+
+    if (error) {
+        error->clear();
+    }
+    return actuators;
+}
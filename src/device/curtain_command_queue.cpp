@@ -0,0 +1,325 @@
+#include "device/curtain_command_queue.h"
+#include "config/gpio_config.h"
+
+#include <QDebug>
+#include <QMap>
+#include <QTimer>
+
+CurtainCommandQueue::CurtainCommandQueue(CurtainController *controller, QObject *parent)
+    : QObject(parent)
+    , m_controller(controller)
+    , m_lanes(controller->curtainCount())
+    , m_nextId(0)
+    , m_reversalDwellMs(CURTAIN_REVERSAL_DWELL_MS)
+    , m_dispatching(false)
+{
+    for (int i = 0; i < m_lanes.size(); ++i) {
+        const CurtainController::CurtainType type = i;
+        Lane &lane = m_lanes[i];
+        lane.hasActive = false;
+        lane.hasPending = false;
+        lane.direction = 0;
+        lane.dwellTimer = new QTimer(this);
+        lane.dwellTimer->setSingleShot(true);
+        connect(lane.dwellTimer, &QTimer::timeout, this, [this, type]() {
+            dispatch(QList<CurtainController::CurtainType>() << type);
+        });
+    }
+
+    connect(m_controller, &CurtainController::curtainStateChanged,
+            this, &CurtainCommandQueue::onCurtainStateChanged);
+}
+
+quint64 CurtainCommandQueue::submit(CurtainController::CurtainType type, Action action, double percent,
+                                    const QString &source)
+{
+    if (!m_controller->isValidCurtain(type)) {
+        qWarning() << QString("保温帘命令（%1）：编号%2无效").arg(source).arg(type);
+        return 0;
+    }
+
+    const Command command = makeCommand(type, action, percent, source);
+    if (action == Pause) {
+        pauseLanes(QList<CurtainController::CurtainType>() << type, QList<Command>() << command);
+    } else if (enqueue(type, command)) {
+        dispatch(QList<CurtainController::CurtainType>() << type);
+    }
+    return command.id;
+}
+
+QList<quint64> CurtainCommandQueue::submitGroup(const QString &group, Action action, double percent,
+                                                const QString &source)
+{
+    const QList<CurtainController::CurtainType> types = m_controller->curtainsInGroup(group);
+    if (types.isEmpty()) {
+        qWarning() << QString("保温帘命令（%1）：分组%2不存在").arg(source).arg(group);
+        return QList<quint64>();
+    }
+
+    QList<quint64> ids;
+    QList<Command> commands;
+    QList<CurtainController::CurtainType> ready;
+    for (CurtainController::CurtainType type : types) {
+        const Command command = makeCommand(type, action, percent, source);
+        ids.append(command.id);
+        commands.append(command);
+        if (action != Pause && enqueue(type, command)) {
+            ready.append(type);
+        }
+    }
+
+    // 成员的停机或启动各自合并为一次控制器调用
+    if (action == Pause) {
+        pauseLanes(types, commands);
+    } else {
+        dispatch(ready);
+    }
+    return ids;
+}
+
+bool CurtainCommandQueue::cancel(quint64 id)
+{
+    for (int i = 0; i < m_lanes.size(); ++i) {
+        const CurtainController::CurtainType type = i;
+        Lane &lane = m_lanes[i];
+
+        if (lane.hasPending && lane.pending.id == id) {
+            lane.hasPending = false;
+            lane.dwellTimer->stop();
+            finish(type, lane.pending, Cancelled);
+            return true;
+        }
+
+        if (lane.hasActive && (lane.active.id == id || lane.active.merged.contains(id))) {
+            m_controller->pauseCurtain(type);
+            finishActive(type, Cancelled);
+            dispatch(QList<CurtainController::CurtainType>() << type);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CurtainCommandQueue::isIdle(CurtainController::CurtainType type) const
+{
+    if (!m_controller->isValidCurtain(type)) {
+        return true;
+    }
+    const Lane &lane = m_lanes.at(type);
+    return !lane.hasActive && !lane.hasPending;
+}
+
+void CurtainCommandQueue::setReversalDwellMs(int dwellMs)
+{
+    // 已在等待的通道按原间隔到期，之后的换向使用新间隔
+    m_reversalDwellMs = qMax(0, dwellMs);
+}
+
+CurtainCommandQueue::Statistics CurtainCommandQueue::statistics(CurtainController::CurtainType type) const
+{
+    return m_controller->isValidCurtain(type) ? m_lanes.at(type).stats : Statistics();
+}
+
+void CurtainCommandQueue::onCurtainStateChanged(CurtainController::CurtainType type,
+                                                CurtainController::CurtainState state)
+{
+    Lane &lane = laneOf(type);
+    if (m_dispatching || !lane.hasActive) {
+        return;
+    }
+
+    switch (state) {
+        case CurtainController::Open:
+        case CurtainController::Closed:
+        case CurtainController::Stopped:
+            finishActive(type, Completed);
+            break;
+        case CurtainController::Error:
+            lane.stats.failed++;
+            finishActive(type, Failed);
+            break;
+        default:
+            return; // 运动中
+    }
+
+    dispatch(QList<CurtainController::CurtainType>() << type);
+}
+
+CurtainCommandQueue::Lane &CurtainCommandQueue::laneOf(CurtainController::CurtainType type)
+{
+    return m_lanes[type];
+}
+
+CurtainCommandQueue::Command CurtainCommandQueue::makeCommand(CurtainController::CurtainType type, Action action,
+                                                              double percent, const QString &source)
+{
+    Command command;
+    command.id = ++m_nextId;
+    command.action = action;
+    command.target = (action == Open) ? 100.0 : (action == Close) ? 0.0 : qBound(0.0, percent, 100.0);
+    command.source = source;
+    laneOf(type).stats.submitted++;
+    return command;
+}
+
+void CurtainCommandQueue::pauseLanes(const QList<CurtainController::CurtainType> &types, const QList<Command> &commands)
+{
+    // 暂停：丢弃待执行命令并立即停止当前运动
+    for (CurtainController::CurtainType type : types) {
+        Lane &lane = laneOf(type);
+        lane.dwellTimer->stop();
+        if (lane.hasPending) {
+            lane.hasPending = false;
+            lane.stats.superseded++;
+            finish(type, lane.pending, Superseded);
+        }
+    }
+
+    m_controller->pauseCurtains(types);
+
+    for (int i = 0; i < types.size(); ++i) {
+        Lane &lane = laneOf(types.at(i));
+        if (lane.hasActive) {
+            lane.stats.preempted++;
+            finishActive(types.at(i), Preempted);
+        }
+        finish(types.at(i), commands.at(i), Completed);
+    }
+}
+
+bool CurtainCommandQueue::enqueue(CurtainController::CurtainType type, const Command &command)
+{
+    Lane &lane = laneOf(type);
+
+    // 与执行中命令目标相同，并入执行中命令
+    if (lane.hasActive && !lane.hasPending && qFuzzyCompare(lane.active.target + 1.0, command.target + 1.0)) {
+        lane.active.merged.append(command.id);
+        lane.stats.coalesced++;
+        return false;
+    }
+
+    // 后到者优先：覆盖尚未执行的命令
+    if (lane.hasPending) {
+        lane.stats.superseded++;
+        finish(type, lane.pending, Superseded);
+    }
+    lane.pending = command;
+    lane.hasPending = true;
+    return true;
+}
+
+void CurtainCommandQueue::dispatch(const QList<CurtainController::CurtainType> &types)
+{
+    QList<CurtainController::CurtainType> reversing;
+    QList<CurtainController::CurtainType> ready;
+    for (CurtainController::CurtainType type : types) {
+        Lane &lane = laneOf(type);
+        if (!lane.hasPending || lane.dwellTimer->isActive()) {
+            continue;
+        }
+
+        if (lane.hasActive) {
+            const int direction = directionOf(type, lane.pending);
+            if (lane.direction != 0 && direction != 0 && direction != lane.direction) {
+                reversing.append(type);
+                continue;
+            }
+
+            // 同方向：直接改为新目标
+            lane.stats.preempted++;
+            finishActive(type, Preempted);
+        }
+        ready.append(type);
+    }
+
+    // 反向：先停机，停稳后再按最新命令启动
+    if (!reversing.isEmpty()) {
+        m_controller->pauseCurtains(reversing);
+        for (CurtainController::CurtainType type : reversing) {
+            Lane &lane = laneOf(type);
+            lane.stats.preempted++;
+            lane.stats.reversals++;
+            finishActive(type, Preempted);
+            lane.dwellTimer->start(m_reversalDwellMs);
+        }
+    }
+
+    if (!ready.isEmpty()) {
+        start(ready);
+    }
+}
+
+void CurtainCommandQueue::start(const QList<CurtainController::CurtainType> &types)
+{
+    // 目标相同的通道合并为一次控制器调用（分组命令的成员目标一致）
+    QMap<double, QList<CurtainController::CurtainType> > batches;
+    for (CurtainController::CurtainType type : types) {
+        Lane &lane = laneOf(type);
+        lane.active = lane.pending;
+        lane.hasActive = true;
+        lane.hasPending = false;
+        lane.direction = directionOf(type, lane.active);
+        lane.stats.executed++;
+        batches[lane.active.target].append(type);
+
+        qDebug() << QString("保温帘命令#%1（%2）：%3目标%4%")
+                    .arg(lane.active.id)
+                    .arg(lane.active.source.isEmpty() ? "未知来源" : lane.active.source)
+                    .arg(m_controller->curtainName(type))
+                    .arg(lane.active.target, 0, 'f', 1);
+    }
+
+    QList<CurtainController::CurtainType> failed;
+    m_dispatching = true;
+    for (auto it = batches.constBegin(); it != batches.constEnd(); ++it) {
+        m_controller->moveCurtains(it.value(), it.key(), &failed);
+    }
+    m_dispatching = false;
+
+    for (CurtainController::CurtainType type : types) {
+        if (failed.contains(type)) {
+            laneOf(type).stats.failed++;
+            finishActive(type, Failed);
+        } else if (!m_controller->isCurtainMoving(type)) {
+            finishActive(type, Completed); // 已在目标位置或已到达限位
+        }
+    }
+}
+
+void CurtainCommandQueue::finishActive(CurtainController::CurtainType type, Result result)
+{
+    Lane &lane = laneOf(type);
+    if (!lane.hasActive) {
+        return;
+    }
+    lane.hasActive = false;
+    lane.direction = 0;
+    finish(type, lane.active, result);
+}
+
+void CurtainCommandQueue::finish(CurtainController::CurtainType type, const Command &command, Result result)
+{
+    // 排队发出，保证调用方在submit()返回后才收到结果
+    QList<quint64> ids = command.merged;
+    ids.prepend(command.id);
+    QMetaObject::invokeMethod(this, [this, type, ids, result]() {
+        for (quint64 id : ids) {
+            emit commandFinished(id, type, result);
+        }
+    }, Qt::QueuedConnection);
+}
+
+int CurtainCommandQueue::directionOf(CurtainController::CurtainType type, const Command &command) const
+{
+    if (command.action == Open) {
+        return 1;
+    }
+    if (command.action == Close) {
+        return -1;
+    }
+    const double current = m_controller->getCurtainPosition(type);
+    if (qAbs(command.target - current) < CURTAIN_POSITION_TOLERANCE_PERCENT) {
+        return 0;
+    }
+    return (command.target > current) ? 1 : -1;
+}
@@ -1,137 +1,567 @@
 #include "device/curtain_controller.h"
+#include "device/curtain_command_queue.h"
 #include "hardware/gpio_controller.h"
+#include "hardware/power_budget_scheduler.h"
+#include "hardware/stepper_pulse_generator.h"
+#include "hardware/serial_stepper_bus.h"
+#include "hardware/serial_stepper_emulator.h"
+#include "hardware/motion_profile.h"
+#include "system/state_journal.h"
 #include "config/gpio_config.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QTimer>
 
+#include <time.h>
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 使能低电平运行，高电平暂停（双使能引脚逻辑相同）
+static void addEnablePins(GPIOController::Transaction &transaction, const CurtainActuator &actuator, bool enable)
+{
+    transaction.setPin(actuator.enablePin, enable ? CURTAIN_ENABLE : CURTAIN_DISABLE);
+    if (actuator.enable2Pin >= 0) {
+        transaction.setPin(actuator.enable2Pin, enable ? CURTAIN_ENABLE : CURTAIN_DISABLE);
+    }
+}
+
+// 打开: 方向引脚1高电平，引脚2低电平；关闭相反
+static void addDrivePins(GPIOController::Transaction &transaction, const CurtainActuator &actuator, bool open)
+{
+    if (actuator.dir1Pin >= 0) {
+        transaction.setPin(actuator.dir1Pin, open ? GPIO_HIGH : GPIO_LOW);
+    }
+    if (actuator.dir2Pin >= 0) {
+        transaction.setPin(actuator.dir2Pin, open ? GPIO_LOW : GPIO_HIGH);
+    }
+    addEnablePins(transaction, actuator, true);
+}
+
+CurtainController::Channel::Channel(const CurtainActuator &config, qint64 fullTravelNs, quint64 fullTravelSteps)
+    : actuator(config)
+    , motion(0)
+    , position(fullTravelNs, fullTravelSteps)
+    , calibrator(fullTravelNs, fullTravelSteps)
+    , target(0.0)
+    , travelTimer(nullptr)
+    , positionTimer(nullptr)
+    , reversalTimer(nullptr)
+    , reversalTarget(0.0)
+    , powerTicket(0)
+    , serialMove(0)
+    , serialStop(0)
+{
+}
+
 CurtainController::CurtainController(QObject *parent)
     : QObject(parent)
-    , m_topCurtainState(Stopped)
-    , m_sideCurtainState(Stopped)
     , m_initialized(false)
     , m_gpioController(nullptr)
+    , m_commandQueue(nullptr)
+    , m_powerScheduler(nullptr)
+    , m_stateJournal(nullptr)
+    , m_stepper(nullptr)
+    , m_serialBus(nullptr)
+    , m_serialEmulator(nullptr)
 {
-    qDebug() << "保温帘控制器创建完成";
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    m_positionFile = dataDir + "/" + CURTAIN_POSITION_FILE;
+    m_calibrationFile = dataDir + "/" + CURTAIN_CALIBRATION_FILE;
+
+    // 执行器配置：应用数据目录下的配置文件优先，否则使用gpio_config.h中的配置表
+    QString configError;
+    const QVector<CurtainActuator> actuators = CurtainActuator::load(dataDir + "/" + CURTAIN_ACTUATOR_FILE, &configError);
+    if (!configError.isEmpty()) {
+        qDebug() << QString("保温帘执行器%1").arg(configError);
+    }
+
+    // 一次性建好，此后不再增删（其它线程持有下标访问）
+    m_channels.reserve(actuators.size());
+    for (const CurtainActuator &actuator : actuators) {
+        m_channels.append(Channel(actuator, fullTravelNs(actuator),
+                                  actuator.stepPin >= 0 ? CURTAIN_TRAVEL_STEPS : 0));
+    }
+
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        Channel &channel = m_channels[type];
+        channel.travelTimer = new QTimer(this);
+        channel.travelTimer->setSingleShot(true);
+        connect(channel.travelTimer, &QTimer::timeout, this, [this, type]() {
+            onTravelTimeout(type);
+        });
+
+        channel.positionTimer = new QTimer(this);
+        channel.positionTimer->setSingleShot(true);
+        channel.positionTimer->setTimerType(Qt::PreciseTimer);
+        connect(channel.positionTimer, &QTimer::timeout, this, [this, type]() {
+            onPositionTimeout(type);
+        });
+
+        channel.reversalTimer = new QTimer(this);
+        channel.reversalTimer->setSingleShot(true);
+        connect(channel.reversalTimer, &QTimer::timeout, this, [this, type]() {
+            moveTo(type, m_channels[type].reversalTarget);
+        });
+    }
+
+    loadCalibration();
+    loadPositions();
+
+    // 按恢复的位置确定初始状态，未校准时视为停止
+    for (Channel &channel : m_channels) {
+        const double percent = channel.position.percent(0);
+        if (channel.position.isCalibrated() && percent >= 100.0) {
+            channel.machine = CurtainStateMachine(CurtainStateMachine::Open);
+        } else if (channel.position.isCalibrated() && percent <= 0.0) {
+            channel.machine = CurtainStateMachine(CurtainStateMachine::Closed);
+        }
+    }
+
+    m_commandQueue = new CurtainCommandQueue(this, this);
+
+    qDebug() << QString("保温帘控制器创建完成，共%1个执行器").arg(m_channels.size());
 }
 
 CurtainController::~CurtainController()
 {
+    shutdown();
     qDebug() << "保温帘控制器已销毁";
 }
 
+void CurtainController::shutdown()
+{
+    for (Channel &channel : m_channels) {
+        channel.reversalTimer->stop();
+    }
+
+    // 脉冲线程退出时仍会结束运动中的通道并写GPIO，GPIO控制器必须仍然有效
+    if (m_stepper) {
+        m_stepper->stop();
+    }
+    if (m_serialBus) {
+        m_serialBus->close();
+    }
+    if (m_serialEmulator) {
+        m_serialEmulator->stop();
+    }
+}
+
 bool CurtainController::openCurtain(CurtainType type)
 {
     qDebug() << QString("打开%1").arg(curtainTypeToString(type));
+    return moveTo(type, 100.0);
+}
 
-    // 设置状态为打开中
-    if (type == TopCurtain) {
-        m_topCurtainState = Opening;
-    } else {
-        m_sideCurtainState = Opening;
+bool CurtainController::closeCurtain(CurtainType type)
+{
+    qDebug() << QString("关闭%1").arg(curtainTypeToString(type));
+    return moveTo(type, 0.0);
+}
+
+bool CurtainController::setCurtainPosition(CurtainType type, double percent)
+{
+    qDebug() << QString("%1运动到%2%").arg(curtainTypeToString(type)).arg(percent, 0, 'f', 1);
+    return moveTo(type, qBound(0.0, percent, 100.0));
+}
+
+bool CurtainController::setGroupPosition(const QString &group, double percent)
+{
+    const QList<CurtainType> types = curtainsInGroup(group);
+    if (types.isEmpty()) {
+        emit errorOccurred(QString("保温帘分组%1不存在").arg(group));
+        return false;
     }
 
-    emit curtainStateChanged(type, Opening);
+    qDebug() << QString("分组%1（%2个执行器）运动到%3%").arg(group).arg(types.size()).arg(percent, 0, 'f', 1);
+    return moveCurtains(types, qBound(0.0, percent, 100.0));
+}
 
-    // 调用实际的GPIO控制方法
-    bool success = false;
-    if (type == TopCurtain) {
-        success = openTopCurtain();
-    } else {
-        success = openSideCurtain();
+bool CurtainController::pauseGroup(const QString &group)
+{
+    const QList<CurtainType> types = curtainsInGroup(group);
+    if (types.isEmpty()) {
+        emit errorOccurred(QString("保温帘分组%1不存在").arg(group));
+        return false;
+    }
+
+    qDebug() << QString("暂停分组%1").arg(group);
+    return pauseCurtains(types);
+}
+
+bool CurtainController::moveTo(CurtainType type, double percent)
+{
+    QList<CurtainType> failed;
+    moveCurtains(QList<CurtainType>() << type, percent, &failed);
+    return failed.isEmpty();
+}
+
+bool CurtainController::moveCurtains(const QList<CurtainType> &types, double percent, QList<CurtainType> *failed)
+{
+    if (!m_initialized) {
+        emit errorOccurred("保温帘控制器未初始化");
+        if (failed) {
+            *failed += types;
+        }
+        return false;
     }
 
-    if (success) {
-        // 模拟操作完成后设置为打开状态
-        QTimer::singleShot(2000, this, [this, type]() {
-            if (type == TopCurtain) {
-                m_topCurtainState = Open;
-            } else {
-                m_sideCurtainState = Open;
+    bool success = true;
+    QList<CurtainType> valid;
+    for (CurtainType type : types) {
+        if (!isValidCurtain(type)) {
+            emit errorOccurred(QString("保温帘编号%1无效").arg(type));
+            success = false;
+            if (failed) {
+                failed->append(type);
             }
-            emit curtainStateChanged(type, Open);
-            updateStatus();
-        });
-    } else {
-        // 操作失败，设置为错误状态
-        if (type == TopCurtain) {
-            m_topCurtainState = Error;
-        } else {
-            m_sideCurtainState = Error;
+            continue;
+        }
+        valid.append(type);
+    }
+
+    // 先更新各执行器的状态与位置模型，再把所有方向与使能引脚合并为一次事务提交，
+    // 字符设备后端下同一芯片的引脚同时切换
+    QList<Travel> travels;
+    GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+    for (CurtainType type : deferReversals(valid, percent)) {
+
+        // 供电余量不足的执行器排队，准入后单独通电（状态保持打开中/关闭中）
+        Travel travel;
+        if (prepareTravel(type, percent, &travel) && acquirePower(travel)) {
+            addDrivePins(transaction, m_channels[type].actuator, travel.open);
+            travels.append(travel);
         }
-        emit curtainStateChanged(type, Error);
-        emit errorOccurred(QString("%1打开失败").arg(curtainTypeToString(type)));
     }
 
+    if (travels.isEmpty()) {
+        return success;
+    }
+
+    for (const Travel &travel : travels) {
+        beginTravel(travel);
+    }
+    savePositions();
+
+    const GPIOController::TransactionResult result = transaction.commit();
+    for (auto it = result.failures.constBegin(); it != result.failures.constEnd(); ++it) {
+        qWarning() << QString("保温帘GPIO引脚%1设置失败: %2").arg(it.key()).arg(it.value());
+    }
+
+    for (const Travel &travel : travels) {
+        launchTravel(travel, result.success);
+        if (getCurtainState(travel.type) == Error) {
+            success = false;
+            if (failed) {
+                failed->append(travel.type);
+            }
+        }
+    }
     return success;
 }
 
-bool CurtainController::closeCurtain(CurtainType type)
+QList<CurtainController::CurtainType> CurtainController::deferReversals(const QList<CurtainType> &types, double percent)
 {
-    qDebug() << QString("关闭%1").arg(curtainTypeToString(type));
+    // 直流电机不能在运行中直接翻转方向：运动中反向（或已在停机等待）的执行器先停机，
+    // 等待CURTAIN_REVERSAL_DWELL_MS后再按最新目标启动
+    QList<CurtainType> reversing;
+    QList<CurtainType> ready;
+    for (CurtainType type : types) {
+        const Channel &channel = m_channels[type];
+        const int motion = channel.motion.loadAcquire();
+        const double current = channel.position.percent(monotonicNs());
+        const bool open = (percent <= 0.0 || percent >= 100.0) ? (percent >= 100.0) : (percent > current);
+        if (channel.reversalTimer->isActive() || (motion != 0 && motion != (open ? 1 : -1))) {
+            reversing.append(type);
+        } else {
+            ready.append(type);
+        }
+    }
 
-    // 设置状态为关闭中
-    if (type == TopCurtain) {
-        m_topCurtainState = Closing;
-    } else {
-        m_sideCurtainState = Closing;
+    QList<CurtainType> halting;
+    for (CurtainType type : reversing) {
+        if (!m_channels[type].reversalTimer->isActive()) {
+            halting.append(type);
+        }
+    }
+    if (!halting.isEmpty()) {
+        if (!haltCurtains(halting, true)) {
+            for (CurtainType type : halting) {
+                emit errorOccurred(QString("%1换向停机失败").arg(curtainTypeToString(type)));
+            }
+        }
+        for (CurtainType type : halting) {
+            if (m_channels[type].machine.isMoving()) {
+                transition(type, CurtainStateMachine::Pause);
+            }
+            qDebug() << QString("%1换向，停机等待%2ms").arg(curtainTypeToString(type)).arg(CURTAIN_REVERSAL_DWELL_MS);
+        }
     }
 
-    emit curtainStateChanged(type, Closing);
+    for (CurtainType type : reversing) {
+        Channel &channel = m_channels[type];
+        channel.reversalTarget = percent;
+        if (!channel.reversalTimer->isActive()) {
+            channel.reversalTimer->start(CURTAIN_REVERSAL_DWELL_MS);
+        }
+    }
+    return ready;
+}
 
-    // 调用实际的GPIO控制方法
-    bool success = false;
-    if (type == TopCurtain) {
-        success = closeTopCurtain();
-    } else {
-        success = closeSideCurtain();
+bool CurtainController::prepareTravel(CurtainType type, double percent, Travel *travel)
+{
+    Channel &channel = m_channels[type];
+    const bool full = (percent <= 0.0 || percent >= 100.0);
+    const double current = channel.position.percent(monotonicNs());
+    const bool open = full ? (percent >= 100.0) : (percent > current);
+
+    // 已在终点限位，无需运动
+    if (readSensorStatus(type, open)) {
+        if (full) {
+            finishTravel(type, open);
+        }
+        return false;
     }
 
-    if (success) {
-        // 模拟操作完成后设置为关闭状态
-        QTimer::singleShot(2000, this, [this, type]() {
-            if (type == TopCurtain) {
-                m_topCurtainState = Closed;
-            } else {
-                m_sideCurtainState = Closed;
-            }
-            emit curtainStateChanged(type, Closed);
-            updateStatus();
-        });
-    } else {
-        // 操作失败，设置为错误状态
-        if (type == TopCurtain) {
-            m_topCurtainState = Error;
+    // 已在目标开度（全开/全关只有位置可信时才跳过，否则运动到终点重新归零）
+    if (!channel.position.isMoving() && qAbs(percent - current) < CURTAIN_POSITION_TOLERANCE_PERCENT
+            && (!full || channel.position.isCalibrated())) {
+        qDebug() << QString("%1已在%2%，无需运动").arg(curtainTypeToString(type)).arg(current, 0, 'f', 1);
+        return false;
+    }
+
+    channel.travelTimer->stop();
+    channel.positionTimer->stop();
+    channel.target = percent;
+    if (m_powerScheduler && channel.powerTicket) {
+        m_powerScheduler->cancel(channel.powerTicket); // 新目标取代仍在等待供电的运动
+        channel.powerTicket = 0;
+    }
+
+    transition(type, open ? CurtainStateMachine::StartOpen : CurtainStateMachine::StartClose);
+
+    // 结束方式：全开/全关且安装限位开关时由限位结束；已知全行程步数时由脉冲发生器按步数结束；否则按时间
+    travel->type = type;
+    travel->open = open;
+    travel->limitEnded = full && channel.actuator.limitPin(open) >= 0;
+    travel->stepEnded = !travel->limitEnded && m_stepper && channel.actuator.stepPin >= 0
+            && channel.position.fullTravelSteps(open) > 0; // 配置或标定得到的全行程步数
+    const double overrun = full ? CURTAIN_END_OVERRUN_PERCENT : 0.0; // 无限位时多运行一段，确保到达终点
+    travel->distance = qAbs(percent - current) + overrun;
+    const double end = open ? travel->distance : -travel->distance;
+    travel->steps = travel->stepEnded ? qMax<quint64>(1, channel.position.travelSteps(0.0, end)) : 0;
+    return true;
+}
+
+bool CurtainController::acquirePower(const Travel &travel)
+{
+    Channel &channel = m_channels[travel.type];
+    if (!m_powerScheduler || m_powerScheduler->tryAcquire(channel.actuator.enablePin)) {
+        return true;
+    }
+
+    channel.powerTicket = m_powerScheduler->submit(channel.actuator.enablePin, [this, travel]() {
+        return energizeTravel(travel);
+    });
+    qDebug() << QString("%1等待供电余量后启动").arg(curtainTypeToString(travel.type));
+    return false;
+}
+
+bool CurtainController::energizeTravel(const Travel &travel)
+{
+    Channel &channel = m_channels[travel.type];
+    channel.powerTicket = 0;
+
+    // 等待期间已被暂停、停止或改为其它目标
+    if (!channel.machine.isMoving()
+            || channel.machine.phase() != (travel.open ? CurtainStateMachine::Opening : CurtainStateMachine::Closing)) {
+        return false;
+    }
+
+    GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+    addDrivePins(transaction, channel.actuator, travel.open);
+    beginTravel(travel);
+    savePositions();
+
+    launchTravel(travel, transaction.commit().success);
+    return getCurtainState(travel.type) != Error;
+}
+
+void CurtainController::beginTravel(const Travel &travel)
+{
+    Channel &channel = m_channels[travel.type];
+
+    // 行程标定：从已校准的对侧终点出发、由限位结束的运动才计时；同方向改目标时继续计时
+    const qint64 nowNs = monotonicNs();
+    const double start = channel.position.percent(nowNs);
+    if (!channel.position.isMoving()) {
+        const bool fromEnd = channel.position.isCalibrated() && (travel.open ? start <= 0.0 : start >= 100.0);
+        if (fromEnd && channel.actuator.limitPin(travel.open) >= 0) {
+            channel.calibrator.start(travel.open, nowNs);
         } else {
-            m_sideCurtainState = Error;
+            channel.calibrator.abort();
         }
-        emit curtainStateChanged(type, Error);
-        emit errorOccurred(QString("%1关闭失败").arg(curtainTypeToString(type)));
+    } else if (channel.position.direction() != (travel.open ? 1 : -1)) {
+        channel.calibrator.abort();
     }
 
-    return success;
+    // 并入运行中的步进运动时，结束时的步数包含之前的行程，不能用于修正位置
+    const int pin = channel.actuator.stepPin;
+    const bool merged = m_stepper && pin >= 0 && m_stepper->isMoving(pin);
+    channel.position.begin(travel.open, nowNs, m_stepper && pin >= 0 && !merged);
+
+    // 先记录方向再驱动，确保紧随其后的限位事件能够被识别
+    channel.motion.storeRelease(travel.open ? 1 : -1);
+}
+
+void CurtainController::releasePower(const CurtainActuator &actuator) const
+{
+    if (m_powerScheduler) {
+        m_powerScheduler->release(actuator.enablePin);
+    }
+}
+
+void CurtainController::launchTravel(const Travel &travel, bool driven)
+{
+    Channel &channel = m_channels[travel.type];
+
+    if (!driven || !controlStepperMotor(travel.type, travel.open, travel.steps)) {
+        // 操作失败，停机并进入错误状态
+        haltCurtains(QList<CurtainType>() << travel.type, false);
+        transition(travel.type, CurtainStateMachine::Fault);
+        emit errorOccurred(QString("%1%2失败").arg(curtainTypeToString(travel.type)).arg(travel.open ? "打开" : "关闭"));
+        return;
+    }
+
+    if (travel.limitEnded) {
+        // 由限位开关结束运动，超时视为故障
+        channel.travelTimer->start(CURTAIN_TRAVEL_TIMEOUT_MS);
+    } else if (!travel.stepEnded) {
+        const qint64 travelMs = channel.position.travelTimeNs(0.0, travel.open ? travel.distance : -travel.distance) / 1000000;
+        channel.positionTimer->start(int(travelMs));
+    }
+}
+
+void CurtainController::onPositionTimeout(CurtainType type)
+{
+    // 已被暂停或限位结束
+    if (m_channels[type].motion.loadAcquire() == 0) {
+        return;
+    }
+    finishPositioning(type);
+}
+
+void CurtainController::finishPositioning(CurtainType type)
+{
+    haltCurtains(QList<CurtainType>() << type, true);
+
+    // 全开/全关按时间或步数多运行了一段，视为到达终点
+    const double target = m_channels[type].target;
+    if (target <= 0.0 || target >= 100.0) {
+        finishTravel(type, target >= 100.0);
+        return;
+    }
+
+    transition(type, CurtainStateMachine::ReachTarget);
 }
 
 bool CurtainController::pauseCurtain(CurtainType type)
 {
     qDebug() << QString("暂停%1运动").arg(curtainTypeToString(type));
+    return pauseCurtains(QList<CurtainType>() << type);
+}
 
+bool CurtainController::pauseCurtains(const QList<CurtainType> &types)
+{
     if (!m_initialized) {
         emit errorOccurred("保温帘控制器未初始化");
         return false;
     }
 
-    bool success = false;
-    if (type == TopCurtain) {
-        success = pauseTopCurtain();
-    } else {
-        success = pauseSideCurtain();
+    QList<CurtainType> valid;
+    for (CurtainType type : types) {
+        if (isValidCurtain(type)) {
+            valid.append(type);
+        }
     }
 
-    if (!success) {
-        emit errorOccurred(QString("%1暂停失败").arg(curtainTypeToString(type)));
+    if (!haltCurtains(valid, true)) {
+        for (CurtainType type : valid) {
+            emit errorOccurred(QString("%1暂停失败").arg(curtainTypeToString(type)));
+        }
+        return false;
+    }
+
+    // 未在运动时硬件仍执行暂停（确保使能关闭），状态不变
+    for (CurtainType type : valid) {
+        if (m_channels[type].machine.isMoving()) {
+            transition(type, CurtainStateMachine::Pause);
+        }
+    }
+    return valid.size() == types.size();
+}
+
+bool CurtainController::haltCurtains(const QList<CurtainType> &types, bool decelerate)
+{
+    if (!m_gpioController) {
+        return false;
+    }
+
+    bool settled = false;
+    QList<CurtainType> disabled;
+    GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+    for (CurtainType type : types) {
+        Channel &channel = m_channels[type];
+        channel.travelTimer->stop();
+        channel.positionTimer->stop();
+        channel.reversalTimer->stop();
+        channel.motion.storeRelease(0);
+        channel.calibrator.abort();
+        settled |= settlePosition(type);
+        if (m_powerScheduler && channel.powerTicket) {
+            m_powerScheduler->cancel(channel.powerTicket);
+            channel.powerTicket = 0;
+        }
+
+        if (channel.actuator.isSerial() && m_serialBus) {
+            // 智能驱动器自行减速，应答后再关闭使能（onSerialReply）；立即停机时同时关闭使能
+            const quint32 request = m_serialBus->stop(channel.actuator.serialAddress, decelerate);
+            if (decelerate && request != 0) {
+                channel.serialStop = request;
+                continue;
+            }
+        }
+
+        const int pin = channel.actuator.stepPin;
+        if (m_stepper && pin >= 0 && decelerate && m_stepper->isMoving(pin)) {
+            // 步进驱动减速停止，减速结束后再关闭使能（onStepperStopped），否则电机失去保持力
+            m_stepper->halt(pin, true);
+            continue;
+        }
+        if (m_stepper && pin >= 0) {
+            m_stepper->halt(pin); // 立即停止脉冲（不减速）
+        }
+        addEnablePins(transaction, channel.actuator, false);
+        disabled.append(type);
     }
 
+    if (settled) {
+        savePositions();
+    }
+    const bool success = transaction.isEmpty() || transaction.commit().success;
+    for (CurtainType type : disabled) {
+        releasePower(m_channels[type].actuator);
+    }
     return success;
 }
 
@@ -144,19 +574,18 @@ bool CurtainController::resumeCurtain(CurtainType type)
         return false;
     }
 
-    // 根据当前状态决定恢复方向
-    CurtainState currentState = getCurtainState(type);
-    bool success = false;
-
-    if (currentState == Paused) {
-        // 暂停状态下恢复到之前的运动状态
-        // 这里简化处理，默认恢复为打开操作
-        success = openCurtain(type);
-    } else {
+    // 按暂停前的方向恢复：目标仍在该方向上时继续运动到原目标，否则走到该方向的终点
+    if (!isValidCurtain(type) || !m_channels[type].machine.isPaused()) {
         qWarning() << QString("%1不在暂停状态，无法恢复").arg(curtainTypeToString(type));
         return false;
     }
 
+    const Channel &channel = m_channels[type];
+    const bool open = (channel.machine.phase() == CurtainStateMachine::PausedOpening);
+    const double current = channel.position.percent(monotonicNs());
+    const bool targetAhead = open ? (channel.target > current) : (channel.target < current);
+
+    const bool success = moveTo(type, targetAhead ? channel.target : (open ? 100.0 : 0.0));
     if (!success) {
         emit errorOccurred(QString("%1恢复失败").arg(curtainTypeToString(type)));
     }
@@ -168,25 +597,83 @@ void CurtainController::stopCurtain(CurtainType type)
 {
     qDebug() << QString("停止%1运动").arg(curtainTypeToString(type));
 
-    // TODO: 实现停止控制逻辑
+    if (!m_initialized) {
+        emit errorOccurred("保温帘控制器未初始化");
+        return;
+    }
+    if (!isValidCurtain(type)) {
+        return;
+    }
+
+    // 立即停止脉冲（不减速）并关闭使能
+    if (!haltCurtains(QList<CurtainType>() << type, false)) {
+        emit errorOccurred(QString("%1停止失败").arg(curtainTypeToString(type)));
+    }
 
-    // 保持当前状态不变
-    emit curtainStateChanged(type, getCurtainState(type));
+    // 停止后不可恢复；已在终点或已停止时状态不变
+    if (CurtainStateMachine::accepts(m_channels[type].machine.phase(), CurtainStateMachine::Stop)) {
+        transition(type, CurtainStateMachine::Stop);
+    }
 }
 
 CurtainController::CurtainState CurtainController::getCurtainState(CurtainType type) const
 {
-    return (type == TopCurtain) ? m_topCurtainState : m_sideCurtainState;
+    return isValidCurtain(type) ? toState(m_channels[type].machine.phase()) : Error;
+}
+
+CurtainController::CurtainState CurtainController::toState(CurtainStateMachine::Phase phase)
+{
+    switch (phase) {
+        case CurtainStateMachine::Opening:
+            return Opening;
+        case CurtainStateMachine::Closing:
+            return Closing;
+        case CurtainStateMachine::PausedOpening:
+        case CurtainStateMachine::PausedClosing:
+            return Paused;
+        case CurtainStateMachine::Open:
+            return Open;
+        case CurtainStateMachine::Closed:
+            return Closed;
+        case CurtainStateMachine::Error:
+            return Error;
+        default:
+            return Stopped;
+    }
+}
+
+bool CurtainController::transition(CurtainType type, CurtainStateMachine::Event event)
+{
+    CurtainStateMachine &machine = m_channels[type].machine;
+    const CurtainState before = toState(machine.phase());
+    if (!machine.handle(event)) {
+        qDebug() << QString("%1忽略非法状态转移：%2 -> %3")
+                    .arg(curtainTypeToString(type))
+                    .arg(curtainStateToString(before))
+                    .arg(CurtainStateMachine::eventName(event));
+        return false;
+    }
+
+    // 暂停方向等内部阶段变化不对外发出；同一对外状态只发出一次
+    const CurtainState after = toState(machine.phase());
+    if (after != before) {
+        emit curtainStateChanged(type, after);
+    }
+    updateStatus();
+    return true;
 }
 
 QString CurtainController::getStatusString() const
 {
-    QString topStatus = curtainStateToString(m_topCurtainState);
-    QString sideStatus = curtainStateToString(m_sideCurtainState);
+    const qint64 nowNs = monotonicNs();
+    QStringList parts;
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        parts.append(QString("%1%2%3%").arg(m_channels[type].actuator.name)
+                     .arg(curtainStateToString(getCurtainState(type)))
+                     .arg(m_channels[type].position.percent(nowNs), 0, 'f', 0));
+    }
 
-    return QString("🌡️ 当前状态: 顶部%1 | 侧部%2 | 温度: 适宜")
-           .arg(topStatus)
-           .arg(sideStatus);
+    return QString("🌡️ 当前状态: %1 | 温度: 适宜").arg(parts.join(" | "));
 }
 
 void CurtainController::updateStatus()
@@ -195,48 +682,157 @@ void CurtainController::updateStatus()
     emit statusUpdated(status);
 }
 
-void CurtainController::onOperationTimeout()
+void CurtainController::onTravelTimeout(CurtainType type)
 {
-    emit errorOccurred("保温帘操作超时");
+    // 限位已先一步停机
+    if (m_channels[type].motion.loadAcquire() == 0) {
+        return;
+    }
+
+    // 行程超时仍未到达限位，停机并进入错误状态
+    haltCurtains(QList<CurtainType>() << type, true);
+    transition(type, CurtainStateMachine::Fault);
+    emit errorOccurred(QString("%1操作超时，未到达限位").arg(curtainTypeToString(type)));
 }
 
-bool CurtainController::controlStepperMotor(CurtainType type, bool open)
+bool CurtainController::controlStepperMotor(CurtainType type, bool open, quint64 steps)
 {
-    // TODO: 实现实际的步进电机控制
-    // 这里可以添加以下控制方式：
-    // 1. 串口通信控制
-    // 2. GPIO控制
-    // 3. 网络通信控制
-    // 4. I2C/SPI通信控制
+    // 串口驱动器：命令入队即返回，未应答或被拒绝时由onSerialFailed转入错误状态
+    Channel &channel = m_channels[type];
+    if (channel.actuator.isSerial()) {
+        if (!m_serialBus || !m_serialBus->isOpen()) {
+            return false;
+        }
+        channel.serialStop = 0;
+        channel.serialMove = m_serialBus->move(channel.actuator.serialAddress, open,
+                                               quint32(qMin<quint64>(steps, 0xFFFFFFFFu)),
+                                               CURTAIN_STEPPER_STEPS_PER_SECOND);
+        return channel.serialMove != 0;
+    }
 
-    Q_UNUSED(type)
-    Q_UNUSED(open)
+    // 未接步进驱动器时电机由使能引脚直接驱动
+    const int pin = channel.actuator.stepPin;
+    if (pin < 0 || !m_stepper) {
+        return true;
+    }
 
-    // 模拟控制成功
-    return true;
+    // 起步前规划加减速，脉冲线程按表输出；DIR1已随使能事务设置，行程由步数、限位或暂停结束
+    const MotionProfile profile = MotionProfile::plan(steps, CURTAIN_STEPPER_STEPS_PER_SECOND);
+    qDebug() << QString("%1运动规划: %2步, %3步/秒, 加速%4步, %5")
+                .arg(curtainTypeToString(type))
+                .arg(steps)
+                .arg(profile.stepsPerSecond())
+                .arg(profile.rampLength())
+                .arg(profile.isPrecomputed() ? "预生成加速表" : "运行时生成加速表");
+    return m_stepper->move(pin, -1, open, profile);
 }
 
-bool CurtainController::readSensorStatus(CurtainType type)
+bool CurtainController::readSensorStatus(CurtainType type, bool open)
 {
-    // TODO: 实现传感器状态读取
-    // 可以读取限位开关、位置传感器等状态
+    const int pin = m_channels[type].actuator.limitPin(open);
+    if (pin < 0 || !m_gpioController) {
+        return false; // 未安装限位开关
+    }
 
-    Q_UNUSED(type)
+    return m_gpioController->readHardwarePin(pin) == bool(CURTAIN_LIMIT_ACTIVE);
+}
 
-    // 模拟传感器读取
-    return true;
+void CurtainController::onLimitEdge(int pin, bool rising, qint64 timestampNs)
+{
+    if (rising != bool(CURTAIN_LIMIT_ACTIVE)) {
+        return; // 离开限位
+    }
+
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        const Channel &channel = m_channels.at(type);
+        for (int end = 0; end < 2; ++end) {
+            const bool open = (end == 0);
+            if (channel.actuator.limitPin(open) != pin) {
+                continue;
+            }
+
+            // 只有朝该限位运动时才停机；置零成功者负责停机，避免重复
+            if (!channel.motion.testAndSetOrdered(open ? 1 : -1, 0)) {
+                return;
+            }
+
+            // 在监视线程中直接停止脉冲并关闭使能，不经过GUI事件循环
+            if (m_stepper && channel.actuator.stepPin >= 0) {
+                m_stepper->halt(channel.actuator.stepPin);
+            }
+            if (m_serialBus && channel.actuator.isSerial()) {
+                m_serialBus->stop(channel.actuator.serialAddress, false);
+            }
+            GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+            addEnablePins(transaction, channel.actuator, false);
+            transaction.commit();
+            releasePower(channel.actuator);
+
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            const qint64 latencyUs = (qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec - timestampNs) / 1000;
+            qDebug() << QString("%1到达%2限位，停机延迟%3us")
+                        .arg(channel.actuator.name)
+                        .arg(open ? "全开" : "全关")
+                        .arg(latencyUs);
+
+            QMetaObject::invokeMethod(this, [this, type, open, timestampNs]() {
+                finishTravel(type, open, timestampNs);
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
 }
 
-QString CurtainController::curtainTypeToString(CurtainType type) const
+void CurtainController::finishTravel(CurtainType type, bool open, qint64 limitNs)
 {
-    switch (type) {
-        case TopCurtain:
-            return "顶部保温帘";
-        case SideCurtain:
-            return "侧部保温帘";
-        default:
-            return "未知保温帘";
+    Channel &channel = m_channels[type];
+    channel.travelTimer->stop();
+    channel.positionTimer->stop();
+    channel.motion.storeRelease(0);
+    releasePower(channel.actuator); // 限位线程已释放时忽略
+
+    // 到达终点，位置重新归零
+    channel.position.reachLimit(open);
+    savePositions();
+    emit positionChanged(type, open ? 100.0 : 0.0);
+
+    // 由限位结束的完整行程：更新标定模型（按时间或步数结束的运动不能反映实际行程）
+    double errorPercent = 0.0;
+    if (limitNs > 0 && channel.calibrator.finish(open, limitNs, &errorPercent)) {
+        applyCalibration(type);
+        saveCalibration();
+        const int travelMs = int(channel.calibrator.travelNs(open) / 1000000);
+        qDebug() << QString("%1%2行程标定: %3ms（第%4个样本，原模型终点误差%5%）")
+                    .arg(channel.actuator.name).arg(open ? "打开" : "关闭").arg(travelMs)
+                    .arg(channel.calibrator.samples(open)).arg(errorPercent, 0, 'f', 1);
+        emit travelCalibrated(type, open, travelMs, errorPercent);
+    } else {
+        channel.calibrator.abort();
+    }
+
+    transition(type, open ? CurtainStateMachine::ReachOpen : CurtainStateMachine::ReachClosed);
+}
+
+QString CurtainController::curtainName(CurtainType type) const
+{
+    return isValidCurtain(type) ? m_channels[type].actuator.name : QString();
+}
+
+QList<CurtainController::CurtainType> CurtainController::curtainsInGroup(const QString &group) const
+{
+    QList<CurtainType> types;
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        if (m_channels[type].actuator.inGroup(group)) {
+            types.append(type);
+        }
     }
+    return types;
+}
+
+QString CurtainController::curtainTypeToString(CurtainType type) const
+{
+    return isValidCurtain(type) ? m_channels[type].actuator.name : QString("未知保温帘");
 }
 
 QString CurtainController::curtainStateToString(CurtainState state) const
@@ -261,157 +857,395 @@ QString CurtainController::curtainStateToString(CurtainState state) const
     }
 }
 
-// GPIO控制方法实现
+void CurtainController::onStepperStopped(int pin)
+{
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        const Channel &channel = m_channels.at(type);
+        // 运动已恢复（重新打开或关闭）时保持使能
+        if (channel.actuator.stepPin != pin || channel.motion.loadAcquire() != 0) {
+            continue;
+        }
 
-bool CurtainController::initialize()
+        GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+        addEnablePins(transaction, channel.actuator, false);
+        transaction.commit();
+        releasePower(channel.actuator);
+    }
+}
+
+void CurtainController::onStepperMoveFinished(int pin, quint64 steps, bool halted)
 {
-    if (m_initialized) {
-        return true;
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        if (m_channels[type].actuator.stepPin != pin) {
+            continue;
+        }
+
+        // 按规划步数走完：停机（全开/全关同时归零）
+        if (!halted && m_channels[type].motion.loadAcquire() != 0) {
+            finishPositioning(type);
+        }
+
+        // 标定运动的实际步数更新步数模型
+        if (m_channels[type].calibrator.applySteps(steps)) {
+            applyCalibration(type);
+            saveCalibration();
+        }
+
+        // 用实际步数替换按时间结算的位置（已归零时不再修正）
+        m_channels[type].position.applySteps(steps);
+        savePositions();
+        emit positionChanged(type, m_channels[type].position.percent(monotonicNs()));
     }
+}
 
-    if (!m_gpioController) {
-        emit errorOccurred("GPIO控制器未设置");
-        return false;
+double CurtainController::getCurtainPosition(CurtainType type) const
+{
+    return isValidCurtain(type) ? m_channels[type].position.percent(monotonicNs()) : 0.0;
+}
+
+bool CurtainController::isPositionCalibrated(CurtainType type) const
+{
+    return isValidCurtain(type) && m_channels[type].position.isCalibrated();
+}
+
+bool CurtainController::isCurtainMoving(CurtainType type) const
+{
+    return isValidCurtain(type)
+            && (m_channels[type].machine.isMoving() || m_channels[type].reversalTimer->isActive());
+}
+
+int CurtainController::expectedTravelMs(CurtainType type, double percent) const
+{
+    if (!isValidCurtain(type)) {
+        return 0;
+    }
+    const Channel &channel = m_channels[type];
+    const double current = channel.position.percent(monotonicNs());
+    if (channel.calibrator.samples(percent > current) == 0) {
+        return 0;
     }
+    return int(channel.position.travelTimeNs(current, qBound(0.0, percent, 100.0)) / 1000000);
+}
 
-    if (!initializeGPIOPins()) {
-        emit errorOccurred("GPIO引脚初始化失败");
+int CurtainController::calibrationSamples(CurtainType type, bool open) const
+{
+    return isValidCurtain(type) ? m_channels[type].calibrator.samples(open) : 0;
+}
+
+bool CurtainController::settlePosition(CurtainType type)
+{
+    CurtainPosition &position = m_channels[type].position;
+    if (!position.isMoving()) {
         return false;
     }
+    position.end(monotonicNs());
 
-    m_initialized = true;
+    const double percent = position.percent(monotonicNs());
+    qDebug() << QString("%1停在%2%").arg(curtainTypeToString(type)).arg(percent, 0, 'f', 1);
+    emit positionChanged(type, percent);
     return true;
 }
 
-void CurtainController::setGPIOController(GPIOController *controller)
+qint64 CurtainController::fullTravelNs(const CurtainActuator &actuator)
 {
-    m_gpioController = controller;
+    // 已知全行程步数时按步频折算，否则使用实测的全行程时间
+    if (actuator.stepPin >= 0 && CURTAIN_TRAVEL_STEPS > 0) {
+        return qint64(CURTAIN_TRAVEL_STEPS) * 1000000000LL / CURTAIN_STEPPER_STEPS_PER_SECOND;
+    }
+    return qint64(CURTAIN_FULL_TRAVEL_MS) * 1000000LL;
 }
 
-bool CurtainController::openTopCurtain()
+void CurtainController::setStateJournal(StateJournal *journal)
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    m_stateJournal = journal;
+    if (m_stateJournal) {
+        loadPositions(); // 日志中的位置优先于位置文件
     }
-
-    // 上侧帘打开: 引脚1高电平，引脚2低电平，使能低电平（双使能引脚）
-    return setTopCurtainGPIOWithDual(GPIO_HIGH, GPIO_LOW, CURTAIN_ENABLE);
 }
 
-bool CurtainController::closeTopCurtain()
+void CurtainController::loadPositions()
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    // 按执行器标识保存，配置增删执行器时其余执行器的位置不受影响
+    QJsonObject root;
+    QFile file(m_positionFile);
+    if (file.open(QIODevice::ReadOnly)) {
+        root = QJsonDocument::fromJson(file.readAll()).object();
     }
 
-    // 上侧帘关闭: 引脚1低电平，引脚2高电平，使能低电平（双使能引脚）
-    return setTopCurtainGPIOWithDual(GPIO_LOW, GPIO_HIGH, CURTAIN_ENABLE);
+    for (Channel &channel : m_channels) {
+        StateJournal::Entry entry;
+        if (m_stateJournal && m_stateJournal->lookup(StateJournal::CurtainPosition,
+                                                     StateJournal::keyFor(channel.actuator.key), &entry)) {
+            QJsonObject json;
+            json["percent"] = entry.value / 1000.0;
+            json["startPercent"] = entry.aux / 1000.0;
+            json["moving"] = (entry.flags & StateJournal::CurtainMoving) != 0;
+            json["calibrated"] = (entry.flags & StateJournal::CurtainCalibrated) != 0;
+            channel.position.fromJson(json);
+        } else if (root.contains(channel.actuator.key)) {
+            channel.position.fromJson(root[channel.actuator.key].toObject());
+        } else {
+            qDebug() << QString("%1位置记录不存在，按全关处理").arg(channel.actuator.name);
+            continue;
+        }
+        channel.target = channel.position.percent(0);
+
+        qDebug() << QString("%1位置已恢复: %2%%3")
+                    .arg(channel.actuator.name)
+                    .arg(channel.target, 0, 'f', 1)
+                    .arg(channel.position.isCalibrated() ? "" : "（未校准）");
+    }
 }
 
-bool CurtainController::pauseTopCurtain()
+void CurtainController::applyCalibration(CurtainType type)
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    Channel &channel = m_channels[type];
+    for (int end = 0; end < 2; ++end) {
+        const bool open = (end == 1);
+        channel.position.setTravelModel(open, channel.calibrator.travelNs(open), channel.calibrator.travelSteps(open));
     }
-
-    // 上侧帘暂停: 使能高电平（双使能引脚）
-    return (m_gpioController->setPin(TOP_CURTAIN_ENABLE_PIN, CURTAIN_DISABLE) &&
-            m_gpioController->setPin(TOP_CURTAIN_ENABLE2_PIN, CURTAIN_DISABLE));
 }
 
-bool CurtainController::openSideCurtain()
+void CurtainController::loadCalibration()
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    QFile file(m_calibrationFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return; // 尚未标定，使用配置的全行程时间
     }
 
-    // 侧面帘打开: 引脚3高电平，引脚4低电平，使能低电平（双使能引脚）
-    return setSideCurtainGPIOWithDual(GPIO_HIGH, GPIO_LOW, CURTAIN_ENABLE);
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        Channel &channel = m_channels[type];
+        if (!root.contains(channel.actuator.key)) {
+            continue;
+        }
+        channel.calibrator.fromJson(root[channel.actuator.key].toObject());
+        applyCalibration(type);
+
+        qDebug() << QString("%1行程标定已恢复: 打开%2ms（%3个样本），关闭%4ms（%5个样本）")
+                    .arg(channel.actuator.name)
+                    .arg(channel.calibrator.travelNs(true) / 1000000).arg(channel.calibrator.samples(true))
+                    .arg(channel.calibrator.travelNs(false) / 1000000).arg(channel.calibrator.samples(false));
+    }
 }
 
-bool CurtainController::closeSideCurtain()
+void CurtainController::saveCalibration() const
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    QJsonObject root;
+    for (const Channel &channel : m_channels) {
+        root[channel.actuator.key] = channel.calibrator.toJson();
     }
 
-    // 侧面帘关闭: 引脚3低电平，引脚4高电平，使能低电平（双使能引脚）
-    return setSideCurtainGPIOWithDual(GPIO_LOW, GPIO_HIGH, CURTAIN_ENABLE);
+    QSaveFile file(m_calibrationFile);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+            || !file.commit()) {
+        qWarning() << QString("保温帘行程标定保存失败: %1").arg(file.errorString());
+    }
 }
 
-bool CurtainController::pauseSideCurtain()
+void CurtainController::savePositions() const
 {
-    if (!m_initialized) {
-        emit errorOccurred("保温帘控制器未初始化");
-        return false;
+    // 有状态日志时追加记录（批量落盘），不再整体重写位置文件
+    if (m_stateJournal && m_stateJournal->isOpen()) {
+        for (const Channel &channel : m_channels) {
+            const QJsonObject json = channel.position.toJson();
+            quint32 flags = 0;
+            if (json["moving"].toBool()) {
+                flags |= StateJournal::CurtainMoving;
+            }
+            if (json["calibrated"].toBool()) {
+                flags |= StateJournal::CurtainCalibrated;
+            }
+            m_stateJournal->record(StateJournal::CurtainPosition, StateJournal::keyFor(channel.actuator.key),
+                                   qRound64(json["percent"].toDouble() * 1000.0),
+                                   qRound64(json["startPercent"].toDouble() * 1000.0), flags);
+        }
+        return;
     }
 
-    // 侧面帘暂停: 使能高电平（双使能引脚）
-    return (m_gpioController->setPin(SIDE_CURTAIN_ENABLE_PIN, CURTAIN_DISABLE) &&
-            m_gpioController->setPin(SIDE_CURTAIN_ENABLE2_PIN, CURTAIN_DISABLE));
+    QJsonObject root;
+    for (const Channel &channel : m_channels) {
+        root[channel.actuator.key] = channel.position.toJson();
+    }
+
+    // 先写临时文件再替换，断电时不会留下半个文件
+    QSaveFile file(m_positionFile);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+            || !file.commit()) {
+        qWarning() << QString("保温帘位置保存失败: %1").arg(file.errorString());
+    }
 }
 
-bool CurtainController::setTopCurtainGPIO(bool dir1, bool dir2, bool enable)
+// GPIO控制方法实现
+
+bool CurtainController::initialize()
 {
+    if (m_initialized) {
+        return true;
+    }
+
     if (!m_gpioController) {
+        emit errorOccurred("GPIO控制器未设置");
         return false;
     }
 
-    bool success = true;
-    success &= m_gpioController->setPin(TOP_CURTAIN_DIR1_PIN, dir1);
-    success &= m_gpioController->setPin(TOP_CURTAIN_DIR2_PIN, dir2);
-    success &= m_gpioController->setPin(TOP_CURTAIN_ENABLE_PIN, enable);
+    if (!initializeGPIOPins()) {
+        emit errorOccurred("GPIO引脚初始化失败");
+        return false;
+    }
 
-    return success;
+    initializeLimitSwitches();
+
+    if (m_stepper && !m_stepper->start()) {
+        emit errorOccurred("步进脉冲线程启动失败");
+        return false;
+    }
+
+    if (m_serialBus && !openSerialBus()) {
+        emit errorOccurred("步进驱动器串口总线打开失败");
+        return false;
+    }
+
+    m_initialized = true;
+    return true;
 }
 
-bool CurtainController::setSideCurtainGPIO(bool dir1, bool dir2, bool enable)
+void CurtainController::setGPIOController(GPIOController *controller)
 {
-    if (!m_gpioController) {
-        return false;
+    m_gpioController = controller;
+
+    bool hasStepper = false;
+    bool hasSerial = false;
+    for (const Channel &channel : m_channels) {
+        hasStepper |= (channel.actuator.stepPin >= 0);
+        hasSerial |= channel.actuator.isSerial();
     }
 
-    bool success = true;
-    success &= m_gpioController->setPin(SIDE_CURTAIN_DIR1_PIN, dir1);
-    success &= m_gpioController->setPin(SIDE_CURTAIN_DIR2_PIN, dir2);
-    success &= m_gpioController->setPin(SIDE_CURTAIN_ENABLE_PIN, enable);
+    // 串口总线在GUI线程中创建，应答与失败在收发线程中发出，投递到GUI线程处理
+    if (!m_serialBus && hasSerial) {
+        m_serialBus = new SerialStepperBus(this);
+        connect(m_serialBus, &SerialStepperBus::errorOccurred, this, &CurtainController::errorOccurred,
+                Qt::QueuedConnection);
+        connect(m_serialBus, &SerialStepperBus::replyReceived, this,
+                [this](quint32 requestId, int address, int command, const QByteArray &) {
+            QMetaObject::invokeMethod(this, [this, requestId, address, command]() {
+                onSerialReply(requestId, address, command);
+            }, Qt::QueuedConnection);
+        }, Qt::DirectConnection);
+        connect(m_serialBus, &SerialStepperBus::requestFailed, this,
+                [this](quint32 requestId, int address, int command, const QString &error) {
+            QMetaObject::invokeMethod(this, [this, requestId, address, command, error]() {
+                onSerialFailed(requestId, address, command, error);
+            }, Qt::QueuedConnection);
+        }, Qt::DirectConnection);
+#if CURTAIN_SERIAL_EMULATE
+        // 与总线一同在GUI线程中创建；initialize()在启动工作线程中运行，不能在那里创建子对象
+        m_serialEmulator = new SerialStepperEmulator(this);
+#endif
+    }
 
-    return success;
+    // 在GUI线程中创建，脉冲线程由initialize()启动
+    if (!m_stepper && controller && hasStepper) {
+        m_stepper = new StepperPulseGenerator(controller, this);
+        connect(m_stepper, &StepperPulseGenerator::errorOccurred, this, &CurtainController::errorOccurred);
+        connect(m_stepper, &StepperPulseGenerator::moveFinished, this, [this](int pin, quint64 steps, bool halted) {
+            onStepperStopped(pin);
+            QMetaObject::invokeMethod(this, [this, pin, steps, halted]() {
+                onStepperMoveFinished(pin, steps, halted);
+            }, Qt::QueuedConnection);
+        }, Qt::DirectConnection);
+    }
 }
 
-bool CurtainController::setTopCurtainGPIOWithDual(bool dir1, bool dir2, bool enable)
+bool CurtainController::openSerialBus()
 {
-    if (!m_gpioController) {
+    QString device = CURTAIN_SERIAL_DEVICE;
+#if CURTAIN_SERIAL_EMULATE
+    // 无硬件联调：总线连接伪终端另一端的仿真驱动器，帧、超时与重发路径与实机一致
+    if (!m_serialEmulator || !m_serialEmulator->start()) {
         return false;
     }
+    device = m_serialEmulator->devicePath();
+#endif
+    return m_serialBus->open(device, CURTAIN_SERIAL_BAUD);
+}
 
-    bool success = true;
-    success &= m_gpioController->setPin(TOP_CURTAIN_DIR1_PIN, dir1);
-    success &= m_gpioController->setPin(TOP_CURTAIN_DIR2_PIN, dir2);
-    success &= m_gpioController->setPin(TOP_CURTAIN_ENABLE_PIN, enable);  // GPIO3_A3
-    success &= m_gpioController->setPin(TOP_CURTAIN_ENABLE2_PIN, enable); // GPIO3_A0 - 逻辑完全同GPIO3_A3
+CurtainController::CurtainType CurtainController::serialCurtain(int address) const
+{
+    for (CurtainType type = 0; type < m_channels.size(); ++type) {
+        if (m_channels[type].actuator.serialAddress == address) {
+            return type;
+        }
+    }
+    return -1;
+}
 
-    return success;
+void CurtainController::onSerialReply(quint32 requestId, int address, int command)
+{
+    const CurtainType type = serialCurtain(address);
+    if (type < 0 || command != SerialStepperBus::Stop) {
+        return;
+    }
+
+    // 减速停机完成后关闭使能；其间已重新运动时保持使能
+    Channel &channel = m_channels[type];
+    if (channel.serialStop != requestId) {
+        return;
+    }
+    channel.serialStop = 0;
+    if (channel.motion.loadAcquire() == 0) {
+        GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+        addEnablePins(transaction, channel.actuator, false);
+        transaction.commit();
+        releasePower(channel.actuator);
+    }
 }
 
-bool CurtainController::setSideCurtainGPIOWithDual(bool dir1, bool dir2, bool enable)
+void CurtainController::onSerialFailed(quint32 requestId, int address, int command, const QString &error)
 {
-    if (!m_gpioController) {
-        return false;
+    const CurtainType type = serialCurtain(address);
+    if (type < 0) {
+        return;
+    }
+    Channel &channel = m_channels[type];
+    qWarning() << QString("%1串口命令0x%2失败: %3").arg(channel.actuator.name).arg(command, 2, 16, QChar('0')).arg(error);
+
+    // 减速停机未得到应答：直接关闭使能，确保电机停止
+    if (requestId == channel.serialStop) {
+        channel.serialStop = 0;
+        if (channel.motion.loadAcquire() == 0) {
+            GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+            addEnablePins(transaction, channel.actuator, false);
+            transaction.commit();
+            releasePower(channel.actuator);
+        }
+        return;
     }
 
-    bool success = true;
-    success &= m_gpioController->setPin(SIDE_CURTAIN_DIR1_PIN, dir1);
-    success &= m_gpioController->setPin(SIDE_CURTAIN_DIR2_PIN, dir2);
-    success &= m_gpioController->setPin(SIDE_CURTAIN_ENABLE_PIN, enable);  // GPIO3_B1
-    success &= m_gpioController->setPin(SIDE_CURTAIN_ENABLE2_PIN, enable); // GPIO3_A5 - 逻辑同GPIO3_B1
+    // 当前运动命令失败：停机并进入错误状态（已被后续命令取代的失败忽略）
+    if (requestId == channel.serialMove && channel.motion.loadAcquire() != 0) {
+        channel.serialMove = 0;
+        haltCurtains(QList<CurtainType>() << type, false);
+        transition(type, CurtainStateMachine::Fault);
+        emit errorOccurred(QString("%1驱动器无应答: %2").arg(curtainTypeToString(type)).arg(error));
+    }
+}
 
-    return success;
+void CurtainController::setPowerScheduler(PowerBudgetScheduler *scheduler)
+{
+    m_powerScheduler = scheduler;
+    if (!scheduler) {
+        return;
+    }
+
+    // 负载以使能引脚登记（双驱动板视为同一负载，浪涌按配置合计）
+    for (const Channel &channel : m_channels) {
+        const CurtainActuator &actuator = channel.actuator;
+        scheduler->registerLoad(actuator.enablePin, actuator.name + "电机",
+                                actuator.inrushMa, actuator.steadyMa, actuator.inrushMs);
+    }
 }
 
 bool CurtainController::initializeGPIOPins()
@@ -420,37 +1254,61 @@ bool CurtainController::initializeGPIOPins()
         return false;
     }
 
-    bool success = true;
+    // 导出、设置输出方向并初始化为停止状态（使能高电平，方向引脚低电平），所有执行器一次批量提交
+    GPIOController::Transaction transaction = m_gpioController->beginTransaction();
+    for (const Channel &channel : m_channels) {
+        const CurtainActuator &actuator = channel.actuator;
+        const int outputs[] = { actuator.dir1Pin, actuator.dir2Pin, actuator.enablePin, actuator.enable2Pin };
+        for (int pin : outputs) {
+            if (pin >= 0) {
+                transaction.exportPin(pin).setDirection(pin, "out");
+            }
+        }
+        if (actuator.dir1Pin >= 0) {
+            transaction.setPin(actuator.dir1Pin, GPIO_LOW);
+        }
+        if (actuator.dir2Pin >= 0) {
+            transaction.setPin(actuator.dir2Pin, GPIO_LOW);
+        }
+        addEnablePins(transaction, actuator, false);
 
-    // 导出并设置上侧帘控制引脚
-    success &= m_gpioController->exportPin(TOP_CURTAIN_DIR1_PIN);
-    success &= m_gpioController->exportPin(TOP_CURTAIN_DIR2_PIN);
-    success &= m_gpioController->exportPin(TOP_CURTAIN_ENABLE_PIN);
-    success &= m_gpioController->exportPin(TOP_CURTAIN_ENABLE2_PIN); // 新增双使能引脚
+        // 步进驱动器STEP引脚（可选），空闲为低电平
+        if (actuator.stepPin >= 0) {
+            transaction.exportPin(actuator.stepPin).setDirection(actuator.stepPin, "out").setPin(actuator.stepPin, GPIO_LOW);
+        }
+    }
 
-    // 导出并设置侧面帘控制引脚
-    success &= m_gpioController->exportPin(SIDE_CURTAIN_DIR1_PIN);
-    success &= m_gpioController->exportPin(SIDE_CURTAIN_DIR2_PIN);
-    success &= m_gpioController->exportPin(SIDE_CURTAIN_ENABLE_PIN);
-    success &= m_gpioController->exportPin(SIDE_CURTAIN_ENABLE2_PIN); // 新增双使能引脚
+    GPIOController::TransactionResult result = transaction.commit();
+    for (auto it = result.failures.constBegin(); it != result.failures.constEnd(); ++it) {
+        qWarning() << QString("保温帘GPIO引脚%1初始化失败: %2").arg(it.key()).arg(it.value());
+    }
 
-    if (success) {
-        // 设置所有引脚为输出方向
-        success &= m_gpioController->setDirection(TOP_CURTAIN_DIR1_PIN, "out");
-        success &= m_gpioController->setDirection(TOP_CURTAIN_DIR2_PIN, "out");
-        success &= m_gpioController->setDirection(TOP_CURTAIN_ENABLE_PIN, "out");
-        success &= m_gpioController->setDirection(TOP_CURTAIN_ENABLE2_PIN, "out"); // 新增双使能引脚
-        success &= m_gpioController->setDirection(SIDE_CURTAIN_DIR1_PIN, "out");
-        success &= m_gpioController->setDirection(SIDE_CURTAIN_DIR2_PIN, "out");
-        success &= m_gpioController->setDirection(SIDE_CURTAIN_ENABLE_PIN, "out");
-        success &= m_gpioController->setDirection(SIDE_CURTAIN_ENABLE2_PIN, "out"); // 新增双使能引脚
+    qDebug() << QString("保温帘GPIO引脚初始化完成，耗时%1us，%2个引脚已就绪跳过").arg(result.elapsedUs).arg(result.unchangedCount);
+    return result.success;
+}
 
-        // 初始化为停止状态（使能高电平，方向引脚低电平）- 使用双使能引脚
-        if (success) {
-            success &= setTopCurtainGPIOWithDual(GPIO_LOW, GPIO_LOW, CURTAIN_DISABLE);
-            success &= setSideCurtainGPIOWithDual(GPIO_LOW, GPIO_LOW, CURTAIN_DISABLE);
+void CurtainController::initializeLimitSwitches()
+{
+    bool installed = false;
+    for (const Channel &channel : m_channels) {
+        for (int end = 0; end < 2; ++end) {
+            const int pin = channel.actuator.limitPin(end == 0);
+            if (pin < 0) {
+                continue;
+            }
+            if (!m_gpioController->exportPin(pin)
+                    || !m_gpioController->configureInput(pin, GPIOController::BothEdges, CURTAIN_LIMIT_DEBOUNCE_US)) {
+                qWarning() << QString("%1限位开关引脚%2初始化失败").arg(channel.actuator.name).arg(pin);
+                continue;
+            }
+            installed = true;
         }
     }
 
-    return success;
-}
\ No newline at end of file
+    if (installed) {
+        // 直连：在事件监视线程中完成停机判断，不等待GUI事件循环
+        connect(m_gpioController, &GPIOController::inputEdge,
+                this, &CurtainController::onLimitEdge, Qt::DirectConnection);
+        qDebug() << "保温帘限位开关边沿检测已启用";
+    }
+}
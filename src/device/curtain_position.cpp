@@ -0,0 +1,116 @@
+#include "device/curtain_position.h"
+
+#include <QDebug>
+
+static double clampPercent(double percent)
+{
+    return qBound(0.0, percent, 100.0);
+}
+
+CurtainPosition::CurtainPosition(qint64 fullTravelNs, quint64 fullTravelSteps)
+    : m_runTravelNs(fullTravelNs > 0 ? fullTravelNs : 1)
+    , m_percent(0.0)        // 默认关闭，与重启后的初始化状态一致
+    , m_startPercent(0.0)
+    , m_startNs(0)
+    , m_direction(0)
+    , m_lastDirection(0)
+    , m_stepExact(false)
+    , m_calibrated(false)
+{
+    for (int i = 0; i < 2; ++i) {
+        m_fullTravelNs[i] = m_runTravelNs;
+        m_fullTravelSteps[i] = fullTravelSteps;
+    }
+}
+
+void CurtainPosition::setTravelModel(bool open, qint64 fullTravelNs, quint64 fullTravelSteps)
+{
+    m_fullTravelNs[open ? 1 : 0] = qMax<qint64>(1, fullTravelNs);
+    m_fullTravelSteps[open ? 1 : 0] = fullTravelSteps;
+}
+
+double CurtainPosition::percent(qint64 nowNs) const
+{
+    if (m_direction == 0) {
+        return m_percent;
+    }
+    const double moved = 100.0 * double(nowNs - m_startNs) / double(m_runTravelNs);
+    return clampPercent(m_startPercent + m_direction * moved);
+}
+
+void CurtainPosition::begin(bool open, qint64 nowNs, bool stepExact)
+{
+    if (m_direction != 0) {
+        end(nowNs);
+    }
+    m_startPercent = m_percent;
+    m_startNs = nowNs;
+    m_direction = open ? 1 : -1;
+    m_lastDirection = m_direction;
+    m_runTravelNs = fullTravelNs(open);
+    m_stepExact = stepExact && fullTravelSteps(open) > 0;
+}
+
+void CurtainPosition::end(qint64 nowNs)
+{
+    if (m_direction == 0) {
+        return;
+    }
+    m_percent = percent(nowNs);
+    m_direction = 0;
+}
+
+void CurtainPosition::applySteps(quint64 steps)
+{
+    if (!m_stepExact || m_direction != 0) {
+        return;
+    }
+    // 以运动起点为基准，替换按时间结算的结果
+    const double moved = 100.0 * double(steps) / double(fullTravelSteps(m_lastDirection > 0));
+    m_percent = clampPercent(m_startPercent + m_lastDirection * moved);
+    m_stepExact = false;
+}
+
+void CurtainPosition::reachLimit(bool open)
+{
+    m_percent = open ? 100.0 : 0.0;
+    m_direction = 0;
+    m_stepExact = false;   // 限位优先于步数修正
+    m_calibrated = true;
+}
+
+qint64 CurtainPosition::travelTimeNs(double fromPercent, double toPercent) const
+{
+    return qint64(qAbs(toPercent - fromPercent) / 100.0 * double(fullTravelNs(toPercent > fromPercent)));
+}
+
+quint64 CurtainPosition::travelSteps(double fromPercent, double toPercent) const
+{
+    return quint64(qAbs(toPercent - fromPercent) / 100.0 * double(fullTravelSteps(toPercent > fromPercent)) + 0.5);
+}
+
+QJsonObject CurtainPosition::toJson() const
+{
+    QJsonObject json;
+    json["percent"] = m_percent;
+    json["startPercent"] = m_startPercent;
+    json["moving"] = (m_direction != 0);
+    json["calibrated"] = m_calibrated;
+    return json;
+}
+
+void CurtainPosition::fromJson(const QJsonObject &json)
+{
+    m_direction = 0;
+    m_stepExact = false;
+    if (json["moving"].toBool()) {
+        // 运动中断电，实际位置在起点与终点之间，暂以起点为准
+        m_percent = clampPercent(json["startPercent"].toDouble());
+        m_calibrated = false;
+        qWarning() << QString("保温帘上次在运动中断电，位置按起点%1%估计，待下次到达终点校准").arg(m_percent, 0, 'f', 1);
+    } else {
+        m_percent = clampPercent(json["percent"].toDouble());
+        m_calibrated = json["calibrated"].toBool();
+    }
+    m_startPercent = m_percent;
+}
@@ -0,0 +1,46 @@
+#include "device/curtain_state_machine.h"
+
+typedef CurtainStateMachine SM;
+static constexpr SM::Phase X = SM::PhaseCount; // 非法转移
+
+// 转移表：行为当前阶段，列依次为
+// StartOpen, StartClose, Pause, Resume, Stop, ReachOpen, ReachClosed, ReachTarget, Fault
+static constexpr SM::Phase TRANSITIONS[SM::PhaseCount][SM::EventCount] = {
+    /* Stopped       */ { SM::Opening, SM::Closing, X,                 X,           X,           SM::Open, SM::Closed, X,           SM::Error },
+    /* Opening       */ { SM::Opening, SM::Closing, SM::PausedOpening, X,           SM::Stopped, SM::Open, SM::Closed, SM::Stopped, SM::Error },
+    /* Closing       */ { SM::Opening, SM::Closing, SM::PausedClosing, X,           SM::Stopped, SM::Open, SM::Closed, SM::Stopped, SM::Error },
+    /* PausedOpening */ { SM::Opening, SM::Closing, X,                 SM::Opening, SM::Stopped, SM::Open, SM::Closed, X,           SM::Error },
+    /* PausedClosing */ { SM::Opening, SM::Closing, X,                 SM::Closing, SM::Stopped, SM::Open, SM::Closed, X,           SM::Error },
+    /* Open          */ { SM::Opening, SM::Closing, X,                 X,           X,           SM::Open, SM::Closed, X,           SM::Error },
+    /* Closed        */ { SM::Opening, SM::Closing, X,                 X,           X,           SM::Open, SM::Closed, X,           SM::Error },
+    /* Error         */ { SM::Opening, SM::Closing, X,                 X,           SM::Stopped, SM::Open, SM::Closed, X,           SM::Error },
+};
+
+// 关键语义在编译期校验
+static_assert(TRANSITIONS[SM::Opening][SM::Pause] == SM::PausedOpening, "打开途中暂停须记住方向");
+static_assert(TRANSITIONS[SM::Closing][SM::Pause] == SM::PausedClosing, "关闭途中暂停须记住方向");
+static_assert(TRANSITIONS[SM::PausedOpening][SM::Resume] == SM::Opening, "恢复须沿暂停前的方向");
+static_assert(TRANSITIONS[SM::PausedClosing][SM::Resume] == SM::Closing, "恢复须沿暂停前的方向");
+static_assert(TRANSITIONS[SM::Stopped][SM::Resume] == X, "停止后不可恢复");
+
+static const char *const EVENT_NAMES[SM::EventCount] = {
+    "开始打开", "开始关闭", "暂停", "恢复", "停止", "到达全开", "到达全关", "到达目标开度", "故障"
+};
+
+bool CurtainStateMachine::accepts(Phase phase, Event event)
+{
+    return next(phase, event) != PhaseCount;
+}
+
+CurtainStateMachine::Phase CurtainStateMachine::next(Phase phase, Event event)
+{
+    if (phase < 0 || phase >= PhaseCount || event < 0 || event >= EventCount) {
+        return PhaseCount;
+    }
+    return TRANSITIONS[phase][event];
+}
+
+const char *CurtainStateMachine::eventName(Event event)
+{
+    return (event >= 0 && event < EventCount) ? EVENT_NAMES[event] : "未知事件";
+}
@@ -0,0 +1,166 @@
+#include "device/curtain_travel_calibrator.h"
+#include "config/gpio_config.h"
+
+#include <QDebug>
+
+CurtainTravelCalibrator::CurtainTravelCalibrator(qint64 defaultTravelNs, quint64 defaultTravelSteps)
+    : m_running(false)
+    , m_runOpen(false)
+    , m_runStartNs(0)
+    , m_stepsPending(false)
+    , m_stepsOpen(false)
+{
+    for (Model &model : m_models) {
+        model.travelNs = double(qMax<qint64>(1, defaultTravelNs));
+        model.travelSteps = double(defaultTravelSteps);
+        model.samples = 0;
+        model.stepSamples = 0;
+    }
+}
+
+void CurtainTravelCalibrator::start(bool open, qint64 nowNs)
+{
+    m_running = true;
+    m_runOpen = open;
+    m_runStartNs = nowNs;
+    m_stepsPending = false;
+}
+
+void CurtainTravelCalibrator::abort()
+{
+    m_running = false;
+    m_stepsPending = false;
+}
+
+bool CurtainTravelCalibrator::finish(bool open, qint64 limitNs, double *errorPercent)
+{
+    if (!m_running || m_runOpen != open || limitNs <= m_runStartNs) {
+        abort();
+        return false;
+    }
+    m_running = false;
+
+    Model &model = m_models[open ? 1 : 0];
+    const double sample = double(limitNs - m_runStartNs);
+    const double previousNs = model.travelNs;
+    if (isOutlier(model.travelNs, sample, model.samples)) {
+        if (!relearn(model.travelOutliers, model.travelNs, model.samples, sample)) {
+            qWarning() << QString("保温帘%1行程%2ms偏离模型%3ms过大，不参与标定")
+                          .arg(open ? "打开" : "关闭").arg(sample / 1e6, 0, 'f', 0).arg(previousNs / 1e6, 0, 'f', 0);
+            return false;
+        }
+        qWarning() << QString("保温帘%1行程连续%2次偏离模型%3ms，按新行程%4ms重新标定")
+                      .arg(open ? "打开" : "关闭").arg(model.samples)
+                      .arg(previousNs / 1e6, 0, 'f', 0).arg(model.travelNs / 1e6, 0, 'f', 0);
+    } else {
+        model.travelOutliers = OutlierRun();
+        model.travelNs = blend(model.travelNs, sample, model.samples);
+        model.samples++;
+    }
+
+    // 按原模型推算的终点与实际终点之差（占全行程的百分比）
+    if (errorPercent) {
+        *errorPercent = 100.0 * qAbs(sample - previousNs) / sample;
+    }
+
+    m_stepsPending = true;
+    m_stepsOpen = open;
+    return true;
+}
+
+bool CurtainTravelCalibrator::applySteps(quint64 steps)
+{
+    if (!m_stepsPending || steps == 0) {
+        return false;
+    }
+    m_stepsPending = false;
+
+    Model &model = m_models[m_stepsOpen ? 1 : 0];
+    const bool known = model.travelSteps > 0.0;
+    if (known && isOutlier(model.travelSteps, double(steps), model.stepSamples)) {
+        return relearn(model.stepOutliers, model.travelSteps, model.stepSamples, double(steps));
+    }
+    model.stepOutliers = OutlierRun();
+    model.travelSteps = known ? blend(model.travelSteps, double(steps), model.stepSamples) : double(steps);
+    model.stepSamples++;
+    return true;
+}
+
+qint64 CurtainTravelCalibrator::travelNs(bool open) const
+{
+    return qint64(m_models[open ? 1 : 0].travelNs);
+}
+
+quint64 CurtainTravelCalibrator::travelSteps(bool open) const
+{
+    return quint64(m_models[open ? 1 : 0].travelSteps + 0.5);
+}
+
+int CurtainTravelCalibrator::samples(bool open) const
+{
+    return m_models[open ? 1 : 0].samples;
+}
+
+double CurtainTravelCalibrator::blend(double model, double sample, int samples)
+{
+    // 前几个样本的权重为1/(n+1)（即累计平均），之后固定为CURTAIN_CALIBRATION_ALPHA
+    const double alpha = qMax(double(CURTAIN_CALIBRATION_ALPHA), 1.0 / double(samples + 1));
+    return model + alpha * (sample - model);
+}
+
+bool CurtainTravelCalibrator::isOutlier(double model, double sample, int samples)
+{
+    return samples >= CURTAIN_CALIBRATION_MIN_SAMPLES
+            && qAbs(sample - model) > CURTAIN_CALIBRATION_MAX_DEVIATION * model;
+}
+
+bool CurtainTravelCalibrator::relearn(OutlierRun &run, double &model, int &samples, double sample)
+{
+    // 偏向另一侧的离群样本重新开始计数
+    const int side = (sample > model) ? 1 : -1;
+    if (run.count * side <= 0) {
+        run = OutlierRun();
+    }
+    run.count += side;
+    run.sum += sample;
+
+    const int count = qAbs(run.count);
+    if (count < CURTAIN_CALIBRATION_RELEARN_OUTLIERS) {
+        return false;
+    }
+
+    model = run.sum / double(count);
+    samples = count;
+    run = OutlierRun();
+    return true;
+}
+
+QJsonObject CurtainTravelCalibrator::toJson() const
+{
+    QJsonObject json;
+    const char *names[] = { "close", "open" };
+    for (int i = 0; i < 2; ++i) {
+        QJsonObject model;
+        model["travelMs"] = m_models[i].travelNs / 1e6;
+        model["travelSteps"] = m_models[i].travelSteps;
+        model["samples"] = m_models[i].samples;
+        model["stepSamples"] = m_models[i].stepSamples;
+        json[names[i]] = model;
+    }
+    return json;
+}
+
+void CurtainTravelCalibrator::fromJson(const QJsonObject &json)
+{
+    const char *names[] = { "close", "open" };
+    for (int i = 0; i < 2; ++i) {
+        const QJsonObject model = json[names[i]].toObject();
+        if (model["samples"].toInt() <= 0 && model["stepSamples"].toInt() <= 0) {
+            continue; // 未学习过的方向保持默认值
+        }
+        m_models[i].travelNs = qMax(1.0, model["travelMs"].toDouble() * 1e6);
+        m_models[i].travelSteps = qMax(0.0, model["travelSteps"].toDouble());
+        m_models[i].samples = model["samples"].toInt();
+        m_models[i].stepSamples = model["stepSamples"].toInt();
+    }
+}
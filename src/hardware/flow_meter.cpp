@@ -0,0 +1,79 @@
+#include "hardware/flow_meter.h"
+#include "hardware/gpio_event_monitor.h"
+
+#include <QTimer>
+#include <QDebug>
+
+#include <cmath>
+
+FlowMeter::FlowMeter(int pin, const QSharedPointer<GpioPulseCounter> &counter,
+                     double pulsesPerLitre, QObject *parent)
+    : QObject(parent)
+    , m_pin(pin)
+    , m_counter(counter)
+    , m_pulsesPerLitre(pulsesPerLitre > 0.0 ? pulsesPerLitre : FLOW_METER_PULSES_PER_LITRE)
+    , m_timer(new QTimer(this))
+    , m_lastPulses(0)
+    , m_basePulses(0)
+    , m_litresPerMinute(0.0)
+{
+    m_lastPulses = pulseCount();
+    m_basePulses = m_lastPulses;
+    connect(m_timer, &QTimer::timeout, this, &FlowMeter::publish);
+}
+
+void FlowMeter::start(int publishIntervalMs)
+{
+    m_lastPulses = pulseCount();
+    m_sampleTimer.start();
+    m_timer->start(publishIntervalMs);
+    qDebug() << QString("流量计(GPIO%1)已启动，发布间隔%2ms").arg(m_pin).arg(publishIntervalMs);
+}
+
+void FlowMeter::stop()
+{
+    m_timer->stop();
+    m_litresPerMinute = 0.0;
+}
+
+void FlowMeter::setPublishInterval(int intervalMs)
+{
+    if (m_timer->isActive()) {
+        m_timer->start(intervalMs);
+    } else {
+        m_timer->setInterval(intervalMs);
+    }
+}
+
+quint64 FlowMeter::pulsesForLitres(double litres) const
+{
+    return static_cast<quint64>(std::ceil(litres * m_pulsesPerLitre));
+}
+
+quint64 FlowMeter::pulseCount() const
+{
+    return m_counter ? m_counter->pulses.loadAcquire() : 0;
+}
+
+double FlowMeter::totalLitres() const
+{
+    return double(pulseCount() - m_basePulses) / m_pulsesPerLitre;
+}
+
+void FlowMeter::resetTotal()
+{
+    m_basePulses = pulseCount();
+}
+
+void FlowMeter::publish()
+{
+    const quint64 pulses = pulseCount();
+    const qint64 elapsedMs = m_sampleTimer.restart();
+    if (elapsedMs > 0) {
+        const double litres = double(pulses - m_lastPulses) / m_pulsesPerLitre;
+        m_litresPerMinute = litres * 60000.0 / double(elapsedMs);
+    }
+    m_lastPulses = pulses;
+
+    emit flowUpdated(m_litresPerMinute, totalLitres());
+}
@@ -0,0 +1,542 @@
+#include "hardware/gpio_chardev.h"
+#include "hardware/gpio_line_io.h"
+#include "config/gpio_config.h"
+
+#include <QDebug>
+
+#include <errno.h>
+#include <string.h>
+
+GpioCharDev::GpioCharDev(GpioLineIo *io)
+    : m_io(io ? io : new KernelGpioLineIo)
+{
+}
+
+GpioCharDev::~GpioCharDev()
+{
+    releaseAll();
+    delete m_io;
+}
+
+void GpioCharDev::setLineIo(GpioLineIo *io)
+{
+    releaseAll();
+    delete m_io;
+    m_io = io ? io : new KernelGpioLineIo;
+}
+
+bool GpioCharDev::isAvailable()
+{
+    int fd = m_io->openChip(0);
+    if (fd < 0) {
+        setError(QString("无法打开%10: %2").arg(GPIO_CHIP_DEV_PREFIX).arg(strerror(errno)));
+        return false;
+    }
+    m_io->closeFd(fd);
+    return true;
+}
+
+int GpioCharDev::chipOf(int pin)
+{
+    return pin / GPIO_LINES_PER_CHIP;
+}
+
+int GpioCharDev::offsetOf(int pin)
+{
+    return pin % GPIO_LINES_PER_CHIP;
+}
+
+bool GpioCharDev::claimLine(int pin, bool output, bool level)
+{
+    QMap<int, bool> outputs;
+    QVector<int> inputs;
+    if (output) {
+        outputs.insert(pin, level);
+    } else {
+        inputs.append(pin);
+    }
+    return claimLines(outputs, inputs).isEmpty();
+}
+
+QVector<int> GpioCharDev::claimLines(const QMap<int, bool> &outputs, const QVector<int> &inputs)
+{
+    QMap<int, QVector<int> > addedPins;   // chip -> 新增线路对应的引脚
+    QMap<int, bool> rebuildChips;         // 需要更新请求的芯片（有新增线路时重新申请，否则原请求内改方向）
+    QMap<int, bool> levelOnly;            // 已占用且方向不变的输出，只需设置电平
+    QMap<int, ChipLines> previous;        // chip -> 修改前的线路集合，失败时恢复
+
+    auto stage = [&](int pin, bool output, bool level) {
+        const int chip = chipOf(pin);
+        const int offset = offsetOf(pin);
+        const quint64 bit = quint64(1) << offset;
+
+        ChipLines &lines = m_chips[chip];
+        const bool known = lines.offsets.contains(offset);
+        if (known && bool(lines.outputLines & bit) == output) {
+            if (output) {
+                levelOnly.insert(pin, level);
+            }
+            return;
+        }
+
+        if (!previous.contains(chip)) {
+            previous.insert(chip, lines);
+        }
+
+        if (!known) {
+            lines.offsets.append(offset);
+            addedPins[chip].append(pin);
+        }
+        if (output) {
+            lines.outputLines |= bit;
+        } else {
+            lines.outputLines &= ~bit;
+        }
+        if (level) {
+            lines.levels |= bit;
+        } else {
+            lines.levels &= ~bit;
+        }
+        rebuildChips.insert(chip, true);
+    };
+
+    for (auto it = outputs.constBegin(); it != outputs.constEnd(); ++it) {
+        stage(it.key(), true, it.value());
+    }
+    for (int pin : inputs) {
+        stage(pin, false, false);
+    }
+
+    QVector<int> failed;
+
+    // 方向不变的输出在重新申请时一并带上新电平，否则单独设置
+    for (auto it = levelOnly.begin(); it != levelOnly.end(); ) {
+        const int chip = chipOf(it.key());
+        if (rebuildChips.contains(chip)) {
+            const quint64 bit = quint64(1) << offsetOf(it.key());
+            ChipLines &lines = m_chips[chip];
+            lines.levels = it.value() ? (lines.levels | bit) : (lines.levels & ~bit);
+            it = levelOnly.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!levelOnly.isEmpty()) {
+        setLevels(levelOnly, &failed);
+    }
+
+    for (auto it = rebuildChips.constBegin(); it != rebuildChips.constEnd(); ++it) {
+        const int chip = it.key();
+        // 线路集合不变时在原请求内修改方向，其余线路不会有释放窗口
+        const bool inPlace = !addedPins.contains(chip) && m_chips[chip].requestFd >= 0;
+        if (inPlace ? reconfigureRequest(chip) : rebuildRequest(chip)) {
+            continue;
+        }
+
+        // 失败时回退到原有线路集合与方向（SET_CONFIG失败时原请求不变，无需重新申请）
+        const QVector<int> added = addedPins.value(chip);
+        ChipLines &lines = m_chips[chip];
+        const int chipFd = lines.chipFd;
+        const int requestFd = lines.requestFd;
+        lines = previous.value(chip);
+        lines.chipFd = chipFd;
+        lines.requestFd = requestFd;
+        for (int pin : outputs.keys()) {
+            if (chipOf(pin) == chip && !added.contains(pin)) {
+                failed.append(pin);
+            }
+        }
+        for (int pin : inputs) {
+            if (chipOf(pin) == chip && !added.contains(pin)) {
+                failed.append(pin);
+            }
+        }
+        failed += added;
+        if (!inPlace && !lines.offsets.isEmpty()) {
+            rebuildRequest(chip);
+        }
+    }
+
+    return failed;
+}
+
+bool GpioCharDev::releaseLine(int pin)
+{
+    if (m_edgeLines.contains(pin)) {
+        releaseEdgeLine(pin);
+        return true;
+    }
+
+    const int chip = chipOf(pin);
+    auto it = m_chips.find(chip);
+    if (it == m_chips.end()) {
+        return true;
+    }
+
+    const int offset = offsetOf(pin);
+    ChipLines &lines = it.value();
+    if (!lines.offsets.contains(offset)) {
+        return true;
+    }
+
+    lines.offsets.removeAll(offset);
+    lines.outputLines &= ~(quint64(1) << offset);
+
+    if (lines.offsets.isEmpty()) {
+        closeChip(lines);
+        m_chips.erase(it);
+        return true;
+    }
+
+    return rebuildRequest(chip);
+}
+
+void GpioCharDev::releaseAll()
+{
+    for (auto it = m_chips.begin(); it != m_chips.end(); ++it) {
+        closeChip(it.value());
+    }
+    m_chips.clear();
+
+    for (auto it = m_edgeLines.begin(); it != m_edgeLines.end(); ++it) {
+        m_io->closeFd(it.value().requestFd);
+        m_io->closeFd(it.value().chipFd);
+    }
+    m_edgeLines.clear();
+}
+
+int GpioCharDev::requestEdgeLine(int pin, bool rising, bool falling, bool pullUp, int debounceUs,
+                                 bool *kernelDebounce, int eventBufferSize)
+{
+    // 边沿线路不能留在芯片的共享请求中，否则事件会混入其它线路的请求fd
+    releaseEdgeLine(pin);
+    releaseLine(pin);
+
+    EdgeLine line;
+    line.chipFd = m_io->openChip(chipOf(pin));
+    if (line.chipFd < 0) {
+        setError(QString("无法打开%1%2: %3").arg(GPIO_CHIP_DEV_PREFIX).arg(chipOf(pin)).arg(strerror(errno)));
+        return -1;
+    }
+
+    struct gpio_v2_line_request request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.consumer, GPIO_CHARDEV_CONSUMER, sizeof(request.consumer) - 1);
+    request.num_lines = 1;
+    request.offsets[0] = offsetOf(pin);
+    request.event_buffer_size = static_cast<quint32>(eventBufferSize); // 高频脉冲需要更大的内核事件缓冲
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    if (rising) {
+        request.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+    }
+    if (falling) {
+        request.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    }
+    if (pullUp) {
+        request.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+    }
+    if (debounceUs > 0) {
+        struct gpio_v2_line_config_attribute &attr = request.config.attrs[request.config.num_attrs++];
+        attr.attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+        attr.attr.debounce_period_us = static_cast<quint32>(debounceUs);
+        attr.mask = 1;
+    }
+
+    bool debounced = debounceUs > 0;
+    int result = m_io->requestLines(line.chipFd, &request);
+    if (result < 0 && debounceUs > 0) {
+        // 部分GPIO控制器不支持硬件去抖，退回到无去抖请求，由调用方做软件过滤
+        request.config.num_attrs = 0;
+        debounced = false;
+        result = m_io->requestLines(line.chipFd, &request);
+    }
+    if (result < 0) {
+        setError(QString("GPIO引脚%1边沿检测申请失败: %2").arg(pin).arg(strerror(errno)));
+        m_io->closeFd(line.chipFd);
+        return -1;
+    }
+
+    if (kernelDebounce) {
+        *kernelDebounce = debounced;
+    }
+
+    line.requestFd = request.fd;
+    m_edgeLines.insert(pin, line);
+    return line.requestFd;
+}
+
+void GpioCharDev::releaseEdgeLine(int pin)
+{
+    auto it = m_edgeLines.find(pin);
+    if (it == m_edgeLines.end()) {
+        return;
+    }
+
+    m_io->closeFd(it.value().requestFd);
+    m_io->closeFd(it.value().chipFd);
+    m_edgeLines.erase(it);
+}
+
+bool GpioCharDev::isEdgeLine(int pin) const
+{
+    return m_edgeLines.contains(pin);
+}
+
+bool GpioCharDev::setLevels(const QMap<int, bool> &levels, QVector<int> *failedPins)
+{
+    // 按芯片分组，请求内索引对应的bits/mask
+    QMap<int, struct gpio_v2_line_values> perChip;
+    bool success = true;
+
+    for (auto it = levels.constBegin(); it != levels.constEnd(); ++it) {
+        const int chip = chipOf(it.key());
+        const int offset = offsetOf(it.key());
+        auto chipIt = m_chips.constFind(chip);
+        if (chipIt == m_chips.constEnd() || chipIt.value().requestFd < 0
+                || !(chipIt.value().outputLines & (quint64(1) << offset))) {
+            setError(QString("GPIO引脚%1未作为输出申请").arg(it.key()));
+            if (failedPins) {
+                failedPins->append(it.key());
+            }
+            success = false;
+            continue;
+        }
+
+        const int index = chipIt.value().offsets.indexOf(offset);
+        struct gpio_v2_line_values &values = perChip[chip];
+        values.mask |= quint64(1) << index;
+        if (it.value()) {
+            values.bits |= quint64(1) << index;
+        }
+    }
+
+    for (auto it = perChip.begin(); it != perChip.end(); ++it) {
+        ChipLines &lines = m_chips[it.key()];
+        if (m_io->setValues(lines.requestFd, &it.value()) < 0) {
+            setError(QString("gpiochip%1电平设置失败: %2").arg(it.key()).arg(strerror(errno)));
+            if (failedPins) {
+                for (auto levelIt = levels.constBegin(); levelIt != levels.constEnd(); ++levelIt) {
+                    if (chipOf(levelIt.key()) == it.key()) {
+                        failedPins->append(levelIt.key());
+                    }
+                }
+            }
+            success = false;
+            continue;
+        }
+
+        // 同步电平缓存
+        for (int index = 0; index < lines.offsets.size(); ++index) {
+            const quint64 indexBit = quint64(1) << index;
+            if (!(it.value().mask & indexBit)) {
+                continue;
+            }
+            const quint64 lineBit = quint64(1) << lines.offsets.at(index);
+            if (it.value().bits & indexBit) {
+                lines.levels |= lineBit;
+            } else {
+                lines.levels &= ~lineBit;
+            }
+        }
+    }
+
+    return success;
+}
+
+bool GpioCharDev::getLevel(int pin, bool &level)
+{
+    auto edgeIt = m_edgeLines.constFind(pin);
+    if (edgeIt != m_edgeLines.constEnd()) {
+        struct gpio_v2_line_values values;
+        memset(&values, 0, sizeof(values));
+        values.mask = 1;
+        if (m_io->getValues(edgeIt.value().requestFd, &values) < 0) {
+            setError(QString("GPIO引脚%1电平读取失败: %2").arg(pin).arg(strerror(errno)));
+            return false;
+        }
+        level = values.bits & 1;
+        return true;
+    }
+
+    auto it = m_chips.find(chipOf(pin));
+    if (it == m_chips.end() || it.value().requestFd < 0) {
+        setError(QString("GPIO引脚%1未申请").arg(pin));
+        return false;
+    }
+
+    const int index = it.value().offsets.indexOf(offsetOf(pin));
+    if (index < 0) {
+        setError(QString("GPIO引脚%1未申请").arg(pin));
+        return false;
+    }
+
+    struct gpio_v2_line_values values;
+    memset(&values, 0, sizeof(values));
+    values.mask = quint64(1) << index;
+    if (m_io->getValues(it.value().requestFd, &values) < 0) {
+        setError(QString("GPIO引脚%1电平读取失败: %2").arg(pin).arg(strerror(errno)));
+        return false;
+    }
+
+    level = values.bits & values.mask;
+    return true;
+}
+
+bool GpioCharDev::getLevels(const QList<int> &pins, QMap<int, bool> &levels)
+{
+    QMap<int, struct gpio_v2_line_values> perChip;
+    bool success = true;
+
+    for (int pin : pins) {
+        auto chipIt = m_chips.constFind(chipOf(pin));
+        const int index = (chipIt == m_chips.constEnd()) ? -1 : chipIt.value().offsets.indexOf(offsetOf(pin));
+        if (index < 0 || chipIt.value().requestFd < 0) {
+            setError(QString("GPIO引脚%1未申请").arg(pin));
+            success = false;
+            continue;
+        }
+        perChip[chipOf(pin)].mask |= quint64(1) << index;
+    }
+
+    for (auto it = perChip.begin(); it != perChip.end(); ++it) {
+        const ChipLines &lines = m_chips[it.key()];
+        if (m_io->getValues(lines.requestFd, &it.value()) < 0) {
+            setError(QString("gpiochip%1电平读取失败: %2").arg(it.key()).arg(strerror(errno)));
+            success = false;
+            continue;
+        }
+
+        for (int index = 0; index < lines.offsets.size(); ++index) {
+            const quint64 indexBit = quint64(1) << index;
+            if (it.value().mask & indexBit) {
+                const int pin = it.key() * GPIO_LINES_PER_CHIP + lines.offsets.at(index);
+                levels.insert(pin, it.value().bits & indexBit);
+            }
+        }
+    }
+
+    return success;
+}
+
+bool GpioCharDev::isClaimed(int pin) const
+{
+    if (m_edgeLines.contains(pin)) {
+        return true;
+    }
+
+    auto it = m_chips.constFind(chipOf(pin));
+    return it != m_chips.constEnd() && it.value().offsets.contains(offsetOf(pin));
+}
+
+bool GpioCharDev::isOutput(int pin) const
+{
+    auto it = m_chips.constFind(chipOf(pin));
+    return it != m_chips.constEnd() && (it.value().outputLines & (quint64(1) << offsetOf(pin)));
+}
+
+void GpioCharDev::buildConfig(const ChipLines &lines, struct gpio_v2_line_config *config)
+{
+    memset(config, 0, sizeof(*config));
+
+    quint64 inputMask = 0;
+    quint64 outputMask = 0;
+    quint64 outputValues = 0;
+    for (int index = 0; index < lines.offsets.size(); ++index) {
+        const quint64 lineBit = quint64(1) << lines.offsets.at(index);
+        const quint64 indexBit = quint64(1) << index;
+        if (lines.outputLines & lineBit) {
+            outputMask |= indexBit;
+            if (lines.levels & lineBit) {
+                outputValues |= indexBit;
+            }
+        } else {
+            inputMask |= indexBit;
+        }
+    }
+
+    // 默认全部为输出，输入线路通过按掩码的FLAGS属性覆盖
+    config->flags = outputMask ? GPIO_V2_LINE_FLAG_OUTPUT : GPIO_V2_LINE_FLAG_INPUT;
+    if (outputMask && inputMask) {
+        struct gpio_v2_line_config_attribute &attr = config->attrs[config->num_attrs++];
+        attr.attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attr.attr.flags = GPIO_V2_LINE_FLAG_INPUT;
+        attr.mask = inputMask;
+    }
+    if (outputMask) {
+        // 输出默认值取自电平缓存，重新申请或改方向时输出保持不变
+        struct gpio_v2_line_config_attribute &attr = config->attrs[config->num_attrs++];
+        attr.attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        attr.attr.values = outputValues;
+        attr.mask = outputMask;
+    }
+}
+
+bool GpioCharDev::reconfigureRequest(int chip)
+{
+    ChipLines &lines = m_chips[chip];
+
+    struct gpio_v2_line_config config;
+    buildConfig(lines, &config);
+    if (m_io->setConfig(lines.requestFd, &config) < 0) {
+        setError(QString("gpiochip%1线路配置失败: %2").arg(chip).arg(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+bool GpioCharDev::rebuildRequest(int chip)
+{
+    ChipLines &lines = m_chips[chip];
+
+    if (lines.chipFd < 0) {
+        lines.chipFd = m_io->openChip(chip);
+        if (lines.chipFd < 0) {
+            setError(QString("无法打开%1%2: %3").arg(GPIO_CHIP_DEV_PREFIX).arg(chip).arg(strerror(errno)));
+            return false;
+        }
+    }
+
+    struct gpio_v2_line_request request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.consumer, GPIO_CHARDEV_CONSUMER, sizeof(request.consumer) - 1);
+    request.num_lines = lines.offsets.size();
+    for (int index = 0; index < lines.offsets.size(); ++index) {
+        request.offsets[index] = lines.offsets.at(index);
+    }
+    buildConfig(lines, &request.config);
+
+    // 同一线路不能被两个请求同时占用，必须先释放旧请求：从关闭到重新申请之间，该芯片上本进程的
+    // 全部线路（保温帘使能、水泵等）暂不归本进程所有，其他进程可在此窗口内抢占；控制器释放线路时
+    // 一般保持原方向与电平，重新申请时按电平缓存恢复输出。线路集合不变的方向修改走reconfigureRequest()，
+    // 只有新增或释放线路才经过此窗口，应在启动时以一次事务申请全部线路
+    if (lines.requestFd >= 0) {
+        m_io->closeFd(lines.requestFd);
+        lines.requestFd = -1;
+    }
+
+    if (m_io->requestLines(lines.chipFd, &request) < 0) {
+        setError(QString("gpiochip%1线路申请失败: %2").arg(chip).arg(strerror(errno)));
+        return false;
+    }
+
+    lines.requestFd = request.fd;
+    return true;
+}
+
+void GpioCharDev::closeChip(ChipLines &lines)
+{
+    if (lines.requestFd >= 0) {
+        m_io->closeFd(lines.requestFd);
+        lines.requestFd = -1;
+    }
+    if (lines.chipFd >= 0) {
+        m_io->closeFd(lines.chipFd);
+        lines.chipFd = -1;
+    }
+}
+
+void GpioCharDev::setError(const QString &error)
+{
+    m_lastError = error;
+    qWarning() << error;
+}
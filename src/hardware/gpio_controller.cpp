@@ -1,57 +1,296 @@
 #include "hardware/gpio_controller.h"
+#include "hardware/gpio_chardev.h"
+#include "hardware/gpio_event_monitor.h"
+#include "hardware/flow_meter.h"
+#include "hardware/sysfs_io.h"
+#include "hardware/gpio_mmio.h"
+#include "hardware/power_budget_scheduler.h"
 #include "config/gpio_config.h"
 
-#include <QFile>
-#include <QTextStream>
 #include <QDebug>
-#include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+// 预格式化的电平字节，setPin直接pwrite，不再经过QString/QTextStream
+static const char GPIO_LEVEL_CHARS[2] = { '0', '1' };
+
+/**
+ * @brief 影子寄存器后台校验线程
+ *
+ * 按固定间隔调用GPIOController::verifyShadow()，回读在本线程完成，不占用GUI线程
+ */
+class ShadowVerifyThread : public QThread
+{
+public:
+    ShadowVerifyThread(GPIOController *controller, int intervalMs)
+        : m_controller(controller)
+        , m_intervalMs(intervalMs)
+        , m_stopping(false)
+    {
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_condition.wakeAll();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stopping) {
+            m_condition.wait(&m_mutex, m_intervalMs);
+            if (m_stopping) {
+                break;
+            }
+            locker.unlock();
+            m_controller->verifyShadow();
+            locker.relock();
+        }
+    }
+
+private:
+    GPIOController *m_controller;
+    int m_intervalMs;
+    bool m_stopping;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+};
 
 GPIOController::GPIOController(QObject *parent)
     : QObject(parent)
     , m_initialized(false)
+    , m_backend(GPIO_DEFAULT_BACKEND == GPIO_BACKEND_CHARDEV ? CharDevBackend : SysfsBackend)
+    , m_charDev(new GpioCharDev)
+    , m_sysfs(SysfsIo::defaultIo())
+    , m_mmio(new GpioMmio)
+    , m_fdCacheEnabled(true)
+    , m_verifyThread(nullptr)
+    , m_eventMonitor(new GpioEventMonitor(this))
+    , m_pumpFlowMeter(nullptr)
+    , m_fertilizerFlowMeter(nullptr)
+    , m_powerScheduler(nullptr)
 {
+    // 直连转发，inputEdge在监视线程中发出，消费者自行选择连接方式
+    connect(m_eventMonitor, &GpioEventMonitor::edgeDetected,
+            this, &GPIOController::inputEdge, Qt::DirectConnection);
+    // 定量运行在监视线程中直接关泵，不等待GUI事件循环
+    connect(m_eventMonitor, &GpioEventMonitor::pulseTargetReached,
+            this, &GPIOController::onPulseTargetReached, Qt::DirectConnection);
+
+    static const int fastPins[] = GPIO_FAST_PINS;
+    for (int pin : fastPins) {
+        if (GpioMmio::isValidPin(pin)) {
+            m_fastPins.insert(pin, true);
+        }
+    }
 }
 
 GPIOController::~GPIOController()
 {
+    setShadowVerification(false);
+    m_eventMonitor->stop(); // 先停止监视线程，再关闭其等待的fd
     cleanup();
+    delete m_charDev;
+    delete m_mmio;
+}
+
+bool GPIOController::setBackend(Backend backend)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (backend == m_backend) {
+        return true;
+    }
+
+    if (backend == CharDevBackend && !m_charDev->isAvailable()) {
+        emit errorOccurred("GPIO字符设备不可用，保持当前后端");
+        return false;
+    }
+
+    if (!m_initialized) {
+        m_backend = backend;
+        return true;
+    }
+
+    // 记录已导出引脚的方向和输出电平，切换后按原状态重新申请
+    QMap<int, QString> directions;
+    for (auto it = m_exportedPins.constBegin(); it != m_exportedPins.constEnd(); ++it) {
+        if (!it.value()) {
+            continue;
+        }
+        QString direction = m_pinDirections.value(it.key());
+        if (direction == "out") {
+            direction = getPin(it.key()) ? "high" : "low";
+        }
+        directions.insert(it.key(), direction);
+    }
+
+    const QMap<int, QPair<Edge, int> > inputEdges = m_inputEdges;
+    const QMap<int, QSharedPointer<GpioPulseCounter> > pulseCounters = m_pulseCounters; // 计数在迁移后延续
+
+    for (auto it = directions.constBegin(); it != directions.constEnd(); ++it) {
+        unexportPin(it.key());
+    }
+
+    m_backend = backend;
+
+    bool success = true;
+    for (auto it = directions.constBegin(); it != directions.constEnd(); ++it) {
+        success &= exportPin(it.key());
+        if (inputEdges.contains(it.key())) {
+            const QPair<Edge, int> &config = inputEdges[it.key()];
+            success &= setupInput(it.key(), config.first, config.second, pulseCounters.value(it.key()));
+        } else if (!it.value().isEmpty()) {
+            success &= setDirection(it.key(), it.value());
+        }
+    }
+
+    qDebug() << QString("GPIO后端已切换为%1").arg(backend == CharDevBackend ? "字符设备" : "sysfs");
+    return success;
+}
+
+void GPIOController::setCharDevLineIo(GpioLineIo *io)
+{
+    QMutexLocker locker(&m_mutex);
+    m_charDev->setLineIo(io);
+}
+
+bool GPIOController::setSysfsIo(SysfsIo *io)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 已缓存的fd属于旧实现，运行中切换会使其失效
+    if (m_initialized) {
+        emit errorOccurred("GPIO已初始化，无法切换sysfs访问实现");
+        return false;
+    }
+
+    m_sysfs = io ? io : SysfsIo::defaultIo();
+    qDebug() << "GPIO sysfs访问实现:" << m_sysfs->name();
+    return true;
+}
+
+bool GPIOController::setAttributeFdCache(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_initialized) {
+        emit errorOccurred("GPIO已初始化，无法切换属性文件缓存");
+        return false;
+    }
+
+    m_fdCacheEnabled = enabled;
+    return true;
+}
+
+bool GPIOController::setMmioSource(const QString &source)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_initialized) {
+        emit errorOccurred("GPIO已初始化，无法切换寄存器映射源");
+        return false;
+    }
+
+    delete m_mmio;
+    m_mmio = new GpioMmio(source);
+    return true;
+}
+
+bool GPIOController::setFastPins(const QList<int> &pins)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 初始化时按快速引脚是否为空决定是否映射寄存器
+    if (m_initialized) {
+        emit errorOccurred("GPIO已初始化，无法修改快速引脚");
+        return false;
+    }
+
+    m_fastPins.clear();
+    for (int pin : pins) {
+        if (GpioMmio::isValidPin(pin)) {
+            m_fastPins.insert(pin, true);
+        }
+    }
+    return true;
+}
+
+GpioMmio *GPIOController::fastIo() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mmio->isOpen() ? m_mmio : nullptr;
 }
 
 bool GPIOController::initialize()
 {
+    QMutexLocker locker(&m_mutex);
+
     if (m_initialized) {
         return true;
     }
 
+    // 字符设备不可用时回退到sysfs接口
+    if (m_backend == CharDevBackend && !m_charDev->isAvailable()) {
+        qWarning() << "GPIO字符设备不可用，回退到sysfs接口";
+        m_backend = SysfsBackend;
+    }
+
     // 检查GPIO系统是否可用
-    QDir gpioDir(GPIO_BASE_PATH);
-    if (!gpioDir.exists()) {
+    if (m_backend == SysfsBackend && !m_sysfs->exists(GPIO_BASE_PATH)) {
         emit errorOccurred("GPIO系统不可用");
         return false;
     }
 
     m_initialized = true;
 
-    // 初始化GPIO3_B6为常高电平（3.3V电源输出）
-    if (!initializePowerSupplyPin()) {
-        qWarning() << "GPIO3_B6电源引脚初始化失败";
+    // 快速引脚的寄存器映射，失败时这些引脚退回当前后端
+    if (!m_fastPins.isEmpty() && !m_mmio->open()) {
+        qWarning() << "GPIO寄存器映射失败，快速引脚使用常规后端:" << m_mmio->lastError();
     }
 
-    // 初始化GPIO3_A7水泵控制引脚
-    if (!initializePumpControlPin()) {
-        qWarning() << "GPIO3_A7水泵控制引脚初始化失败";
-    }
+    // 电源、水泵、施药泵引脚一次批量初始化
+    Transaction transaction = beginTransaction();
+    // GPIO3_B6为常高电平（3.3V电源输出）
+    transaction.exportPin(POWER_SUPPLY_PIN).setDirection(POWER_SUPPLY_PIN, "out").setPin(POWER_SUPPLY_PIN, GPIO_HIGH);
+    // GPIO3_A7水泵控制引脚，初始关闭
+    transaction.exportPin(PUMP_CONTROL_PIN).setDirection(PUMP_CONTROL_PIN, "out").setPin(PUMP_CONTROL_PIN, GPIO_LOW);
+    // GPIO3_A1施药泵控制引脚，初始关闭
+    transaction.exportPin(FERTILIZER_PUMP_PIN).setDirection(FERTILIZER_PUMP_PIN, "out").setPin(FERTILIZER_PUMP_PIN, GPIO_LOW);
 
-    // 初始化GPIO3_A1施药泵控制引脚
-    if (!initializeFertilizerPumpPin()) {
-        qWarning() << "GPIO3_A1施药泵控制引脚初始化失败";
+    TransactionResult result = transaction.commit();
+    if (result.failures.contains(POWER_SUPPLY_PIN)) {
+        qWarning() << "GPIO3_B6电源引脚初始化失败:" << result.failures.value(POWER_SUPPLY_PIN);
+    }
+    if (result.failures.contains(PUMP_CONTROL_PIN)) {
+        qWarning() << "GPIO3_A7水泵控制引脚初始化失败:" << result.failures.value(PUMP_CONTROL_PIN);
     }
+    if (result.failures.contains(FERTILIZER_PUMP_PIN)) {
+        qWarning() << "GPIO3_A1施药泵控制引脚初始化失败:" << result.failures.value(FERTILIZER_PUMP_PIN);
+    }
+
+    qDebug() << QString("GPIO输出引脚初始化完成，耗时%1us，%2个引脚已就绪跳过").arg(result.elapsedUs).arg(result.unchangedCount);
 
+    // 流量计（已安装时）
+    m_pumpFlowMeter = createFlowMeter(PUMP_FLOW_METER_PIN);
+    m_fertilizerFlowMeter = createFlowMeter(FERTILIZER_FLOW_METER_PIN);
     return true;
 }
 
 void GPIOController::cleanup()
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!m_initialized) {
         return;
     }
@@ -63,28 +302,54 @@ void GPIOController::cleanup()
         }
     }
 
+    // 关闭剩余的属性文件描述符和字符设备线路
+    const QList<int> openPins = m_pinFiles.keys();
+    for (int pin : openPins) {
+        closePinFiles(pin);
+    }
+    m_charDev->releaseAll();
+    m_mmio->close();
+
+    delete m_pumpFlowMeter;
+    m_pumpFlowMeter = nullptr;
+    delete m_fertilizerFlowMeter;
+    m_fertilizerFlowMeter = nullptr;
+
     m_exportedPins.clear();
+    m_pinDirections.clear();
+    m_outputShadow.clear();
     m_initialized = false;
 }
 
 bool GPIOController::exportPin(int pin)
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!m_initialized) {
         emit errorOccurred("GPIO控制器未初始化");
         return false;
     }
 
+    // 字符设备后端在设置方向时申请线路，这里只需释放sysfs占用
+    if (m_backend == CharDevBackend) {
+        releaseSysfsExport(pin);
+        m_exportedPins[pin] = true;
+        return true;
+    }
+
     // 检查引脚是否已经导出
     QString pinPath = QString("%1/gpio%2").arg(GPIO_BASE_PATH).arg(pin);
-    QDir pinDir(pinPath);
-    if (pinDir.exists()) {
+    if (m_sysfs->exists(pinPath)) {
         m_exportedPins[pin] = true;
+        openPinFiles(pin);
         return true;
     }
 
     // 导出引脚
     if (writeToFile(GPIO_EXPORT_PATH, QString::number(pin))) {
         m_exportedPins[pin] = true;
+        // udev可能尚未完成属性文件权限设置，打开失败时在首次读写时重试，仍失败则逐次打开写入
+        openPinFiles(pin);
         return true;
     } else {
         emit errorOccurred(QString("GPIO引脚%1导出失败").arg(pin));
@@ -94,10 +359,26 @@ bool GPIOController::exportPin(int pin)
 
 bool GPIOController::unexportPin(int pin)
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!m_initialized || !m_exportedPins.value(pin, false)) {
         return true;
     }
 
+    m_pinDirections.remove(pin);
+    m_outputShadow.remove(pin);
+    m_inputEdges.remove(pin);
+    m_eventMonitor->removeSource(pin);
+    m_pulseCounters.remove(pin);
+    m_volumeRuns.remove(pin);
+
+    if (m_backend == CharDevBackend) {
+        m_exportedPins[pin] = false;
+        return m_charDev->releaseLine(pin);
+    }
+
+    closePinFiles(pin);
+
     if (writeToFile(GPIO_UNEXPORT_PATH, QString::number(pin))) {
         m_exportedPins[pin] = false;
         return true;
@@ -109,13 +390,39 @@ bool GPIOController::unexportPin(int pin)
 
 bool GPIOController::setDirection(int pin, const QString &direction)
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!isPinExported(pin)) {
         emit errorOccurred(QString("GPIO引脚%1未导出").arg(pin));
         return false;
     }
 
-    QString directionPath = getPinPath(pin, "direction");
-    if (writeToFile(directionPath, direction)) {
+    m_pinDirections[pin] = direction;
+
+    // 重新设置方向即取消边沿检测
+    if (m_inputEdges.remove(pin)) {
+        m_eventMonitor->removeSource(pin);
+        m_pulseCounters.remove(pin);
+        if (m_backend == CharDevBackend) {
+            m_charDev->releaseEdgeLine(pin);
+        }
+    }
+
+    bool written = false;
+    int fd = -1;
+    if (m_backend == CharDevBackend) {
+        // "high"/"low"与sysfs语义一致：设为输出并指定初始电平
+        written = m_charDev->claimLine(pin, direction != "in", direction == "high");
+    } else if ((fd = pinFd(pin, true)) >= 0) {
+        const QByteArray bytes = direction.toLatin1();
+        written = writeAttribute(pin, fd, bytes.constData(), bytes.size());
+    } else {
+        written = writeToFile(getPinPath(pin, "direction"), direction);
+    }
+
+    if (written) {
+        updateShadow(pin, direction);
+        syncFastPin(pin);
         return true;
     } else {
         emit errorOccurred(QString("GPIO引脚%1方向设置失败").arg(pin));
@@ -125,15 +432,34 @@ bool GPIOController::setDirection(int pin, const QString &direction)
 
 bool GPIOController::setPin(int pin, bool value)
 {
+    QMutexLocker locker(&m_mutex);
+
     if (!isPinExported(pin)) {
         emit errorOccurred(QString("GPIO引脚%1未导出").arg(pin));
         return false;
     }
 
-    QString valuePath = getPinPath(pin, "value");
-    QString valueStr = value ? "1" : "0";
+    // 快速引脚：方向已由后端设为输出，电平一次寄存器存储
+    if (m_fastPins.contains(pin) && m_mmio->isOpen() && m_outputShadow.contains(pin)) {
+        m_mmio->write(pin, value);
+        m_outputShadow[pin] = value;
+        return true;
+    }
+
+    bool written = false;
+    int fd = -1;
+    if (m_backend == CharDevBackend) {
+        QMap<int, bool> levels;
+        levels.insert(pin, value);
+        written = m_charDev->setLevels(levels);
+    } else if ((fd = pinFd(pin, false)) >= 0) {
+        written = writeAttribute(pin, fd, &GPIO_LEVEL_CHARS[value ? 1 : 0], 1);
+    } else {
+        written = writeToFile(getPinPath(pin, "value"), value ? "1" : "0");
+    }
 
-    if (writeToFile(valuePath, valueStr)) {
+    if (written) {
+        m_outputShadow[pin] = value;
         return true;
     } else {
         emit errorOccurred(QString("GPIO引脚%1电平设置失败").arg(pin));
@@ -143,30 +469,428 @@ bool GPIOController::setPin(int pin, bool value)
 
 bool GPIOController::getPin(int pin)
 {
+    QMutexLocker locker(&m_mutex);
+
+    // 输出引脚只由本进程写入，直接返回影子寄存器
+    auto it = m_outputShadow.constFind(pin);
+    if (it != m_outputShadow.constEnd()) {
+        return it.value();
+    }
+
+    return readHardwarePin(pin);
+}
+
+bool GPIOController::readHardwarePin(int pin)
+{
+    QMutexLocker locker(&m_mutex);
+
     if (!isPinExported(pin)) {
         return false;
     }
 
-    QString valuePath = getPinPath(pin, "value");
-    QString value = readFromFile(valuePath);
+    if (m_backend == CharDevBackend) {
+        bool level = false;
+        return m_charDev->getLevel(pin, level) && level;
+    }
+
+    int fd = pinFd(pin, false);
+    if (fd >= 0) {
+        // sysfs属性在偏移0处读取会重新采样引脚电平
+        char buffer[4];
+        int n = m_sysfs->read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            return buffer[0] == '1';
+        }
+        qWarning() << QString("读取GPIO引脚%1电平失败: %2").arg(pin).arg(strerror(errno));
+        return false;
+    }
+
+    QString value = readFromFile(getPinPath(pin, "value"));
     return value.trimmed() == "1";
 }
 
+bool GPIOController::setPins(const QMap<int, bool> &levels)
+{
+    Transaction transaction = beginTransaction();
+    for (auto it = levels.constBegin(); it != levels.constEnd(); ++it) {
+        transaction.setPin(it.key(), it.value());
+    }
+    return transaction.commit().success;
+}
+
+bool GPIOController::configureInput(int pin, Edge edge, int debounceUs)
+{
+    return setupInput(pin, edge, debounceUs, QSharedPointer<GpioPulseCounter>());
+}
+
+bool GPIOController::configurePulseCounter(int pin, Edge edge, int debounceUs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (edge == NoEdge) {
+        emit errorOccurred(QString("GPIO引脚%1脉冲计数必须指定边沿").arg(pin));
+        return false;
+    }
+
+    // 重新配置时保留已有计数
+    QSharedPointer<GpioPulseCounter> counter = m_pulseCounters.value(pin);
+    if (!counter) {
+        counter = QSharedPointer<GpioPulseCounter>::create();
+    }
+    return setupInput(pin, edge, debounceUs, counter);
+}
+
+QSharedPointer<GpioPulseCounter> GPIOController::pulseCounter(int pin) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pulseCounters.value(pin);
+}
+
+quint64 GPIOController::pulseCount(int pin) const
+{
+    QSharedPointer<GpioPulseCounter> counter = pulseCounter(pin);
+    return counter ? counter->pulses.loadAcquire() : 0;
+}
+
+bool GPIOController::setupInput(int pin, Edge edge, int debounceUs, const QSharedPointer<GpioPulseCounter> &counter)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!isPinExported(pin)) {
+        emit errorOccurred(QString("GPIO引脚%1未导出").arg(pin));
+        return false;
+    }
+
+    m_eventMonitor->removeSource(pin);
+    m_pinDirections[pin] = "in";
+    m_outputShadow.remove(pin);
+    if (counter) {
+        m_pulseCounters.insert(pin, counter);
+    } else {
+        m_pulseCounters.remove(pin);
+    }
+
+    if (edge == NoEdge) {
+        m_inputEdges.remove(pin);
+        bool written;
+        if (m_backend == CharDevBackend) {
+            m_charDev->releaseEdgeLine(pin);
+            written = m_charDev->claimLine(pin, false, false);
+        } else {
+            written = writeToFile(getPinPath(pin, "direction"), "in")
+                    && writeToFile(getPinPath(pin, "edge"), "none");
+        }
+        if (!written) {
+            emit errorOccurred(QString("GPIO引脚%1输入设置失败").arg(pin));
+        }
+        return written;
+    }
+
+    m_inputEdges.insert(pin, qMakePair(edge, debounceUs));
+
+    if (!m_eventMonitor->isRunning() && !m_eventMonitor->start()) {
+        emit errorOccurred("GPIO边沿事件监视线程启动失败");
+        return false;
+    }
+
+    if (!applyInputEdge(pin, edge, debounceUs, counter)) {
+        emit errorOccurred(QString("GPIO引脚%1边沿检测设置失败").arg(pin));
+        return false;
+    }
+    return true;
+}
+
+bool GPIOController::applyInputEdge(int pin, Edge edge, int debounceUs, const QSharedPointer<GpioPulseCounter> &counter)
+{
+    const bool rising = (edge == RisingEdge || edge == BothEdges);
+    const bool falling = (edge == FallingEdge || edge == BothEdges);
+
+    if (m_backend == CharDevBackend) {
+        bool kernelDebounce = false;
+        const int fd = m_charDev->requestEdgeLine(pin, rising, falling, GPIO_INPUT_BIAS_PULL_UP, debounceUs,
+                                                  &kernelDebounce, counter ? GPIO_PULSE_EVENT_BUFFER_SIZE : 0);
+        if (fd < 0) {
+            return false;
+        }
+        if (debounceUs > 0 && !kernelDebounce) {
+            qDebug() << QString("GPIO引脚%1不支持硬件去抖，使用软件去抖%2us").arg(pin).arg(debounceUs);
+        }
+        return m_eventMonitor->addSource(pin, fd, GpioEventMonitor::CharDevSource,
+                                         kernelDebounce ? 0 : debounceUs, counter);
+    }
+
+    // 模拟的sysfs实现没有可供epoll等待的真实fd
+    if (!m_sysfs->pollable()) {
+        emit errorOccurred(QString("GPIO引脚%1边沿检测不受sysfs访问实现%2支持")
+                           .arg(pin).arg(m_sysfs->name()));
+        return false;
+    }
+
+    // sysfs无法设置偏置与硬件去抖，依赖外部上拉并在监视线程中软件去抖
+    const char *edgeName = (edge == BothEdges) ? "both" : (rising ? "rising" : "falling");
+    int fd = pinFd(pin, true);
+    if (fd >= 0) {
+        if (!writeAttribute(pin, fd, "in", 2)) {
+            return false;
+        }
+    } else if (!writeToFile(getPinPath(pin, "direction"), "in")) {
+        return false;
+    }
+    if (!writeToFile(getPinPath(pin, "edge"), edgeName)) {
+        return false;
+    }
+
+    fd = pinFd(pin, false);
+    if (fd < 0) {
+        return false;
+    }
+
+    // 先读一次清除导出时遗留的POLLPRI，避免启动即收到伪事件
+    char buffer[4];
+    if (m_sysfs->read(fd, buffer, sizeof(buffer)) < 0) {
+        qWarning() << QString("读取GPIO引脚%1电平失败: %2").arg(pin).arg(strerror(errno));
+    }
+
+    return m_eventMonitor->addSource(pin, fd, GpioEventMonitor::SysfsSource, debounceUs, counter);
+}
+
+GPIOController::Transaction GPIOController::beginTransaction()
+{
+    return Transaction(this);
+}
+
+GPIOController::TransactionResult GPIOController::commitTransaction(const Transaction &transaction)
+{
+    QMutexLocker locker(&m_mutex);
+
+    TransactionResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    QMap<int, bool> pins;
+    for (int pin : transaction.m_exports) {
+        pins.insert(pin, true);
+    }
+    for (auto it = transaction.m_directions.constBegin(); it != transaction.m_directions.constEnd(); ++it) {
+        pins.insert(it.key(), true);
+    }
+    for (auto it = transaction.m_levels.constBegin(); it != transaction.m_levels.constEnd(); ++it) {
+        pins.insert(it.key(), true);
+    }
+    result.pinCount = pins.size();
+
+    auto fail = [&result](int pin, const QString &reason) {
+        if (!result.failures.contains(pin)) {
+            result.failures.insert(pin, reason);
+        }
+    };
+
+    if (!m_initialized) {
+        for (auto it = pins.constBegin(); it != pins.constEnd(); ++it) {
+            fail(it.key(), "GPIO控制器未初始化");
+        }
+        result.success = false;
+        emit errorOccurred("GPIO控制器未初始化");
+        return result;
+    }
+
+    // 1. 导出
+    QMap<int, bool> preexisting; // 提交前已导出的引脚（如程序重启），可能已处于目标状态
+    if (!transaction.m_exports.isEmpty()) {
+        if (m_backend == CharDevBackend) {
+            // 线路在设置方向时按芯片统一申请
+            for (int pin : transaction.m_exports) {
+                releaseSysfsExport(pin);
+                m_exportedPins[pin] = true;
+            }
+        } else {
+            // 一次目录扫描代替逐引脚探测，export文件只打开一次
+            const QStringList present = m_sysfs->entries(GPIO_BASE_PATH);
+            int exportFd = -1;
+            for (int pin : transaction.m_exports) {
+                if (present.contains(QString("gpio%1").arg(pin))) {
+                    preexisting.insert(pin, true);
+                } else {
+                    if (exportFd < 0) {
+                        exportFd = m_sysfs->open(GPIO_EXPORT_PATH, O_WRONLY);
+                    }
+                    const QByteArray number = QByteArray::number(pin);
+                    if (exportFd < 0 || m_sysfs->write(exportFd, number.constData(), number.size()) != number.size()) {
+                        fail(pin, QString("导出失败: %1").arg(strerror(errno)));
+                        continue;
+                    }
+                }
+                m_exportedPins[pin] = true;
+                openPinFiles(pin);
+            }
+            if (exportFd >= 0) {
+                m_sysfs->close(exportFd);
+            }
+        }
+    }
+
+    // 2. 方向（输出引脚的初始电平随方向一起提交）
+    QMap<int, bool> levels = transaction.m_levels;
+    if (m_backend == CharDevBackend) {
+        QMap<int, bool> outputs;
+        QVector<int> inputs;
+        for (auto it = transaction.m_directions.constBegin(); it != transaction.m_directions.constEnd(); ++it) {
+            const int pin = it.key();
+            if (result.failures.contains(pin)) {
+                continue;
+            }
+            if (!isPinExported(pin)) {
+                fail(pin, "未导出");
+                continue;
+            }
+            m_pinDirections[pin] = it.value();
+            if (it.value() == "in") {
+                inputs.append(pin);
+            } else {
+                bool level = (it.value() == "high");
+                if (it.value() == "out" && levels.contains(pin)) {
+                    level = levels.take(pin);
+                }
+                outputs.insert(pin, level);
+            }
+        }
+        if (!outputs.isEmpty() || !inputs.isEmpty()) {
+            const QVector<int> failed = m_charDev->claimLines(outputs, inputs);
+            for (int pin : failed) {
+                fail(pin, QString("线路申请失败: %1").arg(m_charDev->lastError()));
+            }
+            for (int pin : inputs) {
+                m_outputShadow.remove(pin);
+            }
+            for (auto it = outputs.constBegin(); it != outputs.constEnd(); ++it) {
+                if (!result.failures.contains(it.key())) {
+                    m_outputShadow[it.key()] = it.value();
+                }
+            }
+        }
+    } else {
+        for (auto it = transaction.m_directions.constBegin(); it != transaction.m_directions.constEnd(); ++it) {
+            const int pin = it.key();
+            if (result.failures.contains(pin)) {
+                continue;
+            }
+            if (!isPinExported(pin)) {
+                fail(pin, "未导出");
+                continue;
+            }
+            m_pinDirections[pin] = it.value();
+
+            // sysfs的"high"/"low"在设为输出的同时写入初始电平，无毛刺且省去一次写入
+            QString direction = it.value();
+            if (direction == "out" && levels.contains(pin)) {
+                direction = levels.take(pin) ? "high" : "low";
+            }
+
+            // 重写direction会把输出复位为低电平，已处于目标状态的引脚不再写入
+            if (preexisting.contains(pin) && sysfsStateMatches(pin, direction)) {
+                updateShadow(pin, direction);
+                result.unchangedCount++;
+                continue;
+            }
+
+            const QByteArray bytes = direction.toLatin1();
+            int fd = pinFd(pin, true);
+            bool written = (fd >= 0) ? writeAttribute(pin, fd, bytes.constData(), bytes.size())
+                                     : writeToFile(getPinPath(pin, "direction"), direction);
+            if (!written) {
+                fail(pin, "方向设置失败");
+            } else {
+                updateShadow(pin, direction);
+            }
+        }
+    }
+
+    for (auto it = transaction.m_directions.constBegin(); it != transaction.m_directions.constEnd(); ++it) {
+        if (!result.failures.contains(it.key())) {
+            syncFastPin(it.key());
+        }
+    }
+
+    // 3. 电平
+    QMap<int, quint32> fastMasks;  // 快速输出引脚按bank合并：chip -> 线路掩码
+    QMap<int, quint32> fastLevels; // chip -> 线路电平
+    for (auto it = levels.begin(); it != levels.end(); ) {
+        if (result.failures.contains(it.key())) {
+            it = levels.erase(it);
+        } else if (!isPinExported(it.key())) {
+            fail(it.key(), "未导出");
+            it = levels.erase(it);
+        } else if (m_fastPins.contains(it.key()) && m_mmio->isOpen() && m_outputShadow.contains(it.key())) {
+            const int chip = it.key() / GPIO_LINES_PER_CHIP;
+            const quint32 bit = 1u << (it.key() % GPIO_LINES_PER_CHIP);
+            fastMasks[chip] |= bit;
+            if (it.value()) {
+                fastLevels[chip] |= bit;
+            }
+            m_outputShadow[it.key()] = it.value();
+            it = levels.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = fastMasks.constBegin(); it != fastMasks.constEnd(); ++it) {
+        m_mmio->writeBank(it.key(), it.value(), fastLevels.value(it.key()));
+    }
+
+    if (!levels.isEmpty()) {
+        if (m_backend == CharDevBackend) {
+            // 同一芯片上的引脚在一次ioctl中同时更新
+            QVector<int> failed;
+            m_charDev->setLevels(levels, &failed);
+            for (int pin : failed) {
+                fail(pin, QString("电平设置失败: %1").arg(m_charDev->lastError()));
+            }
+            for (auto it = levels.constBegin(); it != levels.constEnd(); ++it) {
+                if (!result.failures.contains(it.key())) {
+                    m_outputShadow[it.key()] = it.value();
+                }
+            }
+        } else {
+            for (auto it = levels.constBegin(); it != levels.constEnd(); ++it) {
+                int fd = pinFd(it.key(), false);
+                bool written = (fd >= 0) ? writeAttribute(it.key(), fd, &GPIO_LEVEL_CHARS[it.value() ? 1 : 0], 1)
+                                         : writeToFile(getPinPath(it.key(), "value"), it.value() ? "1" : "0");
+                if (!written) {
+                    fail(it.key(), "电平设置失败");
+                } else {
+                    m_outputShadow[it.key()] = it.value();
+                }
+            }
+        }
+    }
+
+    result.success = result.failures.isEmpty();
+    result.elapsedUs = timer.nsecsElapsed() / 1000;
+
+    if (!result.success) {
+        QStringList failedPins;
+        for (auto it = result.failures.constBegin(); it != result.failures.constEnd(); ++it) {
+            failedPins.append(QString("%1(%2)").arg(it.key()).arg(it.value()));
+        }
+        emit errorOccurred(QString("GPIO批量操作失败: %1").arg(failedPins.join(", ")));
+    }
+
+    return result;
+}
+
 bool GPIOController::isPinExported(int pin) const
 {
+    QMutexLocker locker(&m_mutex);
     return m_exportedPins.value(pin, false);
 }
 
 bool GPIOController::writeToFile(const QString &filePath, const QString &value)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        QTextStream stream(&file);
-        stream << value;
-        file.close();
+    if (m_sysfs->writeFile(filePath, value.toLatin1())) {
         return true;
     } else {
-        QString errorMsg = QString("无法写入文件 %1: %2").arg(filePath).arg(file.errorString());
+        QString errorMsg = QString("无法写入文件 %1: %2").arg(filePath).arg(strerror(errno));
         qWarning() << errorMsg;
         emit errorOccurred(errorMsg);
         return false;
@@ -175,14 +899,12 @@ bool GPIOController::writeToFile(const QString &filePath, const QString &value)
 
 QString GPIOController::readFromFile(const QString &filePath)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::ReadOnly)) {
-        QTextStream stream(&file);
-        QString content = stream.readAll().trimmed();
-        file.close();
-        return content;
+    bool ok = false;
+    QByteArray content = m_sysfs->readFile(filePath, &ok);
+    if (ok) {
+        return QString::fromLatin1(content);
     } else {
-        qWarning() << QString("无法读取文件 %1: %2").arg(filePath).arg(file.errorString());
+        qWarning() << QString("无法读取文件 %1: %2").arg(filePath).arg(strerror(errno));
         return QString();
     }
 }
@@ -192,41 +914,253 @@ QString GPIOController::getPinPath(int pin, const QString &attribute)
     return QString("%1/gpio%2/%3").arg(GPIO_BASE_PATH).arg(pin).arg(attribute);
 }
 
-bool GPIOController::initializePowerSupplyPin()
+bool GPIOController::openPinFiles(int pin)
 {
-    // 导出GPIO3_B6引脚
-    if (!exportPin(POWER_SUPPLY_PIN)) {
+    if (!m_fdCacheEnabled) {
         return false;
     }
 
-    // 设置为输出模式
-    if (!setDirection(POWER_SUPPLY_PIN, "out")) {
+    PinFiles &files = m_pinFiles[pin];
+
+    if (files.valueFd < 0) {
+        const QString path = getPinPath(pin, "value");
+        files.valueFd = m_sysfs->open(path, O_RDWR);
+        files.valueReadOnly = false;
+        if (files.valueFd < 0 && m_pinDirections.value(pin) == "in") {
+            // 仅输入引脚退化为只读；输出引脚保持未打开，下次使用时重试
+            files.valueFd = m_sysfs->open(path, O_RDONLY);
+            files.valueReadOnly = (files.valueFd >= 0);
+        }
+    }
+
+    if (files.directionFd < 0) {
+        files.directionFd = m_sysfs->open(getPinPath(pin, "direction"), O_RDWR);
+    }
+
+    return files.valueFd >= 0 && files.directionFd >= 0;
+}
+
+void GPIOController::closePinFiles(int pin)
+{
+    auto it = m_pinFiles.find(pin);
+    if (it == m_pinFiles.end()) {
+        return;
+    }
+
+    if (it.value().valueFd >= 0) {
+        m_sysfs->close(it.value().valueFd);
+    }
+    if (it.value().directionFd >= 0) {
+        m_sysfs->close(it.value().directionFd);
+    }
+
+    m_pinFiles.erase(it);
+}
+
+int GPIOController::pinFd(int pin, bool direction)
+{
+    auto it = m_pinFiles.find(pin);
+    int fd = -1;
+    if (it != m_pinFiles.end()) {
+        PinFiles &files = it.value();
+        if (!direction && files.valueReadOnly && m_pinDirections.value(pin) != "in") {
+            // 引脚已改为输出，只读描述符不能再用于写入电平
+            m_sysfs->close(files.valueFd);
+            files.valueFd = -1;
+            files.valueReadOnly = false;
+        }
+        fd = direction ? files.directionFd : files.valueFd;
+    }
+
+    if (fd < 0 && m_fdCacheEnabled) {
+        openPinFiles(pin);
+        const PinFiles &files = m_pinFiles[pin];
+        fd = direction ? files.directionFd : files.valueFd;
+    }
+
+    return fd;
+}
+
+void GPIOController::setShadowVerification(bool enabled, int intervalMs)
+{
+    if (m_verifyThread) {
+        m_verifyThread->stop();
+        m_verifyThread->wait();
+        delete m_verifyThread;
+        m_verifyThread = nullptr;
+    }
+
+    if (enabled) {
+        m_verifyThread = new ShadowVerifyThread(this, intervalMs);
+        m_verifyThread->start(QThread::LowPriority);
+        qDebug() << QString("GPIO影子寄存器后台校验已启动，间隔%1ms").arg(intervalMs);
+    }
+}
+
+bool GPIOController::verifyShadow()
+{
+    QList<int> mismatchedPins;
+    QMap<int, bool> expected;
+    QMap<int, bool> actual;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_initialized || m_outputShadow.isEmpty()) {
+            return true;
+        }
+
+        expected = m_outputShadow;
+        if (!readHardwareLevels(expected.keys(), actual)) {
+            return false;
+        }
+
+        for (auto it = expected.constBegin(); it != expected.constEnd(); ++it) {
+            if (actual.contains(it.key()) && actual.value(it.key()) != it.value()) {
+                mismatchedPins.append(it.key());
+            }
+        }
+    }
+
+    // 在锁外发出信号，避免直连槽函数阻塞硬件访问
+    for (int pin : mismatchedPins) {
+        qWarning() << QString("GPIO引脚%1电平与影子寄存器不一致: 期望%2, 实际%3")
+                      .arg(pin).arg(expected.value(pin)).arg(actual.value(pin));
+        emit shadowMismatch(pin, expected.value(pin), actual.value(pin));
+    }
+
+    return mismatchedPins.isEmpty();
+}
+
+bool GPIOController::readHardwareLevels(const QList<int> &pins, QMap<int, bool> &levels)
+{
+    if (m_backend == CharDevBackend) {
+        // 每个芯片一次GET_VALUES
+        return m_charDev->getLevels(pins, levels);
+    }
+
+    bool success = true;
+    for (int pin : pins) {
+        int fd = pinFd(pin, false);
+        char buffer[4];
+        if (fd < 0 || m_sysfs->read(fd, buffer, sizeof(buffer)) <= 0) {
+            success = false;
+            continue;
+        }
+        levels.insert(pin, buffer[0] == '1');
+    }
+    return success;
+}
+
+bool GPIOController::sysfsStateMatches(int pin, const QString &direction)
+{
+    char buffer[8];
+    int fd = pinFd(pin, true);
+    int n = (fd >= 0) ? m_sysfs->read(fd, buffer, sizeof(buffer)) : -1;
+    if (n <= 0) {
+        return false;
+    }
+    const QByteArray current = QByteArray(buffer, n).trimmed();
+    if (direction == "in") {
+        return current == "in";
+    }
+    if (current != "out") {
         return false;
     }
 
-    // 设置为高电平（3.3V输出）
-    if (!setPin(POWER_SUPPLY_PIN, GPIO_HIGH)) {
+    // "out"与"low"的结果都是低电平输出
+    fd = pinFd(pin, false);
+    n = (fd >= 0) ? m_sysfs->read(fd, buffer, sizeof(buffer)) : -1;
+    if (n <= 0) {
         return false;
     }
+    return (buffer[0] == '1') == (direction == "high");
+}
 
-    qDebug() << "GPIO3_B6电源引脚初始化成功，设置为常高电平";
-    return true;
+void GPIOController::syncFastPin(int pin)
+{
+    if (!m_fastPins.contains(pin) || !m_mmio->isOpen()) {
+        return;
+    }
+
+    // 后端已完成设置，这里使寄存器映射与之一致（文件测试模式下据此校验位模式）
+    // 先写电平再设方向，切换为输出时不产生毛刺
+    auto it = m_outputShadow.constFind(pin);
+    const bool output = (it != m_outputShadow.constEnd());
+    if (output) {
+        m_mmio->write(pin, it.value());
+    }
+    m_mmio->setDirection(pin, output);
 }
 
-bool GPIOController::initializePumpControlPin()
+void GPIOController::updateShadow(int pin, const QString &direction)
+{
+    // 与sysfs语义一致："out"默认低电平，"high"/"low"指定初始电平
+    if (direction == "in") {
+        m_outputShadow.remove(pin);
+    } else {
+        m_outputShadow[pin] = (direction == "high");
+    }
+}
+
+bool GPIOController::releaseSysfsExport(int pin)
 {
-    // 导出GPIO3_A7引脚
-    if (!exportPin(PUMP_CONTROL_PIN)) {
+    // 已被sysfs导出的线路处于占用状态，字符设备申请会返回EBUSY
+    closePinFiles(pin);
+    if (!m_sysfs->exists(QString("%1/gpio%2").arg(GPIO_BASE_PATH).arg(pin))) {
+        return true;
+    }
+    return writeToFile(GPIO_UNEXPORT_PATH, QString::number(pin));
+}
+
+bool GPIOController::writeAttribute(int pin, int fd, const char *data, int length)
+{
+    if (m_sysfs->write(fd, data, length) != length) {
+        QString errorMsg = QString("GPIO引脚%1属性写入失败: %2").arg(pin).arg(strerror(errno));
+        qWarning() << errorMsg;
+        emit errorOccurred(errorMsg);
+
+        // 关闭失效的描述符，下次使用时重新打开
+        auto it = m_pinFiles.find(pin);
+        if (it != m_pinFiles.end()) {
+            if (it.value().valueFd == fd) {
+                it.value().valueFd = -1;
+                it.value().valueReadOnly = false;
+            } else if (it.value().directionFd == fd) {
+                it.value().directionFd = -1;
+            }
+        }
+        m_sysfs->close(fd);
         return false;
     }
 
-    // 设置为输出模式
-    if (!setDirection(PUMP_CONTROL_PIN, "out")) {
+    return true;
+}
+
+bool GPIOController::initializePowerSupplyPin()
+{
+    // 导出GPIO3_B6引脚，设置为输出并置高电平（3.3V输出）
+    TransactionResult result = beginTransaction()
+            .exportPin(POWER_SUPPLY_PIN)
+            .setDirection(POWER_SUPPLY_PIN, "out")
+            .setPin(POWER_SUPPLY_PIN, GPIO_HIGH)
+            .commit();
+    if (!result.success) {
         return false;
     }
 
-    // 初始状态设置为低电平（水泵关闭）
-    if (!setPin(PUMP_CONTROL_PIN, GPIO_LOW)) {
+    qDebug() << "GPIO3_B6电源引脚初始化成功，设置为常高电平";
+    return true;
+}
+
+bool GPIOController::initializePumpControlPin()
+{
+    // 导出GPIO3_A7引脚，设置为输出，初始低电平（水泵关闭）
+    TransactionResult result = beginTransaction()
+            .exportPin(PUMP_CONTROL_PIN)
+            .setDirection(PUMP_CONTROL_PIN, "out")
+            .setPin(PUMP_CONTROL_PIN, GPIO_LOW)
+            .commit();
+    if (!result.success) {
         return false;
     }
 
@@ -242,8 +1176,9 @@ bool GPIOController::startPump()
     }
 
     // 设置GPIO3_A7为高电平（开启水泵）
-    if (setPin(PUMP_CONTROL_PIN, GPIO_HIGH)) {
-        qDebug() << "水泵已开启 - GPIO3_A7置1";
+    bool queued = false;
+    if (switchOnPump(PUMP_CONTROL_PIN, "水泵", &queued)) {
+        qDebug() << (queued ? "水泵已排队，等待供电余量 - GPIO3_A7暂未置1" : "水泵已开启 - GPIO3_A7置1");
         return true;
     } else {
         emit errorOccurred("水泵开启失败");
@@ -258,8 +1193,11 @@ bool GPIOController::stopPump()
         return false;
     }
 
+    // 手动关闭时取消定量运行
+    cancelVolumeRun(PUMP_CONTROL_PIN);
+
     // 设置GPIO3_A7为低电平（关闭水泵）
-    if (setPin(PUMP_CONTROL_PIN, GPIO_LOW)) {
+    if (switchOffPump(PUMP_CONTROL_PIN)) {
         qDebug() << "水泵已关闭 - GPIO3_A7置0";
         return true;
     } else {
@@ -274,24 +1212,25 @@ bool GPIOController::getPumpStatus()
         return false;
     }
 
-    // 读取GPIO3_A7的状态
+    // GPIO3_A7的状态（来自影子寄存器，不访问sysfs）
     return getPin(PUMP_CONTROL_PIN);
 }
 
-bool GPIOController::initializeFertilizerPumpPin()
+bool GPIOController::isPumpStartPending() const
 {
-    // 导出GPIO3_A1引脚
-    if (!exportPin(FERTILIZER_PUMP_PIN)) {
-        return false;
-    }
-
-    // 设置为输出模式
-    if (!setDirection(FERTILIZER_PUMP_PIN, "out")) {
-        return false;
-    }
+    QMutexLocker locker(&m_mutex);
+    return m_pendingPumps.contains(PUMP_CONTROL_PIN);
+}
 
-    // 初始状态设置为低电平（关闭）
-    if (!setPin(FERTILIZER_PUMP_PIN, GPIO_LOW)) {
+bool GPIOController::initializeFertilizerPumpPin()
+{
+    // 导出GPIO3_A1引脚，设置为输出，初始低电平（关闭）
+    TransactionResult result = beginTransaction()
+            .exportPin(FERTILIZER_PUMP_PIN)
+            .setDirection(FERTILIZER_PUMP_PIN, "out")
+            .setPin(FERTILIZER_PUMP_PIN, GPIO_LOW)
+            .commit();
+    if (!result.success) {
         return false;
     }
 
@@ -307,8 +1246,9 @@ bool GPIOController::startFertilizerPump()
     }
 
     // 设置GPIO3_A1为高电平（开启施药泵）
-    if (setPin(FERTILIZER_PUMP_PIN, GPIO_HIGH)) {
-        qDebug() << "施药泵已开启 - GPIO3_A1置1";
+    bool queued = false;
+    if (switchOnPump(FERTILIZER_PUMP_PIN, "施药泵", &queued)) {
+        qDebug() << (queued ? "施药泵已排队，等待供电余量 - GPIO3_A1暂未置1" : "施药泵已开启 - GPIO3_A1置1");
         return true;
     } else {
         emit errorOccurred("施药泵开启失败");
@@ -323,8 +1263,11 @@ bool GPIOController::stopFertilizerPump()
         return false;
     }
 
+    // 手动关闭时取消定量运行
+    cancelVolumeRun(FERTILIZER_PUMP_PIN);
+
     // 设置GPIO3_A1为低电平（关闭施药泵）
-    if (setPin(FERTILIZER_PUMP_PIN, GPIO_LOW)) {
+    if (switchOffPump(FERTILIZER_PUMP_PIN)) {
         qDebug() << "施药泵已关闭 - GPIO3_A1置0";
         return true;
     } else {
@@ -333,12 +1276,248 @@ bool GPIOController::stopFertilizerPump()
     }
 }
 
+bool GPIOController::startPumpForVolume(double litres)
+{
+    return startVolumeRun(PUMP_CONTROL_PIN, m_pumpFlowMeter, litres);
+}
+
+bool GPIOController::startFertilizerPumpForVolume(double litres)
+{
+    return startVolumeRun(FERTILIZER_PUMP_PIN, m_fertilizerFlowMeter, litres);
+}
+
+bool GPIOController::startVolumeRun(int pumpPin, FlowMeter *meter, double litres)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        emit errorOccurred("GPIO控制器未初始化");
+        return false;
+    }
+    if (!meter) {
+        emit errorOccurred(QString("GPIO引脚%1未安装流量计，无法按体积运行").arg(pumpPin));
+        return false;
+    }
+    if (litres <= 0.0) {
+        emit errorOccurred("定量运行体积必须大于0");
+        return false;
+    }
+
+    cancelVolumeRun(pumpPin);
+
+    QSharedPointer<GpioPulseCounter> counter = m_pulseCounters.value(meter->pin());
+    if (!counter) {
+        emit errorOccurred(QString("流量计引脚%1未启用脉冲计数").arg(meter->pin()));
+        return false;
+    }
+
+    // 目标在开泵前设置，监视线程计数越过目标即关泵
+    VolumeRun run;
+    run.pumpPin = pumpPin;
+    run.startPulses = counter->pulses.loadAcquire();
+    run.pulsesPerLitre = meter->pulsesPerLitre();
+    m_volumeRuns.insert(meter->pin(), run);
+    counter->target.storeRelease(run.startPulses + meter->pulsesForLitres(litres));
+
+    if (!switchOnPump(pumpPin, QString("GPIO引脚%1").arg(pumpPin))) {
+        cancelVolumeRun(pumpPin);
+        emit errorOccurred(QString("GPIO引脚%1定量运行开启失败").arg(pumpPin));
+        return false;
+    }
+
+    qDebug() << QString("GPIO引脚%1开始定量运行: %2L").arg(pumpPin).arg(litres);
+    return true;
+}
+
+void GPIOController::cancelVolumeRun(int pumpPin)
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (auto it = m_volumeRuns.begin(); it != m_volumeRuns.end(); ) {
+        if (it.value().pumpPin != pumpPin) {
+            ++it;
+            continue;
+        }
+        QSharedPointer<GpioPulseCounter> counter = m_pulseCounters.value(it.key());
+        if (counter) {
+            counter->target.storeRelease(0);
+        }
+        it = m_volumeRuns.erase(it);
+    }
+}
+
+void GPIOController::onPulseTargetReached(int pin, quint64 pulses)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_volumeRuns.find(pin);
+    if (it == m_volumeRuns.end()) {
+        return; // 已被手动取消
+    }
+    const VolumeRun run = it.value();
+    m_volumeRuns.erase(it);
+
+    QSharedPointer<GpioPulseCounter> counter = m_pulseCounters.value(pin);
+    if (counter) {
+        counter->target.storeRelease(0);
+    }
+
+    beginTransaction().setPin(run.pumpPin, GPIO_LOW).commit();
+    if (m_powerScheduler) {
+        m_powerScheduler->release(run.pumpPin);
+    }
+
+    const double litres = double(pulses - run.startPulses) / run.pulsesPerLitre;
+    qDebug() << QString("GPIO引脚%1定量运行完成，实际输送%2L").arg(run.pumpPin).arg(litres, 0, 'f', 3);
+    emit pumpVolumeReached(run.pumpPin, litres);
+}
+
+bool GPIOController::switchOnPump(int pumpPin, const QString &name, bool *queued)
+{
+    if (queued) {
+        *queued = false;
+    }
+
+    if (m_powerScheduler && !m_powerScheduler->tryAcquire(pumpPin)) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_pendingPumps.contains(pumpPin)) {
+                if (queued) {
+                    *queued = true; // 已在排队，不重复申请
+                }
+                return true;
+            }
+            m_pendingPumps.insert(pumpPin, true);
+        }
+
+        // 余量不足：排队，准入后在调度器所在线程开泵，开启失败时调度器立即释放余量
+        m_powerScheduler->submit(pumpPin, [this, pumpPin, name]() {
+            {
+                QMutexLocker locker(&m_mutex);
+                m_pendingPumps.remove(pumpPin);
+            }
+            if (beginTransaction().setPin(pumpPin, GPIO_HIGH).commit().success) {
+                qDebug() << QString("%1已按供电预算开启").arg(name);
+                return true;
+            }
+            cancelVolumeRun(pumpPin);
+            emit errorOccurred(QString("%1开启失败").arg(name));
+            return false;
+        });
+
+        // 余量恰好在submit()内准入时已同步开泵
+        QMutexLocker locker(&m_mutex);
+        const bool pending = m_pendingPumps.contains(pumpPin);
+        if (queued) {
+            *queued = pending;
+        }
+        if (pending) {
+            qDebug() << QString("%1等待供电余量后开启").arg(name);
+        }
+        return true;
+    }
+
+    if (beginTransaction().setPin(pumpPin, GPIO_HIGH).commit().success) {
+        return true;
+    }
+    if (m_powerScheduler) {
+        m_powerScheduler->release(pumpPin);
+    }
+    return false;
+}
+
+bool GPIOController::switchOffPump(int pumpPin)
+{
+    if (m_powerScheduler) {
+        m_powerScheduler->cancelAll(pumpPin);
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingPumps.remove(pumpPin);
+    }
+    const bool success = beginTransaction().setPin(pumpPin, GPIO_LOW).commit().success;
+    if (m_powerScheduler) {
+        m_powerScheduler->release(pumpPin);
+    }
+    return success;
+}
+
+FlowMeter *GPIOController::createFlowMeter(int pin)
+{
+    if (pin < 0) {
+        return nullptr; // 未安装
+    }
+
+    if (!exportPin(pin) || !configurePulseCounter(pin, RisingEdge, FLOW_METER_DEBOUNCE_US)) {
+        qWarning() << QString("流量计引脚%1初始化失败").arg(pin);
+        return nullptr;
+    }
+
+    // 启动时可能在工作线程中初始化，流量计（含发布定时器）归属控制器所在线程
+    FlowMeter *meter = new FlowMeter(pin, m_pulseCounters.value(pin), FLOW_METER_PULSES_PER_LITRE);
+    if (meter->thread() != thread()) {
+        meter->moveToThread(thread());
+    }
+    meter->setParent(this);
+    QMetaObject::invokeMethod(meter, [meter]() {
+        meter->start(FLOW_METER_PUBLISH_INTERVAL_MS);
+    }, Qt::AutoConnection);
+    return meter;
+}
+
 bool GPIOController::getFertilizerPumpStatus()
 {
     if (!m_initialized) {
         return false;
     }
 
-    // 读取GPIO3_A1的状态
+    // GPIO3_A1的状态（来自影子寄存器，不访问sysfs）
     return getPin(FERTILIZER_PUMP_PIN);
 }
+
+bool GPIOController::isFertilizerPumpStartPending() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingPumps.contains(FERTILIZER_PUMP_PIN);
+}
+
+// ==================== 批量操作 ====================
+
+GPIOController::Transaction::Transaction(GPIOController *controller)
+    : m_controller(controller)
+{
+}
+
+GPIOController::Transaction &GPIOController::Transaction::exportPin(int pin)
+{
+    if (!m_exports.contains(pin)) {
+        m_exports.append(pin);
+    }
+    return *this;
+}
+
+GPIOController::Transaction &GPIOController::Transaction::setDirection(int pin, const QString &direction)
+{
+    m_directions[pin] = direction;
+    return *this;
+}
+
+GPIOController::Transaction &GPIOController::Transaction::setPin(int pin, bool value)
+{
+    m_levels[pin] = value;
+    return *this;
+}
+
+GPIOController::TransactionResult GPIOController::Transaction::commit()
+{
+    TransactionResult result = m_controller->commitTransaction(*this);
+    m_exports.clear();
+    m_directions.clear();
+    m_levels.clear();
+    return result;
+}
+
+bool GPIOController::Transaction::isEmpty() const
+{
+    return m_exports.isEmpty() && m_directions.isEmpty() && m_levels.isEmpty();
+}
@@ -0,0 +1,314 @@
+#include "hardware/gpio_event_monitor.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <linux/gpio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+// epoll用户数据中的唤醒标识（引脚号均为非负数）
+static const quint64 WAKE_SOURCE_ID = ~quint64(0);
+
+// 单次读取的最大事件数，内核事件缓冲中的突发边沿一次取完（流量计脉冲可达数kHz）
+static const int MAX_EVENTS_PER_READ = 64;
+
+/**
+ * @brief 边沿事件监视线程
+ */
+class GpioEventThread : public QThread
+{
+public:
+    explicit GpioEventThread(GpioEventMonitor *monitor) : m_monitor(monitor) {}
+
+protected:
+    void run() override { m_monitor->runLoop(); }
+
+private:
+    GpioEventMonitor *m_monitor;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+GpioEventMonitor::GpioEventMonitor(QObject *parent)
+    : QObject(parent)
+    , m_epollFd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_thread(nullptr)
+{
+}
+
+GpioEventMonitor::~GpioEventMonitor()
+{
+    stop();
+}
+
+bool GpioEventMonitor::start()
+{
+    if (m_thread) {
+        return true;
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_epollFd < 0 || m_wakeFd < 0) {
+        qWarning() << "GPIO事件监视器创建失败:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_SOURCE_ID;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+    // 启动前已登记的事件源
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_sources.constBegin(); it != m_sources.constEnd(); ++it) {
+            memset(&event, 0, sizeof(event));
+            event.events = (it.value().type == SysfsSource) ? (EPOLLPRI | EPOLLERR) : EPOLLIN;
+            event.data.u64 = quint64(it.key());
+            epoll_ctl(m_epollFd, EPOLL_CTL_ADD, it.value().fd, &event);
+        }
+    }
+
+    m_stopping.storeRelease(0);
+    m_thread = new GpioEventThread(this);
+    m_thread->start(QThread::TimeCriticalPriority);
+    qDebug() << "GPIO边沿事件监视线程已启动";
+    return true;
+}
+
+void GpioEventMonitor::stop()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        quint64 one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qWarning() << "GPIO事件监视线程唤醒失败:" << strerror(errno);
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    if (m_epollFd >= 0) {
+        close(m_epollFd);
+        m_epollFd = -1;
+    }
+}
+
+bool GpioEventMonitor::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+bool GpioEventMonitor::addSource(int pin, int fd, SourceType type, int softDebounceUs,
+                                 const QSharedPointer<GpioPulseCounter> &counter)
+{
+    if (fd < 0) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    Source source;
+    source.fd = fd;
+    source.type = type;
+    source.softDebounceUs = softDebounceUs;
+    source.counter = counter;
+    m_sources.insert(pin, source);
+
+    if (m_epollFd < 0) {
+        return true; // 启动时统一登记
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = (type == SysfsSource) ? (EPOLLPRI | EPOLLERR) : EPOLLIN;
+    event.data.u64 = quint64(pin);
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        qWarning() << QString("GPIO引脚%1加入事件监视失败: %2").arg(pin).arg(strerror(errno));
+        m_sources.remove(pin);
+        return false;
+    }
+    return true;
+}
+
+void GpioEventMonitor::removeSource(int pin)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_sources.find(pin);
+    if (it == m_sources.end()) {
+        return;
+    }
+
+    if (m_epollFd >= 0) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, it.value().fd, nullptr);
+    }
+    m_sources.erase(it);
+}
+
+bool GpioEventMonitor::hasSource(int pin) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sources.contains(pin);
+}
+
+void GpioEventMonitor::runLoop()
+{
+    struct epoll_event events[MAX_EVENTS_PER_READ];
+
+    while (!m_stopping.loadAcquire()) {
+        int count = epoll_wait(m_epollFd, events, MAX_EVENTS_PER_READ, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "GPIO事件等待失败:" << strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WAKE_SOURCE_ID) {
+                quint64 value;
+                if (read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    qWarning() << "GPIO事件唤醒读取失败:" << strerror(errno);
+                }
+                continue;
+            }
+            handleSource(static_cast<int>(events[i].data.u64));
+        }
+    }
+}
+
+void GpioEventMonitor::handleSource(int pin)
+{
+    struct gpio_v2_line_event lineEvents[MAX_EVENTS_PER_READ];
+    int eventCount = 0;
+    bool sysfsLevel = false;
+    qint64 sysfsTimestampNs = 0;
+    SourceType type;
+    quint64 reachedPulses = 0;
+
+    // 读取在锁内完成，removeSource()返回后调用方即可安全关闭fd
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_sources.find(pin);
+        if (it == m_sources.end()) {
+            return; // 已被移除
+        }
+        type = it.value().type;
+
+        if (type == CharDevSource) {
+            ssize_t bytes = read(it.value().fd, lineEvents, sizeof(lineEvents));
+            if (bytes <= 0) {
+                return;
+            }
+            eventCount = static_cast<int>(bytes / sizeof(struct gpio_v2_line_event));
+        } else {
+            // sysfs边沿通知：回读value清除POLLPRI，电平即为边沿方向
+            sysfsTimestampNs = monotonicNs();
+            char buffer[4];
+            if (pread(it.value().fd, buffer, sizeof(buffer), 0) <= 0) {
+                return;
+            }
+            sysfsLevel = (buffer[0] == '1');
+        }
+
+        // 计数模式：整批事件一次原子累加，不逐个发出信号
+        Source &source = it.value();
+        if (source.counter) {
+            quint64 accepted = 0;
+            qint64 lastNs = 0;
+            if (type == CharDevSource) {
+                for (int i = 0; i < eventCount; ++i) {
+                    const qint64 timestampNs = static_cast<qint64>(lineEvents[i].timestamp_ns);
+                    if (debounce(source, timestampNs, lineEvents[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE)) {
+                        ++accepted;
+                        lastNs = timestampNs;
+                    }
+                }
+            } else if (debounce(source, sysfsTimestampNs, sysfsLevel)) {
+                accepted = 1;
+                lastNs = sysfsTimestampNs;
+            }
+            if (accepted == 0) {
+                return;
+            }
+
+            GpioPulseCounter *counter = source.counter.data();
+            counter->lastPulseNs.storeRelease(lastNs);
+            const quint64 before = counter->pulses.fetchAndAddOrdered(accepted);
+            const quint64 target = counter->target.loadAcquire();
+            if (target == 0 || before >= target || before + accepted < target) {
+                return;
+            }
+            reachedPulses = before + accepted;
+        }
+    }
+
+    // 信号在锁外发出，直连的槽函数可以调用removeSource()
+    if (reachedPulses) {
+        emit pulseTargetReached(pin, reachedPulses);
+        return;
+    }
+
+    if (type == CharDevSource) {
+        for (int i = 0; i < eventCount; ++i) {
+            const bool rising = (lineEvents[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE);
+            const qint64 timestampNs = static_cast<qint64>(lineEvents[i].timestamp_ns);
+            if (acceptEvent(pin, timestampNs, rising)) {
+                emit edgeDetected(pin, rising, timestampNs);
+            }
+        }
+    } else if (acceptEvent(pin, sysfsTimestampNs, sysfsLevel)) {
+        emit edgeDetected(pin, sysfsLevel, sysfsTimestampNs);
+    }
+}
+
+bool GpioEventMonitor::acceptEvent(int pin, qint64 timestampNs, bool rising)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_sources.find(pin);
+    if (it == m_sources.end()) {
+        return false;
+    }
+    return debounce(it.value(), timestampNs, rising);
+}
+
+bool GpioEventMonitor::debounce(Source &source, qint64 timestampNs, bool rising)
+{
+    // sysfs在抖动时可能连续报告相同电平
+    if (source.type == SysfsSource && !source.counter && source.lastEventNs != 0
+            && source.lastLevel == rising) {
+        return false;
+    }
+
+    if (source.softDebounceUs > 0 && source.lastEventNs != 0
+            && timestampNs - source.lastEventNs < qint64(source.softDebounceUs) * 1000) {
+        return false;
+    }
+
+    source.lastEventNs = timestampNs;
+    source.lastLevel = rising;
+    return true;
+}
@@ -0,0 +1,341 @@
+#include "hardware/gpio_line_io.h"
+#include "config/gpio_config.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <string.h>
+#include <time.h>
+
+// ==================== 内核实现 ====================
+
+int KernelGpioLineIo::openChip(int chip)
+{
+    QByteArray path = QString("%1%2").arg(GPIO_CHIP_DEV_PREFIX).arg(chip).toLocal8Bit();
+    return ::open(path.constData(), O_RDWR | O_CLOEXEC);
+}
+
+int KernelGpioLineIo::requestLines(int chipFd, struct gpio_v2_line_request *request)
+{
+    return ::ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, request);
+}
+
+int KernelGpioLineIo::setValues(int requestFd, struct gpio_v2_line_values *values)
+{
+    return ::ioctl(requestFd, GPIO_V2_LINE_SET_VALUES_IOCTL, values);
+}
+
+int KernelGpioLineIo::getValues(int requestFd, struct gpio_v2_line_values *values)
+{
+    return ::ioctl(requestFd, GPIO_V2_LINE_GET_VALUES_IOCTL, values);
+}
+
+int KernelGpioLineIo::setConfig(int requestFd, struct gpio_v2_line_config *config)
+{
+    return ::ioctl(requestFd, GPIO_V2_LINE_SET_CONFIG_IOCTL, config);
+}
+
+void KernelGpioLineIo::closeFd(int fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+// ==================== 进程内模拟实现 ====================
+
+SimulatedGpioLineIo::SimulatedGpioLineIo(int chipCount, int linesPerChip)
+    : m_chipCount(chipCount)
+    , m_linesPerChip(linesPerChip)
+    , m_nextFd(1000) // 与真实fd区分
+    , m_ioctlCount(0)
+{
+}
+
+int SimulatedGpioLineIo::openChip(int chip)
+{
+    if (chip < 0 || chip >= m_chipCount) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    Handle handle;
+    handle.chip = chip;
+    handle.isRequest = false;
+    handle.outputMask = 0;
+    handle.edgeFlags = 0;
+    handle.eventWriteFd = -1;
+    handle.seqno = 0;
+
+    int fd = m_nextFd++;
+    m_handles.insert(fd, handle);
+    return fd;
+}
+
+int SimulatedGpioLineIo::requestLines(int chipFd, struct gpio_v2_line_request *request)
+{
+    countIoctl(GPIO_V2_GET_LINE_IOCTL);
+
+    auto it = m_handles.find(chipFd);
+    if (it == m_handles.end() || it.value().isRequest) {
+        errno = EBADF;
+        return -1;
+    }
+    if (request->num_lines == 0 || request->num_lines > GPIO_V2_LINES_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    const int chip = it.value().chip;
+    quint64 requested = m_requestedLines.value(chip, 0);
+
+    // 校验线路偏移并检查占用
+    quint64 newLines = 0;
+    for (quint32 i = 0; i < request->num_lines; ++i) {
+        int offset = static_cast<int>(request->offsets[i]);
+        if (offset < 0 || offset >= m_linesPerChip) {
+            errno = EINVAL;
+            return -1;
+        }
+        quint64 bit = quint64(1) << offset;
+        if ((requested & bit) || (newLines & bit)) {
+            errno = EBUSY;
+            return -1;
+        }
+        newLines |= bit;
+    }
+
+    QVector<int> offsets;
+    for (quint32 i = 0; i < request->num_lines; ++i) {
+        offsets.append(static_cast<int>(request->offsets[i]));
+    }
+    const quint64 outputMask = outputMaskOf(request->config, offsets.size());
+    applyOutputValues(chip, request->config, offsets, outputMask);
+    m_requestedLines[chip] = requested | newLines;
+
+    Handle handle;
+    handle.chip = chip;
+    handle.isRequest = true;
+    handle.outputMask = outputMask;
+    handle.edgeFlags = request->config.flags
+            & (GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING);
+    handle.eventWriteFd = -1;
+    handle.seqno = 0;
+    handle.offsets = offsets;
+
+    int fd;
+    if (handle.edgeFlags) {
+        // 边沿请求使用真实管道，读端可被epoll等待
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) < 0) {
+            m_requestedLines[chip] = requested;
+            return -1;
+        }
+        fd = pipeFds[0];
+        handle.eventWriteFd = pipeFds[1];
+    } else {
+        fd = m_nextFd++;
+    }
+    m_handles.insert(fd, handle);
+    request->fd = fd;
+    return 0;
+}
+
+int SimulatedGpioLineIo::setValues(int requestFd, struct gpio_v2_line_values *values)
+{
+    countIoctl(GPIO_V2_LINE_SET_VALUES_IOCTL);
+
+    auto it = m_handles.find(requestFd);
+    if (it == m_handles.end() || !it.value().isRequest) {
+        errno = EBADF;
+        return -1;
+    }
+
+    const Handle &handle = it.value();
+    if (values->mask & ~handle.outputMask) {
+        errno = EPERM; // 内核拒绝写入输入线路
+        return -1;
+    }
+
+    quint64 levels = m_levels.value(handle.chip, 0);
+    for (int i = 0; i < handle.offsets.size(); ++i) {
+        quint64 indexBit = quint64(1) << i;
+        if (!(values->mask & indexBit)) {
+            continue;
+        }
+        quint64 lineBit = quint64(1) << handle.offsets.at(i);
+        if (values->bits & indexBit) {
+            levels |= lineBit;
+        } else {
+            levels &= ~lineBit;
+        }
+    }
+    m_levels[handle.chip] = levels;
+    return 0;
+}
+
+int SimulatedGpioLineIo::getValues(int requestFd, struct gpio_v2_line_values *values)
+{
+    countIoctl(GPIO_V2_LINE_GET_VALUES_IOCTL);
+
+    auto it = m_handles.find(requestFd);
+    if (it == m_handles.end() || !it.value().isRequest) {
+        errno = EBADF;
+        return -1;
+    }
+
+    const Handle &handle = it.value();
+    const quint64 levels = m_levels.value(handle.chip, 0);
+    quint64 bits = 0;
+    for (int i = 0; i < handle.offsets.size(); ++i) {
+        quint64 indexBit = quint64(1) << i;
+        if ((values->mask & indexBit) && (levels & (quint64(1) << handle.offsets.at(i)))) {
+            bits |= indexBit;
+        }
+    }
+    values->bits = bits;
+    return 0;
+}
+
+int SimulatedGpioLineIo::setConfig(int requestFd, struct gpio_v2_line_config *config)
+{
+    countIoctl(GPIO_V2_LINE_SET_CONFIG_IOCTL);
+
+    auto it = m_handles.find(requestFd);
+    if (it == m_handles.end() || !it.value().isRequest) {
+        errno = EBADF;
+        return -1;
+    }
+
+    // 线路保持占用，只更新方向与输出值
+    Handle &handle = it.value();
+    handle.outputMask = outputMaskOf(*config, handle.offsets.size());
+    applyOutputValues(handle.chip, *config, handle.offsets, handle.outputMask);
+    return 0;
+}
+
+void SimulatedGpioLineIo::countIoctl(unsigned long request)
+{
+    m_ioctlCount++;
+    m_ioctlCounts[request]++;
+}
+
+quint64 SimulatedGpioLineIo::outputMaskOf(const struct gpio_v2_line_config &config, int numLines)
+{
+    // 解析方向：全局flags加上按线路掩码的FLAGS属性
+    quint64 outputMask = 0;
+    for (int i = 0; i < numLines; ++i) {
+        quint64 flags = config.flags;
+        for (quint32 a = 0; a < config.num_attrs; ++a) {
+            const struct gpio_v2_line_config_attribute &attr = config.attrs[a];
+            if (attr.attr.id == GPIO_V2_LINE_ATTR_ID_FLAGS && (attr.mask & (quint64(1) << i))) {
+                flags = attr.attr.flags;
+            }
+        }
+        if (flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+            outputMask |= quint64(1) << i;
+        }
+    }
+    return outputMask;
+}
+
+void SimulatedGpioLineIo::applyOutputValues(int chip, const struct gpio_v2_line_config &config,
+                                            const QVector<int> &offsets, quint64 outputMask)
+{
+    quint64 levels = m_levels.value(chip, 0);
+    for (quint32 a = 0; a < config.num_attrs; ++a) {
+        const struct gpio_v2_line_config_attribute &attr = config.attrs[a];
+        if (attr.attr.id != GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES) {
+            continue;
+        }
+        for (int i = 0; i < offsets.size(); ++i) {
+            quint64 indexBit = quint64(1) << i;
+            if ((attr.mask & indexBit) && (outputMask & indexBit)) {
+                quint64 lineBit = quint64(1) << offsets.at(i);
+                if (attr.attr.values & indexBit) {
+                    levels |= lineBit;
+                } else {
+                    levels &= ~lineBit;
+                }
+            }
+        }
+    }
+    m_levels[chip] = levels;
+}
+
+void SimulatedGpioLineIo::closeFd(int fd)
+{
+    auto it = m_handles.find(fd);
+    if (it == m_handles.end()) {
+        return;
+    }
+
+    // 释放线路请求占用的线路
+    if (it.value().isRequest) {
+        quint64 requested = m_requestedLines.value(it.value().chip, 0);
+        for (int offset : it.value().offsets) {
+            requested &= ~(quint64(1) << offset);
+        }
+        m_requestedLines[it.value().chip] = requested;
+    }
+
+    if (it.value().eventWriteFd >= 0) {
+        ::close(it.value().eventWriteFd);
+        ::close(fd);
+    }
+
+    m_handles.erase(it);
+}
+
+bool SimulatedGpioLineIo::lineLevel(int chip, int offset) const
+{
+    return m_levels.value(chip, 0) & (quint64(1) << offset);
+}
+
+bool SimulatedGpioLineIo::isLineRequested(int chip, int offset) const
+{
+    return m_requestedLines.value(chip, 0) & (quint64(1) << offset);
+}
+
+bool SimulatedGpioLineIo::injectEdge(int chip, int offset, bool rising)
+{
+    if (chip < 0 || chip >= m_chipCount || offset < 0 || offset >= m_linesPerChip) {
+        return false;
+    }
+
+    const quint64 lineBit = quint64(1) << offset;
+    quint64 levels = m_levels.value(chip, 0);
+    if (bool(levels & lineBit) == rising) {
+        return false; // 电平未变化，没有边沿
+    }
+    m_levels[chip] = rising ? (levels | lineBit) : (levels & ~lineBit);
+
+    for (auto it = m_handles.begin(); it != m_handles.end(); ++it) {
+        Handle &handle = it.value();
+        if (handle.chip != chip || handle.eventWriteFd < 0 || !handle.offsets.contains(offset)) {
+            continue;
+        }
+
+        const quint64 wanted = rising ? GPIO_V2_LINE_FLAG_EDGE_RISING : GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        if (!(handle.edgeFlags & wanted)) {
+            return true;
+        }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        struct gpio_v2_line_event event;
+        memset(&event, 0, sizeof(event));
+        event.timestamp_ns = quint64(ts.tv_sec) * 1000000000ULL + quint64(ts.tv_nsec);
+        event.id = rising ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+        event.offset = static_cast<quint32>(offset);
+        event.seqno = ++handle.seqno;
+        event.line_seqno = handle.seqno;
+        return ::write(handle.eventWriteFd, &event, sizeof(event)) == sizeof(event);
+    }
+    return true;
+}
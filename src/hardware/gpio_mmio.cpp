@@ -0,0 +1,122 @@
+#include "hardware/gpio_mmio.h"
+
+#include <QDebug>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const quint32 GPIO_MMIO_BASES[GPIO_MMIO_BANK_COUNT] = GPIO_MMIO_BANK_BASES;
+
+GpioMmio::GpioMmio(const QString &source)
+    : m_source(source)
+    , m_fd(-1)
+    , m_fileBacked(false)
+    , m_pageSize(sysconf(_SC_PAGESIZE))
+{
+    for (int chip = 0; chip < GPIO_MMIO_BANK_COUNT; ++chip) {
+        m_maps[chip] = MAP_FAILED;
+        m_banks[chip] = nullptr;
+    }
+}
+
+GpioMmio::~GpioMmio()
+{
+    close();
+}
+
+bool GpioMmio::open()
+{
+    if (isOpen()) {
+        return true;
+    }
+
+    const QByteArray path = m_source.toLocal8Bit();
+    int fd = ::open(path.constData(), O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) {
+        m_lastError = QString("无法打开%1: %2").arg(m_source).arg(strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        m_lastError = QString("无法获取%1状态: %2").arg(m_source).arg(strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    // 普通文件：各bank依次占用一页，文件不足时扩展
+    m_fileBacked = S_ISREG(st.st_mode);
+    const off_t fileSize = off_t(m_pageSize) * GPIO_MMIO_BANK_COUNT;
+    if (m_fileBacked && st.st_size < fileSize && ftruncate(fd, fileSize) < 0) {
+        m_lastError = QString("无法扩展映射文件%1: %2").arg(m_source).arg(strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    for (int chip = 0; chip < GPIO_MMIO_BANK_COUNT; ++chip) {
+        const off_t base = m_fileBacked ? off_t(m_pageSize) * chip : off_t(GPIO_MMIO_BASES[chip]);
+        const off_t pageBase = base & ~off_t(m_pageSize - 1);
+
+        m_maps[chip] = mmap(nullptr, m_pageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, pageBase);
+        if (m_maps[chip] == MAP_FAILED) {
+            m_lastError = QString("GPIO%1寄存器映射失败: %2").arg(chip).arg(strerror(errno));
+            m_fd = fd;
+            close();
+            return false;
+        }
+        m_banks[chip] = reinterpret_cast<volatile quint32 *>(static_cast<char *>(m_maps[chip]) + (base - pageBase));
+    }
+
+    m_fd = fd;
+    qDebug() << QString("GPIO寄存器已映射: %1%2").arg(m_source).arg(m_fileBacked ? "（文件测试模式）" : "");
+    return true;
+}
+
+void GpioMmio::close()
+{
+    for (int chip = 0; chip < GPIO_MMIO_BANK_COUNT; ++chip) {
+        if (m_maps[chip] != MAP_FAILED) {
+            munmap(m_maps[chip], m_pageSize);
+            m_maps[chip] = MAP_FAILED;
+        }
+        m_banks[chip] = nullptr;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void GpioMmio::writeBank(int chip, quint32 mask, quint32 levels)
+{
+    // 低16位与高16位线路各一次存储，掩码为0的半边不写
+    const quint32 lowMask = mask & 0xFFFF;
+    const quint32 highMask = mask >> 16;
+    if (lowMask) {
+        *reg(chip, GPIO_MMIO_SWPORT_DR_L) = (lowMask << 16) | (levels & lowMask);
+    }
+    if (highMask) {
+        *reg(chip, GPIO_MMIO_SWPORT_DR_H) = (highMask << 16) | ((levels >> 16) & highMask);
+    }
+}
+
+bool GpioMmio::read(int pin) const
+{
+    const int line = pin % GPIO_LINES_PER_CHIP;
+    return (*reg(pin / GPIO_LINES_PER_CHIP, GPIO_MMIO_EXT_PORT) >> line) & 1u;
+}
+
+quint32 GpioMmio::registerValue(int chip, int offset) const
+{
+    return *reg(chip, offset);
+}
+
+bool GpioMmio::isValidPin(int pin)
+{
+    return pin >= 0 && pin < GPIO_MMIO_BANK_COUNT * GPIO_LINES_PER_CHIP;
+}
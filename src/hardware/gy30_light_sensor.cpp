@@ -71,6 +71,7 @@ void GY30LightSensor::readSensorData()
             m_currentLux = lux;
             emit luxValueChanged(lux);
         }
+        emit luxSampled(lux, false);
     } else {
         // 硬件不可用时生成模拟数据
         static int counter = 0;
@@ -84,6 +85,7 @@ void GY30LightSensor::readSensorData()
             emit luxValueChanged(simulatedLux);
             qDebug() << "GY30传感器使用模拟数据:" << simulatedLux << "lx";
         }
+        emit luxSampled(simulatedLux, true);
     }
 }
 
@@ -0,0 +1,137 @@
+#include "hardware/motion_profile.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+static_assert(MOTION_RAMP_STEPS > 1, "加速段至少需要两步");
+
+static constexpr int RAMP_COMMON_SPEEDS[] = MOTION_RAMP_COMMON_SPEEDS;
+static constexpr int RAMP_COMMON_SPEED_COUNT = int(sizeof(RAMP_COMMON_SPEEDS) / sizeof(RAMP_COMMON_SPEEDS[0]));
+
+// 编译期可用的平方根（牛顿迭代）
+static constexpr double rampSqrt(double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    double root = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; ++i) {
+        root = 0.5 * (root + x / root);
+    }
+    return root;
+}
+
+// 加速段第step步的步频：梯形曲线速度平方随位置线性增长（匀加速），
+// S形曲线速度按smoothstep增长，起止两端加速度为零
+static constexpr double rampSpeed(int step, int cruiseSps, int shape)
+{
+    const double start = MOTION_RAMP_START_SPS;
+    const double cruise = cruiseSps;
+    const double x = double(step) / (MOTION_RAMP_STEPS - 1);
+    if (shape == MOTION_PROFILE_SCURVE) {
+        return start + (cruise - start) * x * x * (3.0 - 2.0 * x);
+    }
+    return rampSqrt(start * start + (cruise * cruise - start * start) * x);
+}
+
+static constexpr quint32 rampHalfPeriodNs(int step, int cruiseSps, int shape)
+{
+    return quint32(500000000.0 / rampSpeed(step, cruiseSps, shape) + 0.5);
+}
+
+// 常用步频的加速表，[曲线][步频][步]
+struct RampBank {
+    quint32 halfPeriodNs[2][RAMP_COMMON_SPEED_COUNT][MOTION_RAMP_STEPS];
+};
+
+static constexpr RampBank makeRampBank()
+{
+    RampBank bank{};
+    for (int shape = 0; shape < 2; ++shape) {
+        for (int speed = 0; speed < RAMP_COMMON_SPEED_COUNT; ++speed) {
+            for (int step = 0; step < MOTION_RAMP_STEPS; ++step) {
+                bank.halfPeriodNs[shape][speed][step] = rampHalfPeriodNs(step, RAMP_COMMON_SPEEDS[speed], shape);
+            }
+        }
+    }
+    return bank;
+}
+
+static constexpr RampBank RAMP_BANK = makeRampBank();
+
+MotionProfile::MotionProfile()
+    : m_steps(0)
+    , m_stepsPerSecond(0)
+    , m_shape(Trapezoid)
+    , m_ramp(nullptr)
+    , m_rampLength(0)
+    , m_cruiseHalfPeriodNs(0)
+    , m_precomputed(false)
+{
+}
+
+MotionProfile MotionProfile::plan(quint64 steps, int stepsPerSecond, Shape shape)
+{
+    MotionProfile profile;
+    profile.m_steps = steps;
+    profile.m_stepsPerSecond = stepsPerSecond;
+    profile.m_shape = shape;
+    if (stepsPerSecond <= 0) {
+        return profile;
+    }
+
+    profile.m_cruiseHalfPeriodNs = 500000000LL / stepsPerSecond;
+    profile.m_ramp = rampTable(stepsPerSecond, shape, &profile.m_precomputed);
+    if (!profile.m_ramp) {
+        return profile;
+    }
+
+    profile.m_rampLength = MOTION_RAMP_STEPS;
+    if (steps > 0 && steps < quint64(2 * MOTION_RAMP_STEPS)) {
+        // 行程不足以加速到巡航步频：加速到一半行程即开始减速
+        profile.m_rampLength = int(steps / 2);
+        if (profile.m_rampLength == 0) {
+            profile.m_ramp = nullptr;
+            profile.m_cruiseHalfPeriodNs = 500000000LL / MOTION_RAMP_START_SPS;
+            return profile;
+        }
+        profile.m_cruiseHalfPeriodNs = profile.m_ramp[profile.m_rampLength - 1];
+    }
+    return profile;
+}
+
+const quint32 *MotionProfile::rampTable(int stepsPerSecond, Shape shape, bool *precomputed)
+{
+    if (precomputed) {
+        *precomputed = false;
+    }
+    if (stepsPerSecond <= MOTION_RAMP_START_SPS) {
+        return nullptr;
+    }
+
+    const int shapeIndex = (shape == SCurve) ? 1 : 0;
+    for (int speed = 0; speed < RAMP_COMMON_SPEED_COUNT; ++speed) {
+        if (RAMP_COMMON_SPEEDS[speed] == stepsPerSecond) {
+            if (precomputed) {
+                *precomputed = true;
+            }
+            return RAMP_BANK.halfPeriodNs[shapeIndex][speed];
+        }
+    }
+
+    // 非常用步频：首次使用时生成，缓存不释放，返回的指针始终有效
+    static QMutex cacheMutex;
+    static QMap<int, QVector<quint32>> *cache = new QMap<int, QVector<quint32>>();
+
+    QMutexLocker locker(&cacheMutex);
+    QVector<quint32> &table = (*cache)[stepsPerSecond * 2 + shapeIndex];
+    if (table.isEmpty()) {
+        table.resize(MOTION_RAMP_STEPS);
+        for (int step = 0; step < MOTION_RAMP_STEPS; ++step) {
+            table[step] = rampHalfPeriodNs(step, stepsPerSecond, shapeIndex);
+        }
+    }
+    return table.constData();
+}
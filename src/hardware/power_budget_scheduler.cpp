@@ -0,0 +1,253 @@
+#include "hardware/power_budget_scheduler.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QTimer>
+
+#include <algorithm>
+#include <time.h>
+
+PowerBudgetScheduler::PowerBudgetScheduler(int budgetMa, QObject *parent)
+    : QObject(parent)
+    , m_budgetMa(budgetMa)
+    , m_peakDrawMa(0)
+    , m_nextTicket(0)
+    , m_retryTimer(new QTimer(this))
+{
+    m_retryTimer->setSingleShot(true);
+    m_retryTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_retryTimer, &QTimer::timeout, this, &PowerBudgetScheduler::processQueue);
+}
+
+qint64 PowerBudgetScheduler::monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void PowerBudgetScheduler::registerLoad(int loadId, const QString &name, int inrushMa, int steadyMa, int inrushMs)
+{
+    Load load;
+    load.name = name;
+    load.inrushMa = qMax(inrushMa, steadyMa);
+    load.steadyMa = steadyMa;
+    load.inrushNs = qint64(qMax(inrushMs, 0)) * 1000000LL;
+
+    QMutexLocker locker(&m_mutex);
+    m_loads.insert(loadId, load);
+}
+
+void PowerBudgetScheduler::setBudget(int budgetMa)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_budgetMa = budgetMa;
+    }
+    QMetaObject::invokeMethod(this, [this]() { processQueue(); }, Qt::QueuedConnection);
+}
+
+int PowerBudgetScheduler::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budgetMa;
+}
+
+bool PowerBudgetScheduler::tryAcquire(int loadId, qint64 requestedNs, qint64 *retryAtNs)
+{
+    const qint64 nowNs = monotonicNs();
+    qint64 waitUs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 未登记的负载不计入预算；已通电的负载重复申请不增加电流
+        auto load = m_loads.constFind(loadId);
+        if (load != m_loads.constEnd() && !m_active.contains(loadId)) {
+            if (!fitsLocked(load.value(), nowNs, retryAtNs)) {
+                return false;
+            }
+            m_peakDrawMa = qMax(m_peakDrawMa, drawAtLocked(nowNs) + load.value().inrushMa);
+            m_active.insert(loadId, nowNs);
+        }
+
+        waitUs = requestedNs > 0 ? qMax<qint64>(0, (nowNs - requestedNs) / 1000) : 0;
+        recordLocked(loadId, waitUs);
+    }
+
+    emit admitted(loadId, waitUs);
+    return true;
+}
+
+quint64 PowerBudgetScheduler::submit(int loadId, const std::function<bool()> &start)
+{
+    Request request;
+    request.ticket = ++m_nextTicket;
+    request.loadId = loadId;
+    request.start = start;
+    request.requestedNs = monotonicNs();
+    request.deferred = false;
+    m_queue.append(request);
+
+    processQueue();
+    return request.ticket;
+}
+
+bool PowerBudgetScheduler::cancel(quint64 ticket)
+{
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue.at(i).ticket != ticket) {
+            continue;
+        }
+        const int loadId = m_queue.at(i).loadId;
+        m_queue.removeAt(i);
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stats[loadId].cancelled++;
+            m_total.cancelled++;
+        }
+        // 队首被取消后其后的申请可能已能准入
+        QMetaObject::invokeMethod(this, [this]() { processQueue(); }, Qt::QueuedConnection);
+        return true;
+    }
+    return false;
+}
+
+void PowerBudgetScheduler::cancelAll(int loadId)
+{
+    for (int i = m_queue.size() - 1; i >= 0; --i) {
+        if (m_queue.at(i).loadId == loadId) {
+            cancel(m_queue.at(i).ticket);
+        }
+    }
+}
+
+void PowerBudgetScheduler::release(int loadId)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_active.remove(loadId) == 0) {
+            return;
+        }
+    }
+
+    // 可能在监视线程或调度线程中调用，排队的申请回到调度器所在线程处理
+    QMetaObject::invokeMethod(this, [this]() { processQueue(); }, Qt::QueuedConnection);
+}
+
+int PowerBudgetScheduler::currentDrawMa() const
+{
+    QMutexLocker locker(&m_mutex);
+    return drawAtLocked(monotonicNs());
+}
+
+int PowerBudgetScheduler::peakDrawMa() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_peakDrawMa;
+}
+
+PowerBudgetScheduler::Statistics PowerBudgetScheduler::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_total;
+}
+
+PowerBudgetScheduler::Statistics PowerBudgetScheduler::statistics(int loadId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats.value(loadId);
+}
+
+QString PowerBudgetScheduler::loadName(int loadId) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto load = m_loads.constFind(loadId);
+    return load != m_loads.constEnd() ? load.value().name : QString("GPIO引脚%1").arg(loadId);
+}
+
+int PowerBudgetScheduler::drawAtLocked(qint64 atNs) const
+{
+    int drawMa = 0;
+    for (auto it = m_active.constBegin(); it != m_active.constEnd(); ++it) {
+        auto load = m_loads.constFind(it.key());
+        if (load == m_loads.constEnd()) {
+            continue;
+        }
+        drawMa += (atNs < it.value() + load.value().inrushNs) ? load.value().inrushMa : load.value().steadyMa;
+    }
+    return drawMa;
+}
+
+bool PowerBudgetScheduler::fitsLocked(const Load &load, qint64 nowNs, qint64 *retryAtNs) const
+{
+    if (retryAtNs) {
+        *retryAtNs = 0;
+    }
+
+    // 已通电负载的电流只会随浪涌结束而下降，检查当前时刻即可覆盖新负载的整个浪涌期
+    if (m_active.isEmpty() || drawAtLocked(nowNs) + load.inrushMa <= m_budgetMa) {
+        return true;
+    }
+
+    // 依次检查各负载浪涌结束的时刻，最早满足预算者即为错开后的通电时刻
+    QList<qint64> inrushEnds;
+    for (auto it = m_active.constBegin(); it != m_active.constEnd(); ++it) {
+        auto other = m_loads.constFind(it.key());
+        if (other != m_loads.constEnd() && it.value() + other.value().inrushNs > nowNs) {
+            inrushEnds.append(it.value() + other.value().inrushNs);
+        }
+    }
+    std::sort(inrushEnds.begin(), inrushEnds.end());
+    for (qint64 endNs : inrushEnds) {
+        if (drawAtLocked(endNs) + load.inrushMa <= m_budgetMa) {
+            if (retryAtNs) {
+                *retryAtNs = endNs;
+            }
+            return false;
+        }
+    }
+    return false; // 稳态电流已无余量，等待断电
+}
+
+void PowerBudgetScheduler::recordLocked(int loadId, qint64 waitUs)
+{
+    Statistics *stats[] = { &m_stats[loadId], &m_total };
+    for (Statistics *s : stats) {
+        s->requests++;
+        if (waitUs > 0) {
+            s->delayed++;
+        } else {
+            s->immediate++;
+        }
+        s->totalWaitUs += waitUs;
+        s->maxWaitUs = qMax(s->maxWaitUs, waitUs);
+    }
+}
+
+void PowerBudgetScheduler::processQueue()
+{
+    m_retryTimer->stop();
+
+    // 严格按提交顺序准入，队首无法准入时后续申请继续等待，避免大负载被小负载饿死
+    while (!m_queue.isEmpty()) {
+        const Request request = m_queue.first();
+        qint64 retryAtNs = 0;
+        if (!tryAcquire(request.loadId, request.deferred ? request.requestedNs : 0, &retryAtNs)) {
+            m_queue.first().deferred = true;
+            if (retryAtNs > 0) {
+                const qint64 delayMs = (retryAtNs - monotonicNs() + 999999) / 1000000;
+                m_retryTimer->start(int(qMax<qint64>(1, delayMs)));
+                qDebug() << QString("供电预算：%1错开%2ms通电").arg(loadName(request.loadId)).arg(delayMs);
+            } else {
+                qDebug() << QString("供电预算：%1排队等待其它负载断电（当前%2mA）")
+                            .arg(loadName(request.loadId)).arg(currentDrawMa());
+            }
+            return;
+        }
+
+        m_queue.removeFirst();
+        if (!request.start()) {
+            release(request.loadId);
+        }
+    }
+}
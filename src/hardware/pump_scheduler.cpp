@@ -0,0 +1,403 @@
+#include "hardware/pump_scheduler.h"
+#include "hardware/gpio_controller.h"
+#include "hardware/power_budget_scheduler.h"
+#include "system/state_journal.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 泵调度线程
+ *
+ * 尝试切换为SCHED_FIFO实时调度，权限不足时保持普通调度并给出警告
+ */
+class PumpSchedulerThread : public QThread
+{
+public:
+    explicit PumpSchedulerThread(PumpScheduler *scheduler) : m_scheduler(scheduler) {}
+
+protected:
+    void run() override
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = PUMP_SCHEDULER_RT_PRIORITY;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            qWarning() << "泵调度线程无法启用实时调度:" << strerror(result);
+        }
+        m_scheduler->runLoop();
+    }
+
+private:
+    PumpScheduler *m_scheduler;
+};
+
+PumpScheduler::PumpScheduler(GPIOController *controller, QObject *parent)
+    : QObject(parent)
+    , m_gpioController(controller)
+    , m_powerScheduler(nullptr)
+    , m_stateJournal(nullptr)
+    , m_timerFd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_thread(nullptr)
+    , m_nextJobId(1)
+{
+}
+
+PumpScheduler::~PumpScheduler()
+{
+    stop();
+}
+
+qint64 PumpScheduler::monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+bool PumpScheduler::start()
+{
+    if (m_thread) {
+        return true;
+    }
+
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_timerFd < 0 || m_wakeFd < 0) {
+        emit errorOccurred(QString("泵调度器创建失败: %1").arg(strerror(errno)));
+        stop();
+        return false;
+    }
+
+    m_stopping.storeRelease(0);
+    m_thread = new PumpSchedulerThread(this);
+    m_thread->start(QThread::TimeCriticalPriority);
+    qDebug() << "泵定时调度线程已启动";
+
+    resumeFromJournal();
+    return true;
+}
+
+void PumpScheduler::resumeFromJournal()
+{
+    if (!m_stateJournal) {
+        return;
+    }
+
+    // 截止时刻为墙上时间，重启期间的停机时间从剩余时长中扣除；时钟回拨时不超过原请求时长
+    const qint64 nowMs = StateJournal::wallMs();
+    for (int pumpPin : m_stateJournal->keys(StateJournal::PumpDeadline)) {
+        StateJournal::Entry entry;
+        if (!m_stateJournal->lookup(StateJournal::PumpDeadline, pumpPin, &entry) || entry.value <= nowMs) {
+            continue;
+        }
+        const int remainingMs = int(qMin(entry.value - nowMs, qMax<qint64>(entry.aux, 1)));
+        if (schedule(pumpPin, remainingMs) > 0) {
+            qDebug() << QString("GPIO引脚%1继续重启前的定时运行，剩余%2ms").arg(pumpPin).arg(remainingMs);
+        }
+    }
+}
+
+void PumpScheduler::stop()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        wake();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_timerFd >= 0) {
+        close(m_timerFd);
+        m_timerFd = -1;
+    }
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+}
+
+bool PumpScheduler::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+int PumpScheduler::schedule(int pumpPin, int durationMs, qint64 startAtNs)
+{
+    if (durationMs <= 0) {
+        emit errorOccurred("泵运行时长必须大于0");
+        return -1;
+    }
+
+    Job job;
+    job.pumpPin = pumpPin;
+    job.startNs = (startAtNs > 0) ? startAtNs : monotonicNs();
+    job.durationNs = qint64(durationMs) * 1000000LL;
+
+    int jobId;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 同一个泵的任务时间段不能重叠，否则先结束的任务会提前关泵
+        for (auto it = m_jobs.constBegin(); it != m_jobs.constEnd(); ++it) {
+            const Job &other = it.value();
+            if (other.pumpPin != pumpPin || other.cancelled) {
+                continue;
+            }
+            const qint64 otherStart = other.actualStartNs ? other.actualStartNs : other.startNs;
+            if (job.startNs < otherStart + other.durationNs && otherStart < job.startNs + job.durationNs) {
+                locker.unlock();
+                emit errorOccurred(QString("GPIO引脚%1定时任务与任务%2时间重叠").arg(pumpPin).arg(it.key()));
+                return -1;
+            }
+        }
+
+        jobId = m_nextJobId++;
+        m_jobs.insert(jobId, job);
+    }
+
+    wake();
+    return jobId;
+}
+
+int PumpScheduler::scheduleIn(int pumpPin, int durationMs, int delayMs)
+{
+    return schedule(pumpPin, durationMs, monotonicNs() + qint64(qMax(delayMs, 0)) * 1000000LL);
+}
+
+bool PumpScheduler::cancel(int jobId)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_jobs.find(jobId);
+        if (it == m_jobs.end()) {
+            return false;
+        }
+        it.value().cancelled = true;
+    }
+
+    wake();
+    return true;
+}
+
+void PumpScheduler::cancelAll(int pumpPin)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+            if (it.value().pumpPin == pumpPin) {
+                it.value().cancelled = true;
+            }
+        }
+    }
+
+    wake();
+}
+
+void PumpScheduler::wake()
+{
+    if (m_wakeFd < 0) {
+        return;
+    }
+    quint64 one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        qWarning() << "泵调度线程唤醒失败:" << strerror(errno);
+    }
+}
+
+void PumpScheduler::armTimer()
+{
+    qint64 deadline = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_jobs.constBegin(); it != m_jobs.constEnd(); ++it) {
+            const Job &job = it.value();
+            qint64 due;
+            if (job.cancelled) {
+                due = 1; // 立即处理
+            } else if (job.actualStartNs) {
+                due = job.actualStartNs + job.durationNs;
+            } else {
+                due = job.dueNs();
+            }
+            if (deadline == 0 || due < deadline) {
+                deadline = due;
+            }
+        }
+    }
+
+    // 绝对时间定时，已过期的时间点立即触发；全零表示停止定时
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (deadline > 0) {
+        spec.it_value.tv_sec = deadline / 1000000000LL;
+        spec.it_value.tv_nsec = deadline % 1000000000LL;
+    }
+    if (timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        qWarning() << "泵调度定时器设置失败:" << strerror(errno);
+    }
+}
+
+void PumpScheduler::runLoop()
+{
+    struct pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_stopping.loadAcquire()) {
+        armTimer();
+
+        int count = poll(fds, 2, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "泵调度等待失败:" << strerror(errno);
+            break;
+        }
+
+        quint64 value;
+        if ((fds[0].revents & POLLIN) && read(m_timerFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "泵调度定时器读取失败:" << strerror(errno);
+        }
+        if ((fds[1].revents & POLLIN) && read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "泵调度唤醒读取失败:" << strerror(errno);
+        }
+
+        processDueJobs();
+    }
+
+    // 退出前关闭仍在运行的泵
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+            it.value().cancelled = true;
+        }
+    }
+    processDueJobs();
+}
+
+void PumpScheduler::processDueJobs()
+{
+    struct Action {
+        int jobId;
+        Job job;
+    };
+    QList<Action> stops;
+    QList<Action> starts;
+
+    const qint64 now = monotonicNs();
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_jobs.constBegin(); it != m_jobs.constEnd(); ++it) {
+            const Job &job = it.value();
+            Action action;
+            action.jobId = it.key();
+            action.job = job;
+            if (job.cancelled || (job.actualStartNs && job.actualStartNs + job.durationNs <= now)) {
+                stops.append(action);
+            } else if (!job.actualStartNs && job.dueNs() <= now) {
+                starts.append(action);
+            }
+        }
+        for (const Action &action : stops) {
+            m_jobs.remove(action.jobId);
+        }
+    }
+
+    // 先关后开，同一泵首尾相接的任务不会被提前关闭
+    for (const Action &action : stops) {
+        const Job &job = action.job;
+        if (!job.actualStartNs) {
+            // 尚未开启即被取消
+            emit jobFinished(action.jobId, job.pumpPin, job.durationNs / 1000, 0, true);
+            continue;
+        }
+
+        qint64 doneNs = 0;
+        if (!switchPump(job.pumpPin, false, doneNs)) {
+            emit errorOccurred(QString("GPIO引脚%1定时关闭失败").arg(job.pumpPin));
+        }
+        if (m_powerScheduler) {
+            m_powerScheduler->release(job.pumpPin);
+        }
+        if (m_stateJournal) {
+            m_stateJournal->record(StateJournal::PumpDeadline, job.pumpPin, 0);
+        }
+        const qint64 actualUs = (doneNs - job.actualStartNs) / 1000;
+        qDebug() << QString("GPIO引脚%1定时运行结束: 请求%2us，实际%3us%4")
+                    .arg(job.pumpPin).arg(job.durationNs / 1000).arg(actualUs)
+                    .arg(job.cancelled ? "（已取消）" : "");
+        emit jobFinished(action.jobId, job.pumpPin, job.durationNs / 1000, actualUs, job.cancelled);
+    }
+
+    for (const Action &action : starts) {
+        const Job &job = action.job;
+
+        // 供电余量不足：推迟到其它负载浪涌结束时，无确定时刻时按固定间隔重试；等待时间从计划时刻算起
+        qint64 retryAtNs = 0;
+        if (m_powerScheduler && !m_powerScheduler->tryAcquire(job.pumpPin, job.admitNs ? job.startNs : 0, &retryAtNs)) {
+            QMutexLocker locker(&m_mutex);
+            m_jobs[action.jobId].admitNs = (retryAtNs > 0) ? retryAtNs
+                                                          : now + qint64(POWER_BUDGET_RETRY_MS) * 1000000LL;
+            continue;
+        }
+
+        qint64 doneNs = 0;
+        const bool switched = switchPump(job.pumpPin, true, doneNs);
+        if (!switched && m_powerScheduler) {
+            m_powerScheduler->release(job.pumpPin);
+        }
+
+        // 任务只在本线程中移除；开启期间被取消的任务在下一轮按取消处理
+        {
+            QMutexLocker locker(&m_mutex);
+            if (switched) {
+                m_jobs[action.jobId].actualStartNs = doneNs; // 关闭时刻以实际开启时刻为基准
+            } else {
+                m_jobs.remove(action.jobId);
+            }
+        }
+
+        if (!switched) {
+            emit errorOccurred(QString("GPIO引脚%1定时开启失败").arg(job.pumpPin));
+            emit jobFinished(action.jobId, job.pumpPin, job.durationNs / 1000, 0, false);
+            continue;
+        }
+        if (m_stateJournal) {
+            const qint64 durationMs = job.durationNs / 1000000;
+            m_stateJournal->record(StateJournal::PumpDeadline, job.pumpPin,
+                                   StateJournal::wallMs() + durationMs, durationMs);
+        }
+        emit jobStarted(action.jobId, job.pumpPin, (doneNs - job.startNs) / 1000);
+    }
+}
+
+bool PumpScheduler::switchPump(int pumpPin, bool on, qint64 &doneNs)
+{
+    bool success = false;
+    if (m_gpioController) {
+        success = m_gpioController->beginTransaction()
+                .setPin(pumpPin, on ? GPIO_HIGH : GPIO_LOW)
+                .commit().success;
+    }
+    doneNs = monotonicNs();
+    return success;
+}
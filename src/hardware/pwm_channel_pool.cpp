@@ -0,0 +1,310 @@
+#include "hardware/pwm_channel_pool.h"
+#include "config/gpio_config.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <time.h>
+
+static const PwmChannelSpec DEFAULT_CHANNELS[] = PWM_CHANNELS;
+static const PwmRecipeSpec DEFAULT_RECIPES[] = PWM_RECIPES;
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+PwmChannelPool::PwmChannelPool(QObject *parent)
+    : QObject(parent)
+{
+    for (const PwmChannelSpec &spec : DEFAULT_CHANNELS) {
+        const QString key = QString::fromUtf8(spec.key);
+        const quint32 addr = address(spec.chip, spec.channel);
+        if (m_keyIndex.contains(key) || m_addressIndex.contains(addr)) {
+            qWarning() << QString("PWM通道配置重复，已忽略: %1 (pwmchip%2/pwm%3)").arg(key).arg(spec.chip).arg(spec.channel);
+            continue;
+        }
+
+        Channel channel;
+        channel.key = key;
+        channel.name = QString::fromUtf8(spec.name);
+        channel.controller = new PWMController(spec.chip, spec.channel, spec.periodNs, spec.inversed != 0, this);
+        connect(channel.controller, &PWMController::errorOccurred, this, [this, key](const QString &error) {
+            emit errorOccurred(QString("%1: %2").arg(key, error));
+        });
+
+        m_keyIndex.insert(key, m_channels.size());
+        m_addressIndex.insert(addr, m_channels.size());
+        m_channels.append(channel);
+    }
+
+    // 配方中的通道标识须在通道表中，百分比须为0-100，按千分比保存
+    for (const PwmRecipeSpec &spec : DEFAULT_RECIPES) {
+        Recipe recipe;
+        recipe.key = QString::fromUtf8(spec.key);
+        recipe.name = QString::fromUtf8(spec.name);
+        bool valid = true;
+        for (const QString &item : QString::fromUtf8(spec.duties).split(",", Qt::SkipEmptyParts)) {
+            const QStringList parts = item.split(":");
+            bool ok = false;
+            const double percent = (parts.size() == 2) ? parts[1].trimmed().toDouble(&ok) : -1.0;
+            const QString key = parts[0].trimmed();
+            if (!ok || percent < 0.0 || percent > 100.0 || !m_keyIndex.contains(key)) {
+                qWarning() << QString("光谱配方%1的通道项无效: %2").arg(recipe.key, item);
+                valid = false;
+                break;
+            }
+            recipe.duties.insert(key, qRound(percent * 10.0));
+        }
+        if (valid && !recipe.duties.isEmpty()) {
+            m_recipes.append(recipe);
+        }
+    }
+
+    qDebug() << QString("PWM通道池创建完成: %1个通道，%2个光谱配方").arg(m_channels.size()).arg(m_recipes.size());
+}
+
+PwmChannelPool::~PwmChannelPool()
+{
+    cleanup();
+}
+
+bool PwmChannelPool::initialize()
+{
+    if (m_channels.isEmpty()) {
+        emit errorOccurred("未配置PWM通道");
+        return false;
+    }
+
+    // 主通道失败时初始化失败；其余通道失败只影响该灯串
+    bool primaryReady = false;
+    int ready = 0;
+    for (int i = 0; i < m_channels.size(); ++i) {
+        const Channel &channel = m_channels[i];
+        if (channel.controller->initialize()) {
+            ready++;
+            primaryReady = primaryReady || (i == 0);
+        } else {
+            qWarning() << QString("PWM通道%1(%2)不可用").arg(channel.key, channel.name);
+        }
+    }
+
+    qDebug() << QString("PWM通道池初始化完成: %1/%2个通道可用").arg(ready).arg(m_channels.size());
+    return primaryReady;
+}
+
+void PwmChannelPool::cleanup()
+{
+    for (const Channel &channel : m_channels) {
+        channel.controller->cleanup();
+    }
+}
+
+bool PwmChannelPool::setSysfsIo(SysfsIo *io)
+{
+    bool ok = true;
+    for (const Channel &channel : m_channels) {
+        ok = channel.controller->setSysfsIo(io) && ok;
+    }
+    return ok;
+}
+
+void PwmChannelPool::setStateJournal(StateJournal *journal)
+{
+    for (const Channel &channel : m_channels) {
+        channel.controller->setStateJournal(journal);
+    }
+}
+
+QStringList PwmChannelPool::channelKeys() const
+{
+    QStringList keys;
+    for (const Channel &channel : m_channels) {
+        keys << channel.key;
+    }
+    return keys;
+}
+
+QString PwmChannelPool::channelName(const QString &key) const
+{
+    const int index = indexOf(key);
+    return (index >= 0) ? m_channels[index].name : QString();
+}
+
+PWMController *PwmChannelPool::channel(const QString &key) const
+{
+    const int index = indexOf(key);
+    return (index >= 0) ? m_channels[index].controller : nullptr;
+}
+
+PWMController *PwmChannelPool::channel(int chip, int channel) const
+{
+    const int index = m_addressIndex.value(address(chip, channel), -1);
+    return (index >= 0) ? m_channels[index].controller : nullptr;
+}
+
+PWMController *PwmChannelPool::primary() const
+{
+    return m_channels.isEmpty() ? nullptr : m_channels.first().controller;
+}
+
+bool PwmChannelPool::isAvailable(const QString &key) const
+{
+    const PWMController *controller = channel(key);
+    return controller && controller->isInitialized();
+}
+
+QMap<QString, int> PwmChannelPool::dutyPermilles() const
+{
+    QMap<QString, int> duties;
+    for (const Channel &channel : m_channels) {
+        if (channel.controller->isInitialized()) {
+            duties.insert(channel.key, channel.controller->getCurrentDutyPermille());
+        }
+    }
+    return duties;
+}
+
+bool PwmChannelPool::checkTargets(const QMap<QString, int> &duties, QList<int> *indexes)
+{
+    bool ok = true;
+    for (auto it = duties.constBegin(); it != duties.constEnd(); ++it) {
+        const int index = indexOf(it.key());
+        if (index < 0) {
+            emit errorOccurred(QString("未配置的PWM通道: %1").arg(it.key()));
+            ok = false;
+        } else if (!m_channels[index].controller->isInitialized()) {
+            emit errorOccurred(QString("PWM通道%1未初始化").arg(it.key()));
+            ok = false;
+        } else {
+            indexes->append(index);
+        }
+    }
+    std::sort(indexes->begin(), indexes->end()); // 按配置表顺序加锁
+    return ok;
+}
+
+bool PwmChannelPool::setDutyPermilles(const QMap<QString, int> &duties)
+{
+    QList<int> indexes;
+    bool ok = checkTargets(duties, &indexes);
+    if (indexes.isEmpty()) {
+        return false;
+    }
+
+    // 全部目标通道加锁后连续写入：取消进行中的渐变，其他线程看不到一半通道已更新的中间状态
+    QVector<int> permilles(indexes.size());
+    QVector<char> written(indexes.size());
+    QVector<char> performed(indexes.size());
+    for (int index : indexes) {
+        m_channels[index].controller->m_dutyMutex.lock();
+    }
+    for (int i = 0; i < indexes.size(); ++i) {
+        const Channel &channel = m_channels[indexes[i]];
+        PWMController *controller = channel.controller;
+        bool channelPerformed = false;
+        permilles[i] = qBound(0, duties.value(channel.key), PWMController::PWM_PERMILLE_FULL);
+        controller->m_fade.active = false;
+        written[i] = controller->writeDutyLocked(controller->dutyNsForPermille(permilles[i]), &channelPerformed);
+        performed[i] = channelPerformed;
+    }
+    for (int i = indexes.size() - 1; i >= 0; --i) {
+        m_channels[indexes[i]].controller->m_dutyMutex.unlock();
+    }
+
+    // 日志与信号在解锁后处理
+    for (int i = 0; i < indexes.size(); ++i) {
+        const Channel &channel = m_channels[indexes[i]];
+        if (written[i]) {
+            channel.controller->dutyWritten(channel.controller->dutyNsForPermille(permilles[i]), performed[i]);
+        } else {
+            emit errorOccurred(QString("PWM通道%1占空比设置失败: %2‰").arg(channel.key).arg(permilles[i]));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool PwmChannelPool::fadeDutyPermilles(const QMap<QString, int> &duties, int durationMs, PWMController::FadeCurve curve)
+{
+    if (durationMs <= 0) {
+        return setDutyPermilles(duties);
+    }
+
+    QList<int> indexes;
+    bool ok = checkTargets(duties, &indexes);
+
+    // 共用起始时刻，各通道的渐变线程独立计时但进度一致
+    const qint64 startNs = monotonicNs();
+    for (int index : indexes) {
+        const Channel &channel = m_channels[index];
+        ok = channel.controller->fadeToAt(duties.value(channel.key), durationMs, curve, startNs) && ok;
+    }
+    return ok && !indexes.isEmpty();
+}
+
+QStringList PwmChannelPool::recipeKeys() const
+{
+    QStringList keys;
+    for (const Recipe &recipe : m_recipes) {
+        keys << recipe.key;
+    }
+    return keys;
+}
+
+QString PwmChannelPool::recipeName(const QString &key) const
+{
+    for (const Recipe &recipe : m_recipes) {
+        if (recipe.key == key) {
+            return recipe.name;
+        }
+    }
+    return QString();
+}
+
+bool PwmChannelPool::applyRecipe(const QString &key, int fadeMs)
+{
+    for (const Recipe &recipe : m_recipes) {
+        if (recipe.key != key) {
+            continue;
+        }
+
+        // 该棚未接的灯串跳过
+        QMap<QString, int> duties;
+        for (auto it = recipe.duties.constBegin(); it != recipe.duties.constEnd(); ++it) {
+            if (isAvailable(it.key())) {
+                duties.insert(it.key(), it.value());
+            }
+        }
+        if (duties.isEmpty()) {
+            emit errorOccurred(QString("光谱配方%1没有可用的PWM通道").arg(key));
+            return false;
+        }
+
+        if (!fadeDutyPermilles(duties, fadeMs)) {
+            return false;
+        }
+        qDebug() << QString("已应用光谱配方%1(%2)，渐变%3ms").arg(recipe.key, recipe.name).arg(fadeMs);
+        emit recipeApplied(key);
+        return true;
+    }
+
+    emit errorOccurred(QString("未知的光谱配方: %1").arg(key));
+    return false;
+}
+
+PWMController::Statistics PwmChannelPool::statistics() const
+{
+    PWMController::Statistics total;
+    for (const Channel &channel : m_channels) {
+        const PWMController::Statistics stats = channel.controller->statistics();
+        total.requested += stats.requested;
+        total.performed += stats.performed;
+        total.suppressed += stats.suppressed;
+        total.failed += stats.failed;
+        total.opens += stats.opens;
+    }
+    return total;
+}
@@ -1,69 +1,269 @@
 #include "hardware/pwm_controller.h"
+#include "hardware/sysfs_io.h"
+#include "system/state_journal.h"
+#include "config/gpio_config.h"
 
-#include <QDir>
-#include <QFile>
-#include <QTextStream>
 #include <QThread>
 #include <QDebug>
+#include <QMutexLocker>
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
 
 // PWM配置常量定义
-const QString PWMController::PWM_CHIP_PATH = "/sys/class/pwm/pwmchip0";
-const QString PWMController::PWM_EXPORT_PATH = PWM_CHIP_PATH + "/export";
-const QString PWMController::PWM_PATH = PWM_CHIP_PATH + "/pwm0";
-const int PWMController::PWM_PERIOD_NS = 1000000; // 1000Hz = 1000000ns
+const int PWMController::PWM_DEFAULT_PERIOD_NS = 1000000; // 1000Hz = 1000000ns
+const int PWMController::PWM_PERMILLE_FULL = 1000;
+const int PWMController::PWM_EXPORT_TIMEOUT_MS = 100;
+const int PWMController::PWM_EXPORT_POLL_MS = 5;
+
+// 属性文件名，与PWMController::Attribute顺序一致
+static const char *const PWM_ATTRIBUTE_NAMES[] = { "duty_cycle", "enable", "period", "polarity" };
+
+/**
+ * @brief 补光灯渐变线程
+ */
+class PwmFadeThread : public QThread
+{
+public:
+    explicit PwmFadeThread(PWMController *controller) : m_controller(controller) {}
+
+protected:
+    void run() override { m_controller->runFadeLoop(); }
+
+private:
+    PWMController *m_controller;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 感知亮度曲线查找表：亮度0-1均分为CURVE_POINTS段，表项为占空比（65535为100%），段内线性插值
+static const int CURVE_POINTS = 1024;
+static const int CURVE_FULL_SCALE = 65535;
+
+// x的五次方根（牛顿迭代，从不小于根的初值单调收敛），用于编译期计算x^2.2
+static constexpr double fifthRoot(double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    double root = (x < 1.0) ? 1.0 : x;
+    for (int i = 0; i < 64; ++i) {
+        const double root4 = root * root * root * root;
+        root -= (root * root4 - x) / (5.0 * root4);
+    }
+    return root;
+}
+
+static constexpr double gamma22(double level)
+{
+    return level * level * fifthRoot(level); // x^2.2 = x^2 · x^(1/5)
+}
+
+static constexpr double cie1931(double level)
+{
+    // 明度L*（0-100）换算为相对亮度Y
+    const double lightness = level * 100.0;
+    if (lightness <= 8.0) {
+        return lightness / 903.3;
+    }
+    const double f = (lightness + 16.0) / 116.0;
+    return f * f * f;
+}
+
+struct CurveTable {
+    quint16 duty[CURVE_POINTS + 1];
+
+    constexpr explicit CurveTable(PWMController::FadeCurve curve) : duty()
+    {
+        for (int i = 0; i <= CURVE_POINTS; ++i) {
+            const double level = double(i) / CURVE_POINTS;
+            const double value = (curve == PWMController::Gamma22Curve) ? gamma22(level)
+                                 : (curve == PWMController::Cie1931Curve) ? cie1931(level) : level;
+            duty[i] = quint16(value * CURVE_FULL_SCALE + 0.5);
+        }
+    }
+};
+
+static constexpr CurveTable GAMMA22_TABLE(PWMController::Gamma22Curve);
+static constexpr CurveTable CIE1931_TABLE(PWMController::Cie1931Curve);
+
+// 编译期校验：端点精确，半亮度对应0.5^2.2≈21.8%与L*=50时的18.4%
+static_assert(GAMMA22_TABLE.duty[0] == 0 && GAMMA22_TABLE.duty[CURVE_POINTS] == CURVE_FULL_SCALE, "伽马表端点错误");
+static_assert(GAMMA22_TABLE.duty[CURVE_POINTS / 2] > 14200 && GAMMA22_TABLE.duty[CURVE_POINTS / 2] < 14330, "伽马表中点错误");
+static_assert(CIE1931_TABLE.duty[0] == 0 && CIE1931_TABLE.duty[CURVE_POINTS] == CURVE_FULL_SCALE, "CIE表端点错误");
+static_assert(CIE1931_TABLE.duty[CURVE_POINTS / 2] > 12000 && CIE1931_TABLE.duty[CURVE_POINTS / 2] < 12140, "CIE表中点错误");
+
+static const CurveTable *curveTable(PWMController::FadeCurve curve)
+{
+    switch (curve) {
+        case PWMController::Gamma22Curve:
+            return &GAMMA22_TABLE;
+        case PWMController::Cie1931Curve:
+            return &CIE1931_TABLE;
+        default:
+            return nullptr;
+    }
+}
+
+// 亮度（0-1）-> 占空比（0-1）
+static double curveDuty(PWMController::FadeCurve curve, double level)
+{
+    level = qBound(0.0, level, 1.0);
+    const CurveTable *table = curveTable(curve);
+    if (!table) {
+        return level;
+    }
+    const double position = level * CURVE_POINTS;
+    const int index = qMin(int(position), CURVE_POINTS - 1);
+    const double fraction = position - index;
+    return (table->duty[index] + (table->duty[index + 1] - table->duty[index]) * fraction) / CURVE_FULL_SCALE;
+}
+
+// 占空比（0-1）-> 亮度（0-1），表单调递增，二分查找所在段
+static double curveLevel(PWMController::FadeCurve curve, double duty)
+{
+    duty = qBound(0.0, duty, 1.0);
+    const CurveTable *table = curveTable(curve);
+    if (!table) {
+        return duty;
+    }
+    const double value = duty * CURVE_FULL_SCALE;
+    int low = 0;
+    int high = CURVE_POINTS;
+    while (high - low > 1) {
+        const int middle = (low + high) / 2;
+        if (table->duty[middle] <= value) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    const int span = table->duty[high] - table->duty[low];
+    const double fraction = (span > 0) ? qBound(0.0, (value - table->duty[low]) / span, 1.0) : 0.0;
+    return (low + fraction) / CURVE_POINTS;
+}
 
 PWMController::PWMController(QObject *parent)
+    : PWMController(0, 0, PWM_DEFAULT_PERIOD_NS, false, parent)
+{
+}
+
+PWMController::PWMController(int chip, int channel, int periodNs, bool inversed, QObject *parent)
     : QObject(parent)
+    , m_chip(chip)
+    , m_channel(channel)
+    , m_periodNs(periodNs > 0 ? periodNs : PWM_DEFAULT_PERIOD_NS)
+    , m_inversed(inversed)
+    , m_chipPath(QString("%1/pwmchip%2").arg(PWM_CLASS_PATH).arg(chip))
+    , m_channelPath(QString("%1/pwmchip%2/pwm%3").arg(PWM_CLASS_PATH).arg(chip).arg(channel))
+    , m_label(QString("pwmchip%1/pwm%2").arg(chip).arg(channel))
     , m_initialized(false)
-    , m_currentDutyCycle(60) // 默认60%占空比
+    , m_sysfs(SysfsIo::defaultIo())
+    , m_stateJournal(nullptr)
+    , m_currentPermille(600) // 默认60%占空比
+    , m_dutyNs(0)
+    , m_fadeThread(nullptr)
+    , m_fadeTimerFd(-1)
+    , m_fadeWakeFd(-1)
+    , m_fadeStopping(0)
 {
-    qDebug() << "PWM控制器创建完成";
+    for (int i = 0; i < AttributeCount; ++i) {
+        m_attributeFds[i] = -1;
+    }
+    qDebug() << "PWM控制器创建完成:" << m_label;
 }
 
 PWMController::~PWMController()
 {
     cleanup();
+    closeAttributes();
     qDebug() << "PWM控制器已销毁";
 }
 
+bool PWMController::setSysfsIo(SysfsIo *io)
+{
+    if (m_initialized) {
+        emit errorOccurred("PWM已初始化，无法切换sysfs访问实现");
+        return false;
+    }
+
+    closeAttributes(); // 缓存的fd属于原实现
+    m_sysfs = io ? io : SysfsIo::defaultIo();
+    return true;
+}
+
 bool PWMController::initialize()
 {
-    qDebug() << "开始初始化PWM控制器...";
+    qDebug() << "开始初始化PWM控制器..." << m_label;
 
     // 检查PWM设备是否存在
-    if (!QDir(PWM_CHIP_PATH).exists()) {
-        QString error = QString("PWM设备不存在: %1").arg(PWM_CHIP_PATH);
+    if (!m_sysfs->exists(m_chipPath)) {
+        QString error = QString("PWM设备不存在: %1").arg(m_chipPath);
         qWarning() << error;
         emit errorOccurred(error);
         return false;
     }
 
     // 检查PWM设备是否已经存在
-    QFile pwmDir(PWM_PATH);
-    bool pwmExists = pwmDir.exists();
+    bool pwmExists = m_sysfs->exists(m_channelPath);
+    const char *polarity = m_inversed ? "inversed" : "normal";
+
+    // 已导出的通道（如程序重启）只读取一次当前状态，已符合的属性不再写入
+    bool polarityReady = false;
+    bool periodReady = false;
+    bool enabledReady = false;
+    bool dutyReady = true;
+
+    // 状态日志中最近一次设置的占空比优先于硬件当前值与默认值
+    StateJournal::Entry journaled;
+    const bool restored = m_stateJournal && m_stateJournal->lookup(StateJournal::PwmDuty, journalKey(), &journaled);
+    const qint64 restoredNs = restored ? journaledDutyNs(journaled.value, journaled.aux, journaled.flags) : -1;
+    qint64 initialNs = dutyNsForPermille(m_currentPermille);
 
     if (pwmExists) {
         // 读取当前硬件占空比并同步到缓存
-        int actualDuty = readActualDutyCycleInternal();
-        if (actualDuty >= 0) {
-            m_currentDutyCycle = actualDuty;
+        const qint64 actualNs = readActualDutyNsInternal();
+        if (actualNs >= 0) {
+            initialNs = actualNs;
         }
+        if (restored && actualNs != restoredNs) {
+            initialNs = restoredNs;
+            dutyReady = false;
+        }
+        polarityReady = (readAttribute(PolarityAttribute) == polarity);
+        periodReady = (readAttribute(PeriodAttribute).toInt() == m_periodNs);
+        enabledReady = (readAttribute(EnableAttribute) == "1");
     } else {
         // 导出PWM设备
         if (!exportPWM()) {
             emit errorOccurred("PWM设备导出失败");
             return false;
         }
+        if (restored) {
+            initialNs = restoredNs;
+        }
+        dutyReady = false;
     }
 
-    // 设置PWM极性为正常
-    if (!setPolarity("normal")) {
+    // 设置PWM极性（内核要求在通道禁用时修改，导出后即为禁用状态）
+    if (!polarityReady && !setPolarity(polarity)) {
         qWarning() << "PWM极性设置失败，继续执行...";
         // 极性设置失败不是致命错误
     }
 
-    // 设置PWM周期(确保1000Hz)
-    if (!setPeriod(PWM_PERIOD_NS)) {
+    // 设置PWM周期
+    if (!periodReady && !setPeriod(m_periodNs)) {
         emit errorOccurred("PWM周期设置失败");
         return false;
     }
@@ -71,9 +271,12 @@ bool PWMController::initialize()
     // 标记为已初始化
     m_initialized = true;
 
-    // 如果是新导出的设备，设置初始占空比
-    if (!pwmExists) {
-        if (!setDutyCycle(m_currentDutyCycle)) {
+    // 新导出的设备或与日志记录不一致时，设置初始占空比
+    if (!dutyReady) {
+        if (restored) {
+            qDebug() << QString("PWM占空比按状态日志恢复为%1%").arg(permilleFor(initialNs) / 10.0, 0, 'f', 1);
+        }
+        if (!setDutyNs(initialNs)) {
             qWarning() << "PWM初始占空比设置失败";
             m_initialized = false;
             return false;
@@ -81,7 +284,10 @@ bool PWMController::initialize()
     }
 
     // 启用PWM
-    if (!enable(true)) {
+    if (enabledReady) {
+        emit statusChanged(true);
+        qDebug() << "PWM通道已处于目标状态，跳过配置写入";
+    } else if (!enable(true)) {
         qWarning() << "PWM启用失败";
         m_initialized = false;
         return false;
@@ -91,6 +297,18 @@ bool PWMController::initialize()
 }
 
 bool PWMController::setDutyCycle(int percentage)
+{
+    // 限制范围 0-100%
+    return setDutyPermille(qBound(0, percentage, 100) * 10);
+}
+
+bool PWMController::setDutyPermille(int permille)
+{
+    // 计算占空比对应的纳秒值
+    return setDutyNs(dutyNsForPermille(qBound(0, permille, PWM_PERMILLE_FULL)));
+}
+
+bool PWMController::setDutyNs(qint64 dutyNs)
 {
     if (!m_initialized) {
         QString error = "PWM未初始化，无法设置占空比";
@@ -99,24 +317,140 @@ bool PWMController::setDutyCycle(int percentage)
         return false;
     }
 
-    // 限制范围 0-100%
-    percentage = qBound(0, percentage, 100);
-
-    // 计算占空比对应的纳秒值
-    int dutyCycleNs = (PWM_PERIOD_NS * percentage) / 100;
+    const qint64 dutyCycleNs = qBound<qint64>(0, dutyNs, m_periodNs);
 
-    // 设置占空比
-    QString dutyCycleFile = PWM_PATH + "/duty_cycle";
-    if (writeToFile(dutyCycleFile, QString::number(dutyCycleNs))) {
-        m_currentDutyCycle = percentage;
-        emit dutyCycleChanged(percentage);
+    // 设置占空比（纳秒值与上次写入相同时不访问sysfs，也不重复发出信号），立即设置时取消渐变
+    bool performed = false;
+    bool written;
+    {
+        QMutexLocker locker(&m_dutyMutex);
+        m_fade.active = false;
+        written = writeDutyLocked(dutyCycleNs, &performed);
+    }
+    if (written) {
+        dutyWritten(dutyCycleNs, performed);
         return true;
     } else {
-        QString error = QString("PWM占空比设置失败: %1%").arg(percentage);
+        QString error = QString("PWM占空比设置失败: %1ns").arg(dutyCycleNs);
+        qWarning() << error;
+        emit errorOccurred(error);
+        return false;
+    }
+}
+
+void PWMController::dutyWritten(qint64 dutyNs, bool performed)
+{
+    if (m_stateJournal) {
+        m_stateJournal->record(StateJournal::PwmDuty, journalKey(), dutyNs, m_periodNs, StateJournal::PwmNanoseconds);
+    }
+    if (performed) {
+        const int permille = permilleFor(dutyNs);
+        emit dutyPermilleChanged(permille);
+        emit dutyCycleChanged((permille + 5) / 10);
+    }
+}
+
+qint64 PWMController::dutyNsForPermille(int permille) const
+{
+    return (qint64(m_periodNs) * permille + PWM_PERMILLE_FULL / 2) / PWM_PERMILLE_FULL;
+}
+
+int PWMController::permilleFor(qint64 dutyNs) const
+{
+    return int((dutyNs * PWM_PERMILLE_FULL + m_periodNs / 2) / m_periodNs);
+}
+
+qint64 PWMController::journaledDutyNs(qint64 value, qint64 aux, quint32 flags) const
+{
+    if (!(flags & StateJournal::PwmNanoseconds)) {
+        return dutyNsForPermille(qBound(0, int(value), 100) * 10); // 旧记录为百分比
+    }
+    // 周期配置变更后按比例换算
+    const qint64 dutyNs = (aux > 0 && aux != m_periodNs) ? (value * m_periodNs + aux / 2) / aux : value;
+    return qBound<qint64>(0, dutyNs, m_periodNs);
+}
+
+bool PWMController::fadeTo(int percentage, int durationMs, FadeCurve curve)
+{
+    return fadeToAt(qBound(0, percentage, 100) * 10, durationMs, curve, monotonicNs());
+}
+
+bool PWMController::fadeToPermille(int permille, int durationMs, FadeCurve curve)
+{
+    return fadeToAt(permille, durationMs, curve, monotonicNs());
+}
+
+bool PWMController::fadeToAt(int permille, int durationMs, FadeCurve curve, qint64 startNs)
+{
+    if (!m_initialized) {
+        QString error = "PWM未初始化，无法渐变占空比";
         qWarning() << error;
         emit errorOccurred(error);
         return false;
     }
+
+    const qint64 targetNs = dutyNsForPermille(qBound(0, permille, PWM_PERMILLE_FULL));
+    if (durationMs <= 0 || !startFadeThread()) {
+        return setDutyNs(targetNs); // 渐变线程不可用时退化为立即设置
+    }
+
+    {
+        QMutexLocker locker(&m_dutyMutex);
+
+        // 起点取当前输出：运行中的渐变在此改向，亮度连续
+        m_fade.curve = curve;
+        m_fade.startLevel = curveLevel(curve, double(m_dutyNs) / m_periodNs);
+        m_fade.targetLevel = curveLevel(curve, double(targetNs) / m_periodNs);
+        m_fade.targetNs = targetNs;
+        m_fade.startNs = startNs;
+        m_fade.durationNs = qint64(durationMs) * 1000000LL;
+        if (!m_fade.active) {
+            m_fade.active = true;
+            armFadeTimer(true);
+        }
+    }
+
+    // 渐变中重启时按目标值恢复
+    if (m_stateJournal) {
+        m_stateJournal->record(StateJournal::PwmDuty, journalKey(), targetNs, m_periodNs, StateJournal::PwmNanoseconds);
+    }
+    return true;
+}
+
+int PWMController::getCurrentDutyCycle() const
+{
+    QMutexLocker locker(&m_dutyMutex);
+    return (m_currentPermille + 5) / 10;
+}
+
+int PWMController::getCurrentDutyPermille() const
+{
+    QMutexLocker locker(&m_dutyMutex);
+    return m_currentPermille;
+}
+
+qint64 PWMController::currentDutyNs() const
+{
+    QMutexLocker locker(&m_dutyMutex);
+    return m_dutyNs;
+}
+
+bool PWMController::isFading() const
+{
+    QMutexLocker locker(&m_dutyMutex);
+    return m_fade.active;
+}
+
+PWMController::Statistics PWMController::statistics() const
+{
+    QMutexLocker locker(&m_ioMutex);
+    return m_stats;
+}
+
+void PWMController::resetStatistics()
+{
+    QMutexLocker locker(&m_ioMutex);
+    m_stats = Statistics();
 }
 
 bool PWMController::enable(bool enabled)
@@ -128,10 +462,7 @@ bool PWMController::enable(bool enabled)
         return false;
     }
 
-    QString enableFile = PWM_PATH + "/enable";
-    QString value = enabled ? "1" : "0";
-
-    if (writeToFile(enableFile, value)) {
+    if (writeAttribute(EnableAttribute, enabled ? "1" : "0")) {
         emit statusChanged(enabled);
         qDebug() << QString("PWM %1成功").arg(enabled ? "启用" : "禁用");
         return true;
@@ -145,21 +476,27 @@ bool PWMController::enable(bool enabled)
 
 void PWMController::cleanup()
 {
+    stopFadeThread();
+
     if (!m_initialized) {
         return;
     }
 
-    qDebug() << "开始清理PWM资源...";
+    qDebug() << "开始清理PWM资源..." << m_label;
+    qDebug() << QString("PWM属性写入统计(%1): 请求%2次，实际写入%3次，跳过%4次，失败%5次，打开文件%6次")
+                .arg(m_label).arg(m_stats.requested).arg(m_stats.performed).arg(m_stats.suppressed)
+                .arg(m_stats.failed).arg(m_stats.opens);
 
-    // 禁用PWM
+    // 禁用PWM，注销前关闭属性文件
     enable(false);
+    closeAttributes();
 
-    // 注销PWM0 (可选，系统重启时会自动清理)
-    QString unexportFile = PWM_CHIP_PATH + "/unexport";
-    if (writeToFile(unexportFile, "0")) {
-        qDebug() << "PWM0注销成功";
+    // 注销通道 (可选，系统重启时会自动清理)
+    QString unexportFile = m_chipPath + "/unexport";
+    if (writeToFile(unexportFile, QString::number(m_channel))) {
+        qDebug() << m_label << "注销成功";
     } else {
-        qWarning() << "PWM0注销失败";
+        qWarning() << m_label << "注销失败";
     }
 
     m_initialized = false;
@@ -168,37 +505,36 @@ void PWMController::cleanup()
 
 bool PWMController::exportPWM()
 {
-    // 检查PWM0目录是否已存在
-    if (QDir(PWM_PATH).exists()) {
-        qDebug() << "PWM0设备已存在，跳过导出";
+    // 检查通道目录是否已存在
+    if (m_sysfs->exists(m_channelPath)) {
+        qDebug() << m_label << "设备已存在，跳过导出";
         return true;
     }
 
-    // 导出PWM0
-    if (writeToFile(PWM_EXPORT_PATH, "0")) {
-        qDebug() << "PWM0导出成功";
+    // 导出通道
+    if (writeToFile(m_chipPath + "/export", QString::number(m_channel))) {
+        qDebug() << m_label << "导出成功";
 
-        // 等待PWM设备就绪
-        QThread::msleep(100);
-
-        // 再次检查PWM0目录是否存在
-        if (QDir(PWM_PATH).exists()) {
-            return true;
-        } else {
-            qWarning() << "PWM0设备目录仍不存在:" << PWM_PATH;
-            return false;
+        // 轮询等待PWM设备就绪，通常一次轮询内即完成，不再固定等待100ms
+        for (int waited = 0; waited <= PWM_EXPORT_TIMEOUT_MS; waited += PWM_EXPORT_POLL_MS) {
+            if (m_sysfs->exists(m_channelPath)) {
+                return true;
+            }
+            QThread::msleep(PWM_EXPORT_POLL_MS);
         }
+
+        qWarning() << "PWM通道目录仍不存在:" << m_channelPath;
+        return false;
     } else {
-        qWarning() << "PWM0导出失败";
+        qWarning() << m_label << "导出失败";
         return false;
     }
 }
 
 bool PWMController::setPeriod(int periodNs)
 {
-    QString periodFile = PWM_PATH + "/period";
-    if (writeToFile(periodFile, QString::number(periodNs))) {
-        qDebug() << QString("PWM周期设置成功: %1ns (1000Hz)").arg(periodNs);
+    if (writeAttribute(PeriodAttribute, QByteArray::number(periodNs))) {
+        qDebug() << QString("PWM周期设置成功: %1ns (%2Hz)").arg(periodNs).arg(1000000000.0 / periodNs, 0, 'f', 0);
         return true;
     } else {
         qWarning() << "PWM周期设置失败";
@@ -208,8 +544,7 @@ bool PWMController::setPeriod(int periodNs)
 
 bool PWMController::setPolarity(const QString &polarity)
 {
-    QString polarityFile = PWM_PATH + "/polarity";
-    if (writeToFile(polarityFile, polarity)) {
+    if (writeAttribute(PolarityAttribute, polarity.toLatin1())) {
         qDebug() << QString("PWM极性设置成功: %1").arg(polarity);
         return true;
     } else {
@@ -220,63 +555,284 @@ bool PWMController::setPolarity(const QString &polarity)
 
 bool PWMController::writeToFile(const QString &filePath, const QString &value)
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        QTextStream stream(&file);
-        stream << value;
-        file.close();
+    if (m_sysfs->writeFile(filePath, value.toLatin1())) {
         return true;
     } else {
-        qWarning() << QString("无法写入文件 %1: %2").arg(filePath).arg(file.errorString());
+        qWarning() << QString("无法写入文件 %1: %2").arg(filePath).arg(strerror(errno));
         return false;
     }
 }
 
-QString PWMController::readFromFile(const QString &filePath)
+int PWMController::readActualDutyCycle()
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::ReadOnly)) {
-        QTextStream stream(&file);
-        QString content = stream.readAll().trimmed();
-        file.close();
-        return content;
-    } else {
-        qWarning() << QString("无法读取文件 %1: %2").arg(filePath).arg(file.errorString());
-        return QString();
-    }
+    const int permille = readActualDutyPermille();
+    return (permille < 0) ? permille : (permille + 5) / 10;
 }
 
-int PWMController::readActualDutyCycle()
+int PWMController::readActualDutyPermille()
 {
+    QMutexLocker locker(&m_dutyMutex);
     if (!m_initialized) {
         qWarning() << "PWM未初始化，无法读取占空比";
-        return m_currentDutyCycle; // 返回缓存值
+        return m_currentPermille; // 返回缓存值
     }
 
-    return readActualDutyCycleInternal();
+    const qint64 dutyNs = readActualDutyNsInternal();
+    return (dutyNs < 0) ? -1 : permilleFor(dutyNs);
 }
 
-int PWMController::readActualDutyCycleInternal()
+qint64 PWMController::readActualDutyNsInternal()
 {
     // 读取实际的占空比值
-    QString dutyCycleFile = PWM_PATH + "/duty_cycle";
-    QString dutyCycleStr = readFromFile(dutyCycleFile);
+    bool read = false;
+    const QByteArray dutyCycleStr = readAttribute(DutyCycleAttribute, &read);
 
-    if (dutyCycleStr.isEmpty()) {
+    if (!read || dutyCycleStr.isEmpty()) {
         qWarning() << "无法读取PWM占空比文件";
         return -1; // 返回错误值
     }
 
     // 将纳秒值转换为百分比
     bool ok;
-    int dutyCycleNs = dutyCycleStr.toInt(&ok);
+    const qint64 dutyCycleNs = dutyCycleStr.toLongLong(&ok);
     if (!ok) {
         qWarning() << "PWM占空比值格式错误:" << dutyCycleStr;
         return -1;
     }
 
-    // 计算百分比 (dutyCycleNs / PWM_PERIOD_NS * 100)
-    int percentage = (dutyCycleNs * 100) / PWM_PERIOD_NS;
+    // 硬件当前值作为下一次渐变的起点
+    m_dutyNs = qBound<qint64>(0, dutyCycleNs, m_periodNs);
+    m_currentPermille = permilleFor(m_dutyNs);
+    return m_dutyNs;
+}
+
+int PWMController::attributeFd(Attribute attribute)
+{
+    if (m_attributeFds[attribute] < 0) {
+        m_attributeFds[attribute] = m_sysfs->open(m_channelPath + "/" + PWM_ATTRIBUTE_NAMES[attribute], O_RDWR);
+        if (m_attributeFds[attribute] >= 0) {
+            m_stats.opens++;
+        }
+    }
+    return m_attributeFds[attribute];
+}
+
+void PWMController::closeAttributes()
+{
+    QMutexLocker locker(&m_ioMutex);
+    for (int i = 0; i < AttributeCount; ++i) {
+        if (m_attributeFds[i] >= 0) {
+            m_sysfs->close(m_attributeFds[i]);
+            m_attributeFds[i] = -1;
+        }
+        m_attributeValues[i].clear();
+    }
+}
+
+bool PWMController::writeAttribute(Attribute attribute, const QByteArray &value, bool *performed)
+{
+    if (performed) {
+        *performed = false;
+    }
+
+    QMutexLocker locker(&m_ioMutex);
+    m_stats.requested++;
+    if (!m_attributeValues[attribute].isEmpty() && m_attributeValues[attribute] == value) {
+        m_stats.suppressed++;
+        return true;
+    }
+
+    const int fd = attributeFd(attribute);
+    if (fd < 0 || m_sysfs->write(fd, value.constData(), value.size()) != value.size()) {
+        const int error = errno;
+        // 写入失败后内核中的值未知；fd可能因通道被注销而失效，下次重新打开
+        m_attributeValues[attribute].clear();
+        if (fd >= 0) {
+            m_sysfs->close(fd);
+            m_attributeFds[attribute] = -1;
+        }
+        m_stats.failed++;
+        qWarning() << QString("无法写入PWM属性 %1: %2").arg(PWM_ATTRIBUTE_NAMES[attribute]).arg(strerror(error));
+        errno = error;
+        return false;
+    }
+
+    m_attributeValues[attribute] = value;
+    m_stats.performed++;
+    if (performed) {
+        *performed = true;
+    }
+    return true;
+}
+
+QByteArray PWMController::readAttribute(Attribute attribute, bool *ok)
+{
+    QMutexLocker locker(&m_ioMutex);
+    char buffer[64];
+    const int fd = attributeFd(attribute);
+    const int length = (fd >= 0) ? m_sysfs->read(fd, buffer, int(sizeof(buffer))) : -1;
+    if (ok) {
+        *ok = (length >= 0);
+    }
+    if (length < 0) {
+        qWarning() << QString("无法读取PWM属性 %1: %2").arg(PWM_ATTRIBUTE_NAMES[attribute]).arg(strerror(errno));
+        return QByteArray();
+    }
+
+    // 读到的即为内核当前值，之后写入相同值可以跳过
+    m_attributeValues[attribute] = QByteArray(buffer, length).trimmed();
+    return m_attributeValues[attribute];
+}
+
+bool PWMController::writeDutyLocked(qint64 dutyNs, bool *performed)
+{
+    if (!writeAttribute(DutyCycleAttribute, QByteArray::number(dutyNs), performed)) {
+        return false;
+    }
+    m_dutyNs = dutyNs;
+    m_currentPermille = permilleFor(dutyNs);
+    return true;
+}
+
+bool PWMController::startFadeThread()
+{
+    QMutexLocker threadLocker(&m_fadeThreadMutex);
+    if (m_fadeThread) {
+        return true;
+    }
+
+    m_fadeTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_fadeWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_fadeTimerFd < 0 || m_fadeWakeFd < 0) {
+        emit errorOccurred(QString("PWM渐变定时器创建失败: %1").arg(strerror(errno)));
+        threadLocker.unlock();
+        stopFadeThread();
+        return false;
+    }
+
+    m_fadeStopping.storeRelease(0);
+    m_fadeThread = new PwmFadeThread(this);
+    m_fadeThread->start(QThread::HighPriority);
+    qDebug() << QString("PWM渐变线程已启动，更新频率%1Hz").arg(PWM_FADE_RATE_HZ);
+    return true;
+}
+
+void PWMController::stopFadeThread()
+{
+    QMutexLocker threadLocker(&m_fadeThreadMutex);
+    if (m_fadeThread) {
+        m_fadeStopping.storeRelease(1);
+        quint64 one = 1;
+        if (write(m_fadeWakeFd, &one, sizeof(one)) < 0) {
+            qWarning() << "PWM渐变线程唤醒失败:" << strerror(errno);
+        }
+        m_fadeThread->wait();
+        delete m_fadeThread;
+        m_fadeThread = nullptr;
+    }
+
+    {
+        QMutexLocker locker(&m_dutyMutex);
+        m_fade.active = false; // 停在当前输出
+    }
+    if (m_fadeTimerFd >= 0) {
+        close(m_fadeTimerFd);
+        m_fadeTimerFd = -1;
+    }
+    if (m_fadeWakeFd >= 0) {
+        close(m_fadeWakeFd);
+        m_fadeWakeFd = -1;
+    }
+}
+
+void PWMController::armFadeTimer(bool enabled)
+{
+    // 相对时间周期定时，全零表示停止
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (enabled) {
+        spec.it_interval.tv_nsec = 1000000000L / PWM_FADE_RATE_HZ;
+        spec.it_value = spec.it_interval;
+    }
+    if (m_fadeTimerFd >= 0 && timerfd_settime(m_fadeTimerFd, 0, &spec, nullptr) < 0) {
+        qWarning() << "PWM渐变定时器设置失败:" << strerror(errno);
+    }
+}
+
+void PWMController::runFadeLoop()
+{
+    struct pollfd fds[2];
+    fds[0].fd = m_fadeTimerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_fadeWakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_fadeStopping.loadAcquire()) {
+        const int count = poll(fds, 2, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "PWM渐变等待失败:" << strerror(errno);
+            break;
+        }
 
-    return percentage;
+        quint64 value;
+        if ((fds[1].revents & POLLIN) && read(m_fadeWakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "PWM渐变唤醒读取失败:" << strerror(errno);
+        }
+        // 错过的周期合并为一次，过渡值只取决于当前时刻
+        if ((fds[0].revents & POLLIN) && read(m_fadeTimerFd, &value, sizeof(value)) > 0) {
+            stepFade();
+        }
+    }
+}
+
+void PWMController::stepFade()
+{
+    int changedPermille = -1;
+    int changedPercent = -1;
+    bool failed = false;
+    {
+        QMutexLocker locker(&m_dutyMutex);
+        if (!m_fade.active) {
+            armFadeTimer(false); // 已被setDutyCycle取消
+            return;
+        }
+
+        qint64 dutyNs;
+        const qint64 elapsedNs = monotonicNs() - m_fade.startNs;
+        if (elapsedNs >= m_fade.durationNs) {
+            dutyNs = m_fade.targetNs;
+            m_fade.active = false;
+            armFadeTimer(false);
+        } else {
+            const double progress = double(elapsedNs) / double(m_fade.durationNs);
+            const double level = m_fade.startLevel + (m_fade.targetLevel - m_fade.startLevel) * progress;
+            dutyNs = qRound64(curveDuty(m_fade.curve, level) * m_periodNs);
+        }
+
+        const int before = m_currentPermille;
+        if (!writeDutyLocked(dutyNs)) {
+            m_fade.active = false;
+            armFadeTimer(false);
+            failed = true;
+        } else if (m_currentPermille != before) {
+            changedPermille = m_currentPermille;
+            if ((before + 5) / 10 != (changedPermille + 5) / 10) {
+                changedPercent = (changedPermille + 5) / 10;
+            }
+        }
+    }
+
+    // 信号在解锁后发出，直接连接的槽可以查询当前占空比
+    if (failed) {
+        emit errorOccurred("PWM渐变写入失败，渐变已停止");
+    }
+    if (changedPermille >= 0) {
+        emit dutyPermilleChanged(changedPermille);
+    }
+    if (changedPercent >= 0) {
+        emit dutyCycleChanged(changedPercent);
+    }
 }
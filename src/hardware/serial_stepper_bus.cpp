@@ -0,0 +1,512 @@
+#include "hardware/serial_stepper_bus.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <linux/serial.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+const quint8 SerialStepperBus::RequestStart;
+const quint8 SerialStepperBus::ReplyStart;
+const int SerialStepperBus::MaxPayload;
+
+// 帧头（起始、站地址、序号、命令/状态、长度）与CRC长度
+static const int FRAME_HEADER_SIZE = 5;
+static const int FRAME_CRC_SIZE = 2;
+
+/**
+ * @brief 串口收发线程
+ */
+class SerialStepperBusThread : public QThread
+{
+public:
+    explicit SerialStepperBusThread(SerialStepperBus *bus) : m_bus(bus) {}
+
+protected:
+    void run() override { m_bus->runLoop(); }
+
+private:
+    SerialStepperBus *m_bus;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static speed_t baudToSpeed(int baud)
+{
+    switch (baud) {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        default:
+            return B115200;
+    }
+}
+
+static void appendLe(QByteArray &data, quint32 value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        data.append(char((value >> (8 * i)) & 0xFF));
+    }
+}
+
+SerialStepperBus::SerialStepperBus(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_thread(nullptr)
+    , m_loopExited(true)
+    , m_nextId(0)
+    , m_nextSequence(0)
+{
+}
+
+SerialStepperBus::~SerialStepperBus()
+{
+    close();
+}
+
+bool SerialStepperBus::open(const QString &device, int baud)
+{
+    if (m_thread) {
+        if (isOpen()) {
+            return true;
+        }
+        close(); // 串口断开后收发线程已退出，回收后重新打开
+    }
+
+    m_fd = ::open(device.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        emit errorOccurred(QString("串口%1打开失败: %2").arg(device).arg(strerror(errno)));
+        return false;
+    }
+
+    // 原始模式：8N1，无流控，读取不等待（由poll等待）
+    struct termios tio;
+    if (tcgetattr(m_fd, &tio) < 0) {
+        emit errorOccurred(QString("串口%1读取配置失败: %2").arg(device).arg(strerror(errno)));
+        close();
+        return false;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, baudToSpeed(baud));
+    cfsetospeed(&tio, baudToSpeed(baud));
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CRTSCTS | CSTOPB | PARENB);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(m_fd, TCSANOW, &tio) < 0) {
+        emit errorOccurred(QString("串口%1设置失败: %2").arg(device).arg(strerror(errno)));
+        close();
+        return false;
+    }
+    tcflush(m_fd, TCIOFLUSH);
+
+#if CURTAIN_SERIAL_RS485_RTS
+    // 半双工收发器由串口驱动在发送期间拉高RTS；伪终端等不支持时沿用自动方向控制的收发器
+    struct serial_rs485 rs485;
+    memset(&rs485, 0, sizeof(rs485));
+    rs485.flags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+    if (ioctl(m_fd, TIOCSRS485, &rs485) < 0) {
+        qDebug() << QString("串口%1不支持RS-485方向控制，按自动收发处理").arg(device);
+    }
+#endif
+
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeFd < 0) {
+        emit errorOccurred(QString("串口总线唤醒描述符创建失败: %1").arg(strerror(errno)));
+        close();
+        return false;
+    }
+
+    m_device = device;
+    m_rxBuffer.clear();
+    m_txBuffer.clear();
+    m_latestSent.clear();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_loopExited = false;
+    }
+    m_stopping.storeRelease(0);
+    m_thread = new SerialStepperBusThread(this);
+    m_thread->start(QThread::HighPriority);
+    qDebug() << QString("步进驱动器串口总线已打开: %1, %2bps").arg(device).arg(baud);
+    return true;
+}
+
+void SerialStepperBus::close()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        wake();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool SerialStepperBus::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_thread != nullptr && !m_loopExited;
+}
+
+quint32 SerialStepperBus::send(int address, Command command, const QByteArray &payload, int timeoutMs)
+{
+    if (!m_thread || address < 0 || address > 0xFF || payload.size() > MaxPayload) {
+        return 0;
+    }
+
+    Request request;
+    request.address = quint8(address);
+    request.command = quint8(command);
+    request.sequence = 0;
+    request.payload = payload;
+    request.timeoutMs = qMax(1, timeoutMs);
+    request.attempts = 0;
+    request.sentNs = 0;
+    request.deadlineNs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_loopExited) {
+            return 0; // 串口已断开，排队的请求不会再被处理
+        }
+        request.id = ++m_nextId;
+        m_queued.append(request);
+        m_stats.requests++;
+    }
+
+    wake();
+    return request.id;
+}
+
+quint32 SerialStepperBus::move(int address, bool forward, quint32 steps, int stepsPerSecond)
+{
+    QByteArray payload;
+    payload.append(char(forward ? 1 : 0));
+    appendLe(payload, quint32(qBound(1, stepsPerSecond, 0xFFFF)), 2);
+    appendLe(payload, steps, 4);
+    return send(address, Move, payload);
+}
+
+quint32 SerialStepperBus::stop(int address, bool decelerate)
+{
+    QByteArray payload;
+    payload.append(char(decelerate ? 1 : 0));
+    return send(address, Stop, payload);
+}
+
+quint32 SerialStepperBus::queryStatus(int address)
+{
+    return send(address, Status);
+}
+
+SerialStepperBus::Statistics SerialStepperBus::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+quint16 SerialStepperBus::crc16(const char *data, int length)
+{
+    quint16 crc = 0xFFFF;
+    for (int i = 0; i < length; ++i) {
+        crc ^= quint8(data[i]);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? quint16((crc >> 1) ^ 0xA001) : quint16(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+QByteArray SerialStepperBus::encodeFrame(quint8 start, quint8 address, quint8 sequence, quint8 code,
+                                         const QByteArray &payload)
+{
+    QByteArray frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size() + FRAME_CRC_SIZE);
+    frame.append(char(start));
+    frame.append(char(address));
+    frame.append(char(sequence));
+    frame.append(char(code));
+    frame.append(char(payload.size()));
+    frame.append(payload);
+    appendLe(frame, crc16(frame.constData() + 1, frame.size() - 1), FRAME_CRC_SIZE);
+    return frame;
+}
+
+bool SerialStepperBus::takeFrame(QByteArray &buffer, quint8 start, Frame *frame, quint64 *crcErrors)
+{
+    for (;;) {
+        const int begin = buffer.indexOf(char(start));
+        if (begin < 0) {
+            buffer.clear();
+            return false;
+        }
+        if (begin > 0) {
+            buffer.remove(0, begin);
+        }
+        if (buffer.size() < FRAME_HEADER_SIZE) {
+            return false;
+        }
+
+        const int length = quint8(buffer.at(4));
+        if (length > MaxPayload) {
+            buffer.remove(0, 1); // 不是帧头，继续向后同步
+            continue;
+        }
+        const int total = FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE;
+        if (buffer.size() < total) {
+            return false;
+        }
+
+        const quint16 expected = crc16(buffer.constData() + 1, FRAME_HEADER_SIZE - 1 + length);
+        const quint16 actual = quint16(quint8(buffer.at(total - 2)) | (quint8(buffer.at(total - 1)) << 8));
+        if (expected != actual) {
+            if (crcErrors) {
+                ++*crcErrors;
+            }
+            buffer.remove(0, 1);
+            continue;
+        }
+
+        frame->address = quint8(buffer.at(1));
+        frame->sequence = quint8(buffer.at(2));
+        frame->code = quint8(buffer.at(3));
+        frame->payload = buffer.mid(FRAME_HEADER_SIZE, length);
+        buffer.remove(0, total);
+        return true;
+    }
+}
+
+void SerialStepperBus::wake()
+{
+    if (m_wakeFd < 0) {
+        return;
+    }
+    quint64 one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        qWarning() << "串口总线线程唤醒失败:" << strerror(errno);
+    }
+}
+
+void SerialStepperBus::runLoop()
+{
+    struct pollfd fds[2];
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_stopping.loadAcquire()) {
+        const qint64 nowNs = monotonicNs();
+        handleTimeouts(nowNs);
+        takeQueued(nowNs);
+
+        fds[0].fd = m_fd;
+        fds[0].events = POLLIN | (m_txBuffer.isEmpty() ? 0 : POLLOUT);
+        const int count = poll(fds, 2, pollTimeoutMs(nowNs));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "串口总线等待失败:" << strerror(errno);
+            break;
+        }
+
+        quint64 value;
+        if ((fds[1].revents & POLLIN) && read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "串口总线唤醒读取失败:" << strerror(errno);
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            emit errorOccurred(QString("串口%1已断开").arg(m_device));
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            readAvailable(monotonicNs());
+        }
+        if (fds[0].revents & POLLOUT) {
+            writePending();
+        }
+    }
+
+    failAll("串口总线已关闭");
+}
+
+void SerialStepperBus::takeQueued(qint64 nowNs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 序号在待应答请求中唯一，总线上的请求数不超过上限
+    while (!m_queued.isEmpty() && m_outstanding.size() < CURTAIN_SERIAL_MAX_OUTSTANDING) {
+        Request request = m_queued.takeFirst();
+        while (m_outstanding.contains(m_nextSequence)
+               || (m_lastSequence.contains(request.address) && m_lastSequence.value(request.address) == m_nextSequence)) {
+            ++m_nextSequence;
+        }
+        request.sequence = m_nextSequence++;
+        request.frame = encodeFrame(RequestStart, request.address, request.sequence, request.command, request.payload);
+        request.attempts = 1;
+        request.sentNs = nowNs;
+        request.deadlineNs = nowNs + qint64(request.timeoutMs) * 1000000LL;
+
+        m_txBuffer.append(request.frame);
+        m_latestSent.insert(request.address, request.id);
+        m_lastSequence.insert(request.address, request.sequence);
+        m_outstanding.insert(request.sequence, request);
+    }
+}
+
+void SerialStepperBus::readAvailable(qint64 nowNs)
+{
+    char chunk[256];
+    for (;;) {
+        const ssize_t length = read(m_fd, chunk, sizeof(chunk));
+        if (length <= 0) {
+            break;
+        }
+        m_rxBuffer.append(chunk, int(length));
+    }
+
+    Frame frame;
+    quint64 crcErrors = 0;
+    while (takeFrame(m_rxBuffer, ReplyStart, &frame, &crcErrors)) {
+        auto it = m_outstanding.find(frame.sequence);
+        if (it == m_outstanding.end() || it.value().address != frame.address) {
+            QMutexLocker locker(&m_mutex);
+            m_stats.unexpected++;
+            continue;
+        }
+
+        const Request request = it.value();
+        m_outstanding.erase(it);
+        const qint64 roundTripUs = (nowNs - request.sentNs) / 1000;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (frame.code == StatusOk) {
+                m_stats.replies++;
+                m_stats.totalRoundTripUs += roundTripUs;
+                m_stats.maxRoundTripUs = qMax(m_stats.maxRoundTripUs, roundTripUs);
+            } else {
+                m_stats.rejected++;
+            }
+        }
+
+        if (frame.code == StatusOk) {
+            emit replyReceived(request.id, request.address, request.command, frame.payload);
+        } else {
+            emit requestFailed(request.id, request.address, request.command,
+                               QString("驱动器拒绝命令（状态%1）").arg(frame.code));
+        }
+    }
+
+    if (crcErrors > 0) {
+        QMutexLocker locker(&m_mutex);
+        m_stats.crcErrors += crcErrors;
+    }
+}
+
+void SerialStepperBus::writePending()
+{
+    const ssize_t written = write(m_fd, m_txBuffer.constData(), size_t(m_txBuffer.size()));
+    if (written > 0) {
+        m_txBuffer.remove(0, int(written));
+    } else if (written < 0 && errno != EAGAIN && errno != EINTR) {
+        qWarning() << QString("串口%1写入失败: %2").arg(m_device).arg(strerror(errno));
+    }
+}
+
+void SerialStepperBus::handleTimeouts(qint64 nowNs)
+{
+    QList<quint8> expired;
+    for (auto it = m_outstanding.constBegin(); it != m_outstanding.constEnd(); ++it) {
+        if (it.value().deadlineNs <= nowNs) {
+            expired.append(it.key());
+        }
+    }
+
+    for (quint8 sequence : expired) {
+        Request &request = m_outstanding[sequence];
+        const bool superseded = m_latestSent.value(request.address) != request.id;
+
+        // 以原序号重发，驱动器对已执行的序号只重发应答
+        if (!superseded && request.attempts <= CURTAIN_SERIAL_RETRIES) {
+            request.attempts++;
+            request.deadlineNs = nowNs + qint64(request.timeoutMs) * 1000000LL;
+            m_txBuffer.append(request.frame);
+            QMutexLocker locker(&m_mutex);
+            m_stats.retries++;
+            continue;
+        }
+
+        const Request failed = m_outstanding.take(sequence);
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stats.timeouts++;
+        }
+        emit requestFailed(failed.id, failed.address, failed.command,
+                           superseded ? QString("应答超时，已被后续命令取代")
+                                      : QString("应答超时（已发送%1次）").arg(failed.attempts));
+    }
+}
+
+int SerialStepperBus::pollTimeoutMs(qint64 nowNs) const
+{
+    if (m_outstanding.isEmpty()) {
+        return -1;
+    }
+
+    qint64 deadlineNs = m_outstanding.constBegin().value().deadlineNs;
+    for (auto it = m_outstanding.constBegin(); it != m_outstanding.constEnd(); ++it) {
+        deadlineNs = qMin(deadlineNs, it.value().deadlineNs);
+    }
+    return int(qMax<qint64>(0, (deadlineNs - nowNs + 999999) / 1000000));
+}
+
+void SerialStepperBus::failAll(const QString &error)
+{
+    QList<Request> pending = m_outstanding.values();
+    m_outstanding.clear();
+    {
+        // 与send()在同一把锁下切换，之后提交的请求直接返回0，不会滞留在队列中
+        QMutexLocker locker(&m_mutex);
+        pending += m_queued;
+        m_queued.clear();
+        m_loopExited = true;
+    }
+
+    for (const Request &request : pending) {
+        emit requestFailed(request.id, request.address, request.command, error);
+    }
+}
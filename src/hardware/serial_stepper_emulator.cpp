@@ -0,0 +1,327 @@
+#include "hardware/serial_stepper_emulator.h"
+#include "hardware/serial_stepper_bus.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 仿真驱动器应答线程
+ */
+class SerialStepperEmulatorThread : public QThread
+{
+public:
+    explicit SerialStepperEmulatorThread(SerialStepperEmulator *emulator) : m_emulator(emulator) {}
+
+protected:
+    void run() override { m_emulator->runLoop(); }
+
+private:
+    SerialStepperEmulator *m_emulator;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static quint32 readLe(const QByteArray &data, int offset, int bytes)
+{
+    quint32 value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= quint32(quint8(data.at(offset + i))) << (8 * i);
+    }
+    return value;
+}
+
+SerialStepperEmulator::SerialStepperEmulator(QObject *parent)
+    : QObject(parent)
+    , m_masterFd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_thread(nullptr)
+    , m_replyDelayMs(0)
+    , m_dropEvery(0)
+    , m_corruptEvery(0)
+    , m_requestCount(0)
+    , m_replyCount(0)
+{
+}
+
+SerialStepperEmulator::~SerialStepperEmulator()
+{
+    stop();
+}
+
+bool SerialStepperEmulator::start()
+{
+    if (m_thread) {
+        return true;
+    }
+
+    m_masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_masterFd < 0 || grantpt(m_masterFd) < 0 || unlockpt(m_masterFd) < 0) {
+        qWarning() << "仿真驱动器伪终端创建失败:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    // master端同样使用原始模式，避免行规程改写二进制帧
+    struct termios tio;
+    if (tcgetattr(m_masterFd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(m_masterFd, TCSANOW, &tio);
+    }
+
+    const char *name = ptsname(m_masterFd);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (!name || m_wakeFd < 0) {
+        qWarning() << "仿真驱动器初始化失败:" << strerror(errno);
+        stop();
+        return false;
+    }
+    m_devicePath = QString::fromLocal8Bit(name);
+
+    m_stopping.storeRelease(0);
+    m_thread = new SerialStepperEmulatorThread(this);
+    m_thread->start();
+    qDebug() << QString("仿真步进驱动器已启动: %1").arg(m_devicePath);
+    return true;
+}
+
+void SerialStepperEmulator::stop()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        quint64 one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qWarning() << "仿真驱动器线程唤醒失败:" << strerror(errno);
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    if (m_masterFd >= 0) {
+        close(m_masterFd);
+        m_masterFd = -1;
+    }
+}
+
+void SerialStepperEmulator::setReplyDelayMs(int delayMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_replyDelayMs = qMax(0, delayMs);
+}
+
+void SerialStepperEmulator::setDropEvery(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dropEvery = qMax(0, count);
+}
+
+void SerialStepperEmulator::setCorruptEvery(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_corruptEvery = qMax(0, count);
+}
+
+qint32 SerialStepperEmulator::position(int address) const
+{
+    QMutexLocker locker(&m_mutex);
+    Drive drive = m_drives.value(address);
+    advance(drive, monotonicNs());
+    return qint32(drive.position);
+}
+
+bool SerialStepperEmulator::isMoving(int address) const
+{
+    QMutexLocker locker(&m_mutex);
+    Drive drive = m_drives.value(address);
+    advance(drive, monotonicNs());
+    return drive.moving;
+}
+
+int SerialStepperEmulator::executedCommands(int address) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_drives.value(address).executed;
+}
+
+void SerialStepperEmulator::runLoop()
+{
+    struct pollfd fds[2];
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_stopping.loadAcquire()) {
+        // 到期的延迟应答移入发送缓冲
+        const qint64 nowNs = monotonicNs();
+        int timeoutMs = -1;
+        for (int i = 0; i < m_pendingReplies.size(); ) {
+            if (m_pendingReplies.at(i).dueNs <= nowNs) {
+                m_txBuffer.append(m_pendingReplies.takeAt(i).frame);
+            } else {
+                ++i;
+            }
+        }
+        for (const PendingReply &reply : m_pendingReplies) {
+            const int remainingMs = int((reply.dueNs - nowNs + 999999) / 1000000);
+            timeoutMs = (timeoutMs < 0) ? remainingMs : qMin(timeoutMs, remainingMs);
+        }
+
+        fds[0].fd = m_masterFd;
+        fds[0].events = POLLIN | (m_txBuffer.isEmpty() ? 0 : POLLOUT);
+        const int count = poll(fds, 2, timeoutMs);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "仿真驱动器等待失败:" << strerror(errno);
+            break;
+        }
+
+        quint64 value;
+        if ((fds[1].revents & POLLIN) && read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "仿真驱动器唤醒读取失败:" << strerror(errno);
+        }
+        if (fds[0].revents & POLLIN) {
+            char chunk[256];
+            ssize_t length;
+            while ((length = read(m_masterFd, chunk, sizeof(chunk))) > 0) {
+                m_rxBuffer.append(chunk, int(length));
+            }
+            handleRequests();
+        }
+        if ((fds[0].revents & POLLOUT) && !m_txBuffer.isEmpty()) {
+            const ssize_t written = write(m_masterFd, m_txBuffer.constData(), size_t(m_txBuffer.size()));
+            if (written > 0) {
+                m_txBuffer.remove(0, int(written));
+            }
+        }
+        if (fds[0].revents & POLLHUP) {
+            QThread::msleep(10); // slave端尚未打开或已关闭，等待总线重新打开
+        }
+    }
+}
+
+void SerialStepperEmulator::handleRequests()
+{
+    SerialStepperBus::Frame frame;
+    while (SerialStepperBus::takeFrame(m_rxBuffer, SerialStepperBus::RequestStart, &frame)) {
+        QByteArray reply;
+        int delayMs = 0;
+        bool executed = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_requestCount++;
+            if (m_dropEvery > 0 && m_requestCount % quint64(m_dropEvery) == 0) {
+                continue; // 模拟总线干扰导致请求丢失
+            }
+
+            Drive &drive = m_drives[frame.address];
+            if (drive.lastSequence == frame.sequence && !drive.lastReply.isEmpty()) {
+                reply = drive.lastReply; // 重发的请求不重复执行
+            } else {
+                quint8 status = SerialStepperBus::StatusOk;
+                const QByteArray payload = execute(drive, frame.code, frame.payload, &status);
+                reply = SerialStepperBus::encodeFrame(SerialStepperBus::ReplyStart, frame.address,
+                                                      frame.sequence, status, payload);
+                drive.lastSequence = frame.sequence;
+                drive.lastReply = reply;
+                executed = (status == SerialStepperBus::StatusOk);
+            }
+
+            m_replyCount++;
+            if (m_corruptEvery > 0 && m_replyCount % quint64(m_corruptEvery) == 0) {
+                reply[reply.size() - 1] = char(reply.at(reply.size() - 1) ^ 0xFF);
+            }
+            delayMs = m_replyDelayMs;
+        }
+
+        if (executed) {
+            emit commandExecuted(frame.address, frame.code);
+        }
+
+        if (delayMs > 0) {
+            PendingReply pending;
+            pending.dueNs = monotonicNs() + qint64(delayMs) * 1000000LL;
+            pending.frame = reply;
+            m_pendingReplies.append(pending);
+        } else {
+            m_txBuffer.append(reply);
+        }
+    }
+}
+
+QByteArray SerialStepperEmulator::execute(Drive &drive, quint8 command, const QByteArray &payload, quint8 *status)
+{
+    const qint64 nowNs = monotonicNs();
+    advance(drive, nowNs);
+
+    QByteArray reply;
+    switch (command) {
+        case SerialStepperBus::Ping:
+            break;
+        case SerialStepperBus::Move:
+            if (payload.size() != 7) {
+                *status = SerialStepperBus::StatusBadCommand;
+                return reply;
+            }
+            drive.moving = true;
+            drive.forward = (payload.at(0) != 0);
+            drive.stepsPerSecond = int(readLe(payload, 1, 2));
+            drive.remaining = readLe(payload, 3, 4);
+            break;
+        case SerialStepperBus::Stop:
+            drive.moving = false;
+            drive.remaining = 0;
+            break;
+        case SerialStepperBus::Status: {
+            const quint32 position = quint32(qint32(drive.position));
+            reply.append(char(drive.moving ? 1 : 0));
+            for (int i = 0; i < 4; ++i) {
+                reply.append(char((position >> (8 * i)) & 0xFF));
+            }
+            break;
+        }
+        default:
+            *status = SerialStepperBus::StatusBadCommand;
+            return reply;
+    }
+
+    drive.executed++;
+    return reply;
+}
+
+void SerialStepperEmulator::advance(Drive &drive, qint64 nowNs)
+{
+    if (drive.moving && drive.updatedNs > 0) {
+        double steps = double(nowNs - drive.updatedNs) * drive.stepsPerSecond / 1e9;
+        if (drive.remaining > 0 && steps >= drive.remaining) {
+            steps = drive.remaining;
+            drive.moving = false;
+        }
+        if (drive.remaining > 0) {
+            drive.remaining -= quint32(steps);
+        }
+        drive.position += drive.forward ? steps : -steps;
+    }
+    drive.updatedNs = nowNs;
+}
@@ -0,0 +1,436 @@
+#include "hardware/stepper_pulse_generator.h"
+#include "hardware/gpio_controller.h"
+#include "hardware/gpio_mmio.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+// 预先触碰的栈大小，避免实时循环中发生缺页
+static const int STEPPER_STACK_PREFAULT_BYTES = 64 * 1024;
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief 步进脉冲线程
+ *
+ * 切换为SCHED_FIFO并锁定进程内存，权限不足时保持普通调度并给出警告
+ */
+class StepperPulseThread : public QThread
+{
+public:
+    explicit StepperPulseThread(StepperPulseGenerator *generator) : m_generator(generator) {}
+
+protected:
+    void run() override
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = STEPPER_RT_PRIORITY;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            qWarning() << "步进脉冲线程无法启用实时调度:" << strerror(result);
+        }
+
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            qWarning() << "步进脉冲线程无法锁定内存:" << strerror(errno);
+        }
+
+        volatile char stack[STEPPER_STACK_PREFAULT_BYTES];
+        for (int i = 0; i < STEPPER_STACK_PREFAULT_BYTES; i += 4096) {
+            stack[i] = 0;
+        }
+        Q_UNUSED(stack)
+
+        m_generator->runLoop();
+    }
+
+private:
+    StepperPulseGenerator *m_generator;
+};
+
+StepperPulseGenerator::StepperPulseGenerator(GPIOController *controller, QObject *parent)
+    : QObject(parent)
+    , m_gpioController(controller)
+    , m_thread(nullptr)
+    , m_stopping(0)
+    , m_commandsPending(0)
+{
+}
+
+StepperPulseGenerator::~StepperPulseGenerator()
+{
+    stop();
+}
+
+bool StepperPulseGenerator::start()
+{
+    if (m_thread) {
+        return true;
+    }
+
+    if (!m_gpioController) {
+        emit errorOccurred("步进脉冲发生器未设置GPIO控制器");
+        return false;
+    }
+
+    m_stopping.storeRelease(0);
+    m_thread = new StepperPulseThread(this);
+    m_thread->start(QThread::TimeCriticalPriority);
+    qDebug() << "步进脉冲线程已启动";
+    return true;
+}
+
+void StepperPulseGenerator::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping.storeRelease(1);
+        m_commandReady.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    m_commands.clear();
+    m_moving.clear();
+    m_commandsPending.storeRelease(0);
+}
+
+bool StepperPulseGenerator::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+bool StepperPulseGenerator::move(int stepPin, int dirPin, bool forward, quint64 steps, int stepsPerSecond)
+{
+    Command command;
+    command.stepPin = stepPin;
+    command.dirPin = dirPin;
+    command.forward = forward;
+    command.steps = steps;
+    command.halfPeriodNs = stepsPerSecond > 0 ? 500000000LL / stepsPerSecond : 0;
+    command.ramp = nullptr;
+    command.rampLength = 0;
+    command.halt = false;
+    command.decelerate = false;
+    return enqueueMove(command, stepsPerSecond);
+}
+
+bool StepperPulseGenerator::move(int stepPin, int dirPin, bool forward, const MotionProfile &profile)
+{
+    Command command;
+    command.stepPin = stepPin;
+    command.dirPin = dirPin;
+    command.forward = forward;
+    command.steps = profile.steps();
+    command.halfPeriodNs = profile.cruiseHalfPeriodNs();
+    command.ramp = profile.ramp();
+    command.rampLength = profile.rampLength();
+    command.halt = false;
+    command.decelerate = false;
+    return enqueueMove(command, profile.stepsPerSecond());
+}
+
+bool StepperPulseGenerator::enqueueMove(const Command &command, int stepsPerSecond)
+{
+    if (!m_thread) {
+        emit errorOccurred("步进脉冲线程未启动");
+        return false;
+    }
+    if (command.stepPin < 0 || stepsPerSecond <= 0 || stepsPerSecond > STEPPER_MAX_STEPS_PER_SECOND) {
+        emit errorOccurred(QString("步进参数无效: 引脚%1, 步频%2").arg(command.stepPin).arg(stepsPerSecond));
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_commands.append(command);
+    m_moving[command.stepPin] = true;
+    m_commandsPending.storeRelease(1);
+    m_commandReady.wakeAll();
+    return true;
+}
+
+void StepperPulseGenerator::halt(int stepPin, bool decelerate)
+{
+    Command command;
+    command.stepPin = stepPin;
+    command.dirPin = -1;
+    command.forward = false;
+    command.steps = 0;
+    command.halfPeriodNs = 0;
+    command.ramp = nullptr;
+    command.rampLength = 0;
+    command.halt = true;
+    command.decelerate = decelerate;
+
+    QMutexLocker locker(&m_mutex);
+    m_commands.append(command);
+    m_commandsPending.storeRelease(1);
+    m_commandReady.wakeAll();
+}
+
+bool StepperPulseGenerator::isMoving(int stepPin) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_moving.contains(stepPin);
+}
+
+StepperPulseGenerator::Statistics StepperPulseGenerator::lastStatistics(int stepPin) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastStatistics.value(stepPin);
+}
+
+void StepperPulseGenerator::runLoop()
+{
+    QVector<Channel> channels;
+    channels.reserve(8);
+
+    while (!m_stopping.loadAcquire()) {
+        if (m_commandsPending.loadAcquire()) {
+            takeCommands(channels);
+        }
+
+        if (channels.isEmpty()) {
+            QMutexLocker locker(&m_mutex);
+            while (m_commands.isEmpty() && !m_stopping.loadAcquire()) {
+                m_commandReady.wait(&m_mutex);
+            }
+            continue;
+        }
+
+        // 最早到期的边沿（新命令最迟在当前等待结束后生效）
+        int next = 0;
+        for (int i = 1; i < channels.size(); ++i) {
+            if (channels[i].nextEdgeNs < channels[next].nextEdgeNs) {
+                next = i;
+            }
+        }
+        Channel &channel = channels[next];
+
+        struct timespec deadline;
+        deadline.tv_sec = channel.nextEdgeNs / 1000000000LL;
+        deadline.tv_nsec = channel.nextEdgeNs % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+        }
+
+        channel.level = !channel.level;
+        writeStep(channel);
+        const qint64 nowNs = monotonicNs();
+        recordLateness(channel, nowNs - channel.nextEdgeNs);
+
+        // 下降沿完成一步，停止只发生在低电平，不会留下半个脉冲
+        if (!channel.level) {
+            channel.stats.steps++;
+            if (channel.halting || (channel.targetSteps && channel.stats.steps >= channel.targetSteps)) {
+                finishChannel(channel);
+                channels.remove(next);
+                continue;
+            }
+
+            // 下一步的半周期：剩余步数不超过已用加速步数时倒序查表减速，否则继续加速或巡航
+            if (channel.ramp) {
+                const quint64 remaining = channel.targetSteps ? channel.targetSteps - channel.stats.steps : ~quint64(0);
+                if (remaining <= quint64(channel.rampIndex)) {
+                    channel.rampIndex = int(remaining);
+                    channel.halfPeriodNs = channel.ramp[remaining - 1];
+                } else if (channel.rampIndex < channel.rampLength) {
+                    channel.halfPeriodNs = channel.ramp[channel.rampIndex++];
+                } else {
+                    channel.halfPeriodNs = channel.cruiseHalfPeriodNs;
+                }
+            }
+        }
+
+        // 按绝对时间推进，不累积误差；落后超过半个周期时重新对齐，避免补发的密集脉冲使电机失步
+        channel.nextEdgeNs += channel.halfPeriodNs;
+        if (nowNs > channel.nextEdgeNs) {
+            channel.nextEdgeNs = nowNs + channel.halfPeriodNs;
+        }
+    }
+
+    // 停止线程：STEP引脚全部置低
+    for (Channel &channel : channels) {
+        if (channel.level) {
+            channel.level = false;
+            writeStep(channel);
+        }
+        channel.halting = true;
+        finishChannel(channel);
+    }
+}
+
+void StepperPulseGenerator::takeCommands(QVector<Channel> &channels)
+{
+    QList<Command> commands;
+    {
+        QMutexLocker locker(&m_mutex);
+        commands.swap(m_commands);
+        m_commandsPending.storeRelease(0);
+    }
+
+    QList<Command> deferred;
+    const qint64 nowNs = monotonicNs();
+
+    for (const Command &command : commands) {
+        int index = -1;
+        for (int i = 0; i < channels.size(); ++i) {
+            if (channels[i].stepPin == command.stepPin) {
+                index = i;
+                break;
+            }
+        }
+
+        if (command.halt) {
+            // 取消该引脚等待换向的命令（包括上一轮推迟的），否则当前运动结束后又按旧命令起动，停止被丢失
+            for (auto it = deferred.begin(); it != deferred.end(); ) {
+                it = (it->stepPin == command.stepPin) ? deferred.erase(it) : it + 1;
+            }
+            if (index >= 0) {
+                Channel &channel = channels[index];
+                const quint64 stopAt = channel.stats.steps + quint64(channel.rampIndex);
+                if (command.decelerate && channel.ramp && channel.rampIndex > 0) {
+                    // 减速停止：用已加速的步数对称减速
+                    if (!channel.targetSteps || channel.targetSteps > stopAt) {
+                        channel.targetSteps = stopAt;
+                    }
+                } else {
+                    channel.halting = true;
+                }
+            }
+            continue;
+        }
+
+        if (index >= 0) {
+            if (command.dirPin >= 0) {
+                // 需要换向：先结束当前运动，再按新方向开始
+                channels[index].halting = true;
+                deferred.append(command);
+            } else {
+                // 方向由调用方管理：保持相位与当前速度，只更新曲线与目标步数
+                Channel &channel = channels[index];
+                channel.cruiseHalfPeriodNs = command.halfPeriodNs;
+                channel.ramp = command.ramp;
+                channel.rampLength = command.rampLength;
+                if (!channel.ramp) {
+                    channel.halfPeriodNs = command.halfPeriodNs;
+                } else if (channel.rampIndex > channel.rampLength) {
+                    channel.rampIndex = channel.rampLength;
+                }
+                channel.targetSteps = command.steps ? channel.stats.steps + command.steps : 0;
+                channel.halting = false;
+            }
+            continue;
+        }
+
+        if (command.dirPin >= 0) {
+            m_gpioController->setPin(command.dirPin, command.forward);
+        }
+
+        Channel channel;
+        channel.stepPin = command.stepPin;
+        channel.targetSteps = command.steps;
+        channel.cruiseHalfPeriodNs = command.halfPeriodNs;
+        channel.ramp = command.ramp;
+        channel.rampLength = command.rampLength;
+        channel.rampIndex = channel.ramp ? 1 : 0;
+        channel.halfPeriodNs = channel.ramp ? qint64(channel.ramp[0]) : command.halfPeriodNs;
+        channel.nextEdgeNs = nowNs + qint64(STEPPER_DIR_SETUP_US) * 1000;
+        channel.level = false;
+        channel.halting = false;
+        channel.fastIo = m_gpioController->isFastPin(command.stepPin) ? m_gpioController->fastIo() : nullptr;
+        channel.stats.fastPath = (channel.fastIo != nullptr);
+        channel.latencySum = 0.0;
+        channel.latencySquareSum = 0.0;
+        channels.append(channel);
+    }
+
+    if (!deferred.isEmpty()) {
+        // 下一轮边沿之后再次处理，届时当前运动已结束
+        QMutexLocker locker(&m_mutex);
+        m_commands = deferred + m_commands;
+        m_commandsPending.storeRelease(1);
+    }
+}
+
+void StepperPulseGenerator::writeStep(const Channel &channel)
+{
+    if (channel.fastIo) {
+        channel.fastIo->write(channel.stepPin, channel.level);
+    } else {
+        m_gpioController->setPin(channel.stepPin, channel.level);
+    }
+}
+
+void StepperPulseGenerator::recordLateness(Channel &channel, qint64 latenessNs)
+{
+    Statistics &stats = channel.stats;
+    stats.edges++;
+    if (latenessNs > stats.maxLatenessNs) {
+        stats.maxLatenessNs = latenessNs;
+    }
+    if (latenessNs > qint64(STEPPER_DEADLINE_MISS_US) * 1000) {
+        stats.missedDeadlines++;
+    }
+    channel.latencySum += double(latenessNs);
+    channel.latencySquareSum += double(latenessNs) * double(latenessNs);
+}
+
+void StepperPulseGenerator::finishChannel(Channel &channel)
+{
+    Statistics &stats = channel.stats;
+    if (stats.edges > 0) {
+        const double mean = channel.latencySum / double(stats.edges);
+        const double variance = channel.latencySquareSum / double(stats.edges) - mean * mean;
+        stats.meanLatenessNs = qint64(mean);
+        stats.jitterNs = qint64(sqrt(variance > 0.0 ? variance : 0.0));
+    }
+
+    // 寄存器直写不经过影子寄存器，结束时经控制器同步为低电平
+    if (channel.fastIo) {
+        m_gpioController->setPin(channel.stepPin, false);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastStatistics[channel.stepPin] = stats;
+        // 换向等待中的命令仍使该引脚保持运动状态
+        bool queued = false;
+        for (const Command &command : m_commands) {
+            queued |= (command.stepPin == channel.stepPin && !command.halt);
+        }
+        if (!queued) {
+            m_moving.remove(channel.stepPin);
+        }
+    }
+
+    qDebug() << QString("步进引脚%1运动结束: %2步, %3, 最大延迟%4us, 平均延迟%5us, 抖动%6us, 错过截止期%7次")
+                .arg(channel.stepPin)
+                .arg(stats.steps)
+                .arg(stats.fastPath ? "寄存器直写" : "常规后端")
+                .arg(stats.maxLatenessNs / 1000.0, 0, 'f', 1)
+                .arg(stats.meanLatenessNs / 1000.0, 0, 'f', 1)
+                .arg(stats.jitterNs / 1000.0, 0, 'f', 1)
+                .arg(stats.missedDeadlines);
+
+    emit moveFinished(channel.stepPin, stats.steps, channel.halting);
+}
@@ -0,0 +1,590 @@
+#include "hardware/sysfs_io.h"
+#include "config/gpio_config.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+// ==================== 公共便利函数 ====================
+
+bool SysfsIo::writeFile(const QString &path, const QByteArray &data)
+{
+    int fd = open(path, O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool written = (write(fd, data.constData(), data.size()) == data.size());
+    const int savedErrno = errno;
+    close(fd);
+    errno = savedErrno;
+    return written;
+}
+
+QByteArray SysfsIo::readFile(const QString &path, bool *ok)
+{
+    if (ok) {
+        *ok = false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return QByteArray();
+    }
+
+    char buffer[256];
+    int n = read(fd, buffer, sizeof(buffer));
+    const int savedErrno = errno;
+    close(fd);
+    errno = savedErrno;
+    if (n < 0) {
+        return QByteArray();
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+    return QByteArray(buffer, n).trimmed();
+}
+
+SysfsIo *SysfsIo::defaultIo()
+{
+#if SYSFS_IO_BACKEND == SYSFS_IO_MIRROR
+    static MirroredSysfsIo io(SYSFS_MIRROR_ROOT);
+#elif SYSFS_IO_BACKEND == SYSFS_IO_MEMORY
+    static MemorySysfsIo io;
+#else
+    static KernelSysfsIo io;
+#endif
+    return &io;
+}
+
+// ==================== 真实sysfs ====================
+
+int KernelSysfsIo::open(const QString &path, int flags)
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    return ::open(localPath.constData(), flags | O_CLOEXEC);
+}
+
+int KernelSysfsIo::write(int fd, const char *data, int length)
+{
+    ssize_t n;
+    do {
+        n = ::pwrite(fd, data, length, 0);
+    } while (n < 0 && errno == EINTR);
+    return static_cast<int>(n);
+}
+
+int KernelSysfsIo::read(int fd, char *buffer, int length)
+{
+    // sysfs属性在偏移0处读取会重新采样
+    ssize_t n;
+    do {
+        n = ::pread(fd, buffer, length, 0);
+    } while (n < 0 && errno == EINTR);
+    return static_cast<int>(n);
+}
+
+void KernelSysfsIo::close(int fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool KernelSysfsIo::exists(const QString &path)
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    struct stat st;
+    return ::stat(localPath.constData(), &st) == 0;
+}
+
+QStringList KernelSysfsIo::entries(const QString &dirPath)
+{
+    return QDir(m_root + dirPath).entryList(QDir::AllEntries | QDir::NoDotAndDotDot);
+}
+
+// ==================== 模拟sysfs公共部分 ====================
+
+EmulatedSysfsIo::EmulatedSysfsIo()
+    : m_nextHandle(1 << 20) // 远离真实fd，误传给系统调用时返回EBADF
+{
+}
+
+void EmulatedSysfsIo::populate(int pwmChips, int channelsPerChip)
+{
+    QMutexLocker locker(&m_mutex);
+
+    storeMkdir(GPIO_BASE_PATH);
+    storeWrite(GPIO_EXPORT_PATH, QByteArray());
+    storeWrite(GPIO_UNEXPORT_PATH, QByteArray());
+
+    for (int chip = 0; chip < pwmChips; ++chip) {
+        const QString chipPath = QString("%1/pwmchip%2").arg(PWM_CLASS_PATH).arg(chip);
+        storeMkdir(chipPath);
+        storeWrite(chipPath + "/export", QByteArray());
+        storeWrite(chipPath + "/unexport", QByteArray());
+        storeWrite(chipPath + "/npwm", QByteArray::number(channelsPerChip) + "\n");
+    }
+}
+
+int EmulatedSysfsIo::open(const QString &path, int flags)
+{
+    if (!beforeOperation(OpenOperation)) {
+        return -1;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!storeIsFile(path)) {
+        errno = storeIsDir(path) ? EISDIR : ENOENT;
+        return -1;
+    }
+
+    Handle handle;
+    handle.path = path;
+    handle.flags = flags & O_ACCMODE;
+    const int fd = m_nextHandle++;
+    m_handles.insert(fd, handle);
+    return fd;
+}
+
+int EmulatedSysfsIo::write(int fd, const char *data, int length)
+{
+    if (!beforeOperation(WriteOperation)) {
+        return -1;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_handles.constFind(fd);
+    if (it == m_handles.constEnd() || it.value().flags == O_RDONLY) {
+        errno = EBADF;
+        return -1;
+    }
+
+    const int error = applyWrite(it.value().path, QByteArray(data, length).trimmed());
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return length;
+}
+
+int EmulatedSysfsIo::read(int fd, char *buffer, int length)
+{
+    if (!beforeOperation(ReadOperation)) {
+        return -1;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_handles.constFind(fd);
+    if (it == m_handles.constEnd() || it.value().flags == O_WRONLY) {
+        errno = EBADF;
+        return -1;
+    }
+
+    QByteArray data;
+    if (!storeRead(it.value().path, data)) {
+        errno = ENODEV; // 文件在打开后被注销
+        return -1;
+    }
+
+    const int n = qMin(length, data.size());
+    memcpy(buffer, data.constData(), n);
+    return n;
+}
+
+void EmulatedSysfsIo::close(int fd)
+{
+    QMutexLocker locker(&m_mutex);
+    m_handles.remove(fd);
+}
+
+bool EmulatedSysfsIo::exists(const QString &path)
+{
+    if (!beforeOperation(OpenOperation)) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return storeIsFile(path) || storeIsDir(path);
+}
+
+QStringList EmulatedSysfsIo::entries(const QString &dirPath)
+{
+    if (!beforeOperation(ListOperation)) {
+        return QStringList();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return storeList(dirPath);
+}
+
+QByteArray EmulatedSysfsIo::attribute(const QString &path) const
+{
+    QByteArray data;
+    storeRead(path, data);
+    return data.trimmed();
+}
+
+int EmulatedSysfsIo::applyWrite(const QString &path, const QByteArray &value)
+{
+    const QString parent = QFileInfo(path).path();
+    const QString attributeName = QFileInfo(path).fileName();
+    bool ok = false;
+
+    // gpio导出/注销
+    if (path == GPIO_EXPORT_PATH || path == GPIO_UNEXPORT_PATH) {
+        const int pin = value.toInt(&ok);
+        if (!ok || pin < 0) {
+            return EINVAL;
+        }
+        const QString pinPath = QString("%1/gpio%2").arg(GPIO_BASE_PATH).arg(pin);
+        if (path == GPIO_UNEXPORT_PATH) {
+            if (!storeIsDir(pinPath)) {
+                return EINVAL;
+            }
+            storeRemove(pinPath);
+            return 0;
+        }
+        if (storeIsDir(pinPath)) {
+            return EBUSY;
+        }
+        storeMkdir(pinPath);
+        storeWrite(pinPath + "/value", "0\n");
+        storeWrite(pinPath + "/direction", "in\n");
+        storeWrite(pinPath + "/edge", "none\n");
+        storeWrite(pinPath + "/active_low", "0\n");
+        return 0;
+    }
+
+    // gpio属性
+    if (parent.startsWith(QString(GPIO_BASE_PATH) + "/gpio")) {
+        if (attributeName == "direction") {
+            if (value == "high" || value == "low") {
+                storeWrite(parent + "/value", value == "high" ? "1\n" : "0\n");
+                return storeWrite(path, "out\n") ? 0 : EIO;
+            }
+            if (value != "in" && value != "out") {
+                return EINVAL;
+            }
+        } else if (attributeName == "value") {
+            if (attribute(parent + "/direction") == "in") {
+                return EPERM;
+            }
+            return storeWrite(path, value.toInt() ? "1\n" : "0\n") ? 0 : EIO;
+        } else if (attributeName == "edge") {
+            if (value != "none" && value != "rising" && value != "falling" && value != "both") {
+                return EINVAL;
+            }
+        }
+        return storeWrite(path, value + "\n") ? 0 : EIO;
+    }
+
+    // pwm导出/注销
+    if (parent.startsWith(QString(PWM_CLASS_PATH) + "/pwmchip")
+            && (attributeName == "export" || attributeName == "unexport")) {
+        const int channel = value.toInt(&ok);
+        if (!ok || channel < 0 || channel >= attribute(parent + "/npwm").toInt()) {
+            return EINVAL;
+        }
+        const QString channelPath = QString("%1/pwm%2").arg(parent).arg(channel);
+        if (attributeName == "unexport") {
+            if (!storeIsDir(channelPath)) {
+                return EINVAL;
+            }
+            storeRemove(channelPath);
+            return 0;
+        }
+        if (storeIsDir(channelPath)) {
+            return EBUSY;
+        }
+        storeMkdir(channelPath);
+        storeWrite(channelPath + "/period", "0\n");
+        storeWrite(channelPath + "/duty_cycle", "0\n");
+        storeWrite(channelPath + "/enable", "0\n");
+        storeWrite(channelPath + "/polarity", "normal\n");
+        return 0;
+    }
+
+    // pwm通道属性
+    if (parent.startsWith(QString(PWM_CLASS_PATH) + "/pwmchip") && QFileInfo(parent).fileName().startsWith("pwm")) {
+        if (attributeName == "period" || attributeName == "duty_cycle") {
+            const qint64 number = value.toLongLong(&ok);
+            if (!ok || number < 0) {
+                return EINVAL;
+            }
+            // 内核要求 duty_cycle <= period
+            if (attributeName == "period" && number < attribute(parent + "/duty_cycle").toLongLong()) {
+                return EINVAL;
+            }
+            if (attributeName == "duty_cycle" && number > attribute(parent + "/period").toLongLong()) {
+                return EINVAL;
+            }
+        } else if (attributeName == "enable") {
+            if (value != "0" && value != "1") {
+                return EINVAL;
+            }
+        } else if (attributeName == "polarity") {
+            if (value != "normal" && value != "inversed") {
+                return EINVAL;
+            }
+            if (attribute(parent + "/enable") == "1") {
+                return EBUSY; // 运行中不能修改极性
+            }
+        }
+        return storeWrite(path, value + "\n") ? 0 : EIO;
+    }
+
+    return storeWrite(path, value + "\n") ? 0 : EIO;
+}
+
+// ==================== tmpfs镜像 ====================
+
+MirroredSysfsIo::MirroredSysfsIo(const QString &root, int pwmChips, int channelsPerChip)
+    : m_root(root)
+{
+    // 每次启动从干净的树开始，避免上次运行遗留的导出状态
+    QDir(m_root).removeRecursively();
+    QDir().mkpath(m_root);
+    populate(pwmChips, channelsPerChip);
+    qDebug() << "sysfs镜像树已创建:" << m_root;
+}
+
+bool MirroredSysfsIo::storeIsDir(const QString &path) const
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    struct stat st;
+    return ::stat(localPath.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool MirroredSysfsIo::storeIsFile(const QString &path) const
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    struct stat st;
+    return ::stat(localPath.constData(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+bool MirroredSysfsIo::storeRead(const QString &path, QByteArray &data) const
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    int fd = ::open(localPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char buffer[256];
+    ssize_t n = ::pread(fd, buffer, sizeof(buffer), 0);
+    ::close(fd);
+    if (n < 0) {
+        return false;
+    }
+    data = QByteArray(buffer, static_cast<int>(n));
+    return true;
+}
+
+bool MirroredSysfsIo::storeWrite(const QString &path, const QByteArray &data)
+{
+    const QByteArray localPath = (m_root + path).toLocal8Bit();
+    int fd = ::open(localPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+    if (fd < 0) {
+        return false;
+    }
+    const bool written = (::pwrite(fd, data.constData(), data.size(), 0) == data.size());
+    ::close(fd);
+    return written;
+}
+
+void MirroredSysfsIo::storeMkdir(const QString &path)
+{
+    QDir().mkpath(m_root + path);
+}
+
+void MirroredSysfsIo::storeRemove(const QString &path)
+{
+    QDir(m_root + path).removeRecursively();
+}
+
+QStringList MirroredSysfsIo::storeList(const QString &dirPath) const
+{
+    return QDir(m_root + dirPath).entryList(QDir::AllEntries | QDir::NoDotAndDotDot);
+}
+
+// ==================== 纯内存 ====================
+
+MemorySysfsIo::MemorySysfsIo(int pwmChips, int channelsPerChip)
+    : m_random(std::random_device()())
+{
+    populate(pwmChips, channelsPerChip);
+}
+
+bool MemorySysfsIo::storeIsDir(const QString &path) const
+{
+    return m_dirs.contains(path);
+}
+
+bool MemorySysfsIo::storeIsFile(const QString &path) const
+{
+    return m_files.contains(path);
+}
+
+bool MemorySysfsIo::storeRead(const QString &path, QByteArray &data) const
+{
+    auto it = m_files.constFind(path);
+    if (it == m_files.constEnd()) {
+        return false;
+    }
+    data = it.value();
+    return true;
+}
+
+bool MemorySysfsIo::storeWrite(const QString &path, const QByteArray &data)
+{
+    m_files.insert(path, data);
+    return true;
+}
+
+void MemorySysfsIo::storeMkdir(const QString &path)
+{
+    // 同时登记所有上级目录
+    QString current = path;
+    while (!current.isEmpty() && current != "/" && !m_dirs.contains(current)) {
+        m_dirs.insert(current);
+        current = QFileInfo(current).path();
+    }
+}
+
+void MemorySysfsIo::storeRemove(const QString &path)
+{
+    const QString prefix = path + "/";
+    for (auto it = m_files.begin(); it != m_files.end(); ) {
+        if (it.key().startsWith(prefix)) {
+            it = m_files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_dirs.begin(); it != m_dirs.end(); ) {
+        if (*it == path || it->startsWith(prefix)) {
+            it = m_dirs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QStringList MemorySysfsIo::storeList(const QString &dirPath) const
+{
+    const QString prefix = dirPath + "/";
+    QStringList names;
+    auto collect = [&](const QString &path) {
+        if (path.startsWith(prefix) && path.indexOf('/', prefix.size()) < 0) {
+            names.append(path.mid(prefix.size()));
+        }
+    };
+    for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        collect(it.key());
+    }
+    for (const QString &dir : m_dirs) {
+        collect(dir);
+    }
+    names.sort();
+    return names;
+}
+
+void MemorySysfsIo::setLatency(Operation operation, qint64 latencyNs)
+{
+    QMutexLocker locker(&m_injectionMutex);
+    m_injection[operation].latencyNs = latencyNs;
+}
+
+void MemorySysfsIo::setFailureRate(Operation operation, double probability, int error)
+{
+    QMutexLocker locker(&m_injectionMutex);
+    m_injection[operation].failureRate = qBound(0.0, probability, 1.0);
+    m_injection[operation].failureError = error;
+}
+
+void MemorySysfsIo::failNext(Operation operation, int count, int error)
+{
+    QMutexLocker locker(&m_injectionMutex);
+    m_injection[operation].failNextCount = count;
+    m_injection[operation].failNextError = error;
+}
+
+void MemorySysfsIo::clearInjection()
+{
+    QMutexLocker locker(&m_injectionMutex);
+    for (int i = 0; i < OperationCount; ++i) {
+        const quint64 operations = m_injection[i].operations;
+        const quint64 failures = m_injection[i].failures;
+        m_injection[i] = Injection();
+        m_injection[i].operations = operations;
+        m_injection[i].failures = failures;
+    }
+}
+
+quint64 MemorySysfsIo::operationCount(Operation operation) const
+{
+    QMutexLocker locker(&m_injectionMutex);
+    return m_injection[operation].operations;
+}
+
+quint64 MemorySysfsIo::failureCount(Operation operation) const
+{
+    QMutexLocker locker(&m_injectionMutex);
+    return m_injection[operation].failures;
+}
+
+void MemorySysfsIo::resetCounters()
+{
+    QMutexLocker locker(&m_injectionMutex);
+    for (int i = 0; i < OperationCount; ++i) {
+        m_injection[i].operations = 0;
+        m_injection[i].failures = 0;
+    }
+}
+
+bool MemorySysfsIo::beforeOperation(Operation operation)
+{
+    qint64 latencyNs;
+    int error = 0;
+    {
+        QMutexLocker locker(&m_injectionMutex);
+        Injection &injection = m_injection[operation];
+        injection.operations++;
+        latencyNs = injection.latencyNs;
+
+        if (injection.failNextCount > 0) {
+            injection.failNextCount--;
+            error = injection.failNextError;
+        } else if (injection.failureRate > 0.0
+                   && std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < injection.failureRate) {
+            error = injection.failureError;
+        }
+        if (error) {
+            injection.failures++;
+        }
+    }
+
+    // 延迟在锁外注入，模拟慢速总线时不阻塞其它线程的配置与统计
+    if (latencyNs > 0) {
+        struct timespec ts;
+        ts.tv_sec = latencyNs / 1000000000LL;
+        ts.tv_nsec = latencyNs % 1000000000LL;
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+        }
+    }
+
+    if (error) {
+        errno = error;
+        return false;
+    }
+    return true;
+}
@@ -632,7 +632,13 @@ QJsonObject MqttService::deviceDataToJson(const DeviceData &data)
     params["temperature"] = data.temperature;              // 温度
     params["Humidity"] = data.humidity;                    // 湿度
     params["LightLux"] = static_cast<int>(data.lightIntensity);  // 光照值(整数)
-    params["pwm"] = data.pwmDutyCycle;                     // PWM占空比(整数)
+    // 主通道沿用物模型pwm属性（整数百分比），各通道另以pwm_<通道标识>上报（百分比，一位小数）
+    if (!data.pwmChannels.isEmpty()) {
+        params["pwm"] = (data.pwmChannels.first().dutyPermille + 5) / 10; // PWM占空比(整数)
+    }
+    for (const PwmChannelData &channel : data.pwmChannels) {
+        params["pwm_" + channel.key] = channel.dutyPermille / 10.0;
+    }
     // 移除阿里云物模型中未定义的属性
     // params["curtainTopOpen"] = data.curtainTopOpen;
     // params["curtainSideOpen"] = data.curtainSideOpen;
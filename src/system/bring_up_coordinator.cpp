@@ -0,0 +1,280 @@
+#include "system/bring_up_coordinator.h"
+
+#include <QDebug>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+/**
+ * @brief 在线程池中执行单个启动任务
+ */
+class BringUpRunnable : public QRunnable
+{
+public:
+    BringUpRunnable(BringUpCoordinator *coordinator, int index, const std::function<bool()> &function)
+        : m_coordinator(coordinator)
+        , m_index(index)
+        , m_function(function)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override { m_coordinator->runTask(m_index, m_function); }
+
+private:
+    BringUpCoordinator *m_coordinator;
+    int m_index;
+    std::function<bool()> m_function; // 副本，工作线程不访问m_tasks
+};
+
+BringUpCoordinator::BringUpCoordinator(QObject *parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_started(false)
+    , m_aborted(0)
+    , m_remaining(0)
+    , m_allSucceeded(true)
+{
+}
+
+BringUpCoordinator::~BringUpCoordinator()
+{
+    abort();
+}
+
+bool BringUpCoordinator::addTask(const QString &name, const std::function<bool()> &function,
+                                 const QStringList &dependencies, Affinity affinity)
+{
+    if (m_started) {
+        qWarning() << "启动任务已开始执行，无法登记:" << name;
+        return false;
+    }
+    if (indexOf(name) >= 0) {
+        qWarning() << "启动任务重复登记:" << name;
+        return false;
+    }
+
+    Task task;
+    task.name = name;
+    task.function = function;
+    task.affinity = affinity;
+    for (const QString &dependency : dependencies) {
+        const int index = indexOf(dependency);
+        if (index < 0) {
+            qWarning() << QString("启动任务%1依赖未登记的任务%2").arg(name, dependency);
+            return false;
+        }
+        task.dependencies.append(index);
+    }
+
+    m_tasks.append(task);
+    return true;
+}
+
+bool BringUpCoordinator::start()
+{
+    if (m_started) {
+        return true;
+    }
+
+    // 依赖只能指向先登记的任务，正常不会成环，这里防御后续修改
+    if (hasCycle()) {
+        qWarning() << "启动任务依赖关系存在环";
+        return false;
+    }
+
+    // 无依赖的工作线程任务都可能同时运行
+    int workerTasks = 0;
+    for (const Task &task : m_tasks) {
+        if (task.affinity == WorkerThread) {
+            ++workerTasks;
+        }
+    }
+    m_pool->setMaxThreadCount(qMax(1, workerTasks));
+
+    m_started = true;
+    m_remaining = m_tasks.size();
+    m_clock.start();
+
+    if (m_remaining == 0) {
+        QMetaObject::invokeMethod(this, [this]() { emit finished(true, 0); }, Qt::QueuedConnection);
+        return true;
+    }
+
+    dispatchReady();
+    return true;
+}
+
+void BringUpCoordinator::abort()
+{
+    m_aborted.storeRelease(1);
+    m_pool->waitForDone();
+}
+
+BringUpCoordinator::State BringUpCoordinator::taskState(const QString &name) const
+{
+    const int index = indexOf(name);
+    return (index >= 0) ? m_tasks[index].state : Pending;
+}
+
+QString BringUpCoordinator::report() const
+{
+    static const char *stateNames[] = { "等待", "执行中", "成功", "失败", "跳过" };
+
+    QStringList lines;
+    qint64 busyNs = 0;
+    for (const Task &task : m_tasks) {
+        const qint64 waitMs = (task.startNs - task.readyNs) / 1000000;
+        const qint64 runMs = (task.finishNs - task.startNs) / 1000000;
+        if (task.state == Succeeded || task.state == Failed) {
+            busyNs += task.finishNs - task.startNs;
+        }
+        lines.append(QString("  %1 [%2] %3: 开始于%4ms，排队%5ms，执行%6ms")
+                     .arg(task.name, -20)
+                     .arg(task.affinity == MainThread ? "主线程" : "工作线程")
+                     .arg(stateNames[task.state])
+                     .arg(task.startNs / 1000000)
+                     .arg(waitMs)
+                     .arg(runMs));
+    }
+
+    const qint64 totalMs = isFinished() ? m_clock.elapsed() : -1;
+    lines.prepend(QString("硬件启动耗时明细（总计%1ms，各任务执行时间之和%2ms）:")
+                  .arg(totalMs).arg(busyNs / 1000000));
+    return lines.join("\n");
+}
+
+int BringUpCoordinator::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_tasks.size(); ++i) {
+        if (m_tasks[i].name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool BringUpCoordinator::hasCycle() const
+{
+    // 0 未访问，1 访问中，2 已完成
+    QVector<int> marks(m_tasks.size(), 0);
+    std::function<bool(int)> visit = [&](int index) {
+        if (marks[index] == 1) {
+            return true;
+        }
+        if (marks[index] == 2) {
+            return false;
+        }
+        marks[index] = 1;
+        for (int dependency : m_tasks[index].dependencies) {
+            if (visit(dependency)) {
+                return true;
+            }
+        }
+        marks[index] = 2;
+        return false;
+    };
+
+    for (int i = 0; i < m_tasks.size(); ++i) {
+        if (visit(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BringUpCoordinator::dispatchReady()
+{
+    if (m_aborted.loadAcquire()) {
+        return;
+    }
+
+    // 依赖失败的任务连同其下游一并跳过，循环直到没有新的跳过
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < m_tasks.size(); ++i) {
+            Task &task = m_tasks[i];
+            if (task.state != Pending) {
+                continue;
+            }
+
+            bool ready = true;
+            bool blocked = false;
+            for (int dependency : task.dependencies) {
+                const State state = m_tasks[dependency].state;
+                if (state == Failed || state == Skipped) {
+                    blocked = true;
+                } else if (state != Succeeded) {
+                    ready = false;
+                }
+            }
+
+            if (blocked) {
+                task.state = Skipped;
+                task.readyNs = task.startNs = task.finishNs = m_clock.nsecsElapsed();
+                m_allSucceeded = false;
+                --m_remaining;
+                qWarning() << "启动任务因依赖失败跳过:" << task.name;
+                emit taskFinished(task.name, false, 0);
+                changed = true;
+                continue;
+            }
+            if (!ready) {
+                continue;
+            }
+
+            task.state = Running;
+            task.readyNs = m_clock.nsecsElapsed();
+            if (task.affinity == WorkerThread) {
+                m_pool->start(new BringUpRunnable(this, i, task.function));
+            } else {
+                // 经事件循环派发，先让窗口完成绘制
+                const std::function<bool()> function = task.function;
+                QMetaObject::invokeMethod(this, [this, i, function]() { runTask(i, function); },
+                                          Qt::QueuedConnection);
+            }
+        }
+    }
+
+    if (m_remaining == 0) {
+        qDebug().noquote() << report();
+        emit finished(m_allSucceeded, m_clock.elapsed());
+    }
+}
+
+void BringUpCoordinator::runTask(int index, const std::function<bool()> &function)
+{
+    const qint64 startNs = m_clock.nsecsElapsed();
+    const bool success = !m_aborted.loadAcquire() && function && function();
+    const qint64 finishNs = m_clock.nsecsElapsed();
+
+    if (QThread::currentThread() == thread()) {
+        onTaskDone(index, success, startNs, finishNs);
+    } else {
+        QMetaObject::invokeMethod(this, [this, index, success, startNs, finishNs]() {
+            onTaskDone(index, success, startNs, finishNs);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void BringUpCoordinator::onTaskDone(int index, bool success, qint64 startNs, qint64 finishNs)
+{
+    Task &task = m_tasks[index];
+    task.state = success ? Succeeded : Failed;
+    task.startNs = startNs;
+    task.finishNs = finishNs;
+    --m_remaining;
+
+    const qint64 elapsedMs = (finishNs - startNs) / 1000000;
+    if (success) {
+        qDebug() << QString("启动任务%1完成，耗时%2ms").arg(task.name).arg(elapsedMs);
+    } else {
+        m_allSucceeded = false;
+        qWarning() << QString("启动任务%1失败，耗时%2ms").arg(task.name).arg(elapsedMs);
+    }
+    emit taskFinished(task.name, success, elapsedMs);
+
+    dispatchReady();
+}
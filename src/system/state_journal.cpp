@@ -0,0 +1,436 @@
+#include "system/state_journal.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+// 记录起始标记"SJ01"，用于识别未写完或被覆盖的记录
+static const quint32 JOURNAL_MAGIC = 0x31304A53;
+
+/**
+ * @brief 状态日志落盘线程
+ */
+class StateJournalThread : public QThread
+{
+public:
+    explicit StateJournalThread(StateJournal *journal) : m_journal(journal) {}
+
+protected:
+    void run() override { m_journal->runLoop(); }
+
+private:
+    StateJournal *m_journal;
+};
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+StateJournal::StateJournal(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_wakeFd(-1)
+    , m_stopping(0)
+    , m_thread(nullptr)
+    , m_sequence(0)
+    , m_dirtySinceNs(0)
+    , m_sinceCompaction(0)
+    , m_compacting(false)
+{
+}
+
+StateJournal::~StateJournal()
+{
+    close();
+}
+
+bool StateJournal::open(const QString &path)
+{
+    if (m_thread) {
+        return true;
+    }
+
+    m_path = path;
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        emit errorOccurred(QString("状态日志%1打开失败: %2").arg(path).arg(strerror(errno)));
+        return false;
+    }
+
+    if (!replay()) {
+        close();
+        return false;
+    }
+
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeFd < 0) {
+        emit errorOccurred(QString("状态日志唤醒描述符创建失败: %1").arg(strerror(errno)));
+        close();
+        return false;
+    }
+
+    m_stopping.storeRelease(0);
+    m_thread = new StateJournalThread(this);
+    m_thread->start(QThread::LowPriority);
+    qDebug() << QString("状态日志已打开: %1，回放%2条记录，%3项状态")
+                .arg(path).arg(m_stats.replayed).arg(m_latest.size());
+    return true;
+}
+
+void StateJournal::close()
+{
+    if (m_thread) {
+        m_stopping.storeRelease(1);
+        wake();
+        m_thread->wait(); // 线程退出前完成最后一次落盘
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool StateJournal::record(Kind kind, int key, qint64 value, qint64 aux, quint32 flags)
+{
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = JOURNAL_MAGIC;
+    record.kind = quint16(kind);
+    record.key = quint16(key);
+    record.flags = flags;
+    record.value = value;
+    record.aux = aux;
+
+    bool wakeThread = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_fd < 0) {
+            return false;
+        }
+
+        // 状态未变化时不追加，避免周期性保存撑大日志
+        auto it = m_latest.constFind(slot(kind, key));
+        if (it != m_latest.constEnd() && it.value().value == value && it.value().aux == aux
+                && it.value().flags == flags) {
+            m_stats.skipped++;
+            return true;
+        }
+
+        record.sequence = ++m_sequence;
+        record.wallMs = wallMs();
+        record.crc = crc32(&record, offsetof(Record, crc));
+        if (!appendLocked(record)) {
+            locker.unlock();
+            emit errorOccurred(QString("状态日志写入失败: %1").arg(strerror(errno)));
+            return false;
+        }
+
+        m_latest.insert(slot(kind, key), record);
+        if (m_compacting) {
+            m_carry.append(record);
+        }
+        m_stats.appended++;
+        if (m_dirtySinceNs == 0) {
+            m_dirtySinceNs = monotonicNs();
+            wakeThread = true;
+        }
+        if (++m_sinceCompaction == STATE_JOURNAL_COMPACT_RECORDS) {
+            wakeThread = true;
+        }
+    }
+
+    if (wakeThread) {
+        wake();
+    }
+    return true;
+}
+
+bool StateJournal::lookup(Kind kind, int key, Entry *entry) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_latest.constFind(slot(kind, key));
+    if (it == m_latest.constEnd()) {
+        return false;
+    }
+
+    entry->value = it.value().value;
+    entry->aux = it.value().aux;
+    entry->flags = it.value().flags;
+    entry->wallMs = it.value().wallMs;
+    return true;
+}
+
+QList<int> StateJournal::keys(Kind kind) const
+{
+    QList<int> result;
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_latest.constBegin(); it != m_latest.constEnd(); ++it) {
+        if (it.value().kind == kind) {
+            result.append(it.value().key);
+        }
+    }
+    return result;
+}
+
+StateJournal::Statistics StateJournal::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+quint16 StateJournal::keyFor(const QString &name)
+{
+    const QByteArray utf8 = name.toUtf8();
+    return qChecksum(utf8.constData(), uint(utf8.size()));
+}
+
+qint64 StateJournal::wallMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return qint64(ts.tv_sec) * 1000LL + ts.tv_nsec / 1000000;
+}
+
+quint32 StateJournal::crc32(const void *data, int length)
+{
+    const quint8 *bytes = static_cast<const quint8 *>(data);
+    quint32 crc = 0xFFFFFFFF;
+    for (int i = 0; i < length; ++i) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+bool StateJournal::replay()
+{
+    static_assert(sizeof(Record) == 48, "状态日志记录必须为定长48字节");
+
+    struct stat st;
+    if (fstat(m_fd, &st) < 0) {
+        emit errorOccurred(QString("状态日志%1读取失败: %2").arg(m_path).arg(strerror(errno)));
+        return false;
+    }
+    const qint64 size = qint64(st.st_size);
+    if (size == 0) {
+        return true;
+    }
+
+    void *map = mmap(nullptr, size_t(size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (map == MAP_FAILED) {
+        emit errorOccurred(QString("状态日志%1映射失败: %2").arg(m_path).arg(strerror(errno)));
+        return false;
+    }
+
+    // 顺序回放，遇到第一条无效记录（断电时写了一半）即停止
+    const char *data = static_cast<const char *>(map);
+    const qint64 count = size / qint64(sizeof(Record));
+    qint64 valid = 0;
+    for (; valid < count; ++valid) {
+        Record record;
+        memcpy(&record, data + valid * qint64(sizeof(Record)), sizeof(record));
+        if (record.magic != JOURNAL_MAGIC || record.crc != crc32(&record, offsetof(Record, crc))) {
+            break;
+        }
+        m_latest.insert(slot(record.kind, record.key), record);
+        m_sequence = qMax(m_sequence, record.sequence);
+    }
+    munmap(map, size_t(size));
+
+    const qint64 validBytes = valid * qint64(sizeof(Record));
+    m_stats.replayed = quint64(valid);
+    m_sinceCompaction = int(qMin<qint64>(valid, STATE_JOURNAL_COMPACT_RECORDS)); // 积累过多时启动后先压缩
+    if (validBytes < size) {
+        // 截掉无效尾部，之后追加的记录才能被回放
+        m_stats.discarded = quint64(size - validBytes);
+        qWarning() << QString("状态日志末尾%1字节无效，已截断").arg(size - validBytes);
+        if (ftruncate(m_fd, off_t(validBytes)) < 0) {
+            emit errorOccurred(QString("状态日志%1截断失败: %2").arg(m_path).arg(strerror(errno)));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StateJournal::appendLocked(const Record &record)
+{
+    const ssize_t written = write(m_fd, &record, sizeof(record));
+    if (written == ssize_t(sizeof(record))) {
+        return true;
+    }
+
+    // 写入不完整（如磁盘已满）时去掉残片，保持记录对齐
+    if (written > 0) {
+        const off_t end = lseek(m_fd, 0, SEEK_END);
+        if (end >= written && ftruncate(m_fd, end - written) < 0) {
+            qWarning() << "状态日志残片清理失败:" << strerror(errno);
+        }
+        errno = ENOSPC;
+    }
+    return false;
+}
+
+bool StateJournal::writeRecords(int fd, const QList<Record> &records)
+{
+    for (const Record &record : records) {
+        if (write(fd, &record, sizeof(record)) != ssize_t(sizeof(record))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StateJournal::wake()
+{
+    if (m_wakeFd < 0) {
+        return;
+    }
+    quint64 one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        qWarning() << "状态日志线程唤醒失败:" << strerror(errno);
+    }
+}
+
+void StateJournal::runLoop()
+{
+    struct pollfd fds[1];
+    fds[0].fd = m_wakeFd;
+    fds[0].events = POLLIN;
+
+    while (!m_stopping.loadAcquire()) {
+        qint64 dirtySinceNs;
+        bool compactDue;
+        {
+            QMutexLocker locker(&m_mutex);
+            dirtySinceNs = m_dirtySinceNs;
+            compactDue = (m_sinceCompaction >= STATE_JOURNAL_COMPACT_RECORDS);
+        }
+
+        if (compactDue) {
+            compact();
+            continue;
+        }
+
+        // 首条未落盘记录之后等待一个批量周期再落盘
+        int timeoutMs = -1;
+        if (dirtySinceNs > 0) {
+            const qint64 dueNs = dirtySinceNs + qint64(STATE_JOURNAL_SYNC_MS) * 1000000LL;
+            timeoutMs = int(qMax<qint64>(0, (dueNs - monotonicNs() + 999999) / 1000000));
+            if (timeoutMs == 0) {
+                syncNow();
+                continue;
+            }
+        }
+
+        const int count = poll(fds, 1, timeoutMs);
+        if (count < 0 && errno != EINTR) {
+            qWarning() << "状态日志等待失败:" << strerror(errno);
+            break;
+        }
+
+        quint64 value;
+        if (count > 0 && read(m_wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+            qWarning() << "状态日志唤醒读取失败:" << strerror(errno);
+        }
+    }
+
+    syncNow();
+}
+
+void StateJournal::syncNow()
+{
+    // 日志文件只在本线程中替换，解锁后描述符仍然有效
+    int fd;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_dirtySinceNs == 0) {
+            return;
+        }
+        m_dirtySinceNs = 0;
+        fd = m_fd;
+    }
+
+    if (fdatasync(fd) < 0) {
+        qWarning() << "状态日志落盘失败:" << strerror(errno);
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_stats.syncs++;
+}
+
+bool StateJournal::compact()
+{
+    // 快照在锁外写入并落盘，期间追加的记录暂存在m_carry中
+    QList<Record> snapshot;
+    {
+        QMutexLocker locker(&m_mutex);
+        snapshot = m_latest.values();
+        m_compacting = true;
+        m_carry.clear();
+    }
+
+    const QByteArray tempPath = (m_path + ".tmp").toLocal8Bit();
+    const int fd = ::open(tempPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    bool ok = (fd >= 0) && writeRecords(fd, snapshot) && fdatasync(fd) == 0;
+
+    int oldFd = -1;
+    {
+        QMutexLocker locker(&m_mutex);
+        ok = ok && writeRecords(fd, m_carry)
+                && rename(tempPath.constData(), m_path.toLocal8Bit().constData()) == 0;
+        if (ok) {
+            oldFd = m_fd;
+            m_fd = fd;
+            if (!m_carry.isEmpty() && m_dirtySinceNs == 0) {
+                m_dirtySinceNs = monotonicNs(); // 补写的记录尚未落盘
+            }
+            m_stats.compactions++;
+        }
+        m_sinceCompaction = 0; // 失败时也等下一个周期再试
+        m_compacting = false;
+        m_carry.clear();
+    }
+
+    if (!ok) {
+        qWarning() << QString("状态日志压缩失败: %1").arg(strerror(errno));
+        if (fd >= 0) {
+            ::close(fd);
+            unlink(tempPath.constData());
+        }
+        return false;
+    }
+    ::close(oldFd);
+
+    // 目录项落盘后替换才在断电后可见
+    const int dirFd = ::open(QFileInfo(m_path).absolutePath().toLocal8Bit().constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+    qDebug() << QString("状态日志已压缩为%1条记录").arg(snapshot.size());
+    return true;
+}
@@ -3,6 +3,7 @@
 #include "hardware/gpio_controller.h"
 #include "network/mqtt_service.h"
 #include "device/curtain_controller.h"
+#include "device/curtain_command_queue.h"
 #include "ai/ai_decision_manager.h"
 
 // Qt界面组件
@@ -952,7 +953,7 @@ void UIManager::createLightControlPage(QWidget *page, QVBoxLayout *contentLayout
     };
 
     // 添加两个状态卡片
-    statusLayout->addWidget(createStatusCard(statusArea, "💡", "补光灯强度", "60%", "lightStatusValue"));
+    statusLayout->addWidget(createStatusCard(statusArea, "💡", "补光灯强度", "60.0%", "lightStatusValue"));
     statusLayout->addWidget(createStatusCard(statusArea, "⚙️", "工作模式", "手动模式", "modeStatusValue"));
 
     dashboardLayout->addWidget(statusArea);
@@ -987,8 +988,9 @@ void UIManager::createLightControlPage(QWidget *page, QVBoxLayout *contentLayout
     sliderLayout->setSpacing(10);
 
     QSlider *lightSlider = new QSlider(Qt::Horizontal, sliderContainer);
-    lightSlider->setRange(0, 100);
-    lightSlider->setValue(60);
+    lightSlider->setRange(0, 1000); // 占空比千分比，步长0.1%
+    lightSlider->setPageStep(10);
+    lightSlider->setValue(600);
     lightSlider->setObjectName("lightSlider");
     lightSlider->setStyleSheet(
         "QSlider::groove:horizontal { "
@@ -1015,12 +1017,12 @@ void UIManager::createLightControlPage(QWidget *page, QVBoxLayout *contentLayout
     connect(lightSlider, &QSlider::valueChanged, [this, lightStatusValue](int value) {
         // 更新UI显示
         if (lightStatusValue) {
-            lightStatusValue->setText(QString("%1%").arg(value));
+            lightStatusValue->setText(QString("%1%").arg(value / 10.0, 0, 'f', 1));
         }
 
-        // 更新PWM硬件占空比
+        // 更新PWM硬件占空比：短时渐变，拖动中不断改向新位置
         if (m_pwmController) {
-            m_pwmController->setDutyCycle(value);
+            m_pwmController->fadeToPermille(value, PWM_SLIDER_FADE_MS);
 
             // 立即触发MQTT数据上报
             if (m_mqttService) {
@@ -1251,9 +1253,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 openBtn->setStyleSheet(pressedButtonStyle);
 
-                // 调用GPIO控制方法
+                // 经命令队列提交，与AI和云端命令合并
                 if (m_curtainController) {
-                    m_curtainController->openTopCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::TopCurtain, CurtainCommandQueue::Open, 0.0, "界面");
                 }
             });
 
@@ -1265,9 +1267,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 openBtn->setStyleSheet(buttonStyle);
 
-                // 调用GPIO暂停方法
+                // 松开即暂停，同时丢弃尚未执行的命令
                 if (m_curtainController) {
-                    m_curtainController->pauseTopCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::TopCurtain, CurtainCommandQueue::Pause, 0.0, "界面");
                 }
             });
 
@@ -1279,9 +1281,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 closeBtn->setStyleSheet(pressedButtonStyle);
 
-                // 调用GPIO控制方法
+                // 经命令队列提交，与AI和云端命令合并
                 if (m_curtainController) {
-                    m_curtainController->closeTopCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::TopCurtain, CurtainCommandQueue::Close, 0.0, "界面");
                 }
             });
 
@@ -1293,9 +1295,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 closeBtn->setStyleSheet(buttonStyle);
 
-                // 调用GPIO暂停方法
+                // 松开即暂停，同时丢弃尚未执行的命令
                 if (m_curtainController) {
-                    m_curtainController->pauseTopCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::TopCurtain, CurtainCommandQueue::Pause, 0.0, "界面");
                 }
             });
         } else {
@@ -1308,9 +1310,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 openBtn->setStyleSheet(pressedButtonStyle);
 
-                // 调用GPIO控制方法
+                // 经命令队列提交，与AI和云端命令合并
                 if (m_curtainController) {
-                    m_curtainController->openSideCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::SideCurtain, CurtainCommandQueue::Open, 0.0, "界面");
                 }
             });
 
@@ -1322,9 +1324,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 openBtn->setStyleSheet(buttonStyle);
 
-                // 调用GPIO暂停方法
+                // 松开即暂停，同时丢弃尚未执行的命令
                 if (m_curtainController) {
-                    m_curtainController->pauseSideCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::SideCurtain, CurtainCommandQueue::Pause, 0.0, "界面");
                 }
             });
 
@@ -1336,9 +1338,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 closeBtn->setStyleSheet(pressedButtonStyle);
 
-                // 调用GPIO控制方法
+                // 经命令队列提交，与AI和云端命令合并
                 if (m_curtainController) {
-                    m_curtainController->closeSideCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::SideCurtain, CurtainCommandQueue::Close, 0.0, "界面");
                 }
             });
 
@@ -1350,9 +1352,9 @@ void UIManager::createCurtainControlPage(QWidget *page, QVBoxLayout *contentLayo
                 );
                 closeBtn->setStyleSheet(buttonStyle);
 
-                // 调用GPIO暂停方法
+                // 松开即暂停，同时丢弃尚未执行的命令
                 if (m_curtainController) {
-                    m_curtainController->pauseSideCurtain();
+                    m_curtainController->commandQueue()->submit(CurtainController::SideCurtain, CurtainCommandQueue::Pause, 0.0, "界面");
                 }
             });
         }
@@ -2501,7 +2503,14 @@ void UIManager::createIrrigationControlPage(QWidget *page, QVBoxLayout *contentL
 
         // GPIO控制
         if (m_gpioController && m_gpioController->startPump()) {
-            qDebug() << "水泵已开启 - GPIO3_A7置1";
+            if (m_gpioController->isPumpStartPending()) {
+                qDebug() << "水泵等待供电余量后开启";
+                if (pumpStatusValue) {
+                    pumpStatusValue->setText("等待供电");
+                }
+            } else {
+                qDebug() << "水泵已开启 - GPIO3_A7置1";
+            }
         } else {
             qWarning() << "水泵开启失败";
         }
@@ -2618,7 +2627,14 @@ void UIManager::createIrrigationControlPage(QWidget *page, QVBoxLayout *contentL
 
         // GPIO控制
         if (m_gpioController && m_gpioController->startFertilizerPump()) {
-            qDebug() << "施药泵已开启 - GPIO3_A1置1";
+            if (m_gpioController->isFertilizerPumpStartPending()) {
+                qDebug() << "施药泵等待供电余量后开启";
+                if (fertilizerStatusValue) {
+                    fertilizerStatusValue->setText("等待供电");
+                }
+            } else {
+                qDebug() << "施药泵已开启 - GPIO3_A1置1";
+            }
         } else {
             qWarning() << "施药泵开启失败";
         }
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_curtain_command_queue_stress
+
+SOURCES += \
+    tst_curtain_command_queue_stress.cpp
@@ -0,0 +1,398 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QVector>
+
+#include "device/curtain_command_queue.h"
+#include "device/curtain_controller.h"
+#include "hardware/gpio_controller.h"
+#include "hardware/gpio_line_io.h"
+#include "hardware/sysfs_io.h"
+#include "config/gpio_config.h"
+
+namespace {
+
+// 测试用执行器：直流电机，引脚避开电源与水泵所在的gpio3
+struct TestActuator {
+    const char *key;
+    const char *group;
+    int dir1;
+    int dir2;
+    int enable;
+    int enable2;
+};
+
+const TestActuator ACTUATORS[] = {
+    { "east1", "east", 32, 33, 34, 35 },
+    { "east2", "east", 36, 37, 38, -1 },
+    { "west1", "west", 64, 65, 66, 67 },
+    { "west2", "west", 68, 69, 70, -1 },
+};
+const int ACTUATOR_COUNT = int(sizeof(ACTUATORS) / sizeof(ACTUATORS[0]));
+const char *const GROUPS[] = { "east", "west", "all" };
+
+const int STRESS_OPERATIONS = 5000;
+const int CHECK_INTERVAL = 250;      // 每隔多少条命令处理事件并比较引脚
+const int DWELL_ROUNDS = 10;         // 检查点处理事件的最多轮数，之后仍在停机等待视为失败
+const quint32 STRESS_SEED = 20240611;
+
+} // namespace
+
+/**
+ * @brief 保温帘命令队列压力测试
+ *
+ * 四个直流电机执行器接在进程内模拟的GPIO字符设备上，按固定种子随机提交开、关、暂停、
+ * 分组与取消命令。参考模型按队列的合并、覆盖、抢占与换向停机规则推算每条通道的状态和
+ * 每个命令的结果；检查点处比较执行器引脚电平，结束时比较换向次数等统计与全部命令结果。
+ * 计时相关的变化（换向停机到期、按时间到达终点）只在检查点处理事件后从控制器读回。
+ * 换向停机间隔设为0，停机等待在检查点处理事件时到期，不依赖实际时间。
+ */
+class CurtainCommandQueueStressTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void mixedCommands();
+
+private:
+    // 参考模型中的一条通道
+    struct LaneModel {
+        int active = 0;              // 执行中命令的方向：1打开，-1关闭，0无
+        QList<quint64> activeIds;    // 执行中命令及并入的命令
+        int pending = 0;             // 待执行命令的方向
+        quint64 pendingId = 0;
+        bool dwell = false;          // 换向停机等待中
+        quint64 executed = 0;
+        quint64 coalesced = 0;
+        quint64 reversals = 0;
+    };
+
+    void modelEnqueue(int type, int direction, quint64 id);
+    void modelDispatch(int type);
+    void modelPause(int type, quint64 id);
+    bool modelCancel(quint64 id);
+    void modelFinishActive(int type, CurtainCommandQueue::Result result);
+    void syncTimers();               // 读回检查点期间到期的换向停机与到达终点
+    void expireDwell();              // 处理事件直到所有通道的换向停机结束
+    void verifyLanes();
+    bool lineLevel(int pin) const;
+
+    MemorySysfsIo m_sysfsIo;
+    SimulatedGpioLineIo *m_lines = nullptr;  // 由GPIO控制器拥有
+    GPIOController *m_gpio = nullptr;
+    CurtainController *m_curtain = nullptr;
+    CurtainCommandQueue *m_queue = nullptr;
+
+    QVector<LaneModel> m_model;
+    QHash<quint64, CurtainCommandQueue::Result> m_expected;
+    QHash<quint64, CurtainCommandQueue::Result> m_finished;
+    int m_duplicateResults = 0;
+};
+
+void CurtainCommandQueueStressTest::initTestCase()
+{
+    // 位置、标定与执行器配置放在测试专用目录，不影响开发机上的实际数据
+    QStandardPaths::setTestModeEnabled(true);
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir(dataDir).removeRecursively();
+    QVERIFY(QDir().mkpath(dataDir));
+
+    QJsonArray curtains;
+    for (const TestActuator &actuator : ACTUATORS) {
+        QJsonObject json;
+        json["key"] = actuator.key;
+        json["groups"] = QJsonArray() << actuator.group;
+        json["dir1"] = actuator.dir1;
+        json["dir2"] = actuator.dir2;
+        json["enable"] = actuator.enable;
+        json["enable2"] = actuator.enable2;
+        curtains.append(json);
+    }
+    QJsonObject root;
+    root["curtains"] = curtains;
+    QFile file(dataDir + "/" + CURTAIN_ACTUATOR_FILE);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    m_gpio = new GPIOController;
+    QVERIFY(m_gpio->setSysfsIo(&m_sysfsIo));
+    m_lines = new SimulatedGpioLineIo;
+    m_gpio->setCharDevLineIo(m_lines);
+    QVERIFY(m_gpio->setBackend(GPIOController::CharDevBackend));
+    QVERIFY(m_gpio->initialize());
+
+    m_curtain = new CurtainController;
+    m_curtain->setGPIOController(m_gpio);
+    QVERIFY(m_curtain->initialize());
+    QCOMPARE(m_curtain->curtainCount(), ACTUATOR_COUNT);
+
+    m_queue = m_curtain->commandQueue();
+    m_queue->setReversalDwellMs(0);
+    connect(m_queue, &CurtainCommandQueue::commandFinished, this,
+            [this](quint64 id, CurtainController::CurtainType, CurtainCommandQueue::Result result) {
+        if (m_finished.contains(id)) {
+            m_duplicateResults++;
+        }
+        m_finished.insert(id, result);
+    });
+
+    m_model.resize(ACTUATOR_COUNT);
+}
+
+void CurtainCommandQueueStressTest::cleanupTestCase()
+{
+    if (m_curtain) {
+        m_curtain->shutdown();
+    }
+    delete m_curtain;
+    delete m_gpio;
+}
+
+void CurtainCommandQueueStressTest::mixedCommands()
+{
+    QRandomGenerator random(STRESS_SEED);
+    quint64 lastId = 0;
+
+    for (int op = 1; op <= STRESS_OPERATIONS; ++op) {
+        const int kind = random.bounded(100);
+        const int type = random.bounded(ACTUATOR_COUNT);
+        const int direction = random.bounded(2) ? 1 : -1;
+        const CurtainCommandQueue::Action move = (direction > 0) ? CurtainCommandQueue::Open
+                                                                 : CurtainCommandQueue::Close;
+        const QString group = GROUPS[random.bounded(3)];
+
+        if (kind < 45) {
+            const quint64 id = m_queue->submit(type, move, 0.0, "stress");
+            QVERIFY(id > lastId);
+            lastId = id;
+            modelEnqueue(type, direction, id);
+        } else if (kind < 55) {
+            lastId = m_queue->submit(type, CurtainCommandQueue::Pause, 0.0, "stress");
+            modelPause(type, lastId);
+        } else if (kind < 85) {
+            const bool pause = (kind >= 80);
+            const QList<quint64> ids = m_queue->submitGroup(group, pause ? CurtainCommandQueue::Pause : move,
+                                                            0.0, "stress");
+            const QList<CurtainController::CurtainType> members = m_curtain->curtainsInGroup(group);
+            QCOMPARE(ids.size(), members.size());
+            for (int i = 0; i < members.size(); ++i) {
+                if (pause) {
+                    modelPause(members.at(i), ids.at(i));
+                } else {
+                    modelEnqueue(members.at(i), direction, ids.at(i));
+                }
+            }
+            lastId = ids.last();
+        } else if (lastId > 0) {
+            // 取消任意已发出的命令，多数已经结束
+            const quint64 id = 1 + random.bounded(quint32(lastId));
+            QCOMPARE(m_queue->cancel(id), modelCancel(id));
+        }
+        syncTimers();
+        if (QTest::currentTestFailed()) {
+            qWarning() << "命令序号" << op;
+            return;
+        }
+
+        if (op % CHECK_INTERVAL == 0) {
+            expireDwell();
+            verifyLanes();
+            if (QTest::currentTestFailed()) {
+                qWarning() << "检查点，命令序号" << op;
+                return;
+            }
+        }
+    }
+
+    // 结束最后的换向停机，再整体暂停：所有命令均应结束，全部使能关闭
+    expireDwell();
+    for (const LaneModel &lane : m_model) {
+        QVERIFY(!lane.dwell);
+    }
+    const QList<quint64> ids = m_queue->submitGroup("all", CurtainCommandQueue::Pause, 0.0, "stress");
+    QCOMPARE(ids.size(), ACTUATOR_COUNT);
+    for (int type = 0; type < ACTUATOR_COUNT; ++type) {
+        modelPause(type, ids.at(type));
+    }
+    verifyLanes();
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    for (const TestActuator &actuator : ACTUATORS) {
+        QCOMPARE(lineLevel(actuator.enable), bool(CURTAIN_DISABLE));
+    }
+
+    quint64 reversals = 0;
+    for (int type = 0; type < ACTUATOR_COUNT; ++type) {
+        const CurtainCommandQueue::Statistics stats = m_queue->statistics(type);
+        const LaneModel &lane = m_model.at(type);
+        QCOMPARE(stats.reversals, lane.reversals);
+        QCOMPARE(stats.executed, lane.executed);
+        QCOMPARE(stats.coalesced, lane.coalesced);
+        QCOMPARE(stats.failed, quint64(0));
+        reversals += stats.reversals;
+    }
+    QVERIFY(reversals > 0);
+
+    // 每个命令恰好结束一次，结果与模型一致
+    QCOMPARE(quint64(m_expected.size()), ids.last());
+    QTRY_COMPARE(m_finished.size(), m_expected.size());
+    QCOMPARE(m_duplicateResults, 0);
+    for (auto it = m_expected.constBegin(); it != m_expected.constEnd(); ++it) {
+        QVERIFY2(m_finished.value(it.key(), CurtainCommandQueue::Failed) == it.value(),
+                 qPrintable(QString("命令#%1结果不符").arg(it.key())));
+    }
+    qDebug() << QString("%1条命令，换向%2次").arg(m_expected.size()).arg(reversals);
+}
+
+void CurtainCommandQueueStressTest::modelEnqueue(int type, int direction, quint64 id)
+{
+    LaneModel &lane = m_model[type];
+    if (lane.active == direction && lane.pending == 0) {
+        lane.activeIds.append(id);
+        lane.coalesced++;
+        return;
+    }
+    if (lane.pending != 0) {
+        m_expected.insert(lane.pendingId, CurtainCommandQueue::Superseded);
+    }
+    lane.pending = direction;
+    lane.pendingId = id;
+    modelDispatch(type);
+}
+
+void CurtainCommandQueueStressTest::modelDispatch(int type)
+{
+    LaneModel &lane = m_model[type];
+    if (lane.pending == 0 || lane.dwell) {
+        return;
+    }
+    if (lane.active != 0) {
+        const bool reversing = (lane.active != lane.pending);
+        modelFinishActive(type, CurtainCommandQueue::Preempted);
+        if (reversing) {
+            lane.reversals++;
+            lane.dwell = true;
+            return;
+        }
+    }
+    lane.active = lane.pending;
+    lane.activeIds = QList<quint64>() << lane.pendingId;
+    lane.pending = 0;
+    lane.executed++;
+}
+
+void CurtainCommandQueueStressTest::modelPause(int type, quint64 id)
+{
+    LaneModel &lane = m_model[type];
+    lane.dwell = false;
+    if (lane.pending != 0) {
+        m_expected.insert(lane.pendingId, CurtainCommandQueue::Superseded);
+        lane.pending = 0;
+    }
+    modelFinishActive(type, CurtainCommandQueue::Preempted);
+    m_expected.insert(id, CurtainCommandQueue::Completed);
+}
+
+bool CurtainCommandQueueStressTest::modelCancel(quint64 id)
+{
+    for (int type = 0; type < m_model.size(); ++type) {
+        LaneModel &lane = m_model[type];
+        if (lane.pending != 0 && lane.pendingId == id) {
+            m_expected.insert(id, CurtainCommandQueue::Cancelled);
+            lane.pending = 0;
+            lane.dwell = false;
+            return true;
+        }
+        if (lane.active != 0 && lane.activeIds.contains(id)) {
+            modelFinishActive(type, CurtainCommandQueue::Cancelled);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CurtainCommandQueueStressTest::modelFinishActive(int type, CurtainCommandQueue::Result result)
+{
+    LaneModel &lane = m_model[type];
+    for (quint64 id : lane.activeIds) {
+        m_expected.insert(id, result);
+    }
+    lane.active = 0;
+    lane.activeIds.clear();
+}
+
+void CurtainCommandQueueStressTest::syncTimers()
+{
+    for (int type = 0; type < m_model.size(); ++type) {
+        LaneModel &lane = m_model[type];
+
+        // 停机等待中控制器不运动且队列非空闲；二者之一改变说明等待已结束并按待执行命令启动
+        if (lane.dwell && (m_curtain->isCurtainMoving(type) || m_queue->isIdle(type))) {
+            lane.dwell = false;
+            modelDispatch(type);
+        }
+
+        // 按时间到达终点，或已在标定过的终点时立即完成
+        if (lane.active != 0 && !m_curtain->isCurtainMoving(type)) {
+            const CurtainController::CurtainState state = m_curtain->getCurtainState(type);
+            QVERIFY(state == CurtainController::Open || state == CurtainController::Closed);
+            modelFinishActive(type, CurtainCommandQueue::Completed);
+        }
+    }
+}
+
+void CurtainCommandQueueStressTest::expireDwell()
+{
+    for (int round = 0; round < DWELL_ROUNDS; ++round) {
+        QCoreApplication::processEvents();
+        syncTimers();
+
+        bool dwelling = false;
+        for (const LaneModel &lane : m_model) {
+            dwelling = dwelling || lane.dwell;
+        }
+        if (!dwelling) {
+            return;
+        }
+    }
+}
+
+void CurtainCommandQueueStressTest::verifyLanes()
+{
+    for (int type = 0; type < m_model.size(); ++type) {
+        const LaneModel &lane = m_model.at(type);
+        const TestActuator &actuator = ACTUATORS[type];
+
+        QCOMPARE(m_queue->isIdle(type), lane.active == 0 && lane.pending == 0);
+        QCOMPARE(m_curtain->isCurtainMoving(type), lane.active != 0);
+
+        const bool enable = (lane.active != 0) ? CURTAIN_ENABLE : CURTAIN_DISABLE;
+        QCOMPARE(lineLevel(actuator.enable), enable);
+        if (actuator.enable2 >= 0) {
+            QCOMPARE(lineLevel(actuator.enable2), enable);
+        }
+        if (lane.active != 0) {
+            QCOMPARE(lineLevel(actuator.dir1), lane.active > 0);
+            QCOMPARE(lineLevel(actuator.dir2), lane.active < 0);
+        }
+    }
+}
+
+bool CurtainCommandQueueStressTest::lineLevel(int pin) const
+{
+    return m_lines->lineLevel(pin / GPIO_LINES_PER_CHIP, pin % GPIO_LINES_PER_CHIP);
+}
+
+QTEST_GUILESS_MAIN(CurtainCommandQueueStressTest)
+
+#include "tst_curtain_command_queue_stress.moc"
@@ -0,0 +1,212 @@
+#include <QtTest>
+#include <QMap>
+#include <QVector>
+
+#include "hardware/gpio_chardev.h"
+#include "hardware/gpio_controller.h"
+#include "hardware/gpio_line_io.h"
+#include "hardware/sysfs_io.h"
+#include "config/gpio_config.h"
+
+namespace {
+
+// 测试引脚：gpio1上三条线路，gpio2上一条，避开电源与水泵所在的gpio3
+const int PIN_A = 40;
+const int PIN_B = 41;
+const int PIN_C = 42;
+const int PIN_OTHER_CHIP = 70;
+
+bool lineLevel(const SimulatedGpioLineIo *io, int pin)
+{
+    return io->lineLevel(GpioCharDev::chipOf(pin), GpioCharDev::offsetOf(pin));
+}
+
+bool lineRequested(const SimulatedGpioLineIo *io, int pin)
+{
+    return io->isLineRequested(GpioCharDev::chipOf(pin), GpioCharDev::offsetOf(pin));
+}
+
+} // namespace
+
+/**
+ * @brief GPIO字符设备后端测试
+ *
+ * 线路管理（GpioCharDev）与GPIO控制器的字符设备后端接在进程内模拟的ioctl实现上，
+ * 按ioctl种类计数，检查同一芯片的多条线路只用一次请求或一次SET_VALUES、方向修改
+ * 留在原请求内、线路集合变化时重新申请保持输出电平，以及sysfs到字符设备的后端迁移。
+ */
+class GpioCharDevTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void multiLineSetIsSingleIoctl();
+    void directionChangeStaysInRequest();
+    void rebuildRequestKeepsLevels();
+    void setBackendMigratesPins();
+};
+
+void GpioCharDevTest::multiLineSetIsSingleIoctl()
+{
+    SimulatedGpioLineIo *io = new SimulatedGpioLineIo;
+    GpioCharDev charDev(io);
+
+    QMap<int, bool> outputs;
+    outputs.insert(PIN_A, false);
+    outputs.insert(PIN_B, false);
+    outputs.insert(PIN_C, true);
+    outputs.insert(PIN_OTHER_CHIP, false);
+    QVERIFY(charDev.claimLines(outputs, QVector<int>()).isEmpty());
+    QCOMPARE(io->ioctlCount(GPIO_V2_GET_LINE_IOCTL), 2); // 每个芯片一次请求
+    QVERIFY(!lineLevel(io, PIN_A));
+    QVERIFY(lineLevel(io, PIN_C));
+
+    // 同一芯片的三条线路：一次SET_VALUES
+    io->resetIoctlCount();
+    QMap<int, bool> levels;
+    levels.insert(PIN_A, true);
+    levels.insert(PIN_B, true);
+    levels.insert(PIN_C, false);
+    QVERIFY(charDev.setLevels(levels));
+    QCOMPARE(io->ioctlCount(), 1);
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_VALUES_IOCTL), 1);
+    QVERIFY(lineLevel(io, PIN_A));
+    QVERIFY(lineLevel(io, PIN_B));
+    QVERIFY(!lineLevel(io, PIN_C));
+
+    // 跨芯片：每个芯片一次
+    io->resetIoctlCount();
+    levels.insert(PIN_OTHER_CHIP, true);
+    QVERIFY(charDev.setLevels(levels));
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_VALUES_IOCTL), 2);
+    QVERIFY(lineLevel(io, PIN_OTHER_CHIP));
+
+    bool level = false;
+    QVERIFY(charDev.getLevel(PIN_B, level));
+    QVERIFY(level);
+}
+
+void GpioCharDevTest::directionChangeStaysInRequest()
+{
+    SimulatedGpioLineIo *io = new SimulatedGpioLineIo;
+    GpioCharDev charDev(io);
+
+    QMap<int, bool> outputs;
+    outputs.insert(PIN_A, true);
+    outputs.insert(PIN_B, false);
+    QVERIFY(charDev.claimLines(outputs, QVector<int>()).isEmpty());
+
+    // 线路集合不变：原请求内SET_CONFIG，不重新申请
+    io->resetIoctlCount();
+    QVERIFY(charDev.claimLine(PIN_B, false, false));
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_CONFIG_IOCTL), 1);
+    QCOMPARE(io->ioctlCount(GPIO_V2_GET_LINE_IOCTL), 0);
+    QVERIFY(charDev.isClaimed(PIN_B));
+    QVERIFY(!charDev.isOutput(PIN_B));
+    QVERIFY(lineLevel(io, PIN_A));
+
+    // 输入线路不能写入，且不产生ioctl
+    io->resetIoctlCount();
+    QMap<int, bool> levels;
+    levels.insert(PIN_B, true);
+    QVERIFY(!charDev.setLevels(levels));
+    QCOMPARE(io->ioctlCount(), 0);
+
+    // 改回输出时附带初始电平
+    QVERIFY(charDev.claimLine(PIN_B, true, true));
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_CONFIG_IOCTL), 1);
+    QCOMPARE(io->ioctlCount(GPIO_V2_GET_LINE_IOCTL), 0);
+    QVERIFY(charDev.isOutput(PIN_B));
+    QVERIFY(lineLevel(io, PIN_B));
+    QVERIFY(lineLevel(io, PIN_A));
+}
+
+void GpioCharDevTest::rebuildRequestKeepsLevels()
+{
+    SimulatedGpioLineIo *io = new SimulatedGpioLineIo;
+    GpioCharDev charDev(io);
+
+    QVERIFY(charDev.claimLine(PIN_A, true, true));
+
+    // 新增线路：关闭旧请求后按新集合重新申请，原有输出保持电平
+    io->resetIoctlCount();
+    QVERIFY(charDev.claimLine(PIN_B, true, false));
+    QCOMPARE(io->ioctlCount(GPIO_V2_GET_LINE_IOCTL), 1);
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_CONFIG_IOCTL), 0);
+    QVERIFY(lineRequested(io, PIN_A));
+    QVERIFY(lineRequested(io, PIN_B));
+    QVERIFY(lineLevel(io, PIN_A));
+    QVERIFY(!lineLevel(io, PIN_B));
+
+    // 新请求可以继续写入
+    QMap<int, bool> levels;
+    levels.insert(PIN_A, false);
+    levels.insert(PIN_B, true);
+    QVERIFY(charDev.setLevels(levels));
+    QVERIFY(!lineLevel(io, PIN_A));
+    QVERIFY(lineLevel(io, PIN_B));
+
+    // 释放一条线路同样重新申请，其余线路保持
+    io->resetIoctlCount();
+    QVERIFY(charDev.releaseLine(PIN_A));
+    QCOMPARE(io->ioctlCount(GPIO_V2_GET_LINE_IOCTL), 1);
+    QVERIFY(!charDev.isClaimed(PIN_A));
+    QVERIFY(!lineRequested(io, PIN_A));
+    QVERIFY(lineRequested(io, PIN_B));
+    QVERIFY(lineLevel(io, PIN_B));
+
+    // 释放最后一条线路只关闭请求
+    io->resetIoctlCount();
+    QVERIFY(charDev.releaseLine(PIN_B));
+    QCOMPARE(io->ioctlCount(), 0);
+    QVERIFY(!lineRequested(io, PIN_B));
+}
+
+void GpioCharDevTest::setBackendMigratesPins()
+{
+    MemorySysfsIo sysfsIo;
+    GPIOController gpio;
+    QVERIFY(gpio.setSysfsIo(&sysfsIo));
+    QVERIFY(gpio.setBackend(GPIOController::SysfsBackend));
+    QVERIFY(gpio.initialize());
+    QCOMPARE(gpio.backend(), GPIOController::SysfsBackend);
+
+    QVERIFY(gpio.exportPin(PIN_A));
+    QVERIFY(gpio.setDirection(PIN_A, "out"));
+    QVERIFY(gpio.setPin(PIN_A, true));
+    QVERIFY(gpio.exportPin(PIN_B));
+    QVERIFY(gpio.setDirection(PIN_B, "in"));
+
+    SimulatedGpioLineIo *io = new SimulatedGpioLineIo;
+    gpio.setCharDevLineIo(io);
+    QVERIFY(gpio.setBackend(GPIOController::CharDevBackend));
+    QCOMPARE(gpio.backend(), GPIOController::CharDevBackend);
+
+    // 输出按原电平迁移，输入仍为输入，sysfs导出已释放
+    QVERIFY(lineRequested(io, PIN_A));
+    QVERIFY(lineLevel(io, PIN_A));
+    QVERIFY(gpio.getPin(PIN_A));
+    QVERIFY(lineRequested(io, PIN_B));
+    QVERIFY(lineRequested(io, POWER_SUPPLY_PIN));
+    QVERIFY(lineLevel(io, POWER_SUPPLY_PIN));
+    QVERIFY(!lineLevel(io, PUMP_CONTROL_PIN));
+    QVERIFY(!sysfsIo.exists(QString("%1/gpio%2").arg(GPIO_BASE_PATH).arg(PIN_A)));
+    QVERIFY(!sysfsIo.exists(QString("%1/gpio%2").arg(GPIO_BASE_PATH).arg(POWER_SUPPLY_PIN)));
+
+    // 迁移后的批量写入：两台泵在同一芯片上，一次SET_VALUES
+    io->resetIoctlCount();
+    QMap<int, bool> levels;
+    levels.insert(PUMP_CONTROL_PIN, true);
+    levels.insert(FERTILIZER_PUMP_PIN, true);
+    QVERIFY(gpio.setPins(levels));
+    QCOMPARE(io->ioctlCount(GPIO_V2_LINE_SET_VALUES_IOCTL), 1);
+    QVERIFY(lineLevel(io, PUMP_CONTROL_PIN));
+    QVERIFY(lineLevel(io, FERTILIZER_PUMP_PIN));
+    QVERIFY(lineLevel(io, POWER_SUPPLY_PIN));
+
+    gpio.cleanup();
+}
+
+QTEST_GUILESS_MAIN(GpioCharDevTest)
+
+#include "tst_gpio_chardev.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_gpio_mmio
+
+SOURCES += \
+    tst_gpio_mmio.cpp
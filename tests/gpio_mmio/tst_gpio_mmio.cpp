@@ -0,0 +1,157 @@
+#include <QtTest>
+#include <QFile>
+#include <QMap>
+#include <QTemporaryDir>
+
+#include <string.h>
+#include <unistd.h>
+
+#include "hardware/gpio_controller.h"
+#include "hardware/gpio_mmio.h"
+#include "hardware/sysfs_io.h"
+#include "config/gpio_config.h"
+
+namespace {
+
+// 测试引脚：gpio1的线路8（L寄存器）与线路25（H寄存器）
+const int BANK = 1;
+const int PIN_LOW = BANK * GPIO_LINES_PER_CHIP + 8;
+const int PIN_HIGH = BANK * GPIO_LINES_PER_CHIP + 25;
+const quint32 LOW_BIT = 1u << 8;
+const quint32 HIGH_BIT = 1u << (25 - 16);
+
+// 带写使能掩码的寄存器值：高16位为掩码，低16位为电平/方向
+quint32 masked(quint32 bits, quint32 values)
+{
+    return (bits << 16) | (values & bits);
+}
+
+} // namespace
+
+/**
+ * @brief GPIO寄存器直接访问测试
+ *
+ * 映射源指向临时目录中的普通文件（测试模式，各bank依次占用一页），
+ * 经GpioMmio与GPIO控制器的快速引脚写入后，从文件内容中读回数据寄存器与方向寄存器，
+ * 检查L/H寄存器的选择、写使能掩码与电平位。
+ */
+class GpioMmioTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void registerBitPatterns();
+    void controllerFastPins();
+
+private:
+    quint32 fileRegister(int chip, int offset) const; // 从映射文件读取寄存器（不经映射）
+
+    QTemporaryDir m_dir;
+    QString m_source;
+};
+
+void GpioMmioTest::init()
+{
+    QVERIFY(m_dir.isValid());
+    m_source = m_dir.filePath("gpio_mmio.bin");
+    QFile::remove(m_source);
+    QFile file(m_source);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+}
+
+quint32 GpioMmioTest::fileRegister(int chip, int offset) const
+{
+    QFile file(m_source);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(qint64(sysconf(_SC_PAGESIZE)) * chip + offset)) {
+        return 0xFFFFFFFFu;
+    }
+    const QByteArray bytes = file.read(sizeof(quint32));
+    quint32 value = 0xFFFFFFFFu;
+    if (bytes.size() == int(sizeof(value))) {
+        memcpy(&value, bytes.constData(), sizeof(value));
+    }
+    return value;
+}
+
+void GpioMmioTest::registerBitPatterns()
+{
+    GpioMmio mmio(m_source);
+    QVERIFY2(mmio.open(), qPrintable(mmio.lastError()));
+    QVERIFY(mmio.isFileBacked());
+
+    // 单条线路：一次存储，只有该线路的掩码置位
+    mmio.write(PIN_LOW, true);
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(LOW_BIT, LOW_BIT));
+    mmio.write(PIN_HIGH, false);
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_H), masked(HIGH_BIT, 0));
+    mmio.setDirection(PIN_LOW, true);
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DDR_L), masked(LOW_BIT, LOW_BIT));
+    mmio.setDirection(PIN_HIGH, false);
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DDR_H), masked(HIGH_BIT, 0));
+    QCOMPARE(mmio.registerValue(BANK, GPIO_MMIO_SWPORT_DDR_H), masked(HIGH_BIT, 0));
+
+    // 其它bank未被写入
+    QCOMPARE(fileRegister(BANK + 1, GPIO_MMIO_SWPORT_DR_L), 0u);
+
+    // 同一bank多条线路：L/H各一次存储
+    const quint32 lowLines = (1u << 3) | (1u << 8);
+    const quint32 highLines = (1u << 20) | (1u << 25);
+    mmio.writeBank(BANK, lowLines | highLines, (1u << 8) | (1u << 20));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(lowLines, 1u << 8));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_H), masked(highLines >> 16, 1u << 4));
+
+    // 掩码为0的半边不写
+    mmio.writeBank(BANK, 1u << 3, 1u << 3);
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(1u << 3, 1u << 3));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_H), masked(highLines >> 16, 1u << 4));
+}
+
+void GpioMmioTest::controllerFastPins()
+{
+    MemorySysfsIo sysfsIo;
+    GPIOController gpio;
+    QVERIFY(gpio.setSysfsIo(&sysfsIo));
+    QVERIFY(gpio.setBackend(GPIOController::SysfsBackend));
+    QVERIFY(gpio.setMmioSource(m_source));
+    QVERIFY(gpio.setFastPins(QList<int>() << PIN_LOW << PIN_HIGH << -1));
+    QVERIFY(gpio.isFastPin(PIN_LOW));
+    QVERIFY(!gpio.isFastPin(-1));
+    QVERIFY(gpio.initialize());
+    QVERIFY(gpio.fastIo() != nullptr);
+    QVERIFY(!gpio.setFastPins(QList<int>()));
+
+    // 方向经后端设置后同步到寄存器：先写电平再设方向
+    QVERIFY(gpio.exportPin(PIN_LOW));
+    QVERIFY(gpio.setDirection(PIN_LOW, "high"));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(LOW_BIT, LOW_BIT));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DDR_L), masked(LOW_BIT, LOW_BIT));
+    QVERIFY(gpio.exportPin(PIN_HIGH));
+    QVERIFY(gpio.setDirection(PIN_HIGH, "out"));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_H), masked(HIGH_BIT, 0));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DDR_H), masked(HIGH_BIT, HIGH_BIT));
+
+    // 单个快速引脚：一次寄存器存储，影子寄存器同步
+    QVERIFY(gpio.setPin(PIN_LOW, false));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(LOW_BIT, 0));
+    QVERIFY(!gpio.getPin(PIN_LOW));
+
+    // 批量写入：同一bank合并，L/H各一次存储
+    QMap<int, bool> levels;
+    levels.insert(PIN_LOW, true);
+    levels.insert(PIN_HIGH, true);
+    QVERIFY(gpio.setPins(levels));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_L), masked(LOW_BIT, LOW_BIT));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DR_H), masked(HIGH_BIT, HIGH_BIT));
+    QVERIFY(gpio.getPin(PIN_HIGH));
+
+    // 改为输入：方向位清零
+    QVERIFY(gpio.setDirection(PIN_HIGH, "in"));
+    QCOMPARE(fileRegister(BANK, GPIO_MMIO_SWPORT_DDR_H), masked(HIGH_BIT, 0));
+
+    gpio.cleanup();
+}
+
+QTEST_GUILESS_MAIN(GpioMmioTest)
+
+#include "tst_gpio_mmio.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_serial_stepper_bus
+
+SOURCES += \
+    tst_serial_stepper_bus.cpp
@@ -0,0 +1,170 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QStringList>
+
+#include "hardware/serial_stepper_bus.h"
+#include "hardware/serial_stepper_emulator.h"
+#include "config/gpio_config.h"
+
+namespace {
+
+const int ADDRESS = 1;
+const int REPLY_TIMEOUT_MS = 1000;     // 足够长，只有注入的故障才会超时
+const int RETRY_TIMEOUT_MS = 100;      // 校验错误后等待重发的超时
+const int WAIT_MS = 5000;              // 等待应答或失败信号的上限
+const int PIPELINE_REQUESTS = 8;
+const int PIPELINE_DELAY_MS = 100;     // 仿真驱动器应答延迟
+
+} // namespace
+
+/**
+ * @brief RS-485步进驱动器串口总线测试
+ *
+ * 总线打开仿真驱动器创建的伪终端，经真实的termios串口与poll收发循环通信，
+ * 用仿真驱动器的应答延迟、丢弃请求与破坏校验检查流水线、校验错误重发、
+ * 超时与被后续命令取代的请求，以及串口断开后的失败报告与重新打开。
+ * 总线信号在收发线程中发出，经排队连接在测试线程中记录。
+ */
+class SerialStepperBusTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void pipelinedRequests();
+    void corruptRepliesAreRetried();
+    void droppedRequestsTimeOut();
+    void disconnectFailsRequests();
+
+private:
+    SerialStepperEmulator *m_emulator = nullptr;
+    SerialStepperBus *m_bus = nullptr;
+    QMap<quint32, int> m_replies;          // 请求编号 -> 应答站地址
+    QMap<quint32, QString> m_failures;     // 请求编号 -> 失败原因
+    QStringList m_errors;
+};
+
+void SerialStepperBusTest::init()
+{
+    m_emulator = new SerialStepperEmulator;
+    QVERIFY(m_emulator->start());
+
+    m_bus = new SerialStepperBus;
+    connect(m_bus, &SerialStepperBus::replyReceived, this,
+            [this](quint32 requestId, int address, int, const QByteArray &) {
+        m_replies.insert(requestId, address);
+    });
+    connect(m_bus, &SerialStepperBus::requestFailed, this,
+            [this](quint32 requestId, int, int, const QString &error) {
+        m_failures.insert(requestId, error);
+    });
+    connect(m_bus, &SerialStepperBus::errorOccurred, this, [this](const QString &error) {
+        m_errors.append(error);
+    });
+    QVERIFY(m_bus->open(m_emulator->devicePath()));
+}
+
+void SerialStepperBusTest::cleanup()
+{
+    delete m_bus;
+    m_bus = nullptr;
+    delete m_emulator;
+    m_emulator = nullptr;
+    m_replies.clear();
+    m_failures.clear();
+    m_errors.clear();
+}
+
+void SerialStepperBusTest::pipelinedRequests()
+{
+    m_emulator->setReplyDelayMs(PIPELINE_DELAY_MS);
+
+    QElapsedTimer timer;
+    timer.start();
+    QMap<quint32, int> sent;
+    for (int i = 0; i < PIPELINE_REQUESTS; ++i) {
+        const int address = ADDRESS + i % 2;
+        const quint32 id = m_bus->send(address, SerialStepperBus::Ping, QByteArray(), REPLY_TIMEOUT_MS);
+        QVERIFY(id != 0);
+        sent.insert(id, address);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(m_replies.size(), PIPELINE_REQUESTS, WAIT_MS);
+
+    // 按序号匹配到各自的请求
+    QCOMPARE(m_replies, sent);
+    QVERIFY(m_failures.isEmpty());
+
+    // 每次最多CURTAIN_SERIAL_MAX_OUTSTANDING个请求同时等待应答：逐个收发需要全部延迟之和
+    QVERIFY2(timer.elapsed() < qint64(PIPELINE_DELAY_MS) * PIPELINE_REQUESTS / 2,
+             qPrintable(QString("耗时%1ms").arg(timer.elapsed())));
+    QCOMPARE(m_bus->statistics().retries, quint64(0));
+}
+
+void SerialStepperBusTest::corruptRepliesAreRetried()
+{
+    // 第2、4、6个应答校验错误：每个错误应答超时后以原序号重发，驱动器只补发应答
+    m_emulator->setCorruptEvery(2);
+    const int requests = 4;
+    for (int i = 0; i < requests; ++i) {
+        const quint32 id = m_bus->send(ADDRESS, SerialStepperBus::Ping, QByteArray(), RETRY_TIMEOUT_MS);
+        QVERIFY(id != 0);
+        QTRY_VERIFY_WITH_TIMEOUT(m_replies.contains(id) || m_failures.contains(id), WAIT_MS);
+        QVERIFY2(m_replies.contains(id), qPrintable(m_failures.value(id)));
+    }
+
+    const SerialStepperBus::Statistics stats = m_bus->statistics();
+    QCOMPARE(stats.replies, quint64(requests));
+    QVERIFY(stats.crcErrors >= quint64(requests - 1));
+    QVERIFY(stats.retries >= quint64(requests - 1));
+    QCOMPARE(stats.timeouts, quint64(0));
+    QCOMPARE(m_emulator->executedCommands(ADDRESS), requests);
+}
+
+void SerialStepperBusTest::droppedRequestsTimeOut()
+{
+    // 全部请求丢失：运动命令被随后的停机命令取代，不再重发；停机命令重发后报告超时
+    m_emulator->setDropEvery(1);
+    const quint32 move = m_bus->move(ADDRESS, true, 1000, 500);
+    const quint32 stop = m_bus->stop(ADDRESS, true);
+    QVERIFY(move != 0 && stop != 0);
+
+    QTRY_VERIFY_WITH_TIMEOUT(m_failures.contains(move) && m_failures.contains(stop), WAIT_MS);
+    QVERIFY(m_replies.isEmpty());
+    QVERIFY(m_failures.value(move).contains("取代"));
+    QVERIFY(!m_failures.value(stop).contains("取代"));
+
+    const SerialStepperBus::Statistics stats = m_bus->statistics();
+    QCOMPARE(stats.retries, quint64(CURTAIN_SERIAL_RETRIES));
+    QCOMPARE(stats.timeouts, quint64(2));
+    QCOMPARE(m_emulator->executedCommands(ADDRESS), 0);
+}
+
+void SerialStepperBusTest::disconnectFailsRequests()
+{
+    // 请求无应答，断开时仍在等待
+    m_emulator->setDropEvery(1);
+    const quint32 pending = m_bus->send(ADDRESS, SerialStepperBus::Ping, QByteArray(), WAIT_MS * 2);
+    QVERIFY(pending != 0);
+
+    // 关闭伪终端master端，总线读到POLLHUP后退出收发循环
+    m_emulator->stop();
+    QTRY_VERIFY_WITH_TIMEOUT(m_failures.contains(pending), WAIT_MS);
+    QVERIFY(!m_errors.isEmpty());
+    QVERIFY(!m_bus->isOpen());
+    QCOMPARE(m_bus->send(ADDRESS, SerialStepperBus::Ping), quint32(0));
+
+    // 重新打开后恢复收发
+    m_emulator->setDropEvery(0);
+    QVERIFY(m_emulator->start());
+    QVERIFY(m_bus->open(m_emulator->devicePath()));
+    QVERIFY(m_bus->isOpen());
+    const quint32 id = m_bus->send(ADDRESS, SerialStepperBus::Status, QByteArray(), REPLY_TIMEOUT_MS);
+    QVERIFY(id != 0);
+    QTRY_VERIFY_WITH_TIMEOUT(m_replies.contains(id), WAIT_MS);
+}
+
+QTEST_GUILESS_MAIN(SerialStepperBusTest)
+
+#include "tst_serial_stepper_bus.moc"
@@ -0,0 +1,10 @@
+# 各测试子工程共用：Qt Test、无界面，链接全部硬件控制与执行器模块
+QT       += core testlib
+QT       -= gui
+
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+include($$PWD/../control_modules.pri)
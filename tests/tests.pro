@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# 开发机上运行：qmake tests/tests.pro && make check
+SUBDIRS += \
+    curtain_command_queue_stress \
+    gpio_chardev \
+    gpio_mmio \
+    serial_stepper_bus